@@ -22,7 +22,9 @@ public class MassUnitSystemEditor : ModuleRules
 			new string[]
 			{
 				"UnrealEd",
+				"AssetRegistry",
 				"MassEntity",
+				"NavigationSystem",
 				"Slate",
 				"SlateCore"
 			}
@@ -0,0 +1,263 @@
+// Copyright Digi Logic Labs LLC. All Rights Reserved.
+
+#include "Commandlets/MassUnitImpostorCommandlet.h"
+
+#include "AssetCompilingManager.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Components/SceneCaptureComponent2D.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/Texture2D.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Engine/World.h"
+#include "Entity/UnitTemplate.h"
+#include "Materials/MaterialInstanceConstant.h"
+#include "Misc/App.h"
+#include "Misc/PackageName.h"
+#include "Misc/Parse.h"
+#include "TextureResource.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogMassUnitImpostor, Log, All);
+
+namespace UE::MassUnitSystem::Impostor
+{
+	/** Direction from the mesh toward the camera for atlas frame (X, Y) of a hemi-octahedral grid. */
+	FVector FrameDirection(int32 X, int32 Y, int32 FramesPerAxis)
+	{
+		const double U = (X + 0.5) / FramesPerAxis * 2.0 - 1.0;
+		const double V = (Y + 0.5) / FramesPerAxis * 2.0 - 1.0;
+		const double HemiX = (U + V) * 0.5;
+		const double HemiY = (U - V) * 0.5;
+		return FVector(HemiX, HemiY, 1.0 - FMath::Abs(HemiX) - FMath::Abs(HemiY)).GetSafeNormal();
+	}
+
+	/** Loads PackagePath's asset of the same name, or creates it in a new package. */
+	template <typename AssetType>
+	AssetType* FindOrCreateAsset(const FString& PackagePath)
+	{
+		const FString AssetName = FPackageName::GetShortName(PackagePath);
+		if (AssetType* Existing = LoadObject<AssetType>(nullptr, *(PackagePath + TEXT(".") + AssetName), nullptr, LOAD_NoWarn | LOAD_Quiet))
+		{
+			return Existing;
+		}
+		AssetType* Asset = NewObject<AssetType>(CreatePackage(*PackagePath), *AssetName, RF_Public | RF_Standalone);
+		FAssetRegistryModule::AssetCreated(Asset);
+		return Asset;
+	}
+
+	bool SaveAsset(UObject* Asset)
+	{
+		UPackage* Package = Asset->GetPackage();
+		Package->MarkPackageDirty();
+		const FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+		FSavePackageArgs SaveArgs;
+		SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+		return UPackage::SavePackage(Package, Asset, *Filename, SaveArgs);
+	}
+}
+
+UMassUnitImpostorCommandlet::UMassUnitImpostorCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UMassUnitImpostorCommandlet::Main(const FString& Params)
+{
+	if (!FApp::CanEverRender())
+	{
+		UE_LOG(LogMassUnitImpostor, Error, TEXT("Impostor capture needs a renderer; run with -AllowCommandletRendering and without -nullrhi."));
+		return 1;
+	}
+
+	FString TemplatePath;
+	FString ParentMaterialPath;
+	int32 FramesPerAxis = 8;
+	int32 FrameResolution = 256;
+	FParse::Value(*Params, TEXT("Template="), TemplatePath);
+	FParse::Value(*Params, TEXT("ParentMaterial="), ParentMaterialPath);
+	FParse::Value(*Params, TEXT("Frames="), FramesPerAxis);
+	FParse::Value(*Params, TEXT("FrameResolution="), FrameResolution);
+	FramesPerAxis = FMath::Clamp(FramesPerAxis, 2, 32);
+	FrameResolution = FMath::Clamp(FrameResolution, 32, 1024);
+
+	UMaterialInterface* ParentMaterial = nullptr;
+	if (!ParentMaterialPath.IsEmpty())
+	{
+		ParentMaterial = LoadObject<UMaterialInterface>(nullptr, *ParentMaterialPath);
+		if (!ParentMaterial)
+		{
+			UE_LOG(LogMassUnitImpostor, Error, TEXT("Parent material %s could not be loaded."), *ParentMaterialPath);
+			return 1;
+		}
+	}
+
+	TArray<UUnitTemplate*> Templates;
+	if (!TemplatePath.IsEmpty())
+	{
+		if (UUnitTemplate* Template = LoadObject<UUnitTemplate>(nullptr, *TemplatePath))
+		{
+			Templates.Add(Template);
+		}
+	}
+	else
+	{
+		IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+		AssetRegistry.SearchAllAssets(true);
+		TArray<FAssetData> TemplateAssets;
+		AssetRegistry.GetAssetsByClass(UUnitTemplate::StaticClass()->GetClassPathName(), TemplateAssets, true);
+		for (const FAssetData& TemplateAsset : TemplateAssets)
+		{
+			if (UUnitTemplate* Template = Cast<UUnitTemplate>(TemplateAsset.GetAsset()))
+			{
+				Templates.Add(Template);
+			}
+		}
+	}
+	if (Templates.IsEmpty())
+	{
+		UE_LOG(LogMassUnitImpostor, Error, TEXT("No unit templates found%s."), TemplatePath.IsEmpty() ? TEXT("") : *FString::Printf(TEXT(" at %s"), *TemplatePath));
+		return 1;
+	}
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::EditorPreview, false);
+	int32 FailedCount = 0;
+	for (UUnitTemplate* Template : Templates)
+	{
+		FailedCount += BakeTemplate(Template, World, FramesPerAxis, FrameResolution, ParentMaterial) ? 0 : 1;
+	}
+	World->DestroyWorld(false);
+
+	UE_LOG(LogMassUnitImpostor, Display, TEXT("Baked %d of %d unit template impostors."), Templates.Num() - FailedCount, Templates.Num());
+	return FailedCount > 0 ? 1 : 0;
+}
+
+bool UMassUnitImpostorCommandlet::BakeTemplate(
+	UUnitTemplate* Template,
+	UWorld* World,
+	int32 FramesPerAxis,
+	int32 FrameResolution,
+	UMaterialInterface* ParentMaterial)
+{
+	using namespace UE::MassUnitSystem::Impostor;
+
+	UStaticMesh* Mesh = Template->StaticMesh.LoadSynchronous();
+	if (!Mesh)
+	{
+		UE_LOG(LogMassUnitImpostor, Warning, TEXT("%s has no static mesh to capture."), *Template->GetPathName());
+		return false;
+	}
+
+	UStaticMeshComponent* MeshComponent = NewObject<UStaticMeshComponent>(World);
+	MeshComponent->SetStaticMesh(Mesh);
+	MeshComponent->RegisterComponentWithWorld(World);
+
+	UTextureRenderTarget2D* RenderTarget = NewObject<UTextureRenderTarget2D>();
+	RenderTarget->ClearColor = FLinearColor::Transparent;
+	RenderTarget->InitCustomFormat(FrameResolution, FrameResolution, PF_FloatRGBA, true);
+	RenderTarget->UpdateResourceImmediate(true);
+
+	// The runtime card is as wide as the bounding sphere and centered on its origin, so every frame is too.
+	const FBoxSphereBounds Bounds = Mesh->GetBounds();
+	USceneCaptureComponent2D* Capture = NewObject<USceneCaptureComponent2D>(World);
+	Capture->ProjectionType = ECameraProjectionMode::Orthographic;
+	Capture->OrthoWidth = 2.0f * Bounds.SphereRadius;
+	Capture->bCaptureEveryFrame = false;
+	Capture->bCaptureOnMovement = false;
+	Capture->PrimitiveRenderMode = ESceneCapturePrimitiveRenderMode::PRM_UseShowOnlyList;
+	Capture->ShowOnlyComponents.Add(MeshComponent);
+	Capture->TextureTarget = RenderTarget;
+	Capture->RegisterComponentWithWorld(World);
+
+	// Mesh, texture, and shader compilation must settle before the first capture.
+	FAssetCompilingManager::Get().FinishAllCompilation();
+
+	const int32 AtlasSize = FramesPerAxis * FrameResolution;
+	TArray<FColor> Atlas;
+	Atlas.SetNumZeroed(AtlasSize * AtlasSize);
+	TArray<FLinearColor> BaseColorPixels;
+	TArray<FLinearColor> CoveragePixels;
+	FTextureRenderTargetResource* RenderTargetResource = RenderTarget->GameThread_GetRenderTargetResource();
+	for (int32 FrameY = 0; FrameY < FramesPerAxis; ++FrameY)
+	{
+		for (int32 FrameX = 0; FrameX < FramesPerAxis; ++FrameX)
+		{
+			const FVector Direction = FrameDirection(FrameX, FrameY, FramesPerAxis);
+			Capture->SetWorldLocationAndRotation(Bounds.Origin + Direction * (2.0 * Bounds.SphereRadius), (-Direction).Rotation());
+
+			// Base color is unlit; scene color alpha holds inverse coverage and supplies the card mask.
+			Capture->CaptureSource = ESceneCaptureSource::SCS_BaseColor;
+			Capture->CaptureScene();
+			RenderTargetResource->ReadLinearColorPixels(BaseColorPixels);
+			Capture->CaptureSource = ESceneCaptureSource::SCS_SceneColorHDR;
+			Capture->CaptureScene();
+			RenderTargetResource->ReadLinearColorPixels(CoveragePixels);
+			if (BaseColorPixels.Num() != FrameResolution * FrameResolution || CoveragePixels.Num() != BaseColorPixels.Num())
+			{
+				UE_LOG(LogMassUnitImpostor, Warning, TEXT("Capture of %s returned no pixels."), *Template->GetPathName());
+				MeshComponent->DestroyComponent();
+				Capture->DestroyComponent();
+				return false;
+			}
+
+			for (int32 PixelY = 0; PixelY < FrameResolution; ++PixelY)
+			{
+				for (int32 PixelX = 0; PixelX < FrameResolution; ++PixelX)
+				{
+					const int32 Pixel = PixelY * FrameResolution + PixelX;
+					FLinearColor Color = BaseColorPixels[Pixel];
+					Color.A = 1.0f - FMath::Clamp(CoveragePixels[Pixel].A, 0.0f, 1.0f);
+					Atlas[(FrameY * FrameResolution + PixelY) * AtlasSize + FrameX * FrameResolution + PixelX] = Color.ToFColor(true);
+				}
+			}
+		}
+	}
+	MeshComponent->DestroyComponent();
+	Capture->DestroyComponent();
+
+	const FString AssetPathBase = FPackageName::GetLongPackagePath(Template->GetPackage()->GetName()) / Template->GetName();
+	UTexture2D* Texture = FindOrCreateAsset<UTexture2D>(AssetPathBase + TEXT("_ImpostorAtlas"));
+	Texture->Source.Init(AtlasSize, AtlasSize, 1, 1, TSF_BGRA8, reinterpret_cast<const uint8*>(Atlas.GetData()));
+	Texture->SRGB = true;
+	Texture->CompressionSettings = TC_Default;
+	Texture->PostEditChange();
+	if (!SaveAsset(Texture))
+	{
+		UE_LOG(LogMassUnitImpostor, Warning, TEXT("Could not save %s."), *Texture->GetPathName());
+		return false;
+	}
+
+	UMaterialInstanceConstant* Material = nullptr;
+	if (ParentMaterial)
+	{
+		Material = FindOrCreateAsset<UMaterialInstanceConstant>(AssetPathBase + TEXT("_ImpostorMaterial"));
+		Material->SetParentEditorOnly(ParentMaterial);
+		Material->SetTextureParameterValueEditorOnly(FMaterialParameterInfo(TEXT("ImpostorAtlas")), Texture);
+		Material->SetScalarParameterValueEditorOnly(FMaterialParameterInfo(TEXT("ImpostorFrames")), FramesPerAxis);
+		Material->PostEditChange();
+		if (!SaveAsset(Material))
+		{
+			UE_LOG(LogMassUnitImpostor, Warning, TEXT("Could not save %s."), *Material->GetPathName());
+			return false;
+		}
+	}
+
+	Template->Modify();
+	Template->ImpostorTexture = Texture;
+	Template->ImpostorFramesPerAxis = FramesPerAxis;
+	if (Material)
+	{
+		Template->ImpostorMaterial = Material;
+	}
+	if (!SaveAsset(Template))
+	{
+		UE_LOG(LogMassUnitImpostor, Warning, TEXT("Could not save %s."), *Template->GetPathName());
+		return false;
+	}
+	UE_LOG(LogMassUnitImpostor, Display, TEXT("Baked %dx%d impostor atlas for %s."), AtlasSize, AtlasSize, *Template->GetPathName());
+	return true;
+}
@@ -5,31 +5,161 @@
 #include "Misc/AutomationTest.h"
 #include "Templates/UnrealTemplate.h"
 
+#include "ActorFactories/ActorFactory.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Builders/CubeBuilder.h"
 #include "Components/HierarchicalInstancedStaticMeshComponent.h"
 #include "Components/InstancedStaticMeshComponent.h"
 #include "Config/MassUnitSystemSettings.h"
 #include "Core/MassUnitGameplayTags.h"
 #include "Core/MassUnitSubsystem.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
 #include "Engine/StaticMeshActor.h"
 #include "Engine/World.h"
+#include "GameFramework/DefaultPawn.h"
+#include "GameFramework/PlayerController.h"
+#include "Entity/MassUnitAvoidanceProcessor.h"
 #include "Entity/MassUnitCombatProcessor.h"
+#include "Entity/MassUnitCrowdProcessor.h"
 #include "Entity/MassUnitEntityManager.h"
 #include "Entity/MassUnitFragments.h"
 #include "Entity/MassUnitMovementProcessor.h"
 #include "Entity/MassUnitSpawner.h"
+#include "Entity/MassUnitVisibilityProcessor.h"
 #include "Entity/UnitTemplate.h"
+#include "Gameplay/MassUnitCrowdSpatialHash.h"
 #include "Gameplay/MassUnitCrowdSystem.h"
 #include "Kismet/GameplayStatics.h"
+#include "Materials/Material.h"
 #include "MassEntityManager.h"
 #include "MassEntitySubsystem.h"
 #include "MassExecutionContext.h"
 #include "MassUnitCommonFragments.h"
+#include "NavMesh/NavMeshBoundsVolume.h"
+#include "NavMesh/RecastNavMesh.h"
+#include "NavigationSystem.h"
 #include "Navigation/FormationSystem.h"
+#include "Navigation/MassUnitFlowFieldSystem.h"
 #include "Navigation/MassUnitNavigationSystem.h"
 #include "Tests/AutomationCommon.h"
 #include "UObject/UObjectIterator.h"
+#include "Visual/MassUnitInstanceData.h"
+#include "Visual/MassUnitVisualBuffers.h"
 #include "Visual/NiagaraUnitSystem.h"
 
+namespace
+{
+	/** Spawns a box of the engine cube mesh that navmesh generation treats as ground or obstacle. */
+	AStaticMeshActor* SpawnNavigationBox(UWorld* World, const FVector& Center, const FVector& Size, const FRotator& Rotation = FRotator::ZeroRotator)
+	{
+		UStaticMesh* Cube = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		AStaticMeshActor* Box = World->SpawnActor<AStaticMeshActor>(
+			AStaticMeshActor::StaticClass(),
+			FTransform(Rotation, Center, Size / 100.0f),
+			SpawnParameters);
+		if (Box && Cube)
+		{
+			Box->GetStaticMeshComponent()->SetMobility(EComponentMobility::Movable);
+			Box->GetStaticMeshComponent()->SetStaticMesh(Cube);
+		}
+		return Box;
+	}
+
+	/**
+	 * Builds a navmesh over Bounds and blocks until it is done. Game worlds only
+	 * generate navmesh at runtime, so the spawned instance is made dynamic.
+	 */
+	ARecastNavMesh* BuildTestNavMesh(UWorld* World, const FBox& Bounds)
+	{
+		UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+		if (!NavSys)
+		{
+			FNavigationSystem::AddNavigationSystemToWorld(*World, FNavigationSystemRunMode::GameMode);
+			NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+		}
+		if (!NavSys)
+		{
+			return nullptr;
+		}
+
+		ANavMeshBoundsVolume* Volume = World->SpawnActor<ANavMeshBoundsVolume>(
+			ANavMeshBoundsVolume::StaticClass(),
+			FTransform(Bounds.GetCenter()));
+		UCubeBuilder* Builder = NewObject<UCubeBuilder>();
+		Builder->X = Bounds.GetSize().X;
+		Builder->Y = Bounds.GetSize().Y;
+		Builder->Z = Bounds.GetSize().Z;
+		UActorFactory::CreateBrushForVolumeActor(Volume, Builder);
+		NavSys->OnNavigationBoundsUpdated(Volume);
+
+		FProperty* RuntimeGenerationProperty = ARecastNavMesh::StaticClass()->FindPropertyByName(TEXT("RuntimeGeneration"));
+		if (!RuntimeGenerationProperty)
+		{
+			return nullptr;
+		}
+		ERuntimeGenerationType& DefaultGeneration =
+			*RuntimeGenerationProperty->ContainerPtrToValuePtr<ERuntimeGenerationType>(GetMutableDefault<ARecastNavMesh>());
+		{
+			TGuardValue<ERuntimeGenerationType> GenerationGuard(DefaultGeneration, ERuntimeGenerationType::Dynamic);
+			NavSys->Build();
+		}
+		return Cast<ARecastNavMesh>(NavSys->GetDefaultNavDataInstance(FNavigationSystem::DontCreate));
+	}
+
+	/** Serves queued requests and lets their async navmesh queries land. Returns false if work is still pending. */
+	bool FlushPathRequests(UWorld* World, UMassUnitNavigationSystem* Navigation)
+	{
+		UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+		for (int32 Attempt = 0; Attempt < 200 && Navigation->GetQueuedRequestCount() > 0; ++Attempt)
+		{
+			Navigation->ProcessPathRequests();
+			if (NavSys)
+			{
+				NavSys->Tick(0.016f);
+			}
+			FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+			FPlatformProcess::Sleep(0.005f);
+		}
+		return Navigation->GetQueuedRequestCount() == 0;
+	}
+
+	/** Whether any segment of a corridor passes through the wall spanning Y in [-WallHalfLength, WallHalfLength] at WallX. */
+	bool CrossesWall(TConstArrayView<FVector> PathPoints, float WallX, float WallHalfLength)
+	{
+		for (int32 PointIndex = 0; PointIndex + 1 < PathPoints.Num(); ++PointIndex)
+		{
+			const FVector& From = PathPoints[PointIndex];
+			const FVector& To = PathPoints[PointIndex + 1];
+			if ((From.X - WallX) * (To.X - WallX) >= 0.0f)
+			{
+				continue;
+			}
+			const float Alpha = (WallX - From.X) / (To.X - From.X);
+			if (FMath::Abs(FMath::Lerp(From.Y, To.Y, Alpha)) < WallHalfLength)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/** The world's instanced fallback component drawing Mesh, optionally restricted to impostor cards with Material. */
+	UInstancedStaticMeshComponent* FindInstancedComponent(UWorld* World, const UStaticMesh* Mesh, const UMaterialInterface* Material = nullptr)
+	{
+		for (TObjectIterator<UInstancedStaticMeshComponent> It; It; ++It)
+		{
+			if (It->GetWorld() == World && It->GetStaticMesh() == Mesh && (!Material || It->GetMaterial(0) == Material))
+			{
+				return *It;
+			}
+		}
+		return nullptr;
+	}
+}
+
 IMPLEMENT_SIMPLE_AUTOMATION_TEST(
 	FMassUnitNativeLifecycleTest,
 	"MassUnitSystem.Core.NativeMassLifecycle",
@@ -126,6 +256,7 @@ bool FMassUnitNativeLifecycleTest::RunTest(const FString& Parameters)
 	UnitSubsystem->GetNavigationSystem()->ProcessPathRequests();
 	const FMassUnitNavigationFragment* Navigation = EntityManager.GetFragmentDataPtr<FMassUnitNavigationFragment>(UnitA.EntityHandle.ToMassEntityHandle());
 	TestTrue(TEXT("A world without nav data receives the newest direct-path fallback"), Navigation && Navigation->bPathValid && Navigation->PathPoints.Num() == 1 && Navigation->PathPoints[0].Equals(FVector(500.0f, 0.0f, 0.0f)));
+	TestTrue(TEXT("Served path requests are sampled for queue latency"), UnitSubsystem->GetNavigationSystem()->GetPathQueueStats().SampleCount > 0);
 
 	UMassUnitMovementProcessor* MovementProcessor = NewObject<UMassUnitMovementProcessor>(GetTransientPackage());
 	MovementProcessor->CallInitialize(World, EntityManager.AsShared());
@@ -507,8 +638,13 @@ bool FMassUnitNativeLifecycleTest::RunTest(const FString& Parameters)
 		return false;
 	}
 	VisualSystem->UpdateUnitVisualsByHandles(SpawnedUnits);
-	TestEqual(TEXT("Instanced fallback exposes the documented animation/LOD/team/health custom-data layout"),
-		VisualSystem->GetInstancedMeshCustomDataFloatCount(), 8);
+	TestEqual(TEXT("Instanced fallback exposes the documented packed animation/LOD/team/health and phase layout"),
+		VisualSystem->GetInstancedMeshCustomDataFloatCount(), 2);
+	const UE::MassUnitSystem::InstanceData::FUnpacked Unpacked =
+		UE::MassUnitSystem::InstanceData::Unpack(UE::MassUnitSystem::InstanceData::Pack(37, 3, 5, 0.5f));
+	TestTrue(TEXT("Packed instance data round-trips animation, LOD, team palette index, and quantized health"),
+		Unpacked.AnimationIndex == 37 && Unpacked.LODLevel == 3 && Unpacked.TeamPaletteIndex == 5
+		&& FMath::IsNearlyEqual(Unpacked.HealthFraction, 0.5f, 1.0f / 63.0f));
 	TestTrue(TEXT("Quick-start units have either configured Niagara or asset-free instanced rendering"),
 		VisualSystem->IsUsingNiagara() || VisualSystem->GetInstancedMeshInstanceCount() == SpawnedUnits.Num());
 
@@ -550,10 +686,46 @@ bool FMassUnitNativeLifecycleTest::RunTest(const FString& Parameters)
 			VisualSystem->GetInstancedMeshTopologyRevision(), TopologyRevisionBeforeMove);
 		TestEqual(TEXT("Movement preserves the fallback instance count"),
 			VisualSystem->GetInstancedMeshInstanceCount(), SpawnedUnits.Num());
+
+		VisualSystem->UpdateUnitVisualsByHandles(SpawnedUnits);
+		TestEqual(TEXT("An idle update uploads no transforms"), VisualSystem->GetInstancedMeshTransformUpdateCount(), 0);
+		TestEqual(TEXT("An idle update uploads no custom data"), VisualSystem->GetInstancedMeshCustomDataUpdateCount(), 0);
+
+		// Move two of the units; only their instances should be uploaded.
+		for (const int32 MovedIndex : {0, 2})
+		{
+			FTransform SubsetTransform;
+			UnitManager->GetUnitTransform(SpawnedUnits[MovedIndex], SubsetTransform);
+			SubsetTransform.AddToTranslation(FVector(0.0f, 40.0f, 0.0f));
+			UnitManager->SetUnitTransform(SpawnedUnits[MovedIndex], SubsetTransform);
+		}
+		VisualSystem->UpdateUnitVisualsByHandles(SpawnedUnits);
+		TestEqual(TEXT("Moving a subset uploads only the moved transforms"), VisualSystem->GetInstancedMeshTransformUpdateCount(), 2);
+		TestEqual(TEXT("Moving a subset leaves custom data untouched"), VisualSystem->GetInstancedMeshCustomDataUpdateCount(), 0);
+		TestEqual(TEXT("Moving a subset does not rebuild instanced-mesh topology"),
+			VisualSystem->GetInstancedMeshTopologyRevision(), TopologyRevisionBeforeMove);
+
+		// Destroying a unit from the middle swaps the last instance into its index.
+		FTransform LastUnitTransform;
+		UnitManager->GetUnitTransform(SpawnedUnits.Last(), LastUnitTransform);
+		UnitManager->DestroyUnit(SpawnedUnits[1]);
+		VisualSystem->UpdateUnitVisualsByHandles(SpawnedUnits);
+		TestEqual(TEXT("Removing a unit drops one fallback instance"),
+			VisualSystem->GetInstancedMeshInstanceCount(), SpawnedUnits.Num() - 1);
+		TestNotEqual(TEXT("Removing a unit shrinks instanced-mesh topology"),
+			VisualSystem->GetInstancedMeshTopologyRevision(), TopologyRevisionBeforeMove);
+		FTransform SwappedInstance;
+		TestTrue(TEXT("The freed instance holds the last unit after a swap-remove"),
+			FallbackComponent->GetInstanceTransform(1, SwappedInstance, true)
+			&& SwappedInstance.GetLocation().Equals(LastUnitTransform.GetLocation()));
+		TestEqual(TEXT("A swap-remove uploads only the swapped transform"), VisualSystem->GetInstancedMeshTransformUpdateCount(), 1);
+		TestEqual(TEXT("A swap-remove uploads only the swapped custom data"), VisualSystem->GetInstancedMeshCustomDataUpdateCount(), 1);
 	}
 
 	Spawner->DestroySpawnedUnits();
 	TestEqual(TEXT("Quick-start cleanup destroys only its owned Mass units"), UnitManager->GetUnitCount(), 0);
+	TestFalse(TEXT("Destroyed units release their render slots"),
+		UnitManager->GetRenderSlotOwners().ContainsByPredicate([](const FMassUnitEntityHandle& Owner) { return Owner.IsValid(); }));
 	VisualSystem->UpdateUnitVisualsByHandles(Spawner->GetValidSpawnedUnits());
 	TestTrue(TEXT("Quick-start cleanup removes instanced fallback slots"),
 		VisualSystem->IsUsingNiagara() || VisualSystem->GetInstancedMeshInstanceCount() == 0);
@@ -561,4 +733,1565 @@ bool FMassUnitNativeLifecycleTest::RunTest(const FString& Parameters)
 	return true;
 }
 
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FMassUnitCrowdSpatialHashTest,
+	"MassUnitSystem.Crowd.SpatialHash",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMassUnitCrowdSpatialHashTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 EntryCount = 32;
+	constexpr float CellSize = 100.0f;
+	FMassUnitCrowdSpatialHash SpatialHash;
+	SpatialHash.Initialize(CellSize);
+	for (int32 Index = 0; Index < EntryCount; ++Index)
+	{
+		SpatialHash.Add(FMassUnitEntityHandle(Index + 1, 1), 0, FVector(0.0f, Index * CellSize, 0.0f), false);
+	}
+
+	// Every entry crosses into a fresh cell each step, so the table sees
+	// thousands of distinct cells while only EntryCount of them stay live.
+	int32 PeakCapacity = SpatialHash.GetCellTableCapacity();
+	for (int32 Step = 1; Step <= 2000; ++Step)
+	{
+		for (int32 Index = 0; Index < EntryCount; ++Index)
+		{
+			SpatialHash.UpdateLocation(Index, FVector(Step * CellSize, Index * CellSize, 0.0f));
+		}
+		PeakCapacity = FMath::Max(PeakCapacity, SpatialHash.GetCellTableCapacity());
+	}
+	TestTrue(TEXT("A drifting crowd keeps the cell table sized to its live cells"),
+		PeakCapacity <= static_cast<int32>(FMath::RoundUpToPowerOfTwo((EntryCount + 1) * 4)));
+
+	int32 Visited = 0;
+	SpatialHash.ForEachInRadius(FVector(2000.0f * CellSize, 0.0f, 0.0f), CellSize * 0.5f, false,
+		[&Visited](int32, const FMassUnitCrowdSpatialHash::FEntry& Entry) { Visited += Entry.Cell.Y <= 1 ? 1 : 0; });
+	TestEqual(TEXT("Radius queries still find entries after many table rebuilds"), Visited, 2);
+
+	TestTrue(TEXT("An entry can be removed from the middle of the dense array"),
+		SpatialHash.Remove(FMassUnitEntityHandle(1, 1)));
+	const int32 MovedIndex = SpatialHash.FindEntryIndex(FMassUnitEntityHandle(EntryCount, 1));
+	TestEqual(TEXT("Removal swaps the last entry into the freed index"), MovedIndex, 0);
+	Visited = 0;
+	SpatialHash.ForEachInRadius(SpatialHash.GetEntry(MovedIndex).Location, CellSize * 0.5f, false,
+		[&Visited, MovedIndex](int32 EntryIndex, const FMassUnitCrowdSpatialHash::FEntry&) { Visited += EntryIndex == MovedIndex ? 1 : 0; });
+	TestEqual(TEXT("The swapped entry stays linked into its cell"), Visited, 1);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FMassUnitReciprocalAvoidanceTest,
+	"MassUnitSystem.Crowd.ReciprocalAvoidance",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMassUnitReciprocalAvoidanceTest::RunTest(const FString& Parameters)
+{
+	FTestWorldWrapper TestWorld;
+	if (!TestTrue(TEXT("A transient game world can be created"), TestWorld.CreateTestWorld(EWorldType::Game)))
+	{
+		return false;
+	}
+	UWorld* World = TestWorld.GetTestWorld();
+	UMassUnitSubsystem* UnitSubsystem = World ? World->GetSubsystem<UMassUnitSubsystem>() : nullptr;
+	if (!TestNotNull(TEXT("Mass Unit world subsystem initializes automatically"), UnitSubsystem))
+	{
+		return false;
+	}
+	UMassUnitEntityManager* UnitManager = UnitSubsystem->GetUnitManager();
+	UMassUnitCrowdSystem* CrowdSystem = UnitSubsystem->GetCrowdSystem();
+	FMassEntityManager& EntityManager = UnitSubsystem->GetEntitySubsystem()->GetMutableEntityManager();
+
+	// Two units walk head-on through each other's start, offset slightly so the solver has a side to pick.
+	UUnitTemplate* Template = NewObject<UUnitTemplate>(GetTransientPackage());
+	Template->MoveSpeed = 300.0f;
+	const FVector StartA(-600.0f, 10.0f, 0.0f);
+	const FVector StartB(600.0f, -10.0f, 0.0f);
+	const TArray<FMassUnitHandle> Units = {
+		UnitManager->CreateUnitFromTemplate(Template, FTransform(StartA)),
+		UnitManager->CreateUnitFromTemplate(Template, FTransform(StartB))};
+
+	FMassUnitCrowdConfig Config;
+	Config.AvoidanceMode = EMassUnitCrowdAvoidanceMode::ORCA;
+	Config.AvoidanceTimeHorizon = 2.0f;
+	Config.AvoidanceNeighborDistance = 600.0f;
+	Config.MinMoveSpeedMultiplier = 1.0f;
+	Config.MaxMoveSpeedMultiplier = 1.0f;
+	Config.bEnableSeparation = false;
+	Config.bEnableInteractions = false;
+	Config.MaxSimulationDistance = 0.0f;
+	const int32 GroupHandle = CrowdSystem->RegisterCrowdGroup(Units, FVector::ZeroVector, Config, false, 10.0f);
+	TestTrue(TEXT("ORCA crowd group registers"), GroupHandle != INDEX_NONE);
+	bool bAllUseAvoidance = true;
+	for (const FMassUnitHandle& Unit : Units)
+	{
+		const FMassUnitCrowdFragment* Crowd = EntityManager.GetFragmentDataPtr<FMassUnitCrowdFragment>(Unit.EntityHandle.ToMassEntityHandle());
+		bAllUseAvoidance &= Crowd && Crowd->bEnabled && Crowd->bUseReciprocalAvoidance
+			&& FMath::IsNearlyEqual(Crowd->AvoidanceAgentRadius, Config.AvoidanceAgentRadius);
+	}
+	TestTrue(TEXT("ORCA groups opt their members into reciprocal avoidance"), bAllUseAvoidance);
+	UnitManager->SetUnitDestination(Units[0], StartB, 10.0f);
+	UnitManager->SetUnitDestination(Units[1], StartA, 10.0f);
+
+	UMassUnitAvoidanceProcessor* AvoidanceProcessor = NewObject<UMassUnitAvoidanceProcessor>(GetTransientPackage());
+	AvoidanceProcessor->CallInitialize(World, EntityManager.AsShared());
+	UMassUnitMovementProcessor* MovementProcessor = NewObject<UMassUnitMovementProcessor>(GetTransientPackage());
+	MovementProcessor->CallInitialize(World, EntityManager.AsShared());
+	float MinDistance = TNumericLimits<float>::Max();
+	bool bSolvedVelocity = false;
+	FTransform TransformA;
+	FTransform TransformB;
+	for (int32 Step = 0; Step < 60; ++Step)
+	{
+		FMassExecutionContext AvoidanceContext(EntityManager, 0.1f);
+		AvoidanceContext.SetExecutionType(EMassExecutionContextType::Processor);
+		AvoidanceProcessor->CallExecute(EntityManager, AvoidanceContext);
+		const FMassUnitCrowdFragment* Crowd = EntityManager.GetFragmentDataPtr<FMassUnitCrowdFragment>(Units[0].EntityHandle.ToMassEntityHandle());
+		bSolvedVelocity |= Crowd && Crowd->bHasAvoidanceVelocity;
+
+		FMassExecutionContext MovementContext(EntityManager, 0.1f);
+		MovementContext.SetExecutionType(EMassExecutionContextType::Processor);
+		MovementProcessor->CallExecute(EntityManager, MovementContext);
+		UnitManager->GetUnitTransform(Units[0], TransformA);
+		UnitManager->GetUnitTransform(Units[1], TransformB);
+		MinDistance = FMath::Min(MinDistance, static_cast<float>(FVector::Dist2D(TransformA.GetLocation(), TransformB.GetLocation())));
+	}
+	TestTrue(TEXT("The avoidance processor solves a velocity for units with a destination"), bSolvedVelocity);
+	TestTrue(TEXT("Head-on units keep about their combined radius apart"), MinDistance >= 2.0f * Config.AvoidanceAgentRadius * 0.9f);
+	TestTrue(TEXT("Both units pass each other instead of deadlocking"),
+		TransformA.GetLocation().X > 400.0f && TransformB.GetLocation().X < -400.0f);
+	TestTrue(TEXT("ORCA group unregisters cleanly"), CrowdSystem->UnregisterCrowdGroup(GroupHandle, true));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FMassUnitCrowdParallelDecisionTest,
+	"MassUnitSystem.Crowd.ParallelDecisions",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMassUnitCrowdParallelDecisionTest::RunTest(const FString& Parameters)
+{
+	/** What one crowd decision left on a unit. */
+	struct FDecisionOutcome
+	{
+		FMassUnitEntityHandle Entity;
+		FMassUnitEntityHandle InteractionPartner;
+		FVector TargetLocation = FVector::ZeroVector;
+		FVector SteeringDirection = FVector::ZeroVector;
+		EMassUnitState State = EMassUnitState::Idle;
+		bool bHasTargetLocation = false;
+	};
+
+	// The same crowd is decided twice, once across workers and once on the game thread.
+	TArray<FDecisionOutcome> Outcomes[2];
+	int32 InteractionsStarted[2] = {0, 0};
+	UMassUnitSystemSettings* MutableSettings = GetMutableDefault<UMassUnitSystemSettings>();
+	for (int32 Run = 0; Run < 2; ++Run)
+	{
+		TGuardValue<bool> ParallelGuard(MutableSettings->bParallelCrowdDecisions, Run == 0);
+		FTestWorldWrapper TestWorld;
+		if (!TestTrue(TEXT("A transient game world can be created"), TestWorld.CreateTestWorld(EWorldType::Game)))
+		{
+			return false;
+		}
+		UWorld* World = TestWorld.GetTestWorld();
+		UMassUnitSubsystem* UnitSubsystem = World ? World->GetSubsystem<UMassUnitSubsystem>() : nullptr;
+		if (!TestNotNull(TEXT("Mass Unit world subsystem initializes automatically"), UnitSubsystem))
+		{
+			return false;
+		}
+		UMassUnitEntityManager* UnitManager = UnitSubsystem->GetUnitManager();
+		UMassUnitCrowdSystem* CrowdSystem = UnitSubsystem->GetCrowdSystem();
+		FMassEntityManager& EntityManager = UnitSubsystem->GetEntitySubsystem()->GetMutableEntityManager();
+
+		// Dense enough for separation and partner searches to see neighbors, and
+		// large enough that the decide phase leaves the game thread when allowed.
+		UUnitTemplate* Template = NewObject<UUnitTemplate>(GetTransientPackage());
+		TArray<FMassUnitHandle> Units;
+		for (int32 Index = 0; Index < 160; ++Index)
+		{
+			Units.Add(UnitManager->CreateUnitFromTemplate(Template, FTransform(FVector((Index % 16) * 150.0f, (Index / 16) * 150.0f, 0.0f))));
+		}
+		FMassUnitCrowdConfig Config;
+		Config.WanderRadius = 2000.0f;
+		Config.MinWanderDistance = 100.0f;
+		Config.bEnableSeparation = true;
+		Config.bEnableInteractions = true;
+		Config.InteractionChance = 0.5f;
+		Config.InteractionRadius = 300.0f;
+		Config.MaxSimulationDistance = 0.0f;
+		Config.RandomSeed = 1357;
+		const int32 GroupHandle = CrowdSystem->RegisterCrowdGroup(Units, FVector(1200.0f, 750.0f, 0.0f), Config, false, 25.0f);
+		TestTrue(TEXT("The crowd group registers"), GroupHandle != INDEX_NONE);
+		InteractionsStarted[Run] = CrowdSystem->GetCrowdStats().InteractionsStarted;
+		TestTrue(TEXT("A second forced decision runs"), CrowdSystem->ForceCrowdGroupUpdate(GroupHandle));
+		InteractionsStarted[Run] += CrowdSystem->GetCrowdStats().InteractionsStarted;
+
+		for (const FMassUnitHandle& Unit : Units)
+		{
+			const FMassEntityHandle Entity = Unit.EntityHandle.ToMassEntityHandle();
+			const FMassUnitCrowdFragment* Crowd = EntityManager.GetFragmentDataPtr<FMassUnitCrowdFragment>(Entity);
+			const FMassUnitTargetFragment* Target = EntityManager.GetFragmentDataPtr<FMassUnitTargetFragment>(Entity);
+			const FMassUnitStateFragment* State = EntityManager.GetFragmentDataPtr<FMassUnitStateFragment>(Entity);
+			FDecisionOutcome& Outcome = Outcomes[Run].AddDefaulted_GetRef();
+			Outcome.Entity = Unit.EntityHandle;
+			if (Crowd && Target && State)
+			{
+				Outcome.InteractionPartner = Crowd->InteractionPartner;
+				Outcome.TargetLocation = Target->TargetLocation;
+				Outcome.SteeringDirection = Crowd->SteeringDirection;
+				Outcome.State = State->CurrentState;
+				Outcome.bHasTargetLocation = Target->bHasTargetLocation;
+			}
+		}
+		CrowdSystem->UnregisterCrowdGroup(GroupHandle, true);
+	}
+
+	TestTrue(TEXT("Crowd decisions start interactions"), InteractionsStarted[0] > 0);
+	TestEqual(TEXT("Parallel and game-thread decisions start the same interactions"), InteractionsStarted[0], InteractionsStarted[1]);
+	if (!TestEqual(TEXT("Both runs decide every unit"), Outcomes[0].Num(), Outcomes[1].Num()))
+	{
+		return false;
+	}
+	int32 Mismatches = 0;
+	for (int32 Index = 0; Index < Outcomes[0].Num(); ++Index)
+	{
+		const FDecisionOutcome& Parallel = Outcomes[0][Index];
+		const FDecisionOutcome& Serial = Outcomes[1][Index];
+		// Streams are seeded per entity, so both worlds must hand out the same handles.
+		if (!TestTrue(TEXT("Both worlds allocate the same entity handles"), Parallel.Entity == Serial.Entity))
+		{
+			return false;
+		}
+		const bool bSame = Parallel.InteractionPartner == Serial.InteractionPartner
+			&& Parallel.State == Serial.State
+			&& Parallel.bHasTargetLocation == Serial.bHasTargetLocation
+			&& Parallel.TargetLocation.Equals(Serial.TargetLocation, UE_KINDA_SMALL_NUMBER)
+			&& Parallel.SteeringDirection.Equals(Serial.SteeringDirection, UE_KINDA_SMALL_NUMBER);
+		Mismatches += bSame ? 0 : 1;
+	}
+	TestEqual(TEXT("Parallel decisions leave every unit exactly as game-thread decisions do"), Mismatches, 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FMassUnitCrowdUpdateBudgetTest,
+	"MassUnitSystem.Crowd.UpdateBudget",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMassUnitCrowdUpdateBudgetTest::RunTest(const FString& Parameters)
+{
+	// A budget too small for more than the first decision batch, which always runs.
+	UMassUnitSystemSettings* MutableSettings = GetMutableDefault<UMassUnitSystemSettings>();
+	TGuardValue<float> BudgetGuard(MutableSettings->CrowdUpdateBudgetMs, 0.001f);
+	TGuardValue<int32> UnitCapGuard(MutableSettings->MaxCrowdUnitsPerUpdate, 2000);
+	TGuardValue<float> IntervalGuard(MutableSettings->CrowdUpdateInterval, 0.1f);
+
+	FTestWorldWrapper TestWorld;
+	if (!TestTrue(TEXT("A transient game world can be created"), TestWorld.CreateTestWorld(EWorldType::Game)))
+	{
+		return false;
+	}
+	UWorld* World = TestWorld.GetTestWorld();
+	UMassUnitSubsystem* UnitSubsystem = World ? World->GetSubsystem<UMassUnitSubsystem>() : nullptr;
+	if (!TestNotNull(TEXT("Mass Unit world subsystem initializes automatically"), UnitSubsystem))
+	{
+		return false;
+	}
+	UMassUnitEntityManager* UnitManager = UnitSubsystem->GetUnitManager();
+	UMassUnitCrowdSystem* CrowdSystem = UnitSubsystem->GetCrowdSystem();
+	FMassEntityManager& EntityManager = UnitSubsystem->GetEntitySubsystem()->GetMutableEntityManager();
+
+	UUnitTemplate* Template = NewObject<UUnitTemplate>(GetTransientPackage());
+	TArray<FMassUnitHandle> Units;
+	for (int32 Index = 0; Index < 600; ++Index)
+	{
+		Units.Add(UnitManager->CreateUnitFromTemplate(Template, FTransform(FVector((Index % 30) * 100.0f, (Index / 30) * 100.0f, 0.0f))));
+	}
+	FMassUnitCrowdConfig Config;
+	Config.WanderRadius = 5000.0f;
+	Config.MinWanderDistance = 1000.0f;
+	Config.MaxMoveTime = 60.0f;
+	Config.bEnableSeparation = false;
+	Config.bEnableInteractions = false;
+	Config.MaxSimulationDistance = 0.0f;
+	const int32 GroupHandle = CrowdSystem->RegisterCrowdGroup(Units, FVector(1500.0f, 1000.0f, 0.0f), Config, false, 25.0f);
+	if (!TestTrue(TEXT("The crowd group registers"), GroupHandle != INDEX_NONE))
+	{
+		return false;
+	}
+
+	UMassUnitCrowdProcessor* CrowdProcessor = NewObject<UMassUnitCrowdProcessor>(GetTransientPackage());
+	CrowdProcessor->CallInitialize(World, EntityManager.AsShared());
+	auto GetSteeringTime = [&EntityManager](const FMassUnitHandle& Unit)
+	{
+		const FMassUnitCrowdFragment* Crowd = EntityManager.GetFragmentDataPtr<FMassUnitCrowdFragment>(Unit.EntityHandle.ToMassEntityHandle());
+		return Crowd ? Crowd->NextSteeringUpdateTime : 0.0f;
+	};
+	// Runs one due crowd update at Time and returns the indices of the units it served.
+	auto RunCrowdUpdate = [&](float Time)
+	{
+		TArray<float> SteeringTimes;
+		for (const FMassUnitHandle& Unit : Units)
+		{
+			SteeringTimes.Add(GetSteeringTime(Unit));
+		}
+		World->TimeSeconds = Time;
+		FMassExecutionContext CrowdContext(EntityManager, 0.1f);
+		CrowdContext.SetExecutionType(EMassExecutionContextType::Processor);
+		CrowdProcessor->CallExecute(EntityManager, CrowdContext);
+		TSet<int32> Served;
+		for (int32 Index = 0; Index < Units.Num(); ++Index)
+		{
+			if (GetSteeringTime(Units[Index]) != SteeringTimes[Index])
+			{
+				Served.Add(Index);
+			}
+		}
+		return Served;
+	};
+
+	// Every unit is overdue by the same amount; only the first batch fits the budget.
+	const TSet<int32> FirstServed = RunCrowdUpdate(1.0f);
+	const FMassUnitCrowdStats FirstStats = CrowdSystem->GetCrowdStats();
+	TestTrue(TEXT("An exhausted budget stops the update after its first batch"),
+		FirstStats.UnitsUpdated > 0 && FirstStats.UnitsUpdated < Units.Num());
+	TestEqual(TEXT("Units past the budget are reported as deferred"), FirstStats.UnitsDeferred, Units.Num() - FirstStats.UnitsUpdated);
+	TestEqual(TEXT("Only the served prefix receives new steering"), FirstServed.Num(), FirstStats.UnitsUpdated);
+
+	// Deferred units stay overdue and now outrank the units served a frame ago.
+	const TSet<int32> SecondServed = RunCrowdUpdate(1.1f);
+	TestTrue(TEXT("The next update serves units again"), SecondServed.Num() > 0);
+	TestTrue(TEXT("Deferred units are served before units that were just updated"),
+		SecondServed.Intersect(FirstServed).IsEmpty());
+
+	// Continued saturation still reaches every unit instead of starving any.
+	TSet<int32> AllServed = FirstServed.Union(SecondServed);
+	for (int32 Update = 2; Update < 8 && AllServed.Num() < Units.Num(); ++Update)
+	{
+		AllServed.Append(RunCrowdUpdate(1.0f + Update * 0.1f));
+	}
+	TestEqual(TEXT("A saturated budget still reaches every unit"), AllServed.Num(), Units.Num());
+	TestTrue(TEXT("The crowd group unregisters cleanly"), CrowdSystem->UnregisterCrowdGroup(GroupHandle, true));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FMassUnitCrowdDormantUnitsTest,
+	"MassUnitSystem.Crowd.DormantUnits",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMassUnitCrowdDormantUnitsTest::RunTest(const FString& Parameters)
+{
+	UMassUnitSystemSettings* MutableSettings = GetMutableDefault<UMassUnitSystemSettings>();
+	TGuardValue<float> IntervalGuard(MutableSettings->CrowdUpdateInterval, 0.1f);
+
+	FTestWorldWrapper TestWorld;
+	if (!TestTrue(TEXT("A transient game world can be created"), TestWorld.CreateTestWorld(EWorldType::Game)))
+	{
+		return false;
+	}
+	UWorld* World = TestWorld.GetTestWorld();
+	UMassUnitSubsystem* UnitSubsystem = World ? World->GetSubsystem<UMassUnitSubsystem>() : nullptr;
+	if (!TestNotNull(TEXT("Mass Unit world subsystem initializes automatically"), UnitSubsystem))
+	{
+		return false;
+	}
+	UMassUnitEntityManager* UnitManager = UnitSubsystem->GetUnitManager();
+	UMassUnitCrowdSystem* CrowdSystem = UnitSubsystem->GetCrowdSystem();
+	FMassEntityManager& EntityManager = UnitSubsystem->GetEntitySubsystem()->GetMutableEntityManager();
+
+	// A possessed pawn is the observer that puts distant crowds to sleep.
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	APlayerController* Controller = World->SpawnActor<APlayerController>(APlayerController::StaticClass(), FTransform::Identity, SpawnParameters);
+	ADefaultPawn* Observer = World->SpawnActor<ADefaultPawn>(ADefaultPawn::StaticClass(), FTransform::Identity, SpawnParameters);
+	if (!TestNotNull(TEXT("An observer can be spawned"), Controller) || !TestNotNull(TEXT("An observer pawn can be spawned"), Observer))
+	{
+		return false;
+	}
+	Controller->Possess(Observer);
+
+	UUnitTemplate* Template = NewObject<UUnitTemplate>(GetTransientPackage());
+	TArray<FMassUnitHandle> Units;
+	for (int32 Index = 0; Index < 20; ++Index)
+	{
+		Units.Add(UnitManager->CreateUnitFromTemplate(Template, FTransform(FVector(20000.0f + (Index % 5) * 100.0f, (Index / 5) * 100.0f, 0.0f))));
+	}
+	FMassUnitCrowdConfig Config;
+	Config.WanderRadius = 500.0f;
+	Config.bEnableSeparation = true;
+	Config.bEnableInteractions = false;
+	Config.MaxSimulationDistance = 5000.0f;
+	const int32 GroupHandle = CrowdSystem->RegisterCrowdGroup(Units, FVector(20200.0f, 150.0f, 0.0f), Config, false, 25.0f);
+	if (!TestTrue(TEXT("The crowd group registers"), GroupHandle != INDEX_NONE))
+	{
+		return false;
+	}
+	auto CountSleeping = [&EntityManager, &Units]()
+	{
+		int32 Sleeping = 0;
+		for (const FMassUnitHandle& Unit : Units)
+		{
+			const FMassUnitCrowdFragment* Crowd = EntityManager.GetFragmentDataPtr<FMassUnitCrowdFragment>(Unit.EntityHandle.ToMassEntityHandle());
+			Sleeping += Crowd && Crowd->bSleeping ? 1 : 0;
+		}
+		return Sleeping;
+	};
+
+	FMassUnitCrowdStats Stats = CrowdSystem->GetCrowdStats();
+	TestEqual(TEXT("Units beyond the simulation distance fall asleep"), CountSleeping(), Units.Num());
+	TestEqual(TEXT("Sleeping units leave the active spatial hash"), Stats.ActiveUnits, 0);
+	TestEqual(TEXT("Sleeping units are parked in the dormant grid"), Stats.SleepingUnits, Units.Num());
+	TestTrue(TEXT("The dormant grid reports its occupied cells"), Stats.DormantCells > 0);
+	TestEqual(TEXT("Sleeping units are still registered"), Stats.RegisteredUnits, Units.Num());
+
+	UMassUnitCrowdProcessor* CrowdProcessor = NewObject<UMassUnitCrowdProcessor>(GetTransientPackage());
+	CrowdProcessor->CallInitialize(World, EntityManager.AsShared());
+	auto RunCrowdUpdate = [&]()
+	{
+		FMassExecutionContext CrowdContext(EntityManager, 0.1f);
+		CrowdContext.SetExecutionType(EMassExecutionContextType::Processor);
+		CrowdProcessor->CallExecute(EntityManager, CrowdContext);
+		return CrowdSystem->GetCrowdStats();
+	};
+	Stats = RunCrowdUpdate();
+	TestEqual(TEXT("A crowd update does no per-unit work for a sleeping crowd"), Stats.UnitsUpdated, 0);
+	TestEqual(TEXT("A distant observer wakes nobody"), Stats.UnitsWoken, 0);
+
+	// Walking the observer up to the crowd wakes its dormant cell.
+	Observer->SetActorLocation(FVector(19000.0f, 0.0f, 0.0f));
+	Stats = RunCrowdUpdate();
+	TestEqual(TEXT("An approaching observer wakes the dormant units"), Stats.UnitsWoken, Units.Num());
+	TestEqual(TEXT("Woken units clear their sleep flag"), CountSleeping(), 0);
+	TestEqual(TEXT("Woken units rejoin the active spatial hash"), Stats.ActiveUnits, Units.Num());
+	TestEqual(TEXT("No unit is left in the dormant grid"), Stats.SleepingUnits, 0);
+	TestEqual(TEXT("The dormant grid is empty once every unit wakes"), Stats.DormantCells, 0);
+	TestTrue(TEXT("Woken units are scheduled again"), Stats.UnitsUpdated > 0);
+	TestTrue(TEXT("The crowd group unregisters cleanly"), CrowdSystem->UnregisterCrowdGroup(GroupHandle, true));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FMassUnitCrowdNeighborListTest,
+	"MassUnitSystem.Crowd.NeighborLists",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMassUnitCrowdNeighborListTest::RunTest(const FString& Parameters)
+{
+	FTestWorldWrapper TestWorld;
+	if (!TestTrue(TEXT("A transient game world can be created"), TestWorld.CreateTestWorld(EWorldType::Game)))
+	{
+		return false;
+	}
+	UWorld* World = TestWorld.GetTestWorld();
+	UMassUnitSubsystem* UnitSubsystem = World ? World->GetSubsystem<UMassUnitSubsystem>() : nullptr;
+	if (!TestNotNull(TEXT("Mass Unit world subsystem initializes automatically"), UnitSubsystem))
+	{
+		return false;
+	}
+	UMassUnitEntityManager* UnitManager = UnitSubsystem->GetUnitManager();
+	UMassUnitCrowdSystem* CrowdSystem = UnitSubsystem->GetCrowdSystem();
+	FMassEntityManager& EntityManager = UnitSubsystem->GetEntitySubsystem()->GetMutableEntityManager();
+
+	UUnitTemplate* Template = NewObject<UUnitTemplate>(GetTransientPackage());
+	TArray<FMassUnitHandle> Units;
+	for (int32 Index = 0; Index < 16; ++Index)
+	{
+		Units.Add(UnitManager->CreateUnitFromTemplate(Template, FTransform(FVector((Index % 4) * 100.0f, (Index / 4) * 100.0f, 0.0f))));
+	}
+	FMassUnitCrowdConfig Config;
+	Config.WanderRadius = 500.0f;
+	Config.bEnableSeparation = true;
+	Config.SeparationRadius = 140.0f;
+	Config.NeighborListSkin = 100.0f;
+	Config.bEnableInteractions = false;
+	Config.MaxSimulationDistance = 0.0f;
+	const int32 GroupHandle = CrowdSystem->RegisterCrowdGroup(Units, FVector(150.0f, 150.0f, 0.0f), Config, false, 25.0f);
+	if (!TestTrue(TEXT("The crowd group registers"), GroupHandle != INDEX_NONE))
+	{
+		return false;
+	}
+	TestEqual(TEXT("The first separation pass builds a neighbor list per unit"),
+		CrowdSystem->GetCrowdStats().NeighborListsRebuilt, Units.Num());
+	const int32 RebuildChecks = CrowdSystem->GetCrowdStats().NeighborChecks;
+
+	auto MoveUnit = [&EntityManager](const FMassUnitHandle& Unit, const FVector& Offset)
+	{
+		if (FMassUnitTransformFragment* Transform = EntityManager.GetFragmentDataPtr<FMassUnitTransformFragment>(Unit.EntityHandle.ToMassEntityHandle()))
+		{
+			Transform->GetMutableTransform().AddToTranslation(Offset);
+		}
+	};
+
+	// Nobody moved, so every cached list is still exact.
+	CrowdSystem->ForceCrowdGroupUpdate(GroupHandle);
+	TestEqual(TEXT("Stationary units reuse their neighbor lists"), CrowdSystem->GetCrowdStats().NeighborListsRebuilt, 0);
+	TestTrue(TEXT("Reused lists skip the spatial-hash cell scan"), CrowdSystem->GetCrowdStats().NeighborChecks < RebuildChecks);
+
+	// One unit moves less than the skin; the group's neighbor clock advances by the same step.
+	MoveUnit(Units[5], FVector(30.0f, 0.0f, 0.0f));
+	CrowdSystem->ForceCrowdGroupUpdate(GroupHandle);
+	TestEqual(TEXT("Moves within the skin keep every list"), CrowdSystem->GetCrowdStats().NeighborListsRebuilt, 0);
+
+	// A second move brings the accumulated displacement past the skin.
+	MoveUnit(Units[5], FVector(80.0f, 0.0f, 0.0f));
+	CrowdSystem->ForceCrowdGroupUpdate(GroupHandle);
+	TestEqual(TEXT("Moves that add up past the skin rebuild every list"),
+		CrowdSystem->GetCrowdStats().NeighborListsRebuilt, Units.Num());
+	TestTrue(TEXT("The crowd group unregisters cleanly"), CrowdSystem->UnregisterCrowdGroup(GroupHandle, true));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FMassUnitCrowdGroupAggregateTest,
+	"MassUnitSystem.Crowd.GroupAggregates",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMassUnitCrowdGroupAggregateTest::RunTest(const FString& Parameters)
+{
+	FTestWorldWrapper TestWorld;
+	if (!TestTrue(TEXT("A transient game world can be created"), TestWorld.CreateTestWorld(EWorldType::Game)))
+	{
+		return false;
+	}
+	UWorld* World = TestWorld.GetTestWorld();
+	UMassUnitSubsystem* UnitSubsystem = World ? World->GetSubsystem<UMassUnitSubsystem>() : nullptr;
+	if (!TestNotNull(TEXT("Mass Unit world subsystem initializes automatically"), UnitSubsystem))
+	{
+		return false;
+	}
+	UMassUnitEntityManager* UnitManager = UnitSubsystem->GetUnitManager();
+	UMassUnitCrowdSystem* CrowdSystem = UnitSubsystem->GetCrowdSystem();
+	FMassEntityManager& EntityManager = UnitSubsystem->GetEntitySubsystem()->GetMutableEntityManager();
+
+	UUnitTemplate* Template = NewObject<UUnitTemplate>(GetTransientPackage());
+	const float UnitX[] = { 0.0f, 100.0f, 200.0f, 300.0f, 1000.0f };
+	TArray<FMassUnitHandle> Units;
+	for (const float X : UnitX)
+	{
+		Units.Add(UnitManager->CreateUnitFromTemplate(Template, FTransform(FVector(X, 0.0f, 0.0f))));
+	}
+	FMassUnitCrowdConfig Config;
+	Config.WanderRadius = 50.0f;
+	Config.bEnableInteractions = false;
+	Config.MaxSimulationDistance = 0.0f;
+	const int32 GroupHandle = CrowdSystem->RegisterCrowdGroup(Units, FVector(320.0f, 0.0f, 0.0f), Config, false, 25.0f);
+	if (!TestTrue(TEXT("The crowd group registers"), GroupHandle != INDEX_NONE))
+	{
+		return false;
+	}
+
+	FVector Centroid;
+	FBox Bounds;
+	TestTrue(TEXT("A living group reports its aggregates"), CrowdSystem->GetCrowdGroupLivingBounds(GroupHandle, Centroid, Bounds));
+	TestEqual(TEXT("The centroid averages every living member"), Centroid.X, 320.0, 1.0);
+	TestEqual(TEXT("The bounds start at the westmost member"), Bounds.Min.X, 0.0, 1.0);
+	TestEqual(TEXT("The bounds end at the eastmost member"), Bounds.Max.X, 1000.0, 1.0);
+
+	auto KillUnit = [&EntityManager](const FMassUnitHandle& Unit)
+	{
+		if (FMassUnitStateFragment* State = EntityManager.GetFragmentDataPtr<FMassUnitStateFragment>(Unit.EntityHandle.ToMassEntityHandle()))
+		{
+			State->CurrentState = EMassUnitState::Dead;
+		}
+	};
+
+	// Killing both outliers must pull the centroid in and shrink the bounds to the survivors.
+	KillUnit(Units[0]);
+	KillUnit(Units[4]);
+	CrowdSystem->ForceCrowdGroupUpdate(GroupHandle);
+	TestTrue(TEXT("Survivors keep the group's aggregates valid"), CrowdSystem->GetCrowdGroupLivingBounds(GroupHandle, Centroid, Bounds));
+	TestEqual(TEXT("The centroid averages only the survivors"), Centroid.X, 200.0, 1.0);
+	TestEqual(TEXT("The bounds drop the dead westmost member"), Bounds.Min.X, 100.0, 1.0);
+	TestEqual(TEXT("The bounds drop the dead eastmost member"), Bounds.Max.X, 300.0, 1.0);
+	TestEqual(TEXT("Dead members stay registered"), CrowdSystem->GetCrowdGroupUnitCount(GroupHandle), Units.Num());
+
+	for (const FMassUnitHandle& Unit : Units)
+	{
+		KillUnit(Unit);
+	}
+	CrowdSystem->ForceCrowdGroupUpdate(GroupHandle);
+	TestFalse(TEXT("A group with no survivors reports no aggregates"), CrowdSystem->GetCrowdGroupLivingBounds(GroupHandle, Centroid, Bounds));
+	TestTrue(TEXT("The crowd group unregisters cleanly"), CrowdSystem->UnregisterCrowdGroup(GroupHandle, true));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FMassUnitCrowdWanderPoolTest,
+	"MassUnitSystem.Crowd.WanderPools",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMassUnitCrowdWanderPoolTest::RunTest(const FString& Parameters)
+{
+	FTestWorldWrapper TestWorld;
+	if (!TestTrue(TEXT("A transient game world can be created"), TestWorld.CreateTestWorld(EWorldType::Game)))
+	{
+		return false;
+	}
+	UWorld* World = TestWorld.GetTestWorld();
+	UMassUnitSubsystem* UnitSubsystem = World ? World->GetSubsystem<UMassUnitSubsystem>() : nullptr;
+	if (!TestNotNull(TEXT("Mass Unit world subsystem initializes automatically"), UnitSubsystem))
+	{
+		return false;
+	}
+
+	SpawnNavigationBox(World, FVector(0.0f, 0.0f, -50.0f), FVector(4000.0f, 4000.0f, 100.0f));
+	ARecastNavMesh* NavMesh = BuildTestNavMesh(World, FBox(FVector(-1900.0f, -1900.0f, -500.0f), FVector(1900.0f, 1900.0f, 500.0f)));
+	if (!TestNotNull(TEXT("A navmesh can be built in the test world"), NavMesh))
+	{
+		return false;
+	}
+	UnitSubsystem->GetNavigationSystem()->UpdateNavigationData(World);
+
+	UMassUnitEntityManager* UnitManager = UnitSubsystem->GetUnitManager();
+	UMassUnitCrowdSystem* CrowdSystem = UnitSubsystem->GetCrowdSystem();
+	FMassEntityManager& EntityManager = UnitSubsystem->GetEntitySubsystem()->GetMutableEntityManager();
+	UUnitTemplate* Template = NewObject<UUnitTemplate>(GetTransientPackage());
+	TArray<FMassUnitHandle> Units;
+	Units.Add(UnitManager->CreateUnitFromTemplate(Template, FTransform(FVector(0.0f, 0.0f, 20.0f))));
+
+	constexpr float WanderRadius = 1000.0f;
+	constexpr int32 PoolSize = 48;
+	FMassUnitCrowdConfig Config;
+	Config.WanderRadius = WanderRadius;
+	Config.WanderPointPoolSize = PoolSize;
+	Config.bEnableManagedSubgroups = false;
+	Config.bEnableInteractions = false;
+	Config.MaxSimulationDistance = 0.0f;
+	const int32 GroupHandle = CrowdSystem->RegisterCrowdGroup(Units, FVector::ZeroVector, Config, true, 50.0f);
+	if (!TestTrue(TEXT("The crowd group registers"), GroupHandle != INDEX_NONE))
+	{
+		return false;
+	}
+	TestTrue(TEXT("The pool is queued rather than built during registration"),
+		CrowdSystem->GetCrowdSubgroupWanderPoints(GroupHandle, 0).IsEmpty());
+
+	UMassUnitCrowdProcessor* CrowdProcessor = NewObject<UMassUnitCrowdProcessor>(GetTransientPackage());
+	CrowdProcessor->CallInitialize(World, EntityManager.AsShared());
+	FMassExecutionContext CrowdContext(EntityManager, 0.1f);
+	CrowdContext.SetExecutionType(EMassExecutionContextType::Processor);
+	CrowdProcessor->CallExecute(EntityManager, CrowdContext);
+	TestEqual(TEXT("One crowd update finishes a pool that fits the projection budget"), CrowdSystem->GetCrowdStats().WanderPoolsPending, 0);
+
+	const TArray<FVector> WanderPoints = CrowdSystem->GetCrowdSubgroupWanderPoints(GroupHandle, 0);
+	if (!TestTrue(TEXT("The pool projects points onto the open floor"), WanderPoints.Num() > PoolSize / 2))
+	{
+		return false;
+	}
+	TestTrue(TEXT("The pool never exceeds its configured size"), WanderPoints.Num() <= PoolSize);
+
+	// The sampler spaces points so a maximal set fills the disk with about PoolSize points.
+	const float MinSpacing = WanderRadius * FMath::Sqrt(2.0f / static_cast<float>(PoolSize));
+	float ClosestPair = TNumericLimits<float>::Max();
+	float FarthestPoint = 0.0f;
+	for (int32 Index = 0; Index < WanderPoints.Num(); ++Index)
+	{
+		FarthestPoint = FMath::Max(FarthestPoint, static_cast<float>(WanderPoints[Index].Size2D()));
+		for (int32 Other = Index + 1; Other < WanderPoints.Num(); ++Other)
+		{
+			ClosestPair = FMath::Min(ClosestPair, static_cast<float>(FVector::Dist2D(WanderPoints[Index], WanderPoints[Other])));
+		}
+	}
+	TestTrue(TEXT("No two wander points are closer than the minimum spacing"), ClosestPair >= MinSpacing - 1.0f);
+	TestTrue(TEXT("Every wander point stays inside the wander disk"), FarthestPoint <= WanderRadius + 1.0f);
+	TestTrue(TEXT("The crowd group unregisters cleanly"), CrowdSystem->UnregisterCrowdGroup(GroupHandle, true));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FMassUnitPathRequestQueueTest,
+	"MassUnitSystem.Navigation.PathRequestQueue",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMassUnitPathRequestQueueTest::RunTest(const FString& Parameters)
+{
+	UMassUnitSystemSettings* MutableSettings = GetMutableDefault<UMassUnitSystemSettings>();
+	TGuardValue<bool> DirectFallbackGuard(MutableSettings->bFallbackToDirectPath, true);
+
+	FTestWorldWrapper TestWorld;
+	if (!TestTrue(TEXT("A transient game world can be created"), TestWorld.CreateTestWorld(EWorldType::Game)))
+	{
+		return false;
+	}
+	UWorld* World = TestWorld.GetTestWorld();
+	UMassUnitSubsystem* UnitSubsystem = World ? World->GetSubsystem<UMassUnitSubsystem>() : nullptr;
+	if (!TestNotNull(TEXT("Mass Unit world subsystem initializes automatically"), UnitSubsystem))
+	{
+		return false;
+	}
+
+	// Without a navmesh every served request resolves to a direct path, so
+	// the path a unit ends up with shows which of its requests was served.
+	UMassUnitNavigationSystem* Navigation = UnitSubsystem->GetNavigationSystem();
+	UMassUnitEntityManager* UnitManager = UnitSubsystem->GetUnitManager();
+	FMassEntityManager& EntityManager = UnitSubsystem->GetEntitySubsystem()->GetMutableEntityManager();
+	UUnitTemplate* Template = NewObject<UUnitTemplate>(GetTransientPackage());
+	const FMassUnitHandle SupersededUnit = UnitManager->CreateUnitFromTemplate(Template, FTransform(FVector(0.0f, 0.0f, 0.0f)));
+	const FMassUnitHandle CancelledUnit = UnitManager->CreateUnitFromTemplate(Template, FTransform(FVector(0.0f, 300.0f, 0.0f)));
+	const FMassUnitHandle KeptUnit = UnitManager->CreateUnitFromTemplate(Template, FTransform(FVector(0.0f, 600.0f, 0.0f)));
+	auto HasDirectPathTo = [&EntityManager](const FMassUnitHandle& Unit, const FVector& Destination)
+	{
+		const FMassUnitNavigationFragment* Fragment = EntityManager.GetFragmentDataPtr<FMassUnitNavigationFragment>(Unit.EntityHandle.ToMassEntityHandle());
+		return Fragment
+			&& Fragment->bPathValid
+			&& !Fragment->PathPoints.IsEmpty()
+			&& Fragment->PathPoints.Last().Equals(Destination, 1.0f)
+			&& Fragment->DestinationLocation.Equals(Destination, 1.0f);
+	};
+	auto HasNoPath = [&EntityManager](const FMassUnitHandle& Unit)
+	{
+		const FMassUnitNavigationFragment* Fragment = EntityManager.GetFragmentDataPtr<FMassUnitNavigationFragment>(Unit.EntityHandle.ToMassEntityHandle());
+		return Fragment && !Fragment->bPathValid && !Fragment->bPathRequested;
+	};
+
+	Navigation->RequestPath(SupersededUnit, FVector(1000.0f, 0.0f, 0.0f));
+	Navigation->RequestPath(SupersededUnit, FVector(-1000.0f, 0.0f, 0.0f));
+	Navigation->RequestPath(CancelledUnit, FVector(1000.0f, 300.0f, 0.0f));
+	Navigation->CancelPath(CancelledUnit);
+	Navigation->RequestPath(KeptUnit, FVector(1000.0f, 600.0f, 0.0f));
+	TestEqual(TEXT("Each unit holds at most one live request"), Navigation->GetQueuedRequestCount(), 2);
+	TestTrue(TEXT("Queued requests are served"), FlushPathRequests(World, Navigation));
+	TestTrue(TEXT("A newer request supersedes the queued one"), HasDirectPathTo(SupersededUnit, FVector(-1000.0f, 0.0f, 0.0f)));
+	TestTrue(TEXT("A cancelled request is never served"), HasNoPath(CancelledUnit));
+	TestTrue(TEXT("Other units keep their requests"), HasDirectPathTo(KeptUnit, FVector(1000.0f, 600.0f, 0.0f)));
+	TestEqual(TEXT("Served requests leave no heap entries"), Navigation->GetPathRequestHeapSize(), 0);
+
+	// Churn leaves one live request among hundreds of stale tickets.
+	int32 LargestHeap = 0;
+	for (int32 Round = 0; Round < 200; ++Round)
+	{
+		Navigation->RequestPath(SupersededUnit, FVector(static_cast<float>(Round), 0.0f, 0.0f));
+		Navigation->RequestPath(CancelledUnit, FVector(static_cast<float>(Round), 300.0f, 0.0f));
+		Navigation->CancelPath(CancelledUnit);
+		LargestHeap = FMath::Max(LargestHeap, Navigation->GetPathRequestHeapSize());
+	}
+	TestEqual(TEXT("Only the latest request of a superseded unit stays live"), Navigation->GetQueuedRequestCount(), 1);
+	TestTrue(TEXT("Stale heap entries are compacted once they outnumber live ones"), LargestHeap <= 64);
+	TestTrue(TEXT("The live request survives compaction"), FlushPathRequests(World, Navigation));
+	TestTrue(TEXT("The latest superseding request is the one served"), HasDirectPathTo(SupersededUnit, FVector(199.0f, 0.0f, 0.0f)));
+	TestTrue(TEXT("Cancelled churn is never served"), HasNoPath(CancelledUnit));
+
+	// A cancelled unit's ticket entry is gone, so a fresh request is served normally.
+	Navigation->RequestPath(CancelledUnit, FVector(-500.0f, 300.0f, 0.0f));
+	TestEqual(TEXT("A request after a cancel is queued"), Navigation->GetQueuedRequestCount(), 1);
+	TestTrue(TEXT("A request after a cancel is served"), FlushPathRequests(World, Navigation));
+	TestTrue(TEXT("A request after a cancel reaches its unit"), HasDirectPathTo(CancelledUnit, FVector(-500.0f, 300.0f, 0.0f)));
+	TestEqual(TEXT("The reverse index is empty once the queue drains"), Navigation->GetQueuedRequestCount(), 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FMassUnitNavmeshCorridorTest,
+	"MassUnitSystem.Navigation.NavmeshCorridors",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMassUnitNavmeshCorridorTest::RunTest(const FString& Parameters)
+{
+	UMassUnitSystemSettings* MutableSettings = GetMutableDefault<UMassUnitSystemSettings>();
+	TGuardValue<float> CoalesceCellGuard(MutableSettings->PathCoalesceCellSize, 500.0f);
+	TGuardValue<float> HierarchicalDistanceGuard(MutableSettings->HierarchicalPathDistance, 0.0f);
+
+	FTestWorldWrapper TestWorld;
+	if (!TestTrue(TEXT("A transient game world can be created"), TestWorld.CreateTestWorld(EWorldType::Game)))
+	{
+		return false;
+	}
+	UWorld* World = TestWorld.GetTestWorld();
+	UMassUnitSubsystem* UnitSubsystem = World ? World->GetSubsystem<UMassUnitSubsystem>() : nullptr;
+	if (!TestNotNull(TEXT("Mass Unit world subsystem initializes automatically"), UnitSubsystem))
+	{
+		return false;
+	}
+
+	// A main floor split by a wall, and an island the navmesh cannot reach.
+	constexpr float WallX = 250.0f;
+	constexpr float WallHalfLength = 1000.0f;
+	SpawnNavigationBox(World, FVector(0.0f, 0.0f, -50.0f), FVector(4000.0f, 4000.0f, 100.0f));
+	SpawnNavigationBox(World, FVector(3000.0f, 0.0f, -50.0f), FVector(1000.0f, 1000.0f, 100.0f));
+	SpawnNavigationBox(World, FVector(WallX, 0.0f, 150.0f), FVector(20.0f, WallHalfLength * 2.0f, 300.0f));
+	ARecastNavMesh* NavMesh = BuildTestNavMesh(World, FBox(FVector(-2250.0f, -2200.0f, -500.0f), FVector(3750.0f, 2200.0f, 500.0f)));
+	if (!TestNotNull(TEXT("A navmesh can be built in the test world"), NavMesh))
+	{
+		return false;
+	}
+	UMassUnitNavigationSystem* Navigation = UnitSubsystem->GetNavigationSystem();
+	Navigation->UpdateNavigationData(World);
+
+	UMassUnitEntityManager* UnitManager = UnitSubsystem->GetUnitManager();
+	FMassEntityManager& EntityManager = UnitSubsystem->GetEntitySubsystem()->GetMutableEntityManager();
+	UUnitTemplate* Template = NewObject<UUnitTemplate>(GetTransientPackage());
+	auto GetPathPoints = [&EntityManager](const FMassUnitHandle& Unit)
+	{
+		const FMassUnitNavigationFragment* Fragment = EntityManager.GetFragmentDataPtr<FMassUnitNavigationFragment>(Unit.EntityHandle.ToMassEntityHandle());
+		return Fragment && Fragment->bPathValid && Fragment->bPathUsesNavmesh ? Fragment->PathPoints : TArray<FVector>();
+	};
+
+	// Both units start in one coalescing cell, on opposite sides of the wall.
+	const FVector Goal(1500.0f, 0.0f, 20.0f);
+	const FMassUnitHandle WestUnit = UnitManager->CreateUnitFromTemplate(Template, FTransform(FVector(150.0f, 0.0f, 20.0f)));
+	const FMassUnitHandle EastUnit = UnitManager->CreateUnitFromTemplate(Template, FTransform(FVector(350.0f, 0.0f, 20.0f)));
+	Navigation->RequestPath(WestUnit, Goal, 50.0f);
+	Navigation->RequestPath(EastUnit, Goal, 50.0f);
+	TestTrue(TEXT("Coalesced path queries complete"), FlushPathRequests(World, Navigation));
+	TestEqual(TEXT("Requests in one start cell and goal polygon share a query"), Navigation->GetCoalescedRequestCount(), 1);
+	const TArray<FVector> WestPath = GetPathPoints(WestUnit);
+	const TArray<FVector> EastPath = GetPathPoints(EastUnit);
+	TestTrue(TEXT("The querying unit receives a navmesh corridor"), WestPath.Num() >= 3);
+	TestTrue(TEXT("The querying unit's corridor routes around the wall"), !WestPath.IsEmpty() && !CrossesWall(WestPath, WallX, WallHalfLength));
+	TestTrue(TEXT("A coalesced member across the wall receives a navmesh corridor"), EastPath.Num() >= 2);
+	TestTrue(TEXT("A coalesced member across the wall does not walk through it to reach the shared corners"),
+		!EastPath.IsEmpty() && !CrossesWall(EastPath, WallX, WallHalfLength));
+	TestTrue(TEXT("A coalesced member keeps its own start"),
+		!EastPath.IsEmpty() && EastPath[0].Equals(FVector(350.0f, 0.0f, EastPath[0].Z), 1.0f));
+
+	// Cache hits string-pull the cached polygons again from the new start.
+	const int32 HitsBeforeRepeat = Navigation->GetPathCacheHitCount();
+	Navigation->RequestPath(WestUnit, Goal, 50.0f);
+	TestTrue(TEXT("A repeated path request completes"), FlushPathRequests(World, Navigation));
+	TestEqual(TEXT("A repeated request between the same polygons is served from the cache"),
+		Navigation->GetPathCacheHitCount(), HitsBeforeRepeat + 1);
+	const TArray<FVector> CachedWestPath = GetPathPoints(WestUnit);
+	bool bSameCorridor = CachedWestPath.Num() == WestPath.Num();
+	for (int32 PointIndex = 0; bSameCorridor && PointIndex < WestPath.Num(); ++PointIndex)
+	{
+		bSameCorridor = CachedWestPath[PointIndex].Equals(WestPath[PointIndex], 1.0f);
+	}
+	TestTrue(TEXT("A cache hit from the same start rebuilds the corridor a fresh query found"), bSameCorridor);
+	const FMassUnitHandle NearbyUnit = UnitManager->CreateUnitFromTemplate(Template, FTransform(FVector(100.0f, -300.0f, 20.0f)));
+	Navigation->RequestPath(NearbyUnit, Goal, 50.0f);
+	TestTrue(TEXT("A path request near a cached start completes"), FlushPathRequests(World, Navigation));
+	const TArray<FVector> NearbyPath = GetPathPoints(NearbyUnit);
+	TestTrue(TEXT("A corridor served near a cached start never cuts through the wall"),
+		NearbyPath.Num() >= 3 && !CrossesWall(NearbyPath, WallX, WallHalfLength));
+	TestTrue(TEXT("A corridor served near a cached start begins at that unit"),
+		!NearbyPath.IsEmpty() && NearbyPath[0].Equals(FVector(100.0f, -300.0f, NearbyPath[0].Z), 1.0f));
+
+	// Both units start in one cell and head for the island; neither path can reach it.
+	const int32 CachedBeforePartial = Navigation->GetCachedPathCount();
+	const FVector IslandGoal(3000.0f, 0.0f, 20.0f);
+	const FMassUnitHandle PartialUnit = UnitManager->CreateUnitFromTemplate(Template, FTransform(FVector(-1000.0f, 0.0f, 20.0f)));
+	const FMassUnitHandle PartialMember = UnitManager->CreateUnitFromTemplate(Template, FTransform(FVector(-900.0f, 100.0f, 20.0f)));
+	Navigation->RequestPath(PartialUnit, IslandGoal, 50.0f);
+	Navigation->RequestPath(PartialMember, IslandGoal, 50.0f);
+	TestTrue(TEXT("Partial path queries complete"), FlushPathRequests(World, Navigation));
+	for (const FMassUnitHandle& Unit : {PartialUnit, PartialMember})
+	{
+		const TArray<FVector> PartialPath = GetPathPoints(Unit);
+		TestTrue(TEXT("A partial path keeps the navmesh corridor"), PartialPath.Num() >= 2);
+		TestTrue(TEXT("A partial path stops where the navmesh ends instead of jumping to the goal"),
+			!PartialPath.IsEmpty() && PartialPath.Last().X < 2100.0f);
+		const FMassUnitNavigationFragment* Fragment = EntityManager.GetFragmentDataPtr<FMassUnitNavigationFragment>(Unit.EntityHandle.ToMassEntityHandle());
+		TestTrue(TEXT("A partial path keeps the real goal for later repaths"),
+			Fragment && Fragment->DestinationLocation.X > 2500.0f);
+	}
+	TestEqual(TEXT("Partial corridors are not cached"), Navigation->GetCachedPathCount(), CachedBeforePartial);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FMassUnitHierarchicalDestinationTest,
+	"MassUnitSystem.Navigation.HierarchicalDestination",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMassUnitHierarchicalDestinationTest::RunTest(const FString& Parameters)
+{
+	UMassUnitSystemSettings* MutableSettings = GetMutableDefault<UMassUnitSystemSettings>();
+	TGuardValue<float> HierarchicalDistanceGuard(MutableSettings->HierarchicalPathDistance, 3000.0f);
+	TGuardValue<float> ClusterSizeGuard(MutableSettings->PathClusterSize, 1000.0f);
+
+	FTestWorldWrapper TestWorld;
+	if (!TestTrue(TEXT("A transient game world can be created"), TestWorld.CreateTestWorld(EWorldType::Game)))
+	{
+		return false;
+	}
+	UWorld* World = TestWorld.GetTestWorld();
+	UMassUnitSubsystem* UnitSubsystem = World ? World->GetSubsystem<UMassUnitSubsystem>() : nullptr;
+	if (!TestNotNull(TEXT("Mass Unit world subsystem initializes automatically"), UnitSubsystem))
+	{
+		return false;
+	}
+
+	// A long strip of floor; a move along it spans a dozen clusters.
+	SpawnNavigationBox(World, FVector(0.0f, 0.0f, -50.0f), FVector(14000.0f, 2000.0f, 100.0f));
+	ARecastNavMesh* NavMesh = BuildTestNavMesh(World, FBox(FVector(-6900.0f, -900.0f, -500.0f), FVector(6900.0f, 900.0f, 500.0f)));
+	if (!TestNotNull(TEXT("A navmesh can be built in the test world"), NavMesh))
+	{
+		return false;
+	}
+	UMassUnitNavigationSystem* Navigation = UnitSubsystem->GetNavigationSystem();
+	Navigation->UpdateNavigationData(World);
+
+	UMassUnitEntityManager* UnitManager = UnitSubsystem->GetUnitManager();
+	FMassEntityManager& EntityManager = UnitSubsystem->GetEntitySubsystem()->GetMutableEntityManager();
+	UUnitTemplate* Template = NewObject<UUnitTemplate>(GetTransientPackage());
+	const FMassUnitHandle Unit = UnitManager->CreateUnitFromTemplate(Template, FTransform(FVector(-6000.0f, 0.0f, 20.0f)));
+	const FMassEntityHandle Entity = Unit.EntityHandle.ToMassEntityHandle();
+	const FVector Goal(6000.0f, 0.0f, 20.0f);
+	Navigation->RequestPath(Unit, Goal, 50.0f);
+
+	// Each window is walked to its end, which queues the next one.
+	int32 Windows = 0;
+	for (int32 Attempt = 0; Attempt < 16; ++Attempt)
+	{
+		TestTrue(TEXT("A route window is served"), FlushPathRequests(World, Navigation));
+		FMassUnitNavigationFragment* Fragment = EntityManager.GetFragmentDataPtr<FMassUnitNavigationFragment>(Entity);
+		FMassUnitTransformFragment* Transform = EntityManager.GetFragmentDataPtr<FMassUnitTransformFragment>(Entity);
+		const FMassUnitTargetFragment* Target = EntityManager.GetFragmentDataPtr<FMassUnitTargetFragment>(Entity);
+		if (!TestTrue(TEXT("A route window yields a navmesh corridor"),
+			Fragment && Transform && Fragment->bPathValid && Fragment->bPathUsesNavmesh && !Fragment->PathPoints.IsEmpty()))
+		{
+			return false;
+		}
+		++Windows;
+		TestTrue(TEXT("The destination stays the ordered goal across route windows"),
+			Fragment->DestinationLocation.Equals(FVector(Goal.X, Goal.Y, Fragment->DestinationLocation.Z), 5.0f));
+		TestTrue(TEXT("The target location stays the ordered goal across route windows"),
+			Target && Target->TargetLocation.Equals(FVector(Goal.X, Goal.Y, Target->TargetLocation.Z), 5.0f));
+		if (Navigation->GetHierarchicalRouteCount() == 0)
+		{
+			break;
+		}
+		const FVector WindowEnd = Fragment->PathPoints.Last();
+		TestTrue(TEXT("An intermediate window ends short of the goal"), WindowEnd.X < Goal.X - 500.0f);
+		Transform->GetMutableTransform().SetLocation(WindowEnd + FVector(0.0f, 0.0f, 20.0f));
+		Fragment->CurrentPathIndex = Fragment->PathPoints.Num() - 1;
+		Navigation->ProcessPathRequests();
+	}
+
+	TestTrue(TEXT("A long move is refined over several windows"), Windows > 1);
+	TestEqual(TEXT("The final window retires the route"), Navigation->GetHierarchicalRouteCount(), 0);
+	const FMassUnitNavigationFragment* Fragment = EntityManager.GetFragmentDataPtr<FMassUnitNavigationFragment>(Entity);
+	TestTrue(TEXT("The final window ends at the ordered goal"),
+		Fragment && !Fragment->PathPoints.IsEmpty() && FVector::Dist2D(Fragment->PathPoints.Last(), Goal) < 5.0f);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FMassUnitSharedPathSupersedeTest,
+	"MassUnitSystem.Navigation.SharedPathSupersede",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMassUnitSharedPathSupersedeTest::RunTest(const FString& Parameters)
+{
+	FTestWorldWrapper TestWorld;
+	if (!TestTrue(TEXT("A transient game world can be created"), TestWorld.CreateTestWorld(EWorldType::Game)))
+	{
+		return false;
+	}
+	UWorld* World = TestWorld.GetTestWorld();
+	UMassUnitSubsystem* UnitSubsystem = World ? World->GetSubsystem<UMassUnitSubsystem>() : nullptr;
+	if (!TestNotNull(TEXT("Mass Unit world subsystem initializes automatically"), UnitSubsystem))
+	{
+		return false;
+	}
+
+	SpawnNavigationBox(World, FVector(0.0f, 0.0f, -50.0f), FVector(4000.0f, 4000.0f, 100.0f));
+	ARecastNavMesh* NavMesh = BuildTestNavMesh(World, FBox(FVector(-1900.0f, -1900.0f, -500.0f), FVector(1900.0f, 1900.0f, 500.0f)));
+	if (!TestNotNull(TEXT("A navmesh can be built in the test world"), NavMesh))
+	{
+		return false;
+	}
+	UMassUnitNavigationSystem* Navigation = UnitSubsystem->GetNavigationSystem();
+	Navigation->UpdateNavigationData(World);
+
+	// The crowd supersedes a corridor by cancelling its query and issuing the next one in the same frame.
+	const FVector Start(-1500.0f, 0.0f, 20.0f);
+	const FVector StaleDestination(1500.0f, 1500.0f, 20.0f);
+	const FVector FreshDestination(1500.0f, -1500.0f, 20.0f);
+	int32 StaleCallbacks = 0;
+	int32 FreshCallbacks = 0;
+	TArray<FVector> FreshPath;
+	bool bFreshUsesNavmesh = false;
+	const uint32 StaleQuery = Navigation->FindSharedPathAsync(Start, StaleDestination,
+		[&StaleCallbacks](TArray<FVector>&&, bool)
+		{
+			++StaleCallbacks;
+		});
+	if (!TestTrue(TEXT("A projectable corridor is built asynchronously"), StaleQuery != 0))
+	{
+		return false;
+	}
+	Navigation->CancelSharedPath(StaleQuery);
+	const uint32 FreshQuery = Navigation->FindSharedPathAsync(Start, FreshDestination,
+		[&FreshCallbacks, &FreshPath, &bFreshUsesNavmesh](TArray<FVector>&& PathPoints, bool bUsesNavmesh)
+		{
+			++FreshCallbacks;
+			FreshPath = MoveTemp(PathPoints);
+			bFreshUsesNavmesh = bUsesNavmesh;
+		});
+	TestTrue(TEXT("The superseding query gets its own id"), FreshQuery != 0 && FreshQuery != StaleQuery);
+
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+	for (int32 Attempt = 0; Attempt < 200 && FreshCallbacks == 0 && NavSys; ++Attempt)
+	{
+		NavSys->Tick(0.016f);
+		FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+		FPlatformProcess::Sleep(0.005f);
+	}
+	// A few more frames give a leaked stale result every chance to arrive.
+	for (int32 Frame = 0; Frame < 10 && NavSys; ++Frame)
+	{
+		NavSys->Tick(0.016f);
+		FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+	}
+	TestEqual(TEXT("The superseding corridor lands once"), FreshCallbacks, 1);
+	TestEqual(TEXT("The cancelled corridor never lands"), StaleCallbacks, 0);
+	TestTrue(TEXT("The superseding corridor comes from the navmesh"), bFreshUsesNavmesh);
+	TestTrue(TEXT("The superseding corridor ends at its own destination"),
+		!FreshPath.IsEmpty() && FVector::Dist2D(FreshPath.Last(), FreshDestination) < 50.0f);
+
+	// Cancelling a query that already landed is harmless.
+	Navigation->CancelSharedPath(FreshQuery);
+	TestEqual(TEXT("A late cancellation does not replay the callback"), FreshCallbacks, 1);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FMassUnitRebuiltAreaRepathTest,
+	"MassUnitSystem.Navigation.RebuiltAreaRepaths",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMassUnitRebuiltAreaRepathTest::RunTest(const FString& Parameters)
+{
+	UMassUnitSystemSettings* MutableSettings = GetMutableDefault<UMassUnitSystemSettings>();
+	TGuardValue<float> HierarchicalDistanceGuard(MutableSettings->HierarchicalPathDistance, 0.0f);
+	TGuardValue<float> IndexCellGuard(MutableSettings->RepathIndexCellSize, 500.0f);
+
+	FTestWorldWrapper TestWorld;
+	if (!TestTrue(TEXT("A transient game world can be created"), TestWorld.CreateTestWorld(EWorldType::Game)))
+	{
+		return false;
+	}
+	UWorld* World = TestWorld.GetTestWorld();
+	UMassUnitSubsystem* UnitSubsystem = World ? World->GetSubsystem<UMassUnitSubsystem>() : nullptr;
+	if (!TestNotNull(TEXT("Mass Unit world subsystem initializes automatically"), UnitSubsystem))
+	{
+		return false;
+	}
+
+	SpawnNavigationBox(World, FVector(0.0f, 0.0f, -50.0f), FVector(6000.0f, 6000.0f, 100.0f));
+	ARecastNavMesh* NavMesh = BuildTestNavMesh(World, FBox(FVector(-2900.0f, -2900.0f, -500.0f), FVector(2900.0f, 2900.0f, 500.0f)));
+	if (!TestNotNull(TEXT("A navmesh can be built in the test world"), NavMesh))
+	{
+		return false;
+	}
+	UMassUnitNavigationSystem* Navigation = UnitSubsystem->GetNavigationSystem();
+	Navigation->UpdateNavigationData(World);
+
+	UMassUnitEntityManager* UnitManager = UnitSubsystem->GetUnitManager();
+	FMassEntityManager& EntityManager = UnitSubsystem->GetEntitySubsystem()->GetMutableEntityManager();
+	UUnitTemplate* Template = NewObject<UUnitTemplate>(GetTransientPackage());
+	auto GetPathPoints = [&EntityManager](const FMassUnitHandle& Unit)
+	{
+		const FMassUnitNavigationFragment* Fragment = EntityManager.GetFragmentDataPtr<FMassUnitNavigationFragment>(Unit.EntityHandle.ToMassEntityHandle());
+		return Fragment && Fragment->bPathValid && Fragment->bPathUsesNavmesh ? Fragment->PathPoints : TArray<FVector>();
+	};
+
+	// Two parallel lanes three thousand centimeters apart; only the north one is rebuilt.
+	const FMassUnitHandle NorthUnit = UnitManager->CreateUnitFromTemplate(Template, FTransform(FVector(-2000.0f, 1500.0f, 20.0f)));
+	const FMassUnitHandle SouthUnit = UnitManager->CreateUnitFromTemplate(Template, FTransform(FVector(-2000.0f, -1500.0f, 20.0f)));
+	Navigation->RequestPath(NorthUnit, FVector(2000.0f, 1500.0f, 20.0f), 50.0f);
+	Navigation->RequestPath(SouthUnit, FVector(2000.0f, -1500.0f, 20.0f), 50.0f);
+	TestTrue(TEXT("Lane path queries complete"), FlushPathRequests(World, Navigation));
+	const TArray<FVector> SouthPath = GetPathPoints(SouthUnit);
+	TestEqual(TEXT("An open lane is a straight corridor"), GetPathPoints(NorthUnit).Num(), 2);
+	TestEqual(TEXT("An open lane is a straight corridor"), SouthPath.Num(), 2);
+
+	TArray<FBox> RebuiltAreas;
+	bool bRebuilt = false;
+	const FDelegateHandle RebuiltHandle = Navigation->OnNavigationAreasRebuilt.AddLambda(
+		[&RebuiltAreas, &bRebuilt](TConstArrayView<FBox> Areas)
+		{
+			RebuiltAreas.Append(Areas.GetData(), Areas.Num());
+			bRebuilt = true;
+		});
+	SpawnNavigationBox(World, FVector(0.0f, 1500.0f, 150.0f), FVector(300.0f, 300.0f, 300.0f));
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+	for (int32 Attempt = 0; Attempt < 400 && !bRebuilt && NavSys; ++Attempt)
+	{
+		NavSys->Tick(0.016f);
+		FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+		FPlatformProcess::Sleep(0.005f);
+	}
+	Navigation->OnNavigationAreasRebuilt.Remove(RebuiltHandle);
+	if (!TestTrue(TEXT("An obstacle placed on the north lane rebuilds the navmesh"), bRebuilt))
+	{
+		return false;
+	}
+	TestFalse(TEXT("The rebuild reports the obstacle's bounds rather than the whole navmesh"), RebuiltAreas.IsEmpty());
+	TestEqual(TEXT("Only the corridor crossing the rebuilt bounds is queued for a repath"), Navigation->GetPendingRepathCount(), 1);
+
+	TestTrue(TEXT("The repath completes"), FlushPathRequests(World, Navigation));
+	TestEqual(TEXT("One repath was requested"), Navigation->GetRepathCount(), 1);
+	TestTrue(TEXT("The north corridor now routes around the obstacle"), GetPathPoints(NorthUnit).Num() >= 3);
+	const TArray<FVector> SouthPathAfter = GetPathPoints(SouthUnit);
+	bool bSouthUnchanged = SouthPathAfter.Num() == SouthPath.Num();
+	for (int32 PointIndex = 0; bSouthUnchanged && PointIndex < SouthPath.Num(); ++PointIndex)
+	{
+		bSouthUnchanged = SouthPathAfter[PointIndex].Equals(SouthPath[PointIndex], 1.0f);
+	}
+	TestTrue(TEXT("A corridor outside the rebuilt bounds is left alone"), bSouthUnchanged);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FMassUnitFlowFieldTest,
+	"MassUnitSystem.Navigation.FlowField",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMassUnitFlowFieldTest::RunTest(const FString& Parameters)
+{
+	FTestWorldWrapper TestWorld;
+	if (!TestTrue(TEXT("A transient game world can be created"), TestWorld.CreateTestWorld(EWorldType::Game)))
+	{
+		return false;
+	}
+	UWorld* World = TestWorld.GetTestWorld();
+	UMassUnitSubsystem* UnitSubsystem = World ? World->GetSubsystem<UMassUnitSubsystem>() : nullptr;
+	if (!TestNotNull(TEXT("Mass Unit world subsystem initializes automatically"), UnitSubsystem))
+	{
+		return false;
+	}
+
+	// A plateau 6 m above the floor, reachable only by a ramp on its west side.
+	SpawnNavigationBox(World, FVector(0.0f, 0.0f, -50.0f), FVector(6000.0f, 4000.0f, 100.0f));
+	SpawnNavigationBox(World, FVector(2000.0f, 0.0f, 300.0f), FVector(1000.0f, 1000.0f, 600.0f));
+	SpawnNavigationBox(World, FVector(1000.0f, 0.0f, 300.0f), FVector(1170.0f, 400.0f, 20.0f), FRotator(FMath::RadiansToDegrees(FMath::Atan2(600.0f, 1000.0f)), 0.0f, 0.0f));
+	ARecastNavMesh* NavMesh = BuildTestNavMesh(World, FBox(FVector(-2900.0f, -1900.0f, -500.0f), FVector(2900.0f, 1900.0f, 1000.0f)));
+	if (!TestNotNull(TEXT("A navmesh can be built in the test world"), NavMesh))
+	{
+		return false;
+	}
+	UMassUnitNavigationSystem* Navigation = UnitSubsystem->GetNavigationSystem();
+	Navigation->UpdateNavigationData(World);
+	UMassUnitFlowFieldSystem* FlowField = UnitSubsystem->GetFlowFieldSystem();
+
+	UMassUnitEntityManager* UnitManager = UnitSubsystem->GetUnitManager();
+	FMassEntityManager& EntityManager = UnitSubsystem->GetEntitySubsystem()->GetMutableEntityManager();
+	UUnitTemplate* Template = NewObject<UUnitTemplate>(GetTransientPackage());
+	const FVector Start(-1000.0f, 1500.0f, 20.0f);
+	const FVector Goal(2000.0f, 0.0f, 620.0f);
+	TArray<FMassUnitHandle> Units;
+	for (int32 Index = 0; Index < 3; ++Index)
+	{
+		Units.Add(UnitManager->CreateUnitFromTemplate(Template, FTransform(Start + FVector(0.0f, Index * 100.0f, 0.0f))));
+	}
+	TestEqual(TEXT("Every ordered unit follows the flow field"), FlowField->MoveUnitsToLocation(Units, Goal, 50.0f), 3);
+	TestEqual(TEXT("One field serves the whole order"), FlowField->GetCachedFieldCount(), 1);
+	const FMassUnitNavigationFragment* Fragment = EntityManager.GetFragmentDataPtr<FMassUnitNavigationFragment>(Units[0].EntityHandle.ToMassEntityHandle());
+	const int32 FieldHandle = Fragment ? Fragment->FlowFieldHandle : INDEX_NONE;
+	if (!TestTrue(TEXT("Ordered units hold the field handle"), FieldHandle != INDEX_NONE))
+	{
+		return false;
+	}
+	TestEqual(TEXT("A move order queues its field instead of building it at once"), FlowField->GetPendingFieldRebuildCount(), 1);
+	FVector UnbuiltSteeringPoint;
+	TestFalse(TEXT("Units steer straight at the goal until the field is integrated"),
+		FlowField->SampleSteeringPoint(FieldHandle, Start, UnbuiltSteeringPoint));
+	int32 BuildFrames = 0;
+	while (FlowField->GetPendingFieldRebuildCount() > 0 && BuildFrames < 1000)
+	{
+		FlowField->RebuildDirtyFields();
+		++BuildFrames;
+	}
+	TestTrue(TEXT("The first build is spread over several frames"), BuildFrames > 1);
+	TestEqual(TEXT("The first build integrates the field once"), FlowField->GetFieldBuildCount(), 1);
+
+	// Follow the field from the floor; it must climb the ramp instead of the cliff.
+	auto WalkField = [FlowField, FieldHandle, &Start, &Goal](bool& bOutClimbedCliff)
+	{
+		bOutClimbedCliff = false;
+		FVector Location = Start;
+		for (int32 Step = 0; Step < 200; ++Step)
+		{
+			FVector SteeringPoint;
+			if (!FlowField->SampleSteeringPoint(FieldHandle, Location, SteeringPoint))
+			{
+				return false;
+			}
+			bOutClimbedCliff |= FMath::Abs(SteeringPoint.Z - Location.Z) > 200.0f;
+			if (SteeringPoint.Equals(Goal, 1.0f))
+			{
+				return true;
+			}
+			Location = SteeringPoint;
+		}
+		return false;
+	};
+	bool bClimbedCliff = false;
+	TestTrue(TEXT("The field leads from the floor to a goal 6 m higher"), WalkField(bClimbedCliff));
+	TestFalse(TEXT("The field reaches the plateau by the ramp, not the cliff"), bClimbedCliff);
+
+	// Bury the foot of the ramp in a block too tall to climb. Rebuilt tiles are re-projected a few per frame while units keep the old directions.
+	const int32 BuildsBeforeRebuild = FlowField->GetFieldBuildCount();
+	SpawnNavigationBox(World, FVector(650.0f, 0.0f, 150.0f), FVector(700.0f, 800.0f, 300.0f));
+	if (UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World))
+	{
+		NavSys->Build();
+		NavSys->OnNavigationGenerationFinishedDelegate.Broadcast(NavMesh);
+	}
+	TestEqual(TEXT("A navmesh rebuild schedules the field instead of integrating it at once"), FlowField->GetPendingFieldRebuildCount(), 1);
+	TestEqual(TEXT("A navmesh rebuild does not integrate synchronously"), FlowField->GetFieldBuildCount(), BuildsBeforeRebuild);
+	FVector StaleSteeringPoint;
+	TestTrue(TEXT("Units keep the previous directions while the field is rebuilt"),
+		FlowField->SampleSteeringPoint(FieldHandle, Start, StaleSteeringPoint));
+	int32 RebuildFrames = 0;
+	while (FlowField->GetPendingFieldRebuildCount() > 0 && RebuildFrames < 1000)
+	{
+		FlowField->RebuildDirtyFields();
+		++RebuildFrames;
+	}
+	TestTrue(TEXT("The rebuild is spread over several frames"), RebuildFrames > 1);
+	TestEqual(TEXT("The rebuilt field is integrated once"), FlowField->GetFieldBuildCount(), BuildsBeforeRebuild + 1);
+	TestFalse(TEXT("With the ramp blocked, the floor no longer leads to the plateau"), WalkField(bClimbedCliff));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FMassUnitPublishedVisualFrameTest,
+	"MassUnitSystem.Visual.PublishedFrames",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMassUnitPublishedVisualFrameTest::RunTest(const FString& Parameters)
+{
+	using FFrameRef = TSharedPtr<FMassUnitVisualFrame, ESPMode::ThreadSafe>;
+
+	// Mirrors UNiagaraUnitSystem's publish: refill the back frame unless a reader still holds it, then advance.
+	FMassUnitVisualBuffers Buffers;
+	FFrameRef Frames[2];
+	int32 PublishedIndex = 0;
+	auto Publish = [&Buffers, &Frames, &PublishedIndex]()
+	{
+		const int32 BackIndex = 1 - PublishedIndex;
+		if (!Frames[BackIndex].IsValid() || !Frames[BackIndex].IsUnique())
+		{
+			Frames[BackIndex] = MakeShared<FMassUnitVisualFrame, ESPMode::ThreadSafe>();
+		}
+		Buffers.CopyToFrame(*Frames[BackIndex]);
+		PublishedIndex = BackIndex;
+		Buffers.AdvanceRevision();
+		return Frames[BackIndex];
+	};
+
+	// The data interface reads these arrays by unit index, so every slot must match what was written.
+	auto MatchesBuffers = [&Buffers](const FMassUnitVisualFrame& Frame)
+	{
+		if (Frame.Num() != Buffers.Num())
+		{
+			return false;
+		}
+		for (int32 Slot = 0; Slot < Buffers.Num(); ++Slot)
+		{
+			if (Frame.VisibilityFlags[Slot] != Buffers.VisibilityFlags[Slot]
+				|| Frame.AnimationTimes[Slot] != Buffers.AnimationTimes[Slot])
+			{
+				return false;
+			}
+			if (Buffers.VisibilityFlags[Slot] != 0.0f
+				&& (!Frame.Positions[Slot].Equals(FVector3f(Buffers.Positions[Slot]))
+					|| !Frame.Velocities[Slot].Equals(FVector3f(Buffers.Velocities[Slot]))
+					|| !Frame.Rotations[Slot].Equals(FQuat4f(Buffers.Rotations[Slot]))
+					|| Frame.TeamIDs[Slot] != Buffers.TeamIDs[Slot]
+					|| Frame.AnimationIndices[Slot] != Buffers.AnimationIndices[Slot]
+					|| Frame.LODLevels[Slot] != Buffers.LODLevels[Slot]))
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+
+	FRandomStream RandomStream(1234);
+	auto WriteSlot = [&Buffers, &RandomStream](int32 Slot)
+	{
+		FMassUnitVisualBuffers::FSample Sample;
+		Sample.Position = RandomStream.GetUnitVector() * RandomStream.FRandRange(0.0f, 5000.0f);
+		Sample.Velocity = RandomStream.GetUnitVector() * 300.0f;
+		Sample.Rotation = FRotator(0.0f, RandomStream.FRandRange(-180.0f, 180.0f), 0.0f).Quaternion();
+		Sample.TeamID = static_cast<float>(RandomStream.RandRange(0, 3));
+		Sample.AnimationIndex = static_cast<float>(RandomStream.RandRange(0, 7));
+		Sample.AnimationTime = RandomStream.FRand();
+		Sample.LODLevel = static_cast<float>(RandomStream.RandRange(0, 2));
+		Buffers.Write(Slot, Sample);
+	};
+
+	Buffers.SetNum(64);
+	for (int32 Slot = 0; Slot < Buffers.Num(); ++Slot)
+	{
+		WriteSlot(Slot);
+	}
+	TestTrue(TEXT("The first published frame matches the buffers"), MatchesBuffers(*Publish()));
+
+	// Partial rounds exercise the incremental copy into whichever frame comes back.
+	FFrameRef HeldFrame;
+	TArray<FVector3f> HeldPositions;
+	for (int32 Round = 0; Round < 8; ++Round)
+	{
+		for (int32 Write = 0; Write < 12; ++Write)
+		{
+			WriteSlot(RandomStream.RandHelper(Buffers.Num()));
+		}
+		Buffers.Hide(RandomStream.RandHelper(Buffers.Num()));
+		for (int32 Slot = 0; Slot < Buffers.Num(); ++Slot)
+		{
+			Buffers.AnimationTimes[Slot] += 0.1f;
+		}
+		if (Round == 3)
+		{
+			Buffers.SetNum(80);
+			for (int32 Slot = 64; Slot < 80; ++Slot)
+			{
+				WriteSlot(Slot);
+			}
+		}
+		const FFrameRef Published = Publish();
+		if (!TestTrue(FString::Printf(TEXT("Published frame %d matches the buffers"), Round), MatchesBuffers(*Published)))
+		{
+			return false;
+		}
+		if (Round == 1)
+		{
+			// A data interface instance or the render thread keeps reading this frame.
+			HeldFrame = Published;
+			HeldPositions = HeldFrame->Positions;
+		}
+	}
+	TestTrue(TEXT("A frame held by a reader is never refilled"), HeldFrame.IsValid() && HeldFrame->Positions == HeldPositions);
+	TestTrue(TEXT("The held frame is no longer the published one"), HeldFrame != Frames[PublishedIndex] && HeldFrame != Frames[1 - PublishedIndex]);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FMassUnitLODHysteresisTest,
+	"MassUnitSystem.Visual.LODHysteresis",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMassUnitLODHysteresisTest::RunTest(const FString& Parameters)
+{
+	UMassUnitSystemSettings* MutableSettings = GetMutableDefault<UMassUnitSystemSettings>();
+	TGuardValue<float> VisualUpdateIntervalGuard(MutableSettings->VisualUpdateInterval, 0.0f);
+	TGuardValue<TArray<float>> ThresholdGuard(MutableSettings->LODDistanceThresholds, TArray<float>{1000.0f, 3000.0f});
+	TGuardValue<float> HysteresisGuard(MutableSettings->LODDistanceHysteresis, 1.1f);
+	TGuardValue<float> MaxVisibleDistanceGuard(MutableSettings->MaxVisibleDistance, 0.0f);
+
+	FTestWorldWrapper TestWorld;
+	if (!TestTrue(TEXT("A transient game world can be created"), TestWorld.CreateTestWorld(EWorldType::Game)))
+	{
+		return false;
+	}
+	UWorld* World = TestWorld.GetTestWorld();
+	UMassUnitSubsystem* UnitSubsystem = World ? World->GetSubsystem<UMassUnitSubsystem>() : nullptr;
+	if (!TestNotNull(TEXT("Mass Unit world subsystem initializes automatically"), UnitSubsystem))
+	{
+		return false;
+	}
+	UMassUnitEntityManager* UnitManager = UnitSubsystem->GetUnitManager();
+	UNiagaraUnitSystem* VisualSystem = UnitSubsystem->GetNiagaraSystem();
+	FMassEntityManager& EntityManager = UnitSubsystem->GetEntitySubsystem()->GetMutableEntityManager();
+
+	// A controller without a pawn views the world from its own location at the origin.
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	if (!TestNotNull(TEXT("A local viewer can be spawned"),
+		World->SpawnActor<APlayerController>(APlayerController::StaticClass(), FTransform::Identity, SpawnParameters)))
+	{
+		return false;
+	}
+
+	UStaticMesh* NearMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+	UStaticMesh* FarMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Sphere.Sphere"));
+	if (!TestNotNull(TEXT("Engine basic shapes load"), NearMesh) || !TestNotNull(TEXT("Engine basic shapes load"), FarMesh))
+	{
+		return false;
+	}
+	UUnitTemplate* Template = NewObject<UUnitTemplate>(GetTransientPackage());
+	Template->StaticMesh = NearMesh;
+	FUnitTemplateMeshLOD& NearLOD = Template->StaticMeshLODs.AddDefaulted_GetRef();
+	NearLOD.Mesh = NearMesh;
+	FUnitTemplateMeshLOD& FarLOD = Template->StaticMeshLODs.AddDefaulted_GetRef();
+	FarLOD.Mesh = FarMesh;
+	FarLOD.bCastShadow = false;
+	const FMassUnitHandle Unit = UnitManager->CreateUnitFromTemplate(Template, FTransform(FVector(500.0f, 0.0f, 0.0f)));
+	const TArray<FMassUnitHandle> Units = { Unit };
+
+	UMassUnitVisibilityProcessor* VisibilityProcessor = NewObject<UMassUnitVisibilityProcessor>(GetTransientPackage());
+	VisibilityProcessor->CallInitialize(World, EntityManager.AsShared());
+	double Now = World->GetTimeSeconds();
+	// Places the unit, recomputes its LOD past every update interval, and redraws it.
+	auto ViewUnitAt = [&](float X)
+	{
+		if (FMassUnitTransformFragment* Transform = EntityManager.GetFragmentDataPtr<FMassUnitTransformFragment>(Unit.EntityHandle.ToMassEntityHandle()))
+		{
+			Transform->GetMutableTransform().SetLocation(FVector(X, 0.0f, 0.0f));
+		}
+		Now += 5.0;
+		World->TimeSeconds = Now;
+		FMassExecutionContext VisibilityContext(EntityManager, 0.1f);
+		VisibilityContext.SetExecutionType(EMassExecutionContextType::Processor);
+		VisibilityProcessor->CallExecute(EntityManager, VisibilityContext);
+		VisualSystem->UpdateUnitVisualsByHandles(Units);
+		const FMassUnitVisualFragment* Visual = EntityManager.GetFragmentDataPtr<FMassUnitVisualFragment>(Unit.EntityHandle.ToMassEntityHandle());
+		return Visual ? Visual->LODLevel : INDEX_NONE;
+	};
+
+	TestEqual(TEXT("A nearby unit starts at the first LOD"), ViewUnitAt(500.0f), 0);
+	const bool bCheckBuckets = !VisualSystem->IsUsingNiagara();
+	const int32 TopologyRevision = VisualSystem->GetInstancedMeshTopologyRevision();
+
+	// Hovering just either side of the 1000 cm threshold stays inside the 10% exit margin.
+	const float OutwardJitter[] = { 1080.0f, 980.0f, 1060.0f, 1020.0f, 1085.0f, 990.0f };
+	bool bStayedNear = true;
+	for (const float X : OutwardJitter)
+	{
+		bStayedNear &= ViewUnitAt(X) == 0;
+	}
+	TestTrue(TEXT("A unit hovering at the threshold keeps its LOD"), bStayedNear);
+
+	TestEqual(TEXT("Passing the threshold by the hysteresis margin advances the LOD"), ViewUnitAt(1150.0f), 1);
+	const float InwardJitter[] = { 1050.0f, 1010.0f, 1090.0f, 1005.0f };
+	bool bStayedFar = true;
+	for (const float X : InwardJitter)
+	{
+		bStayedFar &= ViewUnitAt(X) == 1;
+	}
+	TestTrue(TEXT("Coming back inside the exit margin does not return to the nearer LOD"), bStayedFar);
+
+	if (bCheckBuckets)
+	{
+		TestEqual(TEXT("Only the one real LOD change moved the instance between buckets"),
+			VisualSystem->GetInstancedMeshTopologyRevision() - TopologyRevision, 2);
+		const UInstancedStaticMeshComponent* FarComponent = FindInstancedComponent(World, FarMesh);
+		TestTrue(TEXT("The far LOD is drawn with its own mesh"), FarComponent && FarComponent->GetInstanceCount() == 1);
+		TestTrue(TEXT("The far LOD bucket casts no shadow"), FarComponent && !FarComponent->CastShadow);
+		const UInstancedStaticMeshComponent* NearComponent = FindInstancedComponent(World, NearMesh);
+		TestTrue(TEXT("The near bucket no longer draws the unit"), !NearComponent || NearComponent->GetInstanceCount() == 0);
+	}
+
+	TestEqual(TEXT("Crossing back inside the plain threshold returns to the first LOD"), ViewUnitAt(900.0f), 0);
+	if (bCheckBuckets)
+	{
+		const UInstancedStaticMeshComponent* NearComponent = FindInstancedComponent(World, NearMesh);
+		TestTrue(TEXT("The near bucket draws the unit again, with shadows"),
+			NearComponent && NearComponent->GetInstanceCount() == 1 && NearComponent->CastShadow);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FMassUnitImpostorTierTest,
+	"MassUnitSystem.Visual.ImpostorTier",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMassUnitImpostorTierTest::RunTest(const FString& Parameters)
+{
+	UMassUnitSystemSettings* MutableSettings = GetMutableDefault<UMassUnitSystemSettings>();
+	TGuardValue<float> VisualUpdateIntervalGuard(MutableSettings->VisualUpdateInterval, 0.0f);
+	TGuardValue<TArray<float>> ThresholdGuard(MutableSettings->LODDistanceThresholds, TArray<float>{1000.0f, 3000.0f});
+	TGuardValue<float> HysteresisGuard(MutableSettings->LODDistanceHysteresis, 1.1f);
+	TGuardValue<float> MaxVisibleDistanceGuard(MutableSettings->MaxVisibleDistance, 0.0f);
+
+	FTestWorldWrapper TestWorld;
+	if (!TestTrue(TEXT("A transient game world can be created"), TestWorld.CreateTestWorld(EWorldType::Game)))
+	{
+		return false;
+	}
+	UWorld* World = TestWorld.GetTestWorld();
+	UMassUnitSubsystem* UnitSubsystem = World ? World->GetSubsystem<UMassUnitSubsystem>() : nullptr;
+	if (!TestNotNull(TEXT("Mass Unit world subsystem initializes automatically"), UnitSubsystem))
+	{
+		return false;
+	}
+	UMassUnitEntityManager* UnitManager = UnitSubsystem->GetUnitManager();
+	UNiagaraUnitSystem* VisualSystem = UnitSubsystem->GetNiagaraSystem();
+	FMassEntityManager& EntityManager = UnitSubsystem->GetEntitySubsystem()->GetMutableEntityManager();
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	if (!TestNotNull(TEXT("A local viewer can be spawned"),
+		World->SpawnActor<APlayerController>(APlayerController::StaticClass(), FTransform::Identity, SpawnParameters)))
+	{
+		return false;
+	}
+
+	// Any surface material stands in for a project's card material.
+	UStaticMesh* UnitMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+	UStaticMesh* CardMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Plane.Plane"));
+	UMaterialInterface* CardMaterial = UMaterial::GetDefaultMaterial(MD_Surface);
+	if (!TestNotNull(TEXT("Engine basic shapes load"), UnitMesh) || !TestNotNull(TEXT("Engine basic shapes load"), CardMesh))
+	{
+		return false;
+	}
+	UUnitTemplate* Template = NewObject<UUnitTemplate>(GetTransientPackage());
+	Template->StaticMesh = UnitMesh;
+	Template->ImpostorMaterial = CardMaterial;
+	const FMassUnitHandle Unit = UnitManager->CreateUnitFromTemplate(Template, FTransform(FVector(2000.0f, 0.0f, 0.0f)));
+	const TArray<FMassUnitHandle> Units = { Unit };
+	const FMassUnitVisualFragment* Visual = EntityManager.GetFragmentDataPtr<FMassUnitVisualFragment>(Unit.EntityHandle.ToMassEntityHandle());
+	if (!TestNotNull(TEXT("The unit has a visual fragment"), Visual))
+	{
+		return false;
+	}
+	TestTrue(TEXT("The card is sized from the unit mesh bounds"),
+		FMath::IsNearlyEqual(Visual->ImpostorSize, 2.0f * static_cast<float>(UnitMesh->GetBounds().SphereRadius), 0.01f));
+
+	UMassUnitVisibilityProcessor* VisibilityProcessor = NewObject<UMassUnitVisibilityProcessor>(GetTransientPackage());
+	VisibilityProcessor->CallInitialize(World, EntityManager.AsShared());
+	double Now = World->GetTimeSeconds();
+	// Places the unit, recomputes its LOD past every update interval, redraws it, and reports the impostor flag.
+	auto ViewUnitAt = [&](float X)
+	{
+		if (FMassUnitTransformFragment* Transform = EntityManager.GetFragmentDataPtr<FMassUnitTransformFragment>(Unit.EntityHandle.ToMassEntityHandle()))
+		{
+			Transform->GetMutableTransform().SetLocation(FVector(X, 0.0f, 0.0f));
+		}
+		Now += 5.0;
+		World->TimeSeconds = Now;
+		FMassExecutionContext VisibilityContext(EntityManager, 0.1f);
+		VisibilityContext.SetExecutionType(EMassExecutionContextType::Processor);
+		VisibilityProcessor->CallExecute(EntityManager, VisibilityContext);
+		VisualSystem->UpdateUnitVisualsByHandles(Units);
+		Visual = EntityManager.GetFragmentDataPtr<FMassUnitVisualFragment>(Unit.EntityHandle.ToMassEntityHandle());
+		return Visual && Visual->bUseImpostor;
+	};
+	const bool bCheckBuckets = !VisualSystem->IsUsingNiagara();
+
+	TestFalse(TEXT("A unit inside the last threshold is drawn as a mesh"), ViewUnitAt(2000.0f));
+	TestFalse(TEXT("Inside the exit margin of the last threshold the unit stays a mesh"), ViewUnitAt(3200.0f));
+	if (bCheckBuckets)
+	{
+		TestEqual(TEXT("No card is drawn for a mesh unit"), VisualSystem->GetImpostorInstanceCount(), 0);
+	}
+
+	TestTrue(TEXT("Beyond the far distance the unit switches to the impostor"), ViewUnitAt(3500.0f));
+	TestTrue(TEXT("The impostor tier is the LOD after the last threshold"), Visual && Visual->LODLevel == 2);
+	if (bCheckBuckets)
+	{
+		TestEqual(TEXT("The unit is drawn as one card"), VisualSystem->GetImpostorInstanceCount(), 1);
+		TestEqual(TEXT("The unit leaves the mesh bucket rather than being drawn twice"), VisualSystem->GetInstancedMeshInstanceCount(), 1);
+		const UInstancedStaticMeshComponent* CardComponent = FindInstancedComponent(World, CardMesh, CardMaterial);
+		TestTrue(TEXT("Cards are drawn by the shared card mesh with the template material"),
+			CardComponent && CardComponent->GetInstanceCount() == 1);
+		TestTrue(TEXT("Cards cast no shadow"), CardComponent && !CardComponent->CastShadow);
+	}
+
+	TestTrue(TEXT("Coming back inside the exit margin keeps the impostor"), ViewUnitAt(3100.0f));
+	TestFalse(TEXT("Crossing back inside the far distance restores the mesh"), ViewUnitAt(2900.0f));
+	if (bCheckBuckets)
+	{
+		TestEqual(TEXT("The card is released with the tier"), VisualSystem->GetImpostorInstanceCount(), 0);
+		const UInstancedStaticMeshComponent* MeshComponent = FindInstancedComponent(World, UnitMesh);
+		TestTrue(TEXT("The mesh bucket draws the unit again"), MeshComponent && MeshComponent->GetInstanceCount() == 1);
+	}
+
+	// Without a card material the last tier keeps drawing the mesh.
+	UUnitTemplate* PlainTemplate = NewObject<UUnitTemplate>(GetTransientPackage());
+	PlainTemplate->StaticMesh = UnitMesh;
+	const FMassUnitHandle PlainUnit = UnitManager->CreateUnitFromTemplate(PlainTemplate, FTransform(FVector(0.0f, 5000.0f, 0.0f)));
+	ViewUnitAt(2000.0f);
+	const FMassUnitVisualFragment* PlainVisual = EntityManager.GetFragmentDataPtr<FMassUnitVisualFragment>(PlainUnit.EntityHandle.ToMassEntityHandle());
+	TestTrue(TEXT("A template without an impostor material never selects the tier"),
+		PlainVisual && PlainVisual->LODLevel == 2 && !PlainVisual->bUseImpostor);
+	return true;
+}
+
 #endif // WITH_AUTOMATION_TESTS
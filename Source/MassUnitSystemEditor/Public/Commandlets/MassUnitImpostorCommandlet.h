@@ -0,0 +1,36 @@
+// Copyright Digi Logic Labs LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MassUnitImpostorCommandlet.generated.h"
+
+class UMaterialInterface;
+class UUnitTemplate;
+class UWorld;
+
+/**
+ * Bakes impostor cards for unit templates.
+ *
+ * Each template's static mesh is captured from a hemi-octahedral grid of
+ * orthographic views into one atlas saved next to the template. When a parent
+ * material is given, a material instance with the atlas bound is created as
+ * well and assigned as the template's impostor material.
+ *
+ * UnrealEditor-Cmd Project.uproject -run=MassUnitImpostor -AllowCommandletRendering
+ *     [-Template=/Game/Units/DA_Soldier] [-Frames=8] [-FrameResolution=256] [-ParentMaterial=/Game/M_UnitImpostor]
+ */
+UCLASS()
+class MASSUNITSYSTEMEDITOR_API UMassUnitImpostorCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMassUnitImpostorCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	bool BakeTemplate(UUnitTemplate* Template, UWorld* World, int32 FramesPerAxis, int32 FrameResolution, UMaterialInterface* ParentMaterial);
+};
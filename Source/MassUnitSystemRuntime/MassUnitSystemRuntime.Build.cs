@@ -30,8 +30,11 @@ public class MassUnitSystemRuntime : ModuleRules
 		PrivateDependencyModuleNames.AddRange(
 			new string[]
 			{
-				"Projects",
-				"RenderCore"
+				"NiagaraCore",
+				"NiagaraShader",
+				"RenderCore",
+				"RHI",
+				"VectorVM"
 			}
 		);
 	}
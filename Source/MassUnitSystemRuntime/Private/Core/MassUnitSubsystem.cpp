@@ -13,6 +13,8 @@
 #include "Gameplay/UnitGameplayEventSystem.h"
 #include "MassEntitySubsystem.h"
 #include "Navigation/FormationSystem.h"
+#include "Navigation/MassUnitFlowFieldSystem.h"
+#include "Navigation/MassUnitHeightFieldSystem.h"
 #include "Navigation/MassUnitNavigationSystem.h"
 #include "Visual/NiagaraUnitSystem.h"
 #include "Visual/UnitMeshPool.h"
@@ -36,11 +38,17 @@ void UMassUnitSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 	NavigationSystem = NewObject<UMassUnitNavigationSystem>(this);
 	NavigationSystem->Initialize(GetWorld(), EntitySubsystem);
 
+	FlowFieldSystem = NewObject<UMassUnitFlowFieldSystem>(this);
+	FlowFieldSystem->Initialize(GetWorld(), EntitySubsystem, UnitManager, NavigationSystem);
+
+	HeightFieldSystem = NewObject<UMassUnitHeightFieldSystem>(this);
+	HeightFieldSystem->Initialize(GetWorld(), NavigationSystem);
+
 	CrowdSystem = NewObject<UMassUnitCrowdSystem>(this);
 	CrowdSystem->Initialize(GetWorld(), EntitySubsystem, UnitManager, NavigationSystem);
 
 	NiagaraSystem = NewObject<UNiagaraUnitSystem>(this);
-	NiagaraSystem->Initialize(GetWorld(), EntitySubsystem);
+	NiagaraSystem->Initialize(GetWorld(), EntitySubsystem, UnitManager);
 
 	MeshPool = NewObject<UUnitMeshPool>(this);
 	const UMassUnitSystemSettings* Settings = GetDefault<UMassUnitSystemSettings>();
@@ -84,6 +92,14 @@ void UMassUnitSubsystem::Deinitialize()
 	{
 		NiagaraSystem->Deinitialize();
 	}
+	if (HeightFieldSystem)
+	{
+		HeightFieldSystem->Deinitialize();
+	}
+	if (FlowFieldSystem)
+	{
+		FlowFieldSystem->Deinitialize();
+	}
 	if (NavigationSystem)
 	{
 		NavigationSystem->Deinitialize();
@@ -103,6 +119,8 @@ void UMassUnitSubsystem::Deinitialize()
 	GASIntegration = nullptr;
 	MeshPool = nullptr;
 	NiagaraSystem = nullptr;
+	HeightFieldSystem = nullptr;
+	FlowFieldSystem = nullptr;
 	NavigationSystem = nullptr;
 	FormationSystem = nullptr;
 	UnitManager = nullptr;
@@ -117,7 +135,17 @@ void UMassUnitSubsystem::Tick(float DeltaTime)
 	{
 		return;
 	}
+	// Crowd attacks and events queued during Mass processing may spawn or kill units.
+	if (CrowdSystem)
+	{
+		CrowdSystem->FlushDeferredEvents();
+	}
 	UnitManager->PruneInvalidUnits();
+	const TArray<FMassUnitEntityHandle> RemovedUnits = UnitManager->ConsumeRemovedUnits();
+	if (NavigationSystem && !RemovedUnits.IsEmpty())
+	{
+		NavigationSystem->ForgetUnitsInternal(RemovedUnits);
+	}
 
 	if (FormationSystem)
 	{
@@ -127,6 +155,14 @@ void UMassUnitSubsystem::Tick(float DeltaTime)
 	{
 		NavigationSystem->ProcessPathRequests();
 	}
+	if (FlowFieldSystem)
+	{
+		FlowFieldSystem->RebuildDirtyFields();
+	}
+	if (HeightFieldSystem)
+	{
+		HeightFieldSystem->BuildRequestedTiles();
+	}
 	if (BehaviorIntegration)
 	{
 		BehaviorIntegration->Tick(DeltaTime);
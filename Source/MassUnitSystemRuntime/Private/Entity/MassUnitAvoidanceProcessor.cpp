@@ -0,0 +1,497 @@
+// Copyright Digi Logic Labs LLC. All Rights Reserved.
+
+#include "Entity/MassUnitAvoidanceProcessor.h"
+
+#include "Core/MassUnitSubsystem.h"
+#include "Entity/MassUnitFragments.h"
+#include "MassEntityManager.h"
+#include "MassExecutionContext.h"
+#include "MassUnitCommonFragments.h"
+#include "Navigation/MassUnitFlowFieldSystem.h"
+
+namespace
+{
+	constexpr int32 MaxAvoidanceNeighbors = 16;
+
+	struct FOrcaLine
+	{
+		FVector2f Point = FVector2f::ZeroVector;
+		FVector2f Direction = FVector2f::ZeroVector;
+	};
+
+	using FOrcaLines = TArray<FOrcaLine, TInlineAllocator<MaxAvoidanceNeighbors>>;
+
+	float Det(const FVector2f& A, const FVector2f& B)
+	{
+		return A.X * B.Y - A.Y * B.X;
+	}
+
+	// The three linear programs below follow the reference ORCA formulation
+	// (van den Berg et al., "Reciprocal n-Body Collision Avoidance").
+	bool SolveOnLine(
+		const FOrcaLines& Lines,
+		int32 LineIndex,
+		float Radius,
+		const FVector2f& OptimalVelocity,
+		bool bDirectionOptimal,
+		FVector2f& Result)
+	{
+		const FOrcaLine& Line = Lines[LineIndex];
+		const float DotProduct = Line.Point | Line.Direction;
+		const float Discriminant = FMath::Square(DotProduct) + FMath::Square(Radius) - Line.Point.SizeSquared();
+		if (Discriminant < 0.0f)
+		{
+			return false;
+		}
+
+		const float SqrtDiscriminant = FMath::Sqrt(Discriminant);
+		float TLeft = -DotProduct - SqrtDiscriminant;
+		float TRight = -DotProduct + SqrtDiscriminant;
+		for (int32 OtherIndex = 0; OtherIndex < LineIndex; ++OtherIndex)
+		{
+			const FOrcaLine& Other = Lines[OtherIndex];
+			const float Denominator = Det(Line.Direction, Other.Direction);
+			const float Numerator = Det(Other.Direction, Line.Point - Other.Point);
+			if (FMath::Abs(Denominator) <= UE_KINDA_SMALL_NUMBER)
+			{
+				if (Numerator < 0.0f)
+				{
+					return false;
+				}
+				continue;
+			}
+			const float T = Numerator / Denominator;
+			if (Denominator >= 0.0f)
+			{
+				TRight = FMath::Min(TRight, T);
+			}
+			else
+			{
+				TLeft = FMath::Max(TLeft, T);
+			}
+			if (TLeft > TRight)
+			{
+				return false;
+			}
+		}
+
+		if (bDirectionOptimal)
+		{
+			Result = Line.Point + Line.Direction * ((OptimalVelocity | Line.Direction) > 0.0f ? TRight : TLeft);
+		}
+		else
+		{
+			const float T = FMath::Clamp(Line.Direction | (OptimalVelocity - Line.Point), TLeft, TRight);
+			Result = Line.Point + Line.Direction * T;
+		}
+		return true;
+	}
+
+	int32 SolvePlanes(
+		const FOrcaLines& Lines,
+		float Radius,
+		const FVector2f& OptimalVelocity,
+		bool bDirectionOptimal,
+		FVector2f& Result)
+	{
+		if (bDirectionOptimal)
+		{
+			Result = OptimalVelocity * Radius;
+		}
+		else if (OptimalVelocity.SizeSquared() > FMath::Square(Radius))
+		{
+			Result = OptimalVelocity.GetSafeNormal() * Radius;
+		}
+		else
+		{
+			Result = OptimalVelocity;
+		}
+
+		for (int32 LineIndex = 0; LineIndex < Lines.Num(); ++LineIndex)
+		{
+			if (Det(Lines[LineIndex].Direction, Lines[LineIndex].Point - Result) > 0.0f)
+			{
+				const FVector2f PreviousResult = Result;
+				if (!SolveOnLine(Lines, LineIndex, Radius, OptimalVelocity, bDirectionOptimal, Result))
+				{
+					Result = PreviousResult;
+					return LineIndex;
+				}
+			}
+		}
+		return Lines.Num();
+	}
+
+	// Infeasible case: minimize the maximum penetration into any half-plane.
+	void SolveLeastPenetration(const FOrcaLines& Lines, int32 FirstFailedLine, float Radius, FVector2f& Result)
+	{
+		float Distance = 0.0f;
+		for (int32 LineIndex = FirstFailedLine; LineIndex < Lines.Num(); ++LineIndex)
+		{
+			const FOrcaLine& Line = Lines[LineIndex];
+			if (Det(Line.Direction, Line.Point - Result) <= Distance)
+			{
+				continue;
+			}
+
+			FOrcaLines ProjectedLines;
+			for (int32 OtherIndex = 0; OtherIndex < LineIndex; ++OtherIndex)
+			{
+				const FOrcaLine& Other = Lines[OtherIndex];
+				FOrcaLine Projected;
+				const float Determinant = Det(Line.Direction, Other.Direction);
+				if (FMath::Abs(Determinant) <= UE_KINDA_SMALL_NUMBER)
+				{
+					if ((Line.Direction | Other.Direction) > 0.0f)
+					{
+						continue;
+					}
+					Projected.Point = (Line.Point + Other.Point) * 0.5f;
+				}
+				else
+				{
+					Projected.Point = Line.Point
+						+ Line.Direction * (Det(Other.Direction, Line.Point - Other.Point) / Determinant);
+				}
+				Projected.Direction = (Other.Direction - Line.Direction).GetSafeNormal();
+				ProjectedLines.Add(Projected);
+			}
+
+			const FVector2f PreviousResult = Result;
+			if (SolvePlanes(ProjectedLines, Radius, FVector2f(-Line.Direction.Y, Line.Direction.X), true, Result)
+				< ProjectedLines.Num())
+			{
+				// Only numerical error can fail here; keep the previous answer.
+				Result = PreviousResult;
+			}
+			Distance = Det(Line.Direction, Line.Point - Result);
+		}
+	}
+}
+
+UMassUnitAvoidanceProcessor::UMassUnitAvoidanceProcessor()
+	: EntityQuery(*this)
+{
+	bAutoRegisterWithProcessingPhases = true;
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::AllNetModes);
+	ExecutionOrder.ExecuteInGroup = FName(TEXT("MassUnitSystem.Avoidance"));
+	ExecutionOrder.ExecuteAfter.Add(FName(TEXT("MassUnitSystem.Crowd")));
+	ExecutionOrder.ExecuteBefore.Add(FName(TEXT("MassUnitSystem.Movement")));
+}
+
+void UMassUnitAvoidanceProcessor::ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager)
+{
+	EntityQuery.AddRequirement<FMassUnitTransformFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FMassUnitVelocityFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FMassUnitStateFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FMassUnitTargetFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FMassUnitNavigationFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FMassUnitCrowdFragment>(EMassFragmentAccess::ReadWrite);
+}
+
+void UMassUnitAvoidanceProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	PositionX.Reset();
+	PositionY.Reset();
+	VelocityX.Reset();
+	VelocityY.Reset();
+	PreferredVelocityX.Reset();
+	PreferredVelocityY.Reset();
+	MaxSpeeds.Reset();
+	Radii.Reset();
+	float LargestNeighborDistance = 0.0f;
+	TSharedPtr<const FMassUnitFlowFieldSnapshot, ESPMode::ThreadSafe> Fields;
+	if (UWorld* World = Context.GetWorld())
+	{
+		if (const UMassUnitSubsystem* UnitSubsystem = UMassUnitSubsystem::Get(World))
+		{
+			if (const UMassUnitFlowFieldSystem* FlowFieldSystem = UnitSubsystem->GetFlowFieldSystem())
+			{
+				Fields = FlowFieldSystem->GetSnapshot();
+			}
+		}
+	}
+	const FMassUnitFlowFieldSnapshot* FlowFields = Fields.Get();
+
+	// Serial snapshot. Preferred velocities use the same destination order as
+	// the movement processor, without advancing or clearing anything.
+	EntityQuery.ForEachEntityChunk(Context, [this, &LargestNeighborDistance, FlowFields](FMassExecutionContext& ChunkContext)
+	{
+		const TConstArrayView<FMassUnitTransformFragment> Transforms = ChunkContext.GetFragmentView<FMassUnitTransformFragment>();
+		const TConstArrayView<FMassUnitVelocityFragment> Velocities = ChunkContext.GetFragmentView<FMassUnitVelocityFragment>();
+		const TConstArrayView<FMassUnitStateFragment> States = ChunkContext.GetFragmentView<FMassUnitStateFragment>();
+		const TConstArrayView<FMassUnitTargetFragment> Targets = ChunkContext.GetFragmentView<FMassUnitTargetFragment>();
+		const TConstArrayView<FMassUnitNavigationFragment> Navigation = ChunkContext.GetFragmentView<FMassUnitNavigationFragment>();
+		TArrayView<FMassUnitCrowdFragment> Crowds = ChunkContext.GetMutableFragmentView<FMassUnitCrowdFragment>();
+
+		for (FMassExecutionContext::FEntityIterator It = ChunkContext.CreateEntityIterator(); It; ++It)
+		{
+			FMassUnitCrowdFragment& Crowd = Crowds[It];
+			Crowd.AvoidanceAgentIndex = INDEX_NONE;
+			if (!Crowd.bEnabled || !Crowd.bUseReciprocalAvoidance)
+			{
+				Crowd.bHasAvoidanceVelocity = false;
+				continue;
+			}
+
+			const FMassUnitStateFragment& State = States[It];
+			const FMassUnitTargetFragment& Target = Targets[It];
+			const FMassUnitNavigationFragment& Nav = Navigation[It];
+			const FVector Location = Transforms[It].GetTransform().GetLocation();
+			FVector2f PreferredVelocity = FVector2f::ZeroVector;
+			const bool bMovementSuppressed = Crowd.bSleeping
+				|| State.CurrentState == EMassUnitState::Interacting
+				|| State.CurrentState == EMassUnitState::Dead
+				|| State.CurrentState == EMassUnitState::Stunned;
+			if (!bMovementSuppressed && !Target.TargetEntity.IsValid())
+			{
+				bool bHasDestination = false;
+				FVector Destination = FVector::ZeroVector;
+				if (Nav.bPathValid)
+				{
+					int32 PathIndex = Nav.CurrentPathIndex;
+					while (Nav.PathPoints.IsValidIndex(PathIndex)
+						&& FVector::DistSquared2D(Location, Nav.PathPoints[PathIndex]) <= FMath::Square(Nav.AcceptanceRadius))
+					{
+						++PathIndex;
+					}
+					if (Nav.PathPoints.IsValidIndex(PathIndex))
+					{
+						Destination = Nav.PathPoints[PathIndex];
+						FVector FlowPoint;
+						if (FlowFields && Nav.FlowFieldHandle != INDEX_NONE
+							&& FlowFields->SampleSteeringPoint(Nav.FlowFieldHandle, Location, FlowPoint))
+						{
+							Destination = FlowPoint;
+						}
+						bHasDestination = true;
+					}
+				}
+				if (!bHasDestination && Target.bHasTargetLocation)
+				{
+					Destination = Target.TargetLocation;
+					bHasDestination = true;
+				}
+				const FVector2f ToDestination(FVector2D(Destination - Location));
+				if (bHasDestination && ToDestination.SizeSquared() > FMath::Square(Nav.AcceptanceRadius))
+				{
+					PreferredVelocity = ToDestination.GetSafeNormal() * State.MoveSpeed;
+				}
+			}
+
+			Crowd.AvoidanceAgentIndex = PositionX.Num();
+			PositionX.Add(static_cast<float>(Location.X));
+			PositionY.Add(static_cast<float>(Location.Y));
+			VelocityX.Add(static_cast<float>(Velocities[It].Value.X));
+			VelocityY.Add(static_cast<float>(Velocities[It].Value.Y));
+			PreferredVelocityX.Add(PreferredVelocity.X);
+			PreferredVelocityY.Add(PreferredVelocity.Y);
+			MaxSpeeds.Add(FMath::Max(0.0f, State.MoveSpeed));
+			Radii.Add(Crowd.AvoidanceAgentRadius);
+			LargestNeighborDistance = FMath::Max(LargestNeighborDistance, Crowd.AvoidanceNeighborDistance);
+		}
+	});
+	if (PositionX.IsEmpty())
+	{
+		return;
+	}
+
+	CellSize = FMath::Max(1.0f, LargestNeighborDistance);
+	SortAgentsByCell();
+
+	const float DeltaTime = FMath::Max(Context.GetDeltaTimeSeconds(), UE_KINDA_SMALL_NUMBER);
+	EntityQuery.ParallelForEachEntityChunk(Context, [this, DeltaTime](FMassExecutionContext& ChunkContext)
+	{
+		TArrayView<FMassUnitCrowdFragment> Crowds = ChunkContext.GetMutableFragmentView<FMassUnitCrowdFragment>();
+		const float InverseCellSize = 1.0f / CellSize;
+
+		for (FMassExecutionContext::FEntityIterator It = ChunkContext.CreateEntityIterator(); It; ++It)
+		{
+			FMassUnitCrowdFragment& Crowd = Crowds[It];
+			if (Crowd.AvoidanceAgentIndex == INDEX_NONE)
+			{
+				continue;
+			}
+			const int32 Agent = SortedSlotByAgent[Crowd.AvoidanceAgentIndex];
+			const FVector2f PreferredVelocity(PreferredVelocityX[Agent], PreferredVelocityY[Agent]);
+			if (PreferredVelocity.IsNearlyZero())
+			{
+				Crowd.bHasAvoidanceVelocity = false;
+				continue;
+			}
+
+			const float X = PositionX[Agent];
+			const float Y = PositionY[Agent];
+			const float NeighborDistanceSquared = FMath::Square(Crowd.AvoidanceNeighborDistance);
+			const int32 NeighborLimit = FMath::Clamp(Crowd.MaxAvoidanceNeighbors, 1, MaxAvoidanceNeighbors);
+
+			// Bounded nearest-neighbor set kept sorted by distance.
+			int32 NeighborSlots[MaxAvoidanceNeighbors];
+			float NeighborDistances[MaxAvoidanceNeighbors];
+			int32 NeighborCount = 0;
+			const int32 CellX = FMath::FloorToInt(X * InverseCellSize);
+			const int32 CellY = FMath::FloorToInt(Y * InverseCellSize);
+			for (int32 OffsetX = -1; OffsetX <= 1; ++OffsetX)
+			{
+				for (int32 OffsetY = -1; OffsetY <= 1; ++OffsetY)
+				{
+					const FCellRange* Range = Cells.Find(FIntPoint(CellX + OffsetX, CellY + OffsetY));
+					if (!Range)
+					{
+						continue;
+					}
+					const float* RESTRICT CellX0 = PositionX.GetData() + Range->Start;
+					const float* RESTRICT CellY0 = PositionY.GetData() + Range->Start;
+					for (int32 Offset = 0; Offset < Range->Num; ++Offset)
+					{
+						const float DX = CellX0[Offset] - X;
+						const float DY = CellY0[Offset] - Y;
+						const float DistanceSquared = DX * DX + DY * DY;
+						const int32 Candidate = Range->Start + Offset;
+						if (Candidate == Agent || DistanceSquared > NeighborDistanceSquared
+							|| (NeighborCount == NeighborLimit && DistanceSquared >= NeighborDistances[NeighborCount - 1]))
+						{
+							continue;
+						}
+						int32 Insert = FMath::Min(NeighborCount, NeighborLimit - 1);
+						while (Insert > 0 && NeighborDistances[Insert - 1] > DistanceSquared)
+						{
+							NeighborSlots[Insert] = NeighborSlots[Insert - 1];
+							NeighborDistances[Insert] = NeighborDistances[Insert - 1];
+							--Insert;
+						}
+						NeighborSlots[Insert] = Candidate;
+						NeighborDistances[Insert] = DistanceSquared;
+						NeighborCount = FMath::Min(NeighborCount + 1, NeighborLimit);
+					}
+				}
+			}
+
+			const FVector2f Position(X, Y);
+			const FVector2f Velocity(VelocityX[Agent], VelocityY[Agent]);
+			const float InverseTimeHorizon = 1.0f / FMath::Max(0.1f, Crowd.AvoidanceTimeHorizon);
+			FOrcaLines Lines;
+			for (int32 NeighborIndex = 0; NeighborIndex < NeighborCount; ++NeighborIndex)
+			{
+				const int32 Other = NeighborSlots[NeighborIndex];
+				const FVector2f RelativePosition = FVector2f(PositionX[Other], PositionY[Other]) - Position;
+				const FVector2f RelativeVelocity = Velocity - FVector2f(VelocityX[Other], VelocityY[Other]);
+				const float DistanceSquared = NeighborDistances[NeighborIndex];
+				const float CombinedRadius = Radii[Agent] + Radii[Other];
+				const float CombinedRadiusSquared = FMath::Square(CombinedRadius);
+
+				FOrcaLine Line;
+				FVector2f U;
+				if (DistanceSquared > CombinedRadiusSquared)
+				{
+					// Vector from the cutoff center of the velocity obstacle to the relative velocity.
+					const FVector2f W = RelativeVelocity - RelativePosition * InverseTimeHorizon;
+					const float WLengthSquared = W.SizeSquared();
+					const float DotProduct = W | RelativePosition;
+					if (DotProduct < 0.0f && FMath::Square(DotProduct) > CombinedRadiusSquared * WLengthSquared)
+					{
+						// Project onto the cutoff circle.
+						const float WLength = FMath::Sqrt(WLengthSquared);
+						const FVector2f UnitW = W / WLength;
+						Line.Direction = FVector2f(UnitW.Y, -UnitW.X);
+						U = UnitW * (CombinedRadius * InverseTimeHorizon - WLength);
+					}
+					else
+					{
+						// Project onto the nearer leg of the cone.
+						const float Leg = FMath::Sqrt(DistanceSquared - CombinedRadiusSquared);
+						if (Det(RelativePosition, W) > 0.0f)
+						{
+							Line.Direction = FVector2f(
+								RelativePosition.X * Leg - RelativePosition.Y * CombinedRadius,
+								RelativePosition.X * CombinedRadius + RelativePosition.Y * Leg) / DistanceSquared;
+						}
+						else
+						{
+							Line.Direction = -FVector2f(
+								RelativePosition.X * Leg + RelativePosition.Y * CombinedRadius,
+								-RelativePosition.X * CombinedRadius + RelativePosition.Y * Leg) / DistanceSquared;
+						}
+						U = Line.Direction * (RelativeVelocity | Line.Direction) - RelativeVelocity;
+					}
+				}
+				else
+				{
+					// Already overlapping: resolve within one frame.
+					const FVector2f W = RelativeVelocity - RelativePosition / DeltaTime;
+					const float WLength = W.Size();
+					if (WLength <= UE_KINDA_SMALL_NUMBER)
+					{
+						continue;
+					}
+					const FVector2f UnitW = W / WLength;
+					Line.Direction = FVector2f(UnitW.Y, -UnitW.X);
+					U = UnitW * (CombinedRadius / DeltaTime - WLength);
+				}
+				// Each agent takes half of the responsibility for avoiding the other.
+				Line.Point = Velocity + U * 0.5f;
+				Lines.Add(Line);
+			}
+
+			const float MaxSpeed = MaxSpeeds[Agent];
+			FVector2f NewVelocity = FVector2f::ZeroVector;
+			const int32 FailedLine = SolvePlanes(Lines, MaxSpeed, PreferredVelocity, false, NewVelocity);
+			if (FailedLine < Lines.Num())
+			{
+				SolveLeastPenetration(Lines, FailedLine, MaxSpeed, NewVelocity);
+			}
+			Crowd.AvoidanceVelocity = FVector(NewVelocity.X, NewVelocity.Y, 0.0f);
+			Crowd.bHasAvoidanceVelocity = true;
+		}
+	});
+}
+
+void UMassUnitAvoidanceProcessor::SortAgentsByCell()
+{
+	const int32 AgentCount = PositionX.Num();
+	const float InverseCellSize = 1.0f / CellSize;
+	TArray<TPair<FIntPoint, int32>> Order;
+	Order.Reserve(AgentCount);
+	for (int32 Agent = 0; Agent < AgentCount; ++Agent)
+	{
+		Order.Emplace(
+			FIntPoint(FMath::FloorToInt(PositionX[Agent] * InverseCellSize), FMath::FloorToInt(PositionY[Agent] * InverseCellSize)),
+			Agent);
+	}
+	Order.Sort([](const TPair<FIntPoint, int32>& A, const TPair<FIntPoint, int32>& B)
+	{
+		return A.Key.X != B.Key.X ? A.Key.X < B.Key.X : (A.Key.Y != B.Key.Y ? A.Key.Y < B.Key.Y : A.Value < B.Value);
+	});
+
+	auto Permute = [&Order, AgentCount](TArray<float>& Values)
+	{
+		TArray<float> Sorted;
+		Sorted.SetNumUninitialized(AgentCount);
+		for (int32 Slot = 0; Slot < AgentCount; ++Slot)
+		{
+			Sorted[Slot] = Values[Order[Slot].Value];
+		}
+		Values = MoveTemp(Sorted);
+	};
+	Permute(PositionX);
+	Permute(PositionY);
+	Permute(VelocityX);
+	Permute(VelocityY);
+	Permute(PreferredVelocityX);
+	Permute(PreferredVelocityY);
+	Permute(MaxSpeeds);
+	Permute(Radii);
+
+	SortedSlotByAgent.SetNumUninitialized(AgentCount);
+	Cells.Reset();
+	for (int32 Slot = 0; Slot < AgentCount; ++Slot)
+	{
+		SortedSlotByAgent[Order[Slot].Value] = Slot;
+		FCellRange& Range = Cells.FindOrAdd(Order[Slot].Key);
+		if (Range.Num == 0)
+		{
+			Range.Start = Slot;
+		}
+		++Range.Num;
+	}
+}
@@ -0,0 +1,109 @@
+// Copyright Digi Logic Labs LLC. All Rights Reserved.
+
+#include "Entity/MassUnitCrowdProcessor.h"
+
+#include "Core/MassUnitSubsystem.h"
+#include "Entity/MassUnitFragments.h"
+#include "Gameplay/MassUnitCrowdSystem.h"
+#include "MassEntityManager.h"
+#include "MassExecutionContext.h"
+#include "MassUnitCommonFragments.h"
+
+UMassUnitCrowdProcessor::UMassUnitCrowdProcessor()
+	: EntityQuery(*this)
+{
+	bAutoRegisterWithProcessingPhases = true;
+	// Applying decisions issues navigation requests. Gameplay events are queued for UMassUnitSubsystem::Tick.
+	bRequiresGameThreadExecution = true;
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::AllNetModes);
+	ExecutionOrder.ExecuteInGroup = FName(TEXT("MassUnitSystem.Crowd"));
+	ExecutionOrder.ExecuteBefore.Add(FName(TEXT("MassUnitSystem.Movement")));
+}
+
+void UMassUnitCrowdProcessor::ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager)
+{
+	EntityQuery.AddRequirement<FMassUnitTransformFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FMassUnitCrowdFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddRequirement<FMassUnitStateFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FMassUnitTargetFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FMassUnitNavigationFragment>(EMassFragmentAccess::ReadOnly);
+}
+
+void UMassUnitCrowdProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	UMassUnitCrowdSystem* CrowdSystem = nullptr;
+	if (UWorld* World = Context.GetWorld())
+	{
+		if (UMassUnitSubsystem* UnitSubsystem = UMassUnitSubsystem::Get(World))
+		{
+			CrowdSystem = UnitSubsystem->GetCrowdSystem();
+		}
+	}
+	if (!CrowdSystem || !CrowdSystem->AdvanceUpdateClock(Context.GetDeltaTimeSeconds()))
+	{
+		return;
+	}
+
+	EntityQuery.ForEachEntityChunk(Context, [CrowdSystem](FMassExecutionContext& ChunkContext)
+	{
+		const TConstArrayView<FMassUnitTransformFragment> Transforms = ChunkContext.GetFragmentView<FMassUnitTransformFragment>();
+		const TConstArrayView<FMassUnitCrowdFragment> Crowds = ChunkContext.GetFragmentView<FMassUnitCrowdFragment>();
+		const TConstArrayView<FMassUnitStateFragment> States = ChunkContext.GetFragmentView<FMassUnitStateFragment>();
+
+		for (FMassExecutionContext::FEntityIterator It = ChunkContext.CreateEntityIterator(); It; ++It)
+		{
+			// Sleeping units are parked in the dormant grid and need no location refresh.
+			if (Crowds[It].bEnabled && !Crowds[It].bSleeping)
+			{
+				CrowdSystem->SyncUnitLocation(
+					FMassUnitEntityHandle(ChunkContext.GetEntity(It)),
+					Transforms[It].GetTransform().GetLocation(),
+					States[It].CurrentState != EMassUnitState::Dead);
+			}
+		}
+	});
+	if (!CrowdSystem->BeginCrowdUpdate())
+	{
+		return;
+	}
+
+	// Waking happens in BeginCrowdUpdate, so sleep flags are read after it.
+	int32 ChunkOrdinal = 0;
+	EntityQuery.ForEachEntityChunk(Context, [CrowdSystem, &ChunkOrdinal](FMassExecutionContext& ChunkContext)
+	{
+		const TConstArrayView<FMassUnitCrowdFragment> Crowds = ChunkContext.GetFragmentView<FMassUnitCrowdFragment>();
+		const TConstArrayView<FMassUnitStateFragment> States = ChunkContext.GetFragmentView<FMassUnitStateFragment>();
+		const TConstArrayView<FMassUnitTargetFragment> Targets = ChunkContext.GetFragmentView<FMassUnitTargetFragment>();
+		const TConstArrayView<FMassUnitNavigationFragment> Navigations = ChunkContext.GetFragmentView<FMassUnitNavigationFragment>();
+
+		for (FMassExecutionContext::FEntityIterator It = ChunkContext.CreateEntityIterator(); It; ++It)
+		{
+			if (Crowds[It].bEnabled && !Crowds[It].bSleeping)
+			{
+				CrowdSystem->ScheduleUnit(
+					FMassUnitEntityHandle(ChunkContext.GetEntity(It)),
+					Crowds[It],
+					States[It],
+					Targets[It],
+					Navigations[It],
+					ChunkOrdinal,
+					It);
+			}
+		}
+		++ChunkOrdinal;
+	});
+	CrowdSystem->DecideScheduledUnits();
+
+	if (CrowdSystem->HasPendingSteeringWrites())
+	{
+		ChunkOrdinal = 0;
+		EntityQuery.ForEachEntityChunk(Context, [CrowdSystem, &ChunkOrdinal](FMassExecutionContext& ChunkContext)
+		{
+			CrowdSystem->WriteChunkSteering(
+				ChunkOrdinal++,
+				ChunkContext.GetEntities(),
+				ChunkContext.GetMutableFragmentView<FMassUnitCrowdFragment>());
+		});
+	}
+	CrowdSystem->FinishCrowdUpdate();
+}
@@ -11,6 +11,7 @@
 #include "Engine/Texture2D.h"
 #include "Engine/World.h"
 #include "GameFramework/Actor.h"
+#include "Materials/MaterialInterface.h"
 #include "MassEntityManager.h"
 #include "MassEntitySubsystem.h"
 #include "MassEntityView.h"
@@ -31,6 +32,9 @@ void UMassUnitEntityManager::Deinitialize()
 	AllUnits.Reset();
 	UnitTypeMap.Reset();
 	TeamMap.Reset();
+	RenderSlotOwners.Reset();
+	FreeRenderSlots.Reset();
+	RemovedUnits.Reset();
 	UnitArchetype = FMassArchetypeHandle();
 	RuntimeDefaultTemplate = nullptr;
 	EntitySubsystem = nullptr;
@@ -111,6 +115,24 @@ FMassUnitEntityHandle UMassUnitEntityManager::CreateUnitFromTemplateInternal(UUn
 	Visual.DeathAnimation = Template->DeathAnimation.LoadSynchronous();
 	Visual.StunAnimation = Template->StunAnimation.LoadSynchronous();
 	Visual.StaticMesh = Template->StaticMesh.LoadSynchronous();
+	Visual.StaticMeshLODs.Reset();
+	Visual.NoShadowLODMask = 0;
+	for (int32 LODIndex = 0; LODIndex < FMath::Min(Template->StaticMeshLODs.Num(), 32); ++LODIndex)
+	{
+		const FUnitTemplateMeshLOD& MeshLOD = Template->StaticMeshLODs[LODIndex];
+		Visual.StaticMeshLODs.Add(MeshLOD.Mesh.LoadSynchronous());
+		Visual.NoShadowLODMask |= MeshLOD.bCastShadow ? 0u : 1u << LODIndex;
+	}
+	Visual.ImpostorMaterial = Visual.StaticMesh ? Template->ImpostorMaterial.LoadSynchronous() : nullptr;
+	Visual.ImpostorCenter = FVector::ZeroVector;
+	Visual.ImpostorSize = 0.0f;
+	if (Visual.ImpostorMaterial)
+	{
+		// The commandlet captures an orthographic view as wide as the bounding sphere around its origin.
+		const FBoxSphereBounds Bounds = Visual.StaticMesh->GetBounds();
+		Visual.ImpostorCenter = Bounds.Origin;
+		Visual.ImpostorSize = 2.0f * Bounds.SphereRadius;
+	}
 	Visual.VertexAnimationTexture = Template->VertexAnimationTexture.LoadSynchronous();
 	Visual.NormalMapTexture = Template->NormalMapTexture.LoadSynchronous();
 	Visual.AnimationTags = Template->AnimationTags;
@@ -118,12 +140,14 @@ FMassUnitEntityHandle UMassUnitEntityManager::CreateUnitFromTemplateInternal(UUn
 	Visual.TargetAnimation = Visual.CurrentAnimation;
 	Visual.bUseSkeletalMesh = false;
 	Visual.bWantsSkeletalMesh = false;
+	Visual.bUseImpostor = false;
 	Visual.bIsVisible = true;
 
 	FMassUnitFormationFragment& Formation = EntityView.GetFragmentData<FMassUnitFormationFragment>();
 	Formation.DefaultFormation = Template->DefaultFormation;
 
 	const FMassUnitEntityHandle Handle(NativeHandle);
+	EntityView.GetFragmentData<FMassUnitRenderSlotFragment>().Slot = AllocateRenderSlot(Handle);
 	AllUnits.Add(Handle);
 	UnitTypeMap.FindOrAdd(State.UnitType).Add(Handle);
 	TeamMap.FindOrAdd(Team.TeamID).Add(Handle);
@@ -177,7 +201,12 @@ void UMassUnitEntityManager::DestroyUnitInternal(FMassUnitEntityHandle EntityHan
 		}
 	}
 
+	if (const FMassUnitRenderSlotFragment* RenderSlot = EntityManager.GetFragmentDataPtr<FMassUnitRenderSlotFragment>(NativeHandle))
+	{
+		ReleaseRenderSlot(EntityHandle, RenderSlot->Slot);
+	}
 	AllUnits.Remove(EntityHandle);
+	RemovedUnits.Add(EntityHandle);
 	EntityManager.DestroyEntity(NativeHandle);
 	UE_LOG(LogMassUnitSystem, Verbose, TEXT("Destroyed %s"), *EntityHandle.ToString());
 }
@@ -316,6 +345,7 @@ bool UMassUnitEntityManager::SetUnitDestination(FMassUnitHandle UnitHandle, cons
 	Navigation->DestinationLocation = Destination;
 	Navigation->PathPoints = {Destination};
 	Navigation->CurrentPathIndex = 0;
+	Navigation->FlowFieldHandle = INDEX_NONE;
 	Navigation->AcceptanceRadius = FMath::Max(1.0f, AcceptanceRadius);
 	Navigation->bPathRequested = false;
 	Navigation->bPathValid = true;
@@ -352,6 +382,8 @@ void UMassUnitEntityManager::PruneInvalidUnits()
 		AllUnits.Reset();
 		UnitTypeMap.Reset();
 		TeamMap.Reset();
+		RenderSlotOwners.Reset();
+		FreeRenderSlots.Reset();
 		return;
 	}
 
@@ -372,7 +404,12 @@ void UMassUnitEntityManager::PruneInvalidUnits()
 
 void UMassUnitEntityManager::RemoveHandleFromIndexes(FMassUnitEntityHandle EntityHandle)
 {
-	AllUnits.Remove(EntityHandle);
+	// The entity is already gone, so its slot fragment cannot be read.
+	ReleaseRenderSlot(EntityHandle, RenderSlotOwners.IndexOfByKey(EntityHandle));
+	if (AllUnits.Remove(EntityHandle) > 0)
+	{
+		RemovedUnits.Add(EntityHandle);
+	}
 	for (auto It = UnitTypeMap.CreateIterator(); It; ++It)
 	{
 		It.Value().Remove(EntityHandle);
@@ -391,6 +428,28 @@ void UMassUnitEntityManager::RemoveHandleFromIndexes(FMassUnitEntityHandle Entit
 	}
 }
 
+int32 UMassUnitEntityManager::AllocateRenderSlot(FMassUnitEntityHandle EntityHandle)
+{
+	if (FreeRenderSlots.IsEmpty())
+	{
+		return RenderSlotOwners.Add(EntityHandle);
+	}
+	const int32 Slot = FreeRenderSlots.Pop(EAllowShrinking::No);
+	RenderSlotOwners[Slot] = EntityHandle;
+	return Slot;
+}
+
+void UMassUnitEntityManager::ReleaseRenderSlot(FMassUnitEntityHandle EntityHandle, int32 Slot)
+{
+	if (!RenderSlotOwners.IsValidIndex(Slot) || RenderSlotOwners[Slot] != EntityHandle)
+	{
+		return;
+	}
+	RenderSlotOwners[Slot].Invalidate();
+	FreeRenderSlots.Add(Slot);
+	++RenderSlotReleaseCount;
+}
+
 bool UMassUnitEntityManager::ClearUnitTarget(FMassUnitHandle UnitHandle)
 {
 	if (!IsUnitValid(UnitHandle))
@@ -3,10 +3,13 @@
 #include "Entity/MassUnitMovementProcessor.h"
 
 #include "Core/MassUnitGameplayTags.h"
+#include "Core/MassUnitSubsystem.h"
 #include "Entity/MassUnitFragments.h"
 #include "MassEntityManager.h"
 #include "MassExecutionContext.h"
 #include "MassUnitCommonFragments.h"
+#include "Navigation/MassUnitFlowFieldSystem.h"
+#include "Navigation/MassUnitHeightFieldSystem.h"
 
 UMassUnitMovementProcessor::UMassUnitMovementProcessor()
 	: EntityQuery(*this)
@@ -36,7 +39,32 @@ void UMassUnitMovementProcessor::ConfigureQueries(const TSharedRef<FMassEntityMa
 void UMassUnitMovementProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
 {
 	const float DeltaTime = FMath::Min(Context.GetDeltaTimeSeconds(), 0.1f);
-	EntityQuery.ForEachEntityChunk(Context, [this, &EntityManager, DeltaTime](FMassExecutionContext& ChunkContext)
+	UMassUnitHeightFieldSystem* HeightField = nullptr;
+	TSharedPtr<const FMassUnitHeightFieldSnapshot, ESPMode::ThreadSafe> Heights;
+	TSharedPtr<const FMassUnitFlowFieldSnapshot, ESPMode::ThreadSafe> Fields;
+	if (UWorld* World = Context.GetWorld())
+	{
+		if (const UMassUnitSubsystem* UnitSubsystem = UMassUnitSubsystem::Get(World))
+		{
+			HeightField = UnitSubsystem->GetHeightFieldSystem();
+			if (const UMassUnitFlowFieldSystem* FlowFieldSystem = UnitSubsystem->GetFlowFieldSystem())
+			{
+				Fields = FlowFieldSystem->GetSnapshot();
+			}
+		}
+	}
+	// This pass may run off the game thread, so it reads one immutable
+	// snapshot of each cache and only reports the height tiles it used or
+	// missed; the game thread builds missing tiles for a later frame.
+	TSet<FIntVector> UsedHeightTiles;
+	TSet<FIntVector> MissingHeightTiles;
+	if (HeightField)
+	{
+		Heights = HeightField->GetSnapshot();
+	}
+	const FMassUnitHeightFieldSnapshot* HeightSnapshot = Heights.Get();
+	const FMassUnitFlowFieldSnapshot* FlowFields = Fields.Get();
+	EntityQuery.ForEachEntityChunk(Context, [this, &EntityManager, DeltaTime, FlowFields, HeightSnapshot, &UsedHeightTiles, &MissingHeightTiles](FMassExecutionContext& ChunkContext)
 	{
 		TArrayView<FMassUnitTransformFragment> Transforms = ChunkContext.GetMutableFragmentView<FMassUnitTransformFragment>();
 		TArrayView<FMassUnitVelocityFragment> Velocities = ChunkContext.GetMutableFragmentView<FMassUnitVelocityFragment>();
@@ -74,11 +102,21 @@ void UMassUnitMovementProcessor::Execute(FMassEntityManager& EntityManager, FMas
 
 			const FVector CurrentLocation = Transform.GetTransform().GetLocation();
 			const bool bUse3DMovement = Crowd && Crowd->bEnabled && Crowd->bUse3DMovement;
-			const bool bFollowNavmeshHeight = Crowd
+			const bool bConformHeight = Crowd
 				&& Crowd->bEnabled
 				&& !bUse3DMovement
-				&& Crowd->bConformToNavmeshHeight
-				&& Nav.bPathUsesNavmesh;
+				&& Crowd->bConformToNavmeshHeight;
+			// Cached ground heights cover every destination kind; navmesh path
+			// heights remain the fallback where the field has no data yet.
+			const FVector HeightOffset(0.0f, 0.0f, bConformHeight ? Crowd->NavigationHeightOffset : 0.0f);
+			float GroundHeight = 0.0f;
+			bool bUseHeightField = false;
+			if (bConformHeight && HeightSnapshot && !Crowd->bSleeping)
+			{
+				UsedHeightTiles.Add(HeightSnapshot->ToTileKey(CurrentLocation - HeightOffset));
+				bUseHeightField = HeightSnapshot->SampleHeight(CurrentLocation - HeightOffset, GroundHeight, &MissingHeightTiles);
+			}
+			const bool bFollowNavmeshHeight = bConformHeight && !bUseHeightField && Nav.bPathUsesNavmesh;
 			auto AdjustNavigationHeight = [Crowd, bFollowNavmeshHeight](FVector Point)
 			{
 				if (bFollowNavmeshHeight)
@@ -123,11 +161,19 @@ void UMassUnitMovementProcessor::Execute(FMassEntityManager& EntityManager, FMas
 				if (Nav.PathPoints.IsValidIndex(Nav.CurrentPathIndex))
 				{
 					Destination = AdjustNavigationHeight(Nav.PathPoints[Nav.CurrentPathIndex]);
+					FVector FlowPoint;
+					if (FlowFields && !bUse3DMovement && Nav.FlowFieldHandle != INDEX_NONE
+						&& FlowFields->SampleSteeringPoint(Nav.FlowFieldHandle, CurrentLocation, FlowPoint))
+					{
+						// Flow fields route around obstacles; the path point stays the arrival test.
+						Destination = AdjustNavigationHeight(FlowPoint);
+					}
 					bHasDestination = true;
 				}
 				else
 				{
 					Nav.bPathValid = false;
+					Nav.FlowFieldHandle = INDEX_NONE;
 				}
 			}
 
@@ -148,13 +194,24 @@ void UMassUnitMovementProcessor::Execute(FMassEntityManager& EntityManager, FMas
 				if (DistanceSquared > FMath::Square(StopDistance))
 				{
 					FVector DesiredDirection = bUseVerticalMovement ? ToDestination.GetSafeNormal() : ToDestination.GetSafeNormal2D();
-					if (Crowd && Crowd->bEnabled && !Crowd->SteeringDirection.IsNearlyZero())
+					if (Crowd && Crowd->bEnabled && Crowd->bHasAvoidanceVelocity && !Target.TargetEntity.IsValid())
+					{
+						// The avoidance processor already solved a collision-free planar velocity toward this destination.
+						DesiredVelocity = FVector(
+							Crowd->AvoidanceVelocity.X,
+							Crowd->AvoidanceVelocity.Y,
+							bUseVerticalMovement ? DesiredDirection.Z * State.MoveSpeed : 0.0f);
+					}
+					else
 					{
-						DesiredDirection = bUseVerticalMovement
-							? (DesiredDirection + Crowd->SteeringDirection).GetSafeNormal()
-							: (DesiredDirection + Crowd->SteeringDirection).GetSafeNormal2D();
+						if (Crowd && Crowd->bEnabled && !Crowd->SteeringDirection.IsNearlyZero())
+						{
+							DesiredDirection = bUseVerticalMovement
+								? (DesiredDirection + Crowd->SteeringDirection).GetSafeNormal()
+								: (DesiredDirection + Crowd->SteeringDirection).GetSafeNormal2D();
+						}
+						DesiredVelocity = DesiredDirection * State.MoveSpeed;
 					}
-					DesiredVelocity = DesiredDirection * State.MoveSpeed;
 				}
 			}
 
@@ -167,6 +224,13 @@ void UMassUnitMovementProcessor::Execute(FMassEntityManager& EntityManager, FMas
 			{
 				FTransform& MutableTransform = Transform.GetMutableTransform();
 				MutableTransform.AddToTranslation(Velocity.Value * DeltaTime);
+				if (bUseHeightField)
+				{
+					FVector NewLocation = MutableTransform.GetLocation();
+					HeightSnapshot->SampleHeight(NewLocation - HeightOffset, GroundHeight, &MissingHeightTiles);
+					NewLocation.Z = GroundHeight + HeightOffset.Z;
+					MutableTransform.SetLocation(NewLocation);
+				}
 				const FRotator VelocityRotation = Velocity.Value.Rotation();
 				const FRotator DesiredRotation = bUse3DMovement
 					? VelocityRotation
@@ -191,4 +255,8 @@ void UMassUnitMovementProcessor::Execute(FMassEntityManager& EntityManager, FMas
 			}
 		}
 	});
+	if (HeightField)
+	{
+		HeightField->ReportTileUse(UsedHeightTiles, MissingHeightTiles);
+	}
 }
@@ -8,6 +8,7 @@
 #include "Core/MassUnitSystemRuntime.h"
 #include "DrawDebugHelpers.h"
 #include "Entity/UnitTemplate.h"
+#include "Navigation/MassUnitFlowFieldSystem.h"
 #include "Navigation/MassUnitNavigationSystem.h"
 
 AMassUnitSpawner::AMassUnitSpawner()
@@ -152,6 +153,20 @@ int32 AMassUnitSpawner::CommandSpawnedUnitsToLocation(FVector DestinationCenter,
 	}
 	CurrentCenter /= static_cast<float>(UnitLocations.Num());
 
+	// A shared destination needs one flow field instead of one path query per unit.
+	UMassUnitFlowFieldSystem* FlowFieldSystem = UnitSubsystem->GetFlowFieldSystem();
+	if (bUseNavigation && !bPreserveSpacing && FlowFieldSystem && UnitLocations.Num() > 1)
+	{
+		TArray<FMassUnitEntityHandle> Entities;
+		Entities.Reserve(UnitLocations.Num());
+		for (const FUnitLocation& Unit : UnitLocations)
+		{
+			Entities.Add(Unit.Handle.EntityHandle);
+			DrawCommandDebug(Unit.Location, DestinationCenter);
+		}
+		return FlowFieldSystem->MoveUnitsToLocationInternal(Entities, DestinationCenter, AcceptanceRadius);
+	}
+
 	int32 CommandedCount = 0;
 	for (const FUnitLocation& Unit : UnitLocations)
 	{
@@ -60,12 +60,13 @@ void UMassUnitVisibilityProcessor::Execute(FMassEntityManager& EntityManager, FM
 	{
 		UpdateIntervals.Add(0.1f);
 	}
+	const float LODHysteresis = Settings ? FMath::Max(1.0f, Settings->LODDistanceHysteresis) : 1.1f;
 	const float SkeletalDistance = Settings ? Settings->SkeletalMeshDistance : 300.0f;
 	const float SkeletalHysteresis = Settings ? FMath::Max(1.0f, Settings->SkeletalMeshHysteresis) : 1.2f;
 	const float MaxVisibleDistance = Settings ? Settings->MaxVisibleDistance : 10000.0f;
 	const float CurrentTime = World->GetTimeSeconds();
 
-	EntityQuery.ForEachEntityChunk(Context, [ViewLocations, Thresholds, UpdateIntervals, SkeletalDistance, SkeletalHysteresis, MaxVisibleDistance, CurrentTime](FMassExecutionContext& ChunkContext)
+	EntityQuery.ForEachEntityChunk(Context, [ViewLocations, Thresholds, UpdateIntervals, LODHysteresis, SkeletalDistance, SkeletalHysteresis, MaxVisibleDistance, CurrentTime](FMassExecutionContext& ChunkContext)
 	{
 		const TConstArrayView<FMassUnitTransformFragment> Transforms = ChunkContext.GetFragmentView<FMassUnitTransformFragment>();
 		TArrayView<FMassUnitVisualFragment> Visuals = ChunkContext.GetMutableFragmentView<FMassUnitVisualFragment>();
@@ -87,17 +88,20 @@ void UMassUnitVisibilityProcessor::Execute(FMassEntityManager& EntityManager, FM
 					DistanceSquared,
 					FVector::DistSquared(Transforms[It].GetTransform().GetLocation(), ViewLocation));
 			}
+			// Thresholds at or beyond the current LOD are widened, so moving outward needs the extra margin
+			// while moving inward switches at the plain threshold.
+			FMassUnitVisualFragment& Visual = Visuals[It];
 			int32 LODLevel = Thresholds.Num();
 			for (int32 Index = 0; Index < Thresholds.Num(); ++Index)
 			{
-				if (DistanceSquared <= FMath::Square(FMath::Max(0.0f, Thresholds[Index])))
+				const float Threshold = FMath::Max(0.0f, Thresholds[Index]) * (Index >= Visual.LODLevel ? LODHysteresis : 1.0f);
+				if (DistanceSquared <= FMath::Square(Threshold))
 				{
 					LODLevel = Index;
 					break;
 				}
 			}
 
-			FMassUnitVisualFragment& Visual = Visuals[It];
 			Visual.ViewerDistanceSquared = DistanceSquared;
 			Visual.LODLevel = LODLevel;
 			Visual.bIsVisible = MaxVisibleDistance <= 0.0f || DistanceSquared <= FMath::Square(MaxVisibleDistance);
@@ -106,6 +110,8 @@ void UMassUnitVisibilityProcessor::Execute(FMassEntityManager& EntityManager, FM
 				: SkeletalDistance;
 			Visual.bWantsSkeletalMesh = Visual.bIsVisible && Visual.SkeletalMesh != nullptr
 				&& DistanceSquared <= FMath::Square(SkeletalThreshold);
+			Visual.bUseImpostor = !Thresholds.IsEmpty() && LODLevel >= Thresholds.Num()
+				&& Visual.ImpostorMaterial != nullptr && Visual.ImpostorSize > 0.0f;
 			LOD.Level = LODLevel;
 			const int32 IntervalIndex = FMath::Clamp(LODLevel, 0, UpdateIntervals.Num() - 1);
 			const float BaseInterval = UpdateIntervals.IsValidIndex(IntervalIndex)
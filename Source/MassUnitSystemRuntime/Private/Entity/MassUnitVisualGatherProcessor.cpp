@@ -0,0 +1,71 @@
+// Copyright Digi Logic Labs LLC. All Rights Reserved.
+
+#include "Entity/MassUnitVisualGatherProcessor.h"
+
+#include "Core/MassUnitSubsystem.h"
+#include "Entity/MassUnitFragments.h"
+#include "HAL/PlatformTime.h"
+#include "MassEntityManager.h"
+#include "MassExecutionContext.h"
+#include "MassUnitCommonFragments.h"
+#include "Visual/NiagaraUnitSystem.h"
+
+UMassUnitVisualGatherProcessor::UMassUnitVisualGatherProcessor()
+	: EntityQuery(*this)
+{
+	bAutoRegisterWithProcessingPhases = true;
+	// Slot buffers are resized and uploaded by the game-thread representation; chunks still fan out to workers.
+	bRequiresGameThreadExecution = true;
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::AllNetModes);
+	ExecutionOrder.ExecuteInGroup = FName(TEXT("MassUnitSystem.Representation"));
+	ExecutionOrder.ExecuteAfter.Add(FName(TEXT("MassUnitSystem.Visibility")));
+}
+
+void UMassUnitVisualGatherProcessor::ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager)
+{
+	EntityQuery.AddRequirement<FMassUnitTransformFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FMassUnitVelocityFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FMassUnitVisualFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FMassUnitTeamFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FMassUnitStateFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FMassUnitRenderSlotFragment>(EMassFragmentAccess::ReadOnly);
+}
+
+void UMassUnitVisualGatherProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	UNiagaraUnitSystem* NiagaraSystem = nullptr;
+	if (UWorld* World = Context.GetWorld())
+	{
+		if (UMassUnitSubsystem* UnitSubsystem = UMassUnitSubsystem::Get(World))
+		{
+			NiagaraSystem = UnitSubsystem->GetNiagaraSystem();
+		}
+	}
+	if (!NiagaraSystem || !NiagaraSystem->PrepareVisualGather())
+	{
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	EntityQuery.ParallelForEachEntityChunk(Context, [NiagaraSystem](FMassExecutionContext& ChunkContext)
+	{
+		const TConstArrayView<FMassUnitTransformFragment> Transforms = ChunkContext.GetFragmentView<FMassUnitTransformFragment>();
+		const TConstArrayView<FMassUnitVelocityFragment> Velocities = ChunkContext.GetFragmentView<FMassUnitVelocityFragment>();
+		const TConstArrayView<FMassUnitVisualFragment> Visuals = ChunkContext.GetFragmentView<FMassUnitVisualFragment>();
+		const TConstArrayView<FMassUnitTeamFragment> Teams = ChunkContext.GetFragmentView<FMassUnitTeamFragment>();
+		const TConstArrayView<FMassUnitStateFragment> States = ChunkContext.GetFragmentView<FMassUnitStateFragment>();
+		const TConstArrayView<FMassUnitRenderSlotFragment> RenderSlots = ChunkContext.GetFragmentView<FMassUnitRenderSlotFragment>();
+
+		for (FMassExecutionContext::FEntityIterator It = ChunkContext.CreateEntityIterator(); It; ++It)
+		{
+			NiagaraSystem->WriteVisualSample(
+				RenderSlots[It].Slot,
+				Transforms[It],
+				Velocities[It],
+				Visuals[It],
+				Teams[It],
+				States[It]);
+		}
+	});
+	NiagaraSystem->FinishVisualGather(FPlatformTime::Seconds() - StartTime);
+}
@@ -40,6 +40,7 @@ TArray<const UScriptStruct*> UUnitTemplate::GetRequiredFragments() const
 		FMassUnitNavigationFragment::StaticStruct(),
 		FMassUnitCrowdFragment::StaticStruct(),
 		FMassUnitLODFragment::StaticStruct(),
-		FMassUnitVisualizationLODFragment::StaticStruct()
+		FMassUnitVisualizationLODFragment::StaticStruct(),
+		FMassUnitRenderSlotFragment::StaticStruct()
 	};
 }
@@ -0,0 +1,242 @@
+// Copyright Digi Logic Labs LLC. All Rights Reserved.
+
+#include "Gameplay/MassUnitCrowdSpatialHash.h"
+
+void FMassUnitCrowdSpatialHash::Initialize(float InCellSize)
+{
+	Reset();
+	CellSize = FMath::Max(1.0f, InCellSize);
+	InverseCellSize = 1.0f / CellSize;
+}
+
+void FMassUnitCrowdSpatialHash::Reset()
+{
+	Entries.Reset();
+	EntryByEntity.Reset();
+	CellSlots.Reset();
+	OccupiedCellSlots = 0;
+	Num3DEntries = 0;
+}
+
+int32 FMassUnitCrowdSpatialHash::Add(
+	FMassUnitEntityHandle Entity,
+	int32 GroupHandle,
+	const FVector& Location,
+	bool bUse3DMovement)
+{
+	Remove(Entity);
+
+	const int32 EntryIndex = Entries.AddDefaulted();
+	FEntry& Entry = Entries[EntryIndex];
+	Entry.Entity = Entity;
+	Entry.Location = Location;
+	Entry.GroupHandle = GroupHandle;
+	Entry.bUse3DMovement = bUse3DMovement;
+	Entry.Cell = ToCell(Location, bUse3DMovement);
+	EntryByEntity.Add(Entity, EntryIndex);
+	Num3DEntries += bUse3DMovement ? 1 : 0;
+	LinkIntoCell(EntryIndex);
+	return EntryIndex;
+}
+
+bool FMassUnitCrowdSpatialHash::Remove(FMassUnitEntityHandle Entity)
+{
+	int32 EntryIndex = INDEX_NONE;
+	if (!EntryByEntity.RemoveAndCopyValue(Entity, EntryIndex))
+	{
+		return false;
+	}
+
+	UnlinkFromCell(EntryIndex);
+	Num3DEntries -= Entries[EntryIndex].bUse3DMovement ? 1 : 0;
+	const int32 LastIndex = Entries.Num() - 1;
+	if (EntryIndex != LastIndex)
+	{
+		Entries[EntryIndex] = Entries[LastIndex];
+		FEntry& MovedEntry = Entries[EntryIndex];
+		if (MovedEntry.PreviousInCell != INDEX_NONE)
+		{
+			Entries[MovedEntry.PreviousInCell].NextInCell = EntryIndex;
+		}
+		else if (CellSlots.IsValidIndex(MovedEntry.CellSlot))
+		{
+			CellSlots[MovedEntry.CellSlot].Head = EntryIndex;
+		}
+		if (MovedEntry.NextInCell != INDEX_NONE)
+		{
+			Entries[MovedEntry.NextInCell].PreviousInCell = EntryIndex;
+		}
+		EntryByEntity.Add(MovedEntry.Entity, EntryIndex);
+	}
+	Entries.RemoveAt(LastIndex, 1, EAllowShrinking::No);
+	return true;
+}
+
+bool FMassUnitCrowdSpatialHash::UpdateLocation(int32 EntryIndex, const FVector& Location)
+{
+	if (!Entries.IsValidIndex(EntryIndex))
+	{
+		return false;
+	}
+	FEntry& Entry = Entries[EntryIndex];
+	Entry.Location = Location;
+	const FIntVector NewCell = ToCell(Location, Entry.bUse3DMovement);
+	if (NewCell == Entry.Cell)
+	{
+		return false;
+	}
+	UnlinkFromCell(EntryIndex);
+	Entries[EntryIndex].Cell = NewCell;
+	LinkIntoCell(EntryIndex);
+	return true;
+}
+
+int32 FMassUnitCrowdSpatialHash::FindEntryIndex(FMassUnitEntityHandle Entity) const
+{
+	const int32* EntryIndex = EntryByEntity.Find(Entity);
+	return EntryIndex ? *EntryIndex : INDEX_NONE;
+}
+
+FIntVector FMassUnitCrowdSpatialHash::ToCell(const FVector& Location, bool bUse3DMovement) const
+{
+	return FIntVector(
+		FMath::FloorToInt(Location.X * InverseCellSize),
+		FMath::FloorToInt(Location.Y * InverseCellSize),
+		bUse3DMovement ? FMath::FloorToInt(Location.Z * InverseCellSize) : 0);
+}
+
+uint32 FMassUnitCrowdSpatialHash::HashCell(const FIntVector& Cell)
+{
+	return (static_cast<uint32>(Cell.X) * 73856093u)
+		^ (static_cast<uint32>(Cell.Y) * 19349663u)
+		^ (static_cast<uint32>(Cell.Z) * 83492791u);
+}
+
+int32 FMassUnitCrowdSpatialHash::FindCellSlot(const FIntVector& Cell) const
+{
+	if (CellSlots.IsEmpty())
+	{
+		return INDEX_NONE;
+	}
+	const uint32 Mask = static_cast<uint32>(CellSlots.Num() - 1);
+	for (uint32 Probe = HashCell(Cell) & Mask, Steps = 0; Steps <= Mask; Probe = (Probe + 1) & Mask, ++Steps)
+	{
+		const FCellSlot& Slot = CellSlots[Probe];
+		if (!Slot.bOccupied)
+		{
+			return INDEX_NONE;
+		}
+		if (Slot.Key == Cell)
+		{
+			return static_cast<int32>(Probe);
+		}
+	}
+	return INDEX_NONE;
+}
+
+int32 FMassUnitCrowdSpatialHash::FindOrAddCellSlot(const FIntVector& Cell)
+{
+	const int32 ExistingSlot = FindCellSlot(Cell);
+	if (ExistingSlot != INDEX_NONE)
+	{
+		return ExistingSlot;
+	}
+	// Keep the linear-probe table at most half full. Occupied slots include
+	// cells that became empty, so they only trigger the rebuild; the rebuild
+	// drops those cells and sizes from the live ones, so a crowd drifting
+	// across a large map stays bounded.
+	if ((OccupiedCellSlots + 1) * 2 > CellSlots.Num())
+	{
+		RebuildCellTable();
+	}
+
+	const uint32 Mask = static_cast<uint32>(CellSlots.Num() - 1);
+	uint32 Probe = HashCell(Cell) & Mask;
+	while (CellSlots[Probe].bOccupied)
+	{
+		Probe = (Probe + 1) & Mask;
+	}
+	FCellSlot& Slot = CellSlots[Probe];
+	Slot.Key = Cell;
+	Slot.Head = INDEX_NONE;
+	Slot.Count = 0;
+	Slot.bOccupied = true;
+	++OccupiedCellSlots;
+	return static_cast<int32>(Probe);
+}
+
+void FMassUnitCrowdSpatialHash::LinkIntoCell(int32 EntryIndex)
+{
+	const int32 SlotIndex = FindOrAddCellSlot(Entries[EntryIndex].Cell);
+	FCellSlot& Slot = CellSlots[SlotIndex];
+	FEntry& Entry = Entries[EntryIndex];
+	Entry.CellSlot = SlotIndex;
+	Entry.PreviousInCell = INDEX_NONE;
+	Entry.NextInCell = Slot.Head;
+	if (Slot.Head != INDEX_NONE)
+	{
+		Entries[Slot.Head].PreviousInCell = EntryIndex;
+	}
+	Slot.Head = EntryIndex;
+	++Slot.Count;
+}
+
+void FMassUnitCrowdSpatialHash::UnlinkFromCell(int32 EntryIndex)
+{
+	FEntry& Entry = Entries[EntryIndex];
+	if (Entry.PreviousInCell != INDEX_NONE)
+	{
+		Entries[Entry.PreviousInCell].NextInCell = Entry.NextInCell;
+	}
+	else if (CellSlots.IsValidIndex(Entry.CellSlot))
+	{
+		CellSlots[Entry.CellSlot].Head = Entry.NextInCell;
+	}
+	if (Entry.NextInCell != INDEX_NONE)
+	{
+		Entries[Entry.NextInCell].PreviousInCell = Entry.PreviousInCell;
+	}
+	if (CellSlots.IsValidIndex(Entry.CellSlot))
+	{
+		--CellSlots[Entry.CellSlot].Count;
+	}
+	Entry.CellSlot = INDEX_NONE;
+	Entry.PreviousInCell = INDEX_NONE;
+	Entry.NextInCell = INDEX_NONE;
+}
+
+void FMassUnitCrowdSpatialHash::RebuildCellTable()
+{
+	int32 LiveCells = 0;
+	for (const FCellSlot& Slot : CellSlots)
+	{
+		LiveCells += Slot.bOccupied && Slot.Count > 0 ? 1 : 0;
+	}
+	// Room for the cell being added; a quarter-full table absorbs as many new
+	// cells again before the next rebuild.
+	const int32 Capacity = static_cast<int32>(FMath::RoundUpToPowerOfTwo(
+		static_cast<uint32>(FMath::Max(64, (LiveCells + 1) * 4))));
+
+	TArray<FCellSlot> PreviousSlots = MoveTemp(CellSlots);
+	CellSlots.SetNum(Capacity);
+	OccupiedCellSlots = 0;
+	const uint32 Mask = static_cast<uint32>(Capacity - 1);
+	for (const FCellSlot& PreviousSlot : PreviousSlots)
+	{
+		if (!PreviousSlot.bOccupied || PreviousSlot.Count <= 0)
+		{
+			continue;
+		}
+		uint32 Probe = HashCell(PreviousSlot.Key) & Mask;
+		while (CellSlots[Probe].bOccupied)
+		{
+			Probe = (Probe + 1) & Mask;
+		}
+		CellSlots[Probe] = PreviousSlot;
+		++OccupiedCellSlots;
+		for (int32 EntryIndex = PreviousSlot.Head; EntryIndex != INDEX_NONE; EntryIndex = Entries[EntryIndex].NextInCell)
+		{
+			Entries[EntryIndex].CellSlot = static_cast<int32>(Probe);
+		}
+	}
+}
@@ -4,8 +4,13 @@
 
 #include "AbilitySystemBlueprintLibrary.h"
 #include "AbilitySystemComponent.h"
+#include "Algo/AnyOf.h"
+#include "Algo/Partition.h"
+#include "Algo/Sort.h"
+#include "Async/ParallelFor.h"
 #include "Config/MassUnitSystemSettings.h"
 #include "Core/MassUnitGameplayTags.h"
+#include "Core/MassUnitSystemRuntime.h"
 #include "DrawDebugHelpers.h"
 #include "Engine/World.h"
 #include "Entity/MassUnitFragments.h"
@@ -18,9 +23,79 @@
 #include "MassEntityManager.h"
 #include "MassEntitySubsystem.h"
 #include "MassUnitCommonFragments.h"
+#include "Misc/ScopeExit.h"
+#include "NavigationSystem.h"
 #include "Navigation/MassUnitNavigationSystem.h"
 #include "Templates/UnrealTemplate.h"
-#include "TimerManager.h"
+
+namespace
+{
+	/**
+	 * Moves the Count items that order first to the front of Items, sorted, and
+	 * leaves the rest unordered. Quickselect keeps this O(n + Count log Count)
+	 * instead of sorting every item when only a budgeted prefix is served.
+	 */
+	template <typename ItemType, typename PredicateType>
+	void SortFirst(TArrayView<ItemType> Items, int32 Count, const PredicateType& Predicate)
+	{
+		Count = FMath::Min(Count, Items.Num());
+		if (Count <= 0)
+		{
+			return;
+		}
+		const int32 Nth = Count - 1;
+		int32 Left = 0;
+		int32 Right = Items.Num() - 1;
+		while (Count < Items.Num() && Left < Right)
+		{
+			// Median of three, so already ordered ranges do not degrade.
+			const int32 Middle = Left + (Right - Left) / 2;
+			if (Predicate(Items[Middle], Items[Left]))
+			{
+				Swap(Items[Middle], Items[Left]);
+			}
+			if (Predicate(Items[Right], Items[Left]))
+			{
+				Swap(Items[Right], Items[Left]);
+			}
+			if (Predicate(Items[Right], Items[Middle]))
+			{
+				Swap(Items[Right], Items[Middle]);
+			}
+			const ItemType Pivot = Items[Middle];
+			int32 Low = Left;
+			int32 High = Right;
+			while (Low <= High)
+			{
+				while (Predicate(Items[Low], Pivot))
+				{
+					++Low;
+				}
+				while (Predicate(Pivot, Items[High]))
+				{
+					--High;
+				}
+				if (Low <= High)
+				{
+					Swap(Items[Low++], Items[High--]);
+				}
+			}
+			if (Nth <= High)
+			{
+				Right = High;
+			}
+			else if (Nth >= Low)
+			{
+				Left = Low;
+			}
+			else
+			{
+				break;
+			}
+		}
+		Algo::Sort(Items.Left(Count), Predicate);
+	}
+}
 
 void UMassUnitCrowdSystem::Initialize(
 	UWorld* InWorld,
@@ -35,29 +110,34 @@ void UMassUnitCrowdSystem::Initialize(
 
 	const UMassUnitSystemSettings* Settings = GetDefault<UMassUnitSystemSettings>();
 	UpdateInterval = Settings ? FMath::Max(0.02f, Settings->CrowdUpdateInterval) : 0.1f;
-	MaxUnitsPerUpdate = Settings ? FMath::Max(1, Settings->MaxCrowdUnitsPerUpdate) : 500;
+	MaxUnitsPerUpdate = Settings ? FMath::Max(1, Settings->MaxCrowdUnitsPerUpdate) : 2000;
 	MaxSharedPathBuildsPerUpdate = Settings ? FMath::Max(1, Settings->MaxSharedPathBuildsPerCrowdUpdate) : 8;
-	SpatialCellSize = Settings ? FMath::Max(10.0f, Settings->CrowdSpatialCellSize) : 200.0f;
+	UpdateBudgetSeconds = Settings ? FMath::Max(0.0f, Settings->CrowdUpdateBudgetMs) * 0.001 : 0.002;
+	SpatialHash.Initialize(Settings ? FMath::Max(10.0f, Settings->CrowdSpatialCellSize) : 200.0f);
+	DormantCellSize = Settings ? FMath::Max(500.0f, Settings->CrowdDormantCellSize) : 5000.0f;
 	SimulationLODDistances = Settings
 		? Settings->CrowdSimulationLODDistances
 		: TArray<float>{2500.0f, 5000.0f, 10000.0f};
 	SimulationLODIntervalMultipliers = Settings
 		? Settings->CrowdSimulationLODIntervalMultipliers
 		: TArray<float>{1.0f, 2.0f, 4.0f, 8.0f};
+	bAuditPopulationStats = Settings && Settings->bAuditCrowdStats;
+	bParallelDecisions = !Settings || Settings->bParallelCrowdDecisions;
 	SimulationLODDistances.Sort();
 	if (SimulationLODIntervalMultipliers.IsEmpty())
 	{
 		SimulationLODIntervalMultipliers.Add(1.0f);
 	}
+	if (NavigationSystem)
+	{
+		NavigationAreasRebuiltHandle = NavigationSystem->OnNavigationAreasRebuilt.AddUObject(
+			this,
+			&UMassUnitCrowdSystem::HandleNavigationAreasRebuilt);
+	}
 }
 
 void UMassUnitCrowdSystem::Deinitialize()
 {
-	if (World)
-	{
-		World->GetTimerManager().ClearTimer(UpdateTimer);
-	}
-
 	TArray<int32> GroupHandles;
 	Groups.GetKeys(GroupHandles);
 	for (const int32 GroupHandle : GroupHandles)
@@ -67,7 +147,19 @@ void UMassUnitCrowdSystem::Deinitialize()
 
 	Groups.Reset();
 	UnitToGroup.Reset();
+	SpatialHash.Reset();
+	DormantCells.Reset();
+	DormantCellByUnit.Reset();
+	EngagedUnitCount = 0;
+	NeighborLists.Reset();
+	PendingWanderPools.Reset();
+	DeferredEvents.Reset();
 	LastStats = {};
+	if (NavigationSystem)
+	{
+		NavigationSystem->OnNavigationAreasRebuilt.Remove(NavigationAreasRebuiltHandle);
+	}
+	NavigationAreasRebuiltHandle.Reset();
 	NavigationSystem = nullptr;
 	UnitManager = nullptr;
 	EntitySubsystem = nullptr;
@@ -107,18 +199,15 @@ int32 UMassUnitCrowdSystem::RegisterCrowdGroup(
 		RemoveUnitFromPreviousGroup(Entity);
 		FMassUnitCrowdFragment* Crowd = EntityManager.GetFragmentDataPtr<FMassUnitCrowdFragment>(Entity.ToMassEntityHandle());
 		FMassUnitStateFragment* State = EntityManager.GetFragmentDataPtr<FMassUnitStateFragment>(Entity.ToMassEntityHandle());
-		if (!Crowd || !State)
+		const FMassUnitTransformFragment* Transform = EntityManager.GetFragmentDataPtr<FMassUnitTransformFragment>(Entity.ToMassEntityHandle());
+		if (!Crowd || !State || !Transform)
 		{
 			continue;
 		}
 
 		Crowd->Reset();
 		Crowd->bEnabled = true;
-		Crowd->bUse3DMovement = Group.Config.MovementMode == EMassUnitCrowdMovementMode::Free3D;
-		Crowd->bConformToNavmeshHeight = Group.bUseNavigation
-			&& !Crowd->bUse3DMovement
-			&& Group.Config.bConformToNavmeshHeight;
-		Crowd->NavigationHeightOffset = Group.Config.NavigationHeightOffset;
+		CopyGroupMovementSettings(Group, *Crowd);
 		Crowd->GroupHandle = Group.Handle;
 		Crowd->SubgroupIndex = Group.Config.bEnableManagedSubgroups
 			? ValidUnitIndex / Group.Config.ManagedSubgroupSize
@@ -127,6 +216,7 @@ int32 UMassUnitCrowdSystem::RegisterCrowdGroup(
 		Crowd->NextDecisionTime = CurrentTime;
 		Group.Units.AddUnique(Entity);
 		UnitToGroup.Add(Entity, Group.Handle);
+		SpatialHash.Add(Entity, Group.Handle, Transform->GetTransform().GetLocation(), Crowd->bUse3DMovement);
 		++ValidUnitIndex;
 	}
 
@@ -134,14 +224,20 @@ int32 UMassUnitCrowdSystem::RegisterCrowdGroup(
 	{
 		return INDEX_NONE;
 	}
+	// New hash entries start living; the next spatial sync reports members that are already dead.
+	Group.LivingMembers = Group.Units.Num();
 	Group.SubgroupCount = Group.Config.bEnableManagedSubgroups
 		? FMath::Max(1, FMath::DivideAndRoundUp(Group.Units.Num(), Group.Config.ManagedSubgroupSize))
 		: 1;
 	Group.NextSubgroupCueTimes.Init(0.0f, Group.SubgroupCount);
 	Group.Subgroups.SetNum(Group.SubgroupCount);
+	BuildWanderPools(Group);
 
+	if (Groups.IsEmpty())
+	{
+		TimeUntilNextUpdate = UpdateInterval;
+	}
 	Groups.Add(Group.Handle, MoveTemp(Group));
-	StartTimerIfNeeded();
 	ForceCrowdGroupUpdate(Group.Handle);
 	return Group.Handle;
 }
@@ -154,12 +250,31 @@ bool UMassUnitCrowdSystem::UnregisterCrowdGroup(int32 CrowdGroupHandle, bool bSt
 		return false;
 	}
 
+	CancelSharedPathQuery(Group.PendingSharedPathQuery, Group.SharedPathRequestSerial);
+	for (FCrowdSubgroupState& Subgroup : Group.Subgroups)
+	{
+		CancelSharedPathQuery(Subgroup.PendingPathQuery, Subgroup.PathRequestSerial);
+	}
+	PendingWanderPools.RemoveAll([CrowdGroupHandle](const FWanderPoolBuild& Build)
+	{
+		return Build.GroupHandle == CrowdGroupHandle;
+	});
+	if (Group.bEngaged)
+	{
+		EngagedUnitCount -= Group.LivingMembers;
+	}
 	for (const FMassUnitEntityHandle Entity : Group.Units)
 	{
 		UnitToGroup.Remove(Entity);
+		SpatialHash.Remove(Entity);
+		RemoveDormantUnit(Entity);
+		NeighborLists.Remove(Entity);
 		ResetCrowdFragment(Entity, bStopUnits);
 	}
-	StopTimerIfIdle();
+	if (Groups.IsEmpty())
+	{
+		UpdateCursor = 0;
+	}
 	return true;
 }
 
@@ -199,6 +314,7 @@ bool UMassUnitCrowdSystem::SetCrowdGroupCenter(int32 CrowdGroupHandle, FVector N
 	if (FCrowdGroup* Group = Groups.Find(CrowdGroupHandle))
 	{
 		Group->Center = NewCenter;
+		BuildWanderPools(*Group);
 		return true;
 	}
 	return false;
@@ -211,10 +327,17 @@ bool UMassUnitCrowdSystem::ForceCrowdGroupUpdate(int32 CrowdGroupHandle)
 	{
 		return false;
 	}
+	// Declared first so the guard is released before queued events run.
+	ON_SCOPE_EXIT
+	{
+		FlushDeferredEvents();
+	};
 	TGuardValue<bool> UpdateGuard(bUpdatingCrowds, true);
 
-	PruneInvalidUnits();
+	SyncSpatialHash();
 	const float CurrentTime = World->GetTimeSeconds();
+	// Explicit forced updates are never time-sliced.
+	UpdateDeadline = TNumericLimits<double>::Max();
 	LastStats = {};
 	UpdateGroupEngagements(CurrentTime);
 	Group = Groups.Find(CrowdGroupHandle);
@@ -237,30 +360,30 @@ bool UMassUnitCrowdSystem::ForceCrowdGroupUpdate(int32 CrowdGroupHandle)
 		}
 	}
 
-	TArray<FSpatialEntry> Entries;
-	TMap<FIntVector, TArray<int32>> Cells;
-	TMap<FMassUnitEntityHandle, int32> EntryByEntity;
 	TArray<FVector> ObserverLocations;
-	BuildSpatialData(Entries, Cells, EntryByEntity);
 	BuildObserverLocations(ObserverLocations);
-	RefreshManagedSubgroupPaths(CurrentTime, Entries, CrowdGroupHandle, true);
+	WakeDormantUnits(ObserverLocations, CurrentTime, CrowdGroupHandle);
+	Group = Groups.Find(CrowdGroupHandle);
+	if (!Group)
+	{
+		return false;
+	}
+	RefreshManagedSubgroupPaths(CurrentTime, CrowdGroupHandle, true);
 
-	RefreshPopulationStats(Entries);
-	for (const FSpatialEntry& Entry : Entries)
+	PendingDecisions.Reset(Group->Units.Num());
+	for (const FMassUnitEntityHandle Entity : Group->Units)
 	{
-		if (Entry.GroupHandle == CrowdGroupHandle)
+		const int32 EntryIndex = SpatialHash.FindEntryIndex(Entity);
+		if (EntryIndex != INDEX_NONE)
 		{
-			FCrowdGroup* CurrentGroup = Groups.Find(CrowdGroupHandle);
-			if (!CurrentGroup || CurrentGroup->bPaused)
-			{
-				break;
-			}
-			UpdateUnit(Entry, *CurrentGroup, Entries, Cells, EntryByEntity, ObserverLocations, CurrentTime, true);
-			++LastStats.UnitsUpdated;
+			FCrowdUnitDecision& Decision = PendingDecisions.AddDefaulted_GetRef();
+			Decision.Entry = SpatialHash.GetEntry(EntryIndex);
+			CaptureUnitInputs(Entity, Decision.Inputs);
 		}
 	}
+	ProcessPendingDecisions(ObserverLocations, CurrentTime, true);
 	PruneInvalidUnits();
-	RefreshPopulationStats(Entries);
+	RefreshPopulationStats();
 	return true;
 }
 
@@ -275,6 +398,20 @@ int32 UMassUnitCrowdSystem::GetCrowdGroupUnitCount(int32 CrowdGroupHandle) const
 	return Group ? Group->Units.Num() : 0;
 }
 
+bool UMassUnitCrowdSystem::GetCrowdGroupLivingBounds(int32 CrowdGroupHandle, FVector& OutCentroid, FBox& OutBounds) const
+{
+	const FCrowdGroup* Group = Groups.Find(CrowdGroupHandle);
+	if (!Group || Group->LivingUnits <= 0)
+	{
+		OutCentroid = FVector::ZeroVector;
+		OutBounds = FBox(ForceInit);
+		return false;
+	}
+	OutCentroid = CalculateGroupAnchor(*Group);
+	OutBounds = Group->LivingBounds;
+	return true;
+}
+
 int32 UMassUnitCrowdSystem::GetCrowdGroupSubgroupCount(int32 CrowdGroupHandle) const
 {
 	const FCrowdGroup* Group = Groups.Find(CrowdGroupHandle);
@@ -318,6 +455,16 @@ TArray<FMassUnitHandle> UMassUnitCrowdSystem::GetCrowdSubgroupUnits(
 	return Result;
 }
 
+TArray<FVector> UMassUnitCrowdSystem::GetCrowdSubgroupWanderPoints(
+	int32 CrowdGroupHandle,
+	int32 SubgroupIndex) const
+{
+	const FCrowdGroup* Group = Groups.Find(CrowdGroupHandle);
+	return Group && Group->Subgroups.IsValidIndex(SubgroupIndex)
+		? Group->Subgroups[SubgroupIndex].WanderPoints
+		: TArray<FVector>();
+}
+
 bool UMassUnitCrowdSystem::ConfigureCrowdGroupEngagement(
 	int32 CrowdGroupHandle,
 	const FMassUnitPlayerEngagementConfig& Config,
@@ -332,6 +479,7 @@ bool UMassUnitCrowdSystem::ConfigureCrowdGroupEngagement(
 	Group->EngagementConfig = SanitizeEngagementConfig(Config);
 	Group->bEngagementEnabled = bEnableEngagement;
 	Group->bHoldAfterEngagement = false;
+	CancelSharedPathQuery(Group->PendingSharedPathQuery, Group->SharedPathRequestSerial);
 	Group->SharedPathPoints.Reset();
 	Group->bSharedPathUsesNavmesh = false;
 	Group->SharedPathTargetLocation = FVector::ZeroVector;
@@ -358,10 +506,15 @@ bool UMassUnitCrowdSystem::ActivateCrowdGroupForActor(int32 CrowdGroupHandle, AA
 
 	const bool bWasEngaged = Group->bEngaged;
 	Group->bEngaged = true;
+	if (!bWasEngaged)
+	{
+		EngagedUnitCount += Group->LivingMembers;
+	}
 	Group->bHoldAfterEngagement = false;
 	Group->TargetActor = TargetActor;
 	Group->LastTargetLocation = TargetActor->GetActorLocation();
 	Group->NextTargetRefreshTime = World->GetTimeSeconds() + Group->EngagementConfig.TargetRefreshInterval;
+	CancelSharedPathQuery(Group->PendingSharedPathQuery, Group->SharedPathRequestSerial);
 	Group->SharedPathPoints.Reset();
 	Group->bSharedPathUsesNavmesh = false;
 	Group->SharedPathTargetLocation = FVector::ZeroVector;
@@ -381,7 +534,7 @@ bool UMassUnitCrowdSystem::ActivateCrowdGroupForActor(int32 CrowdGroupHandle, AA
 		{
 			continue;
 		}
-		Crowd->bSleeping = false;
+		SetUnitSleeping(Entity, false, World->GetTimeSeconds());
 		Crowd->InteractionEndTime = 0.0f;
 		Crowd->InteractionPartner.Invalidate();
 		Crowd->NextFollowUpdateTime = 0.0f;
@@ -398,8 +551,12 @@ bool UMassUnitCrowdSystem::ActivateCrowdGroupForActor(int32 CrowdGroupHandle, AA
 	if (!bWasEngaged)
 	{
 		RequestPresentationCue(*Group, EMassUnitCrowdCue::EngagementStarted, CalculateGroupAnchor(*Group));
-		OnCrowdEngagementStarted.Broadcast(CrowdGroupHandle, TargetActor);
+		FDeferredEvent& Event = DeferredEvents.AddDefaulted_GetRef();
+		Event.Type = EDeferredEventType::EngagementStarted;
+		Event.GroupHandle = CrowdGroupHandle;
+		Event.Actor = TargetActor;
 	}
+	FlushDeferredEvents();
 	return Groups.Contains(CrowdGroupHandle);
 }
 
@@ -413,10 +570,12 @@ bool UMassUnitCrowdSystem::DeactivateCrowdGroupEngagement(int32 CrowdGroupHandle
 
 	AActor* PreviousTarget = Group->TargetActor.Get();
 	Group->bEngaged = false;
+	EngagedUnitCount -= Group->LivingMembers;
 	Group->bHoldAfterEngagement = !bReturnToWander;
 	Group->TargetActor.Reset();
 	Group->LastTargetLocation = FVector::ZeroVector;
 	Group->NextTargetRefreshTime = 0.0f;
+	CancelSharedPathQuery(Group->PendingSharedPathQuery, Group->SharedPathRequestSerial);
 	Group->SharedPathPoints.Reset();
 	Group->bSharedPathUsesNavmesh = false;
 	Group->SharedPathTargetLocation = FVector::ZeroVector;
@@ -452,7 +611,11 @@ bool UMassUnitCrowdSystem::DeactivateCrowdGroupEngagement(int32 CrowdGroupHandle
 
 	const FVector CueLocation = CalculateGroupAnchor(*Group);
 	RequestPresentationCue(*Group, EMassUnitCrowdCue::EngagementEnded, CueLocation);
-	OnCrowdEngagementEnded.Broadcast(CrowdGroupHandle, PreviousTarget);
+	FDeferredEvent& Event = DeferredEvents.AddDefaulted_GetRef();
+	Event.Type = EDeferredEventType::EngagementEnded;
+	Event.GroupHandle = CrowdGroupHandle;
+	Event.Actor = PreviousTarget;
+	FlushDeferredEvents();
 	return Groups.Contains(CrowdGroupHandle);
 }
 
@@ -504,30 +667,99 @@ FMassUnitHandle UMassUnitCrowdSystem::FindClosestCrowdUnit(
 		return {};
 	}
 	const FMassEntityManager& EntityManager = EntitySubsystem->GetEntityManager();
-	const float MaximumDistanceSquared = FMath::Square(MaxDistance);
-	float BestDistanceSquared = MaximumDistanceSquared;
+	float BestDistanceSquared = FMath::Square(MaxDistance);
 	FMassUnitEntityHandle BestEntity;
-	for (const TPair<int32, FCrowdGroup>& Pair : Groups)
+	auto ConsiderEntity = [&](FMassUnitEntityHandle Candidate)
 	{
-		for (const FMassUnitEntityHandle Entity : Pair.Value.Units)
+		if (!IsEntityValid(Candidate))
 		{
-			if (!IsEntityValid(Entity))
+			return;
+		}
+		const FMassEntityHandle NativeHandle = Candidate.ToMassEntityHandle();
+		const FMassUnitStateFragment* State = EntityManager.GetFragmentDataPtr<FMassUnitStateFragment>(NativeHandle);
+		const FMassUnitTransformFragment* Transform = EntityManager.GetFragmentDataPtr<FMassUnitTransformFragment>(NativeHandle);
+		if (!Transform || (!bIncludeDead && State && State->CurrentState == EMassUnitState::Dead))
+		{
+			return;
+		}
+		const FVector Delta = Transform->GetTransform().GetLocation() - WorldLocation;
+		const float DistanceSquared = bUse3DDistance ? Delta.SizeSquared() : Delta.SizeSquared2D();
+		if (DistanceSquared <= BestDistanceSquared)
+		{
+			BestDistanceSquared = DistanceSquared;
+			BestEntity = Candidate;
+		}
+	};
+	auto ConsiderCandidate = [&ConsiderEntity](int32 EntryIndex, const FSpatialEntry& Candidate)
+	{
+		ConsiderEntity(Candidate.Entity);
+	};
+
+	// Hash locations are refreshed once per crowd update. Widen the candidate
+	// search by one cell and confirm each candidate against its live transform.
+	const float CandidateRadius = MaxDistance + SpatialHash.GetCellSize();
+	SpatialHash.ForEachInRadius(WorldLocation, CandidateRadius, false, ConsiderCandidate);
+	if (SpatialHash.GetNum3DEntries() > 0)
+	{
+		if (bUse3DDistance)
+		{
+			SpatialHash.ForEachInRadius(WorldLocation, CandidateRadius, true, [&](int32 EntryIndex, const FSpatialEntry& Candidate)
 			{
-				continue;
+				if (Candidate.bUse3DMovement)
+				{
+					ConsiderCandidate(EntryIndex, Candidate);
+				}
+			});
+		}
+		else
+		{
+			// Free-3D units can sit in any vertical cell layer of a planar query.
+			const TArray<FSpatialEntry>& Entries = SpatialHash.GetEntries();
+			for (int32 EntryIndex = 0; EntryIndex < Entries.Num(); ++EntryIndex)
+			{
+				if (Entries[EntryIndex].bUse3DMovement)
+				{
+					ConsiderCandidate(EntryIndex, Entries[EntryIndex]);
+				}
 			}
-			const FMassEntityHandle NativeHandle = Entity.ToMassEntityHandle();
-			const FMassUnitStateFragment* State = EntityManager.GetFragmentDataPtr<FMassUnitStateFragment>(NativeHandle);
-			const FMassUnitTransformFragment* Transform = EntityManager.GetFragmentDataPtr<FMassUnitTransformFragment>(NativeHandle);
-			if (!Transform || (!bIncludeDead && State && State->CurrentState == EMassUnitState::Dead))
+		}
+	}
+
+	// Sleeping units are parked in the dormant grid and do not move, so a
+	// planar cell range is enough for both planar and 3D queries.
+	if (!DormantCells.IsEmpty())
+	{
+		const FIntPoint MinCell = ToDormantCell(WorldLocation - FVector(MaxDistance));
+		const FIntPoint MaxCell = ToDormantCell(WorldLocation + FVector(MaxDistance));
+		const int64 CellsInRange = (static_cast<int64>(MaxCell.X) - MinCell.X + 1) * (static_cast<int64>(MaxCell.Y) - MinCell.Y + 1);
+		auto ConsiderDormantCell = [&ConsiderEntity](const TArray<FDormantUnit>& Units)
+		{
+			for (const FDormantUnit& Unit : Units)
 			{
-				continue;
+				ConsiderEntity(Unit.Entity);
+			}
+		};
+		if (CellsInRange > DormantCells.Num())
+		{
+			for (const TPair<FIntPoint, TArray<FDormantUnit>>& Cell : DormantCells)
+			{
+				if (Cell.Key.X >= MinCell.X && Cell.Key.X <= MaxCell.X && Cell.Key.Y >= MinCell.Y && Cell.Key.Y <= MaxCell.Y)
+				{
+					ConsiderDormantCell(Cell.Value);
+				}
 			}
-			const FVector Delta = Transform->GetTransform().GetLocation() - WorldLocation;
-			const float DistanceSquared = bUse3DDistance ? Delta.SizeSquared() : Delta.SizeSquared2D();
-			if (DistanceSquared <= BestDistanceSquared)
+		}
+		else
+		{
+			for (int32 CellX = MinCell.X; CellX <= MaxCell.X; ++CellX)
 			{
-				BestDistanceSquared = DistanceSquared;
-				BestEntity = Entity;
+				for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; ++CellY)
+				{
+					if (const TArray<FDormantUnit>* Units = DormantCells.Find(FIntPoint(CellX, CellY)))
+					{
+						ConsiderDormantCell(*Units);
+					}
+				}
 			}
 		}
 	}
@@ -546,213 +778,587 @@ AActor* UMassUnitCrowdSystem::GetCrowdGroupTargetActor(int32 CrowdGroupHandle) c
 	return Group && Group->bEngaged ? Group->TargetActor.Get() : nullptr;
 }
 
-void UMassUnitCrowdSystem::StartTimerIfNeeded()
+bool UMassUnitCrowdSystem::AdvanceUpdateClock(float DeltaTime)
 {
-	if (World && !Groups.IsEmpty() && !World->GetTimerManager().IsTimerActive(UpdateTimer))
+	if (Groups.IsEmpty())
+	{
+		return false;
+	}
+	TimeUntilNextUpdate -= DeltaTime;
+	if (TimeUntilNextUpdate > 0.0f)
 	{
-		World->GetTimerManager().SetTimer(UpdateTimer, this, &UMassUnitCrowdSystem::UpdateCrowds, UpdateInterval, true);
+		return false;
 	}
+	// Keep a fixed cadence, but never queue catch-up updates after a long hitch.
+	TimeUntilNextUpdate = FMath::Max(TimeUntilNextUpdate + UpdateInterval, 0.0f);
+	return true;
 }
 
-void UMassUnitCrowdSystem::StopTimerIfIdle()
+void UMassUnitCrowdSystem::SyncUnitLocation(FMassUnitEntityHandle Entity, const FVector& Location, bool bLiving)
 {
-	if (World && Groups.IsEmpty())
+	const int32 EntryIndex = SpatialHash.FindEntryIndex(Entity);
+	if (EntryIndex != INDEX_NONE)
 	{
-		World->GetTimerManager().ClearTimer(UpdateTimer);
-		UpdateCursor = 0;
+		SyncEntryLocation(EntryIndex, Location, bLiving);
 	}
 }
 
-void UMassUnitCrowdSystem::UpdateCrowds()
+void UMassUnitCrowdSystem::SyncEntryLocation(int32 EntryIndex, const FVector& Location, bool bLiving)
 {
-	if (!World || !EntitySubsystem || !UnitManager || bUpdatingCrowds)
+	const FSpatialEntry& Entry = SpatialHash.GetEntry(EntryIndex);
+	const FVector Step = Location - Entry.Location;
+	const float StepSquared = Entry.bUse3DMovement ? Step.SizeSquared() : Step.SizeSquared2D();
+	// Stationary units skip the group lookup, so idle crowds keep their neighbor lists indefinitely.
+	if (StepSquared > UE_KINDA_SMALL_NUMBER)
 	{
-		return;
+		if (FCrowdGroup* Group = Groups.Find(Entry.GroupHandle))
+		{
+			Group->PendingNeighborStep = FMath::Max(Group->PendingNeighborStep, FMath::Sqrt(StepSquared));
+		}
 	}
-	TGuardValue<bool> UpdateGuard(bUpdatingCrowds, true);
-
-	PruneInvalidUnits();
-	if (Groups.IsEmpty())
+	if (Entry.bLiving != bLiving)
 	{
-		StopTimerIfIdle();
-		return;
+		if (FCrowdGroup* Group = Groups.Find(Entry.GroupHandle))
+		{
+			AdjustLivingMembers(*Group, bLiving ? 1 : -1);
+		}
 	}
-	const float CurrentTime = World->GetTimeSeconds();
-	LastStats = {};
-	UpdateGroupEngagements(CurrentTime);
-
-	TArray<FSpatialEntry> Entries;
-	TMap<FIntVector, TArray<int32>> Cells;
-	TMap<FMassUnitEntityHandle, int32> EntryByEntity;
-	TArray<FVector> ObserverLocations;
-	BuildSpatialData(Entries, Cells, EntryByEntity);
-	BuildObserverLocations(ObserverLocations);
-	RefreshManagedSubgroupPaths(CurrentTime, Entries);
-
-	RefreshPopulationStats(Entries);
+	SpatialHash.SetLiving(EntryIndex, bLiving);
+	SpatialHash.UpdateLocation(EntryIndex, Location);
+}
 
-	if (Entries.IsEmpty())
+void UMassUnitCrowdSystem::AdvanceNeighborClocks()
+{
+	for (TPair<int32, FCrowdGroup>& Pair : Groups)
 	{
-		return;
+		Pair.Value.NeighborClock += Pair.Value.PendingNeighborStep;
+		Pair.Value.PendingNeighborStep = 0.0f;
 	}
+}
 
-	const int32 UnitsToUpdate = FMath::Min(MaxUnitsPerUpdate, Entries.Num());
-	const int32 StartIndex = UpdateCursor % Entries.Num();
-	for (int32 Offset = 0; Offset < UnitsToUpdate; ++Offset)
+void UMassUnitCrowdSystem::RefreshGroupAggregates()
+{
+	for (TPair<int32, FCrowdGroup>& Pair : Groups)
 	{
-		const FSpatialEntry& Entry = Entries[(StartIndex + Offset) % Entries.Num()];
-		FCrowdGroup* Group = Groups.Find(Entry.GroupHandle);
-		if (!Group || Group->bPaused)
+		Pair.Value.LivingLocationSum = FVector::ZeroVector;
+		Pair.Value.LivingBounds.Init();
+		Pair.Value.LivingUnits = 0;
+	}
+	// One linear pass over dense hash entries replaces per-query fragment
+	// reads. Members are registered together, so consecutive entries usually
+	// share a group and the lookup is cached.
+	int32 GroupHandle = INDEX_NONE;
+	FCrowdGroup* Group = nullptr;
+	for (const FSpatialEntry& Entry : SpatialHash.GetEntries())
+	{
+		if (!Entry.bLiving)
 		{
 			continue;
 		}
-		UpdateUnit(Entry, *Group, Entries, Cells, EntryByEntity, ObserverLocations, CurrentTime, false);
-		++LastStats.UnitsUpdated;
+		if (Entry.GroupHandle != GroupHandle)
+		{
+			GroupHandle = Entry.GroupHandle;
+			Group = Groups.Find(GroupHandle);
+		}
+		if (Group)
+		{
+			Group->LivingLocationSum += Entry.Location;
+			Group->LivingBounds += Entry.Location;
+			++Group->LivingUnits;
+		}
 	}
-	UpdateCursor = (StartIndex + UnitsToUpdate) % Entries.Num();
-	PruneInvalidUnits();
-	RefreshPopulationStats(Entries);
-}
-
-void UMassUnitCrowdSystem::PruneInvalidUnits()
-{
-	TArray<int32> EmptyGroups;
-	for (TPair<int32, FCrowdGroup>& Pair : Groups)
+	for (const TPair<FIntPoint, TArray<FDormantUnit>>& Cell : DormantCells)
 	{
-		Pair.Value.Units.RemoveAll([this](const FMassUnitEntityHandle Entity)
+		for (const FDormantUnit& Unit : Cell.Value)
 		{
-			if (IsEntityValid(Entity))
+			// Destroyed sleepers are pruned lazily, so validity is checked here.
+			if (!Unit.bLiving || !IsEntityValid(Unit.Entity))
 			{
-				return false;
+				continue;
+			}
+			if (Unit.GroupHandle != GroupHandle)
+			{
+				GroupHandle = Unit.GroupHandle;
+				Group = Groups.Find(GroupHandle);
+			}
+			if (Group)
+			{
+				Group->LivingLocationSum += Unit.Location;
+				Group->LivingBounds += Unit.Location;
+				++Group->LivingUnits;
 			}
-			UnitToGroup.Remove(Entity);
-			return true;
-		});
-		if (Pair.Value.Units.IsEmpty())
-		{
-			EmptyGroups.Add(Pair.Key);
 		}
 	}
-	for (const int32 GroupHandle : EmptyGroups)
+}
+
+bool UMassUnitCrowdSystem::BeginCrowdUpdate()
+{
+	if (!World || !EntitySubsystem || !UnitManager || bUpdatingCrowds)
+	{
+		return false;
+	}
+
+	PruneInvalidUnits();
+	if (Groups.IsEmpty())
 	{
-		Groups.Remove(GroupHandle);
+		UpdateCursor = 0;
+		return false;
 	}
+	bUpdatingCrowds = true;
+	AdvanceNeighborClocks();
+	RefreshGroupAggregates();
+	UpdateTime = World->GetTimeSeconds();
+	UpdateStartTime = FPlatformTime::Seconds();
+	UpdateDeadline = UpdateBudgetSeconds > 0.0
+		? UpdateStartTime + UpdateBudgetSeconds
+		: TNumericLimits<double>::Max();
+	LastStats = {};
+	ScheduledUnits.Reset();
+	SteeringWrites.Reset();
+	SteeringWriteCursor = 0;
+	double PhaseStartTime = UpdateStartTime;
+	UpdateGroupEngagements(UpdateTime);
+	LastStats.EngagementMs = static_cast<float>((FPlatformTime::Seconds() - PhaseStartTime) * 1000.0);
+
+	UpdateObserverLocations.Reset();
+	BuildObserverLocations(UpdateObserverLocations);
+	PhaseStartTime = FPlatformTime::Seconds();
+	WakeDormantUnits(UpdateObserverLocations, UpdateTime);
+	LastStats.DormantMs = static_cast<float>((FPlatformTime::Seconds() - PhaseStartTime) * 1000.0);
+	PhaseStartTime = FPlatformTime::Seconds();
+	RefreshManagedSubgroupPaths(UpdateTime);
+	LastStats.SharedPathMs = static_cast<float>((FPlatformTime::Seconds() - PhaseStartTime) * 1000.0);
+	PhaseStartTime = FPlatformTime::Seconds();
+	ProcessWanderPoolBuilds();
+	LastStats.WanderPoolMs = static_cast<float>((FPlatformTime::Seconds() - PhaseStartTime) * 1000.0);
+
+	if (SpatialHash.Num() == 0)
+	{
+		FinishCrowdUpdate();
+		return false;
+	}
+	return true;
 }
 
-void UMassUnitCrowdSystem::BuildSpatialData(
-	TArray<FSpatialEntry>& OutEntries,
-	TMap<FIntVector, TArray<int32>>& OutCells,
-	TMap<FMassUnitEntityHandle, int32>& OutEntryByEntity) const
+void UMassUnitCrowdSystem::ScheduleUnit(
+	FMassUnitEntityHandle Entity,
+	const FMassUnitCrowdFragment& Crowd,
+	const FMassUnitStateFragment& State,
+	const FMassUnitTargetFragment& Target,
+	const FMassUnitNavigationFragment& Navigation,
+	int32 ChunkOrdinal,
+	int32 ChunkIndex)
 {
-	if (!EntitySubsystem)
+	const int32 EntryIndex = SpatialHash.FindEntryIndex(Entity);
+	if (!bUpdatingCrowds || EntryIndex == INDEX_NONE)
 	{
 		return;
 	}
+	FScheduledUnit& Unit = ScheduledUnits.AddDefaulted_GetRef();
+	Unit.Entity = Entity;
+	Unit.EntryIndex = EntryIndex;
+	Unit.ChunkOrdinal = ChunkOrdinal;
+	Unit.ChunkIndex = ChunkIndex;
+	Unit.Inputs.Capture(Crowd, State, Target, Navigation);
+}
 
-	const FMassEntityManager& EntityManager = EntitySubsystem->GetEntityManager();
-	for (const TPair<int32, FCrowdGroup>& Pair : Groups)
+void UMassUnitCrowdSystem::DecideScheduledUnits()
+{
+	if (!bUpdatingCrowds)
 	{
-		for (const FMassUnitEntityHandle Entity : Pair.Value.Units)
-		{
-			if (!IsEntityValid(Entity))
-			{
-				continue;
-			}
-			const FMassUnitTransformFragment* Transform = EntityManager.GetFragmentDataPtr<FMassUnitTransformFragment>(Entity.ToMassEntityHandle());
-			if (!Transform)
+		return;
+	}
+	const float CurrentTime = UpdateTime;
+	double PhaseStartTime = FPlatformTime::Seconds();
+	const int32 DueCount = ScheduleUnits(UpdateObserverLocations, CurrentTime);
+	LastStats.ScheduleMs = static_cast<float>((FPlatformTime::Seconds() - PhaseStartTime) * 1000.0);
+
+	// Serve the schedule in batches and stop between batches once the time
+	// budget is spent. The first batch always runs so a slow frame still makes progress.
+	const int32 UnitsToUpdate = FMath::Min(MaxUnitsPerUpdate, ScheduledUnits.Num());
+	int32 ScheduledIndex = 0;
+	while (ScheduledIndex < UnitsToUpdate && (ScheduledIndex == 0 || HasUpdateBudget()))
+	{
+		const int32 BatchEnd = FMath::Min(ScheduledIndex + DecisionBatchSize, UnitsToUpdate);
+		PendingDecisions.Reset(BatchEnd - ScheduledIndex);
+		for (; ScheduledIndex < BatchEnd; ++ScheduledIndex)
+		{
+			// Entries are resolved per batch and copied: applying a decision can
+			// put units to sleep, which removes them from the hash and reorders it.
+			const FScheduledUnit& Unit = ScheduledUnits[ScheduledIndex];
+			const int32 EntryIndex = SpatialHash.FindEntryIndex(Unit.Entity);
+			if (EntryIndex != INDEX_NONE)
 			{
-				continue;
+				FCrowdUnitDecision& Decision = PendingDecisions.AddDefaulted_GetRef();
+				Decision.Entry = SpatialHash.GetEntry(EntryIndex);
+				Decision.Inputs = Unit.Inputs;
+				Decision.ChunkOrdinal = Unit.ChunkOrdinal;
+				Decision.ChunkIndex = Unit.ChunkIndex;
 			}
-
-			FSpatialEntry& Entry = OutEntries.AddDefaulted_GetRef();
-			Entry.Entity = Entity;
-			Entry.Location = Transform->GetTransform().GetLocation();
-			Entry.GroupHandle = Pair.Key;
-			const int32 EntryIndex = OutEntries.Num() - 1;
-			OutEntryByEntity.Add(Entity, EntryIndex);
-			const bool bUse3DMovement = Pair.Value.Config.MovementMode == EMassUnitCrowdMovementMode::Free3D;
-			OutCells.FindOrAdd(ToSpatialCell(Entry.Location, bUse3DMovement)).Add(EntryIndex);
 		}
+		ProcessPendingDecisions(UpdateObserverLocations, CurrentTime, false);
+	}
+	LastStats.UnitsDeferred = FMath::Max(0, DueCount - ScheduledIndex);
+	// Units that were not due fill the schedule in round-robin order after the due ones.
+	if (ScheduledIndex > DueCount && SpatialHash.Num() > 0)
+	{
+		UpdateCursor = (UpdateCursor + ScheduledIndex - DueCount) % SpatialHash.Num();
 	}
+	// Chunk order, so the processor's write-back pass walks the results once.
+	Algo::Sort(SteeringWrites, [](const FCrowdSteeringWrite& A, const FCrowdSteeringWrite& B)
+	{
+		return A.ChunkOrdinal != B.ChunkOrdinal ? A.ChunkOrdinal < B.ChunkOrdinal : A.ChunkIndex < B.ChunkIndex;
+	});
+	SteeringWriteCursor = 0;
 }
 
-void UMassUnitCrowdSystem::BuildObserverLocations(TArray<FVector>& OutObserverLocations) const
+void UMassUnitCrowdSystem::WriteChunkSteering(
+	int32 ChunkOrdinal,
+	TConstArrayView<FMassEntityHandle> Entities,
+	TArrayView<FMassUnitCrowdFragment> Crowds)
 {
-	if (!World)
-	{
-		return;
-	}
-	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	while (SteeringWriteCursor < SteeringWrites.Num() && SteeringWrites[SteeringWriteCursor].ChunkOrdinal <= ChunkOrdinal)
 	{
-		const APlayerController* Controller = It->Get();
-		if (!Controller)
+		FCrowdSteeringWrite& Write = SteeringWrites[SteeringWriteCursor++];
+		// A chunk that changed since scheduling leaves the write to FinishCrowdUpdate.
+		if (Write.ChunkOrdinal != ChunkOrdinal
+			|| !Entities.IsValidIndex(Write.ChunkIndex)
+			|| Entities[Write.ChunkIndex] != Write.Entity.ToMassEntityHandle())
 		{
 			continue;
 		}
-		if (const APawn* Pawn = Controller->GetPawn())
-		{
-			OutObserverLocations.Add(Pawn->GetActorLocation());
-		}
-		else
+		FMassUnitCrowdFragment& Crowd = Crowds[Write.ChunkIndex];
+		const FCrowdGroup* Group = Groups.Find(Write.GroupHandle);
+		if (Group && Crowd.bEnabled)
 		{
-			FVector ViewLocation;
-			FRotator ViewRotation;
-			Controller->GetPlayerViewPoint(ViewLocation, ViewRotation);
-			OutObserverLocations.Add(ViewLocation);
+			WriteSteering(Write, *Group, Crowd, UpdateTime);
 		}
+		Write.bWritten = true;
 	}
 }
 
-void UMassUnitCrowdSystem::RefreshPopulationStats(const TArray<FSpatialEntry>& Entries)
+void UMassUnitCrowdSystem::FinishCrowdUpdate()
 {
-	LastStats.RegisteredGroups = Groups.Num();
-	LastStats.RegisteredUnits = 0;
-	LastStats.ManagedSubgroups = 0;
-	LastStats.ActiveUnits = 0;
-	LastStats.SleepingUnits = 0;
-	LastStats.EngagedGroups = 0;
-	LastStats.EngagedUnits = 0;
-	for (const TPair<int32, FCrowdGroup>& Pair : Groups)
-	{
-		LastStats.ManagedSubgroups += Pair.Value.SubgroupCount;
-		if (Pair.Value.bEngaged && Pair.Value.TargetActor.IsValid())
-		{
-			++LastStats.EngagedGroups;
-		}
-	}
-	if (!EntitySubsystem)
+	if (!bUpdatingCrowds)
 	{
 		return;
 	}
+	FlushSteeringWrites();
+	RefreshPopulationStats();
+	LastStats.UpdateMs = static_cast<float>((FPlatformTime::Seconds() - UpdateStartTime) * 1000.0);
+	bUpdatingCrowds = false;
+}
+
+void UMassUnitCrowdSystem::FCrowdUnitInputs::Capture(
+	const FMassUnitCrowdFragment& Crowd,
+	const FMassUnitStateFragment& State,
+	const FMassUnitTargetFragment& Target,
+	const FMassUnitNavigationFragment& Navigation)
+{
+	TargetLocation = Target.TargetLocation;
+	NavigationDestination = Navigation.DestinationLocation;
+	NextDecisionTime = Crowd.NextDecisionTime;
+	NextSteeringUpdateTime = Crowd.NextSteeringUpdateTime;
+	InteractionEndTime = Crowd.InteractionEndTime;
+	SubgroupIndex = Crowd.SubgroupIndex;
+	SharedPathRevision = Crowd.SharedPathRevision;
+	DecisionSequence = Crowd.DecisionSequence;
+	bEnabled = Crowd.bEnabled;
+	bUse3DMovement = Crowd.bUse3DMovement;
+	bIncapacitated = State.CurrentState == EMassUnitState::Dead || State.CurrentState == EMassUnitState::Stunned;
+	bHasTargetLocation = Target.bHasTargetLocation;
+	bPathRequested = Navigation.bPathRequested;
+	bPathValid = Navigation.bPathValid;
+}
 
+bool UMassUnitCrowdSystem::CaptureUnitInputs(FMassUnitEntityHandle Entity, FCrowdUnitInputs& OutInputs) const
+{
+	if (!EntitySubsystem || !IsEntityValid(Entity))
+	{
+		return false;
+	}
 	const FMassEntityManager& EntityManager = EntitySubsystem->GetEntityManager();
-	for (const FSpatialEntry& Entry : Entries)
+	const FMassEntityHandle NativeHandle = Entity.ToMassEntityHandle();
+	const FMassUnitCrowdFragment* Crowd = EntityManager.GetFragmentDataPtr<FMassUnitCrowdFragment>(NativeHandle);
+	const FMassUnitStateFragment* State = EntityManager.GetFragmentDataPtr<FMassUnitStateFragment>(NativeHandle);
+	const FMassUnitTargetFragment* Target = EntityManager.GetFragmentDataPtr<FMassUnitTargetFragment>(NativeHandle);
+	const FMassUnitNavigationFragment* Navigation = EntityManager.GetFragmentDataPtr<FMassUnitNavigationFragment>(NativeHandle);
+	if (!Crowd || !State || !Target || !Navigation)
+	{
+		return false;
+	}
+	OutInputs.Capture(*Crowd, *State, *Target, *Navigation);
+	return true;
+}
+
+int32 UMassUnitCrowdSystem::ScheduleUnits(const TArray<FVector>& ObserverLocations, float CurrentTime)
+{
+	RefreshLiveEngagementTargets();
+	const int32 EntryCount = FMath::Max(1, SpatialHash.Num());
+	const int32 StartIndex = UpdateCursor % EntryCount;
+	const int32 ScheduledCount = ScheduledUnits.Num();
+	ParallelFor(
+		ScheduledCount,
+		[this, &ObserverLocations, CurrentTime](int32 ScheduledIndex)
+		{
+			ScoreScheduledUnit(ScheduledUnits[ScheduledIndex], ObserverLocations, CurrentTime);
+		},
+		!bParallelDecisions || ScheduledCount < MinParallelDecisionCount ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+	// Only the prefix this update can serve is ordered: due units by priority,
+	// then units that are not due yet in round-robin order from the update
+	// cursor. Rotated entry indices break ties, so the order is deterministic.
+	const auto RoundRobinOrder = [StartIndex, EntryCount](const FScheduledUnit& A, const FScheduledUnit& B)
+	{
+		return (A.EntryIndex - StartIndex + EntryCount) % EntryCount < (B.EntryIndex - StartIndex + EntryCount) % EntryCount;
+	};
+	const int32 DueCount = Algo::Partition(ScheduledUnits.GetData(), ScheduledCount, [](const FScheduledUnit& Unit)
+	{
+		return Unit.bDue;
+	});
+	const int32 UnitsToUpdate = FMath::Min(MaxUnitsPerUpdate, ScheduledCount);
+	const TArrayView<FScheduledUnit> ScheduledView(ScheduledUnits);
+	SortFirst(ScheduledView.Left(DueCount), UnitsToUpdate, [&RoundRobinOrder](const FScheduledUnit& A, const FScheduledUnit& B)
+	{
+		return A.Priority != B.Priority ? A.Priority > B.Priority : RoundRobinOrder(A, B);
+	});
+	if (UnitsToUpdate > DueCount)
+	{
+		SortFirst(ScheduledView.RightChop(DueCount), UnitsToUpdate - DueCount, RoundRobinOrder);
+	}
+	return DueCount;
+}
+
+void UMassUnitCrowdSystem::ScoreScheduledUnit(
+	FScheduledUnit& Unit,
+	const TArray<FVector>& ObserverLocations,
+	float CurrentTime) const
+{
+	// Priority is seconds overdue plus a head start for engaged units and
+	// units near an observer. A deferred unit keeps aging because its decision
+	// and steering times stay in the past, so under a saturated budget it
+	// eventually outranks fresh engaged work instead of starving.
+	constexpr float EngagedHeadStart = 2.0f;
+	constexpr float NearObserverHeadStart = 1.0f;
+
+	Unit.bDue = false;
+	Unit.Priority = 0.0f;
+	const FSpatialEntry& Entry = SpatialHash.GetEntry(Unit.EntryIndex);
+	const FCrowdGroup* Group = Groups.Find(Entry.GroupHandle);
+	if (!Group || Group->bPaused || !Unit.Inputs.bEnabled || !IsEntityValid(Unit.Entity))
+	{
+		return;
+	}
+
+	const float Overdue = CurrentTime - FMath::Min(Unit.Inputs.NextDecisionTime, Unit.Inputs.NextSteeringUpdateTime);
+	if (Group->bHasLiveEngagementTarget)
+	{
+		Unit.bDue = true;
+		Unit.Priority = EngagedHeadStart + Overdue;
+		return;
+	}
+	if (Overdue < 0.0f)
+	{
+		return;
+	}
+	Unit.bDue = true;
+	Unit.Priority = Overdue;
+	float ObserverDistanceSquared = 0.0f;
+	if (!ObserverLocations.IsEmpty()
+		&& CalculateSimulationLOD(Entry.Location, ObserverLocations, ObserverDistanceSquared) == 0)
+	{
+		Unit.Priority += NearObserverHeadStart;
+	}
+}
+
+void UMassUnitCrowdSystem::RefreshLiveEngagementTargets()
+{
+	// Weak target pointers are resolved once here so the parallel phases only
+	// read plain group data while they run on worker threads.
+	for (TPair<int32, FCrowdGroup>& Pair : Groups)
+	{
+		Pair.Value.bHasLiveEngagementTarget = Pair.Value.bEngaged && Pair.Value.TargetActor.IsValid();
+	}
+}
+
+void UMassUnitCrowdSystem::PruneInvalidUnits()
+{
+	// Walk backwards so swap-removal never skips an entry.
+	for (int32 EntryIndex = SpatialHash.Num() - 1; EntryIndex >= 0; --EntryIndex)
+	{
+		if (!SpatialHash.IsValidIndex(EntryIndex))
+		{
+			continue;
+		}
+		const FMassUnitEntityHandle Entity = SpatialHash.GetEntry(EntryIndex).Entity;
+		if (!IsEntityValid(Entity))
+		{
+			RemoveUnitFromPreviousGroup(Entity);
+		}
+	}
+}
+
+void UMassUnitCrowdSystem::SyncSpatialHash()
+{
+	if (!EntitySubsystem)
+	{
+		return;
+	}
+
+	const FMassEntityManager& EntityManager = EntitySubsystem->GetEntityManager();
+	for (int32 EntryIndex = SpatialHash.Num() - 1; EntryIndex >= 0; --EntryIndex)
+	{
+		if (!SpatialHash.IsValidIndex(EntryIndex))
+		{
+			continue;
+		}
+		const FMassUnitEntityHandle Entity = SpatialHash.GetEntry(EntryIndex).Entity;
+		const FMassUnitTransformFragment* Transform = IsEntityValid(Entity)
+			? EntityManager.GetFragmentDataPtr<FMassUnitTransformFragment>(Entity.ToMassEntityHandle())
+			: nullptr;
+		if (!Transform)
+		{
+			RemoveUnitFromPreviousGroup(Entity);
+			continue;
+		}
+		const FMassUnitStateFragment* State = EntityManager.GetFragmentDataPtr<FMassUnitStateFragment>(Entity.ToMassEntityHandle());
+		SyncEntryLocation(EntryIndex, Transform->GetTransform().GetLocation(), !State || State->CurrentState != EMassUnitState::Dead);
+	}
+	AdvanceNeighborClocks();
+	RefreshGroupAggregates();
+}
+
+void UMassUnitCrowdSystem::BuildObserverLocations(TArray<FVector>& OutObserverLocations) const
+{
+	if (!World)
+	{
+		return;
+	}
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* Controller = It->Get();
+		if (!Controller)
+		{
+			continue;
+		}
+		if (const APawn* Pawn = Controller->GetPawn())
+		{
+			OutObserverLocations.Add(Pawn->GetActorLocation());
+		}
+		else
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			Controller->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			OutObserverLocations.Add(ViewLocation);
+		}
+	}
+}
+
+void UMassUnitCrowdSystem::RefreshPopulationStats()
+{
+	// Every input is maintained on register/unregister, sleep/wake, death, and
+	// engage/disengage transitions, so this is O(groups) rather than O(units).
+	// Dead members of an engaged group are not engaged.
+	LastStats.RegisteredGroups = Groups.Num();
+	LastStats.SleepingUnits = DormantCellByUnit.Num();
+	LastStats.ActiveUnits = SpatialHash.Num();
+	LastStats.RegisteredUnits = LastStats.ActiveUnits + LastStats.SleepingUnits;
+	LastStats.DormantCells = DormantCells.Num();
+	LastStats.ManagedSubgroups = 0;
+	LastStats.EngagedGroups = 0;
+	LastStats.EngagedUnits = EngagedUnitCount;
+	for (const TPair<int32, FCrowdGroup>& Pair : Groups)
+	{
+		LastStats.ManagedSubgroups += Pair.Value.SubgroupCount;
+		if (Pair.Value.bEngaged)
+		{
+			++LastStats.EngagedGroups;
+		}
+	}
+	if (bAuditPopulationStats)
+	{
+		AuditPopulationStats();
+	}
+}
+
+void UMassUnitCrowdSystem::AuditPopulationStats() const
+{
+	if (!EntitySubsystem)
+	{
+		return;
+	}
+
+	int32 RegisteredUnits = 0;
+	int32 SleepingUnits = 0;
+	int32 EngagedUnits = 0;
+	const FMassEntityManager& EntityManager = EntitySubsystem->GetEntityManager();
+	for (const FSpatialEntry& Entry : SpatialHash.GetEntries())
 	{
 		if (!IsEntityValid(Entry.Entity))
 		{
 			continue;
 		}
-		++LastStats.RegisteredUnits;
+		++RegisteredUnits;
 		const FCrowdGroup* Group = Groups.Find(Entry.GroupHandle);
-		if (Group && Group->bEngaged && Group->TargetActor.IsValid())
+		if (Entry.bLiving && Group && Group->bEngaged)
 		{
-			++LastStats.EngagedUnits;
+			++EngagedUnits;
 		}
+		// Sleeping units must live in the dormant grid, never in the hash.
 		const FMassUnitCrowdFragment* Crowd = EntityManager.GetFragmentDataPtr<FMassUnitCrowdFragment>(Entry.Entity.ToMassEntityHandle());
 		if (Crowd && Crowd->bSleeping)
 		{
-			++LastStats.SleepingUnits;
+			++SleepingUnits;
 		}
-		else
+	}
+	// Destroyed dormant units are pruned lazily, a few cells per update, so
+	// they are expected to remain counted until their cell is next visited.
+	int32 UnprunedDormantUnits = 0;
+	for (const TPair<FIntPoint, TArray<FDormantUnit>>& Cell : DormantCells)
+	{
+		for (const FDormantUnit& Unit : Cell.Value)
 		{
-			++LastStats.ActiveUnits;
+			if (!IsEntityValid(Unit.Entity))
+			{
+				++UnprunedDormantUnits;
+				continue;
+			}
+			++RegisteredUnits;
+			const int32* GroupHandle = UnitToGroup.Find(Unit.Entity);
+			const FCrowdGroup* Group = GroupHandle ? Groups.Find(*GroupHandle) : nullptr;
+			if (Unit.bLiving && Group && Group->bEngaged)
+			{
+				++EngagedUnits;
+			}
+			const FMassUnitCrowdFragment* Crowd = EntityManager.GetFragmentDataPtr<FMassUnitCrowdFragment>(Unit.Entity.ToMassEntityHandle());
+			if (Crowd && Crowd->bSleeping)
+			{
+				++SleepingUnits;
+			}
 		}
 	}
+	RegisteredUnits += UnprunedDormantUnits;
+	SleepingUnits += UnprunedDormantUnits;
+	if (RegisteredUnits != LastStats.RegisteredUnits
+		|| SleepingUnits != LastStats.SleepingUnits
+		|| EngagedUnits != LastStats.EngagedUnits)
+	{
+		UE_LOG(
+			LogMassUnitSystem,
+			Warning,
+			TEXT("Crowd stats drifted: registered %d/%d, sleeping %d/%d, engaged %d/%d (incremental/audited)"),
+			LastStats.RegisteredUnits,
+			RegisteredUnits,
+			LastStats.SleepingUnits,
+			SleepingUnits,
+			LastStats.EngagedUnits,
+			EngagedUnits);
+	}
 }
 
 void UMassUnitCrowdSystem::RefreshManagedSubgroupPaths(
 	float CurrentTime,
-	const TArray<FSpatialEntry>& Entries,
 	int32 OnlyGroupHandle,
 	bool bForceRefresh)
 {
@@ -768,7 +1374,7 @@ void UMassUnitCrowdSystem::RefreshManagedSubgroupPaths(
 	};
 	TMap<uint64, FAnchorAccumulator> Anchors;
 	const FMassEntityManager& EntityManager = EntitySubsystem->GetEntityManager();
-	for (const FSpatialEntry& Entry : Entries)
+	for (const FSpatialEntry& Entry : SpatialHash.GetEntries())
 	{
 		const FCrowdGroup* Group = Groups.Find(Entry.GroupHandle);
 		if (!Group
@@ -812,7 +1418,9 @@ void UMassUnitCrowdSystem::RefreshManagedSubgroupPaths(
 
 		for (int32 SubgroupIndex = 0; SubgroupIndex < Group.Subgroups.Num(); ++SubgroupIndex)
 		{
-			if (PathsAttempted >= MaxSharedPathBuildsPerUpdate)
+			// Corridor builds are the most expensive crowd work; the first one
+			// always runs so a tight time budget cannot starve subgroups.
+			if (PathsAttempted >= MaxSharedPathBuildsPerUpdate || (PathsAttempted > 0 && !HasUpdateBudget()))
 			{
 				return;
 			}
@@ -829,9 +1437,10 @@ void UMassUnitCrowdSystem::RefreshManagedSubgroupPaths(
 				&& FVector::DistSquared2D(Anchor, Subgroup.Destination)
 					<= FMath::Square(FMath::Max(Group.AcceptanceRadius, Group.Config.SeparationRadius));
 			if (!bForceRefresh
-				&& !Subgroup.SharedPathPoints.IsEmpty()
-				&& !bReachedDestination
-				&& CurrentTime < Subgroup.NextPathRefreshTime)
+				&& (Subgroup.PendingPathQuery != 0
+					|| (!Subgroup.SharedPathPoints.IsEmpty()
+						&& !bReachedDestination
+						&& CurrentTime < Subgroup.NextPathRefreshTime)))
 			{
 				continue;
 			}
@@ -840,68 +1449,129 @@ void UMassUnitCrowdSystem::RefreshManagedSubgroupPaths(
 			uint32 Seed = HashCombine(::GetTypeHash(Group.Config.RandomSeed), ::GetTypeHash(SubgroupIndex));
 			Seed = HashCombine(Seed, ::GetTypeHash(Subgroup.DecisionSequence++));
 			FRandomStream RandomStream(static_cast<int32>(Seed));
-			const FVector WanderCenter = CalculateSubgroupWanderCenter(SubgroupIndex, Group);
-			const float WanderRadius = Group.SubgroupCount > 1
-				? Group.Config.WanderRadius * Group.Config.SubgroupWanderRadiusScale
-				: Group.Config.WanderRadius;
-			FVector Destination = Anchor;
-			for (int32 Attempt = 0; Attempt < 4; ++Attempt)
-			{
-				const float Angle = RandomStream.FRandRange(0.0f, 2.0f * UE_PI);
-				const float Radius = FMath::Sqrt(RandomStream.FRand()) * WanderRadius;
-				Destination = WanderCenter + FVector(FMath::Cos(Angle) * Radius, FMath::Sin(Angle) * Radius, 0.0f);
-				Destination.Z = Anchor.Z;
-				if (FVector::DistSquared2D(Destination, Anchor) >= FMath::Square(Group.Config.MinWanderDistance))
-				{
-					break;
-				}
-			}
+			const FVector Destination = ChooseWanderDestination(Anchor, SubgroupIndex, Group, RandomStream);
 
-			TArray<FVector> NewPathPoints;
-			bool bUsesNavmesh = false;
-			if (!NavigationSystem->FindSharedPath(Anchor, Destination, NewPathPoints, &bUsesNavmesh)
-				|| NewPathPoints.IsEmpty())
+			// The previous corridor stays in use until this one lands; a fallback
+			// completes before FindSharedPathAsync returns.
+			CancelSharedPathQuery(Subgroup.PendingPathQuery, Subgroup.PathRequestSerial);
+			const int32 Serial = ++Subgroup.PathRequestSerial;
+			++LastStats.AmbientSharedPathsBuilt;
+			const uint32 QueryId = NavigationSystem->FindSharedPathAsync(
+				Anchor,
+				Destination,
+				[WeakThis = TWeakObjectPtr<UMassUnitCrowdSystem>(this), GroupHandle = Pair.Key, SubgroupIndex, Serial, Anchor](
+					TArray<FVector>&& PathPoints,
+					bool bUsesNavmesh)
+				{
+					if (UMassUnitCrowdSystem* CrowdSystem = WeakThis.Get())
+					{
+						CrowdSystem->HandleSubgroupPathBuilt(GroupHandle, SubgroupIndex, Serial, Anchor, MoveTemp(PathPoints), bUsesNavmesh);
+					}
+				});
+			if (Subgroup.PathRequestSerial == Serial && QueryId != 0)
 			{
-				Subgroup.NextPathRefreshTime = CurrentTime + 1.0f;
-				continue;
+				Subgroup.PendingPathQuery = QueryId;
 			}
-			Subgroup.Destination = NewPathPoints.Last();
-			Subgroup.SharedPathPoints = MoveTemp(NewPathPoints);
-			Subgroup.bUsesNavmesh = bUsesNavmesh;
-			Subgroup.NextPathRefreshTime = CurrentTime + Group.Config.MaxMoveTime;
-			++Subgroup.Revision;
-			++LastStats.AmbientSharedPathsBuilt;
+		}
+	}
+}
+
+void UMassUnitCrowdSystem::HandleSubgroupPathBuilt(
+	int32 GroupHandle,
+	int32 SubgroupIndex,
+	int32 Serial,
+	const FVector& Anchor,
+	TArray<FVector>&& PathPoints,
+	bool bUsesNavmesh)
+{
+	FCrowdGroup* Group = Groups.Find(GroupHandle);
+	if (!Group || !World || !Group->Subgroups.IsValidIndex(SubgroupIndex))
+	{
+		return;
+	}
+	FCrowdSubgroupState& Subgroup = Group->Subgroups[SubgroupIndex];
+	if (Subgroup.PathRequestSerial != Serial)
+	{
+		return;
+	}
+	Subgroup.PendingPathQuery = 0;
+	const float CurrentTime = World->GetTimeSeconds();
+	if (PathPoints.IsEmpty())
+	{
+		Subgroup.NextPathRefreshTime = CurrentTime + 1.0f;
+		return;
+	}
+	Subgroup.Destination = PathPoints.Last();
+	Subgroup.SharedPathPoints = MoveTemp(PathPoints);
+	Subgroup.bUsesNavmesh = bUsesNavmesh;
+	Subgroup.NextPathRefreshTime = CurrentTime + Group->Config.MaxMoveTime;
+	++Subgroup.Revision;
 
 #if ENABLE_DRAW_DEBUG
-			if (Group.Config.bEnableVisualDebug && World)
+	if (Group->Config.bEnableVisualDebug)
+	{
+		FVector PreviousPoint = Anchor;
+		for (FVector PathPoint : Subgroup.SharedPathPoints)
+		{
+			if (Subgroup.bUsesNavmesh && Group->Config.bConformToNavmeshHeight)
 			{
-				FVector PreviousPoint = Anchor;
-				for (FVector PathPoint : Subgroup.SharedPathPoints)
-				{
-					if (Subgroup.bUsesNavmesh && Group.Config.bConformToNavmeshHeight)
-					{
-						PathPoint.Z += Group.Config.NavigationHeightOffset;
-					}
-					DrawDebugLine(World, PreviousPoint, PathPoint, FColor::Cyan, false, Group.Config.MaxMoveTime, 0, 2.0f);
-					PreviousPoint = PathPoint;
-				}
+				PathPoint.Z += Group->Config.NavigationHeightOffset;
 			}
-#endif
+			DrawDebugLine(World, PreviousPoint, PathPoint, FColor::Cyan, false, Group->Config.MaxMoveTime, 0, 2.0f);
+			PreviousPoint = PathPoint;
 		}
 	}
+#endif
+}
+
+void UMassUnitCrowdSystem::CancelSharedPathQuery(uint32& QueryId, int32& Serial) const
+{
+	++Serial;
+	if (QueryId != 0 && NavigationSystem)
+	{
+		NavigationSystem->CancelSharedPath(QueryId);
+	}
+	QueryId = 0;
+}
+
+bool UMassUnitCrowdSystem::CalculateManagedSubgroupDestination(
+	const FSpatialEntry& Entry,
+	int32 SubgroupIndex,
+	const FCrowdGroup& Group,
+	FVector& OutDestination) const
+{
+	if (!Group.bUseNavigation
+		|| Group.Config.MovementMode != EMassUnitCrowdMovementMode::Planar2D
+		|| !Group.Config.bEnableManagedSubgroups
+		|| !Group.Subgroups.IsValidIndex(SubgroupIndex))
+	{
+		return false;
+	}
+	const FCrowdSubgroupState& Subgroup = Group.Subgroups[SubgroupIndex];
+	if (Subgroup.SharedPathPoints.IsEmpty())
+	{
+		return false;
+	}
+
+	OutDestination = CalculatePathLookAheadDestination(
+		Entry.Location,
+		Subgroup.SharedPathPoints,
+		Group.Config.SubgroupPathLookAheadDistance);
+	if (!Subgroup.bUsesNavmesh || !Group.Config.bConformToNavmeshHeight)
+	{
+		OutDestination.Z = Entry.Location.Z;
+	}
+	return true;
 }
 
-bool UMassUnitCrowdSystem::UpdateManagedSubgroupUnit(
+bool UMassUnitCrowdSystem::ApplyManagedSubgroupDestination(
 	const FSpatialEntry& Entry,
 	FCrowdGroup& Group,
+	const FVector& Destination,
 	float CurrentTime,
 	float LODIntervalMultiplier)
 {
-	if (!EntitySubsystem
-		|| !UnitManager
-		|| !Group.bUseNavigation
-		|| Group.Config.MovementMode != EMassUnitCrowdMovementMode::Planar2D
-		|| !Group.Config.bEnableManagedSubgroups)
+	if (!EntitySubsystem || !UnitManager)
 	{
 		return false;
 	}
@@ -915,19 +1585,6 @@ bool UMassUnitCrowdSystem::UpdateManagedSubgroupUnit(
 		return false;
 	}
 	const FCrowdSubgroupState& Subgroup = Group.Subgroups[Crowd->SubgroupIndex];
-	if (Subgroup.SharedPathPoints.IsEmpty())
-	{
-		return false;
-	}
-
-	FVector Destination = CalculatePathLookAheadDestination(
-		Entry.Location,
-		Subgroup.SharedPathPoints,
-		Group.Config.SubgroupPathLookAheadDistance);
-	if (!Subgroup.bUsesNavmesh || !Group.Config.bConformToNavmeshHeight)
-	{
-		Destination.Z = Entry.Location.Z;
-	}
 	if (!UnitManager->SetUnitDestination(FMassUnitHandle(Entry.Entity), Destination, Group.AcceptanceRadius))
 	{
 		return false;
@@ -953,286 +1610,522 @@ bool UMassUnitCrowdSystem::UpdateManagedSubgroupUnit(
 	return true;
 }
 
-void UMassUnitCrowdSystem::UpdateUnit(
-	const FSpatialEntry& Entry,
-	FCrowdGroup& Group,
-	const TArray<FSpatialEntry>& Entries,
-	const TMap<FIntVector, TArray<int32>>& Cells,
-	const TMap<FMassUnitEntityHandle, int32>& EntryByEntity,
+void UMassUnitCrowdSystem::ProcessPendingDecisions(
 	const TArray<FVector>& ObserverLocations,
 	float CurrentTime,
 	bool bForceDecision)
 {
-	if (!IsEntityValid(Entry.Entity) || !EntitySubsystem)
+	if (PendingDecisions.IsEmpty())
 	{
 		return;
 	}
 
-	FMassEntityManager& EntityManager = EntitySubsystem->GetMutableEntityManager();
-	const FMassEntityHandle NativeHandle = Entry.Entity.ToMassEntityHandle();
-	FMassUnitCrowdFragment* Crowd = EntityManager.GetFragmentDataPtr<FMassUnitCrowdFragment>(NativeHandle);
-	FMassUnitStateFragment* State = EntityManager.GetFragmentDataPtr<FMassUnitStateFragment>(NativeHandle);
-	FMassUnitTargetFragment* Target = EntityManager.GetFragmentDataPtr<FMassUnitTargetFragment>(NativeHandle);
-	FMassUnitNavigationFragment* Navigation = EntityManager.GetFragmentDataPtr<FMassUnitNavigationFragment>(NativeHandle);
-	if (!Crowd || !State || !Target || !Navigation || !Crowd->bEnabled)
+	RefreshLiveEngagementTargets();
+
+	// Take the batch locally: events raised while applying may re-enter ForceCrowdGroupUpdate.
+	TArray<FCrowdUnitDecision> Decisions = MoveTemp(PendingDecisions);
+	const int32 DecisionCount = Decisions.Num();
+	const double DecideStartTime = FPlatformTime::Seconds();
+	ParallelFor(
+		DecisionCount,
+		[this, &Decisions, &ObserverLocations, CurrentTime, bForceDecision](int32 DecisionIndex)
+		{
+			DecideUnit(Decisions[DecisionIndex], ObserverLocations, CurrentTime, bForceDecision);
+		},
+		!bParallelDecisions || DecisionCount < MinParallelDecisionCount ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+	const double ApplyStartTime = FPlatformTime::Seconds();
+	LastStats.DecideMs += static_cast<float>((ApplyStartTime - DecideStartTime) * 1000.0);
+
+	// Apply in budget order so the outcome is identical regardless of how the
+	// decide phase was scheduled across workers.
+	for (const FCrowdUnitDecision& Decision : Decisions)
+	{
+		FCrowdGroup* Group = Groups.Find(Decision.Entry.GroupHandle);
+		if (!Group || Group->bPaused)
+		{
+			continue;
+		}
+		if (Decision.Action != ECrowdDecisionAction::Skip)
+		{
+			ApplyUnitDecision(Decision, *Group, CurrentTime);
+		}
+		++LastStats.UnitsUpdated;
+	}
+	LastStats.ApplyMs += static_cast<float>((FPlatformTime::Seconds() - ApplyStartTime) * 1000.0);
+	// Hand the allocation back so the next batch does not reallocate.
+	Decisions.Reset();
+	PendingDecisions = MoveTemp(Decisions);
+}
+
+void UMassUnitCrowdSystem::DecideUnit(
+	FCrowdUnitDecision& Decision,
+	const TArray<FVector>& ObserverLocations,
+	float CurrentTime,
+	bool bForceDecision) const
+{
+	const FSpatialEntry& Entry = Decision.Entry;
+	const FCrowdGroup* Group = Groups.Find(Entry.GroupHandle);
+	if (!Group || Group->bPaused || !EntitySubsystem || !IsEntityValid(Entry.Entity))
+	{
+		Decision.Action = ECrowdDecisionAction::Skip;
+		return;
+	}
+
+	// Fragment values were captured when the unit was scheduled, so workers
+	// never look fragments up by handle.
+	const FCrowdUnitInputs& Unit = Decision.Inputs;
+	if (!Unit.bEnabled)
 	{
+		Decision.Action = ECrowdDecisionAction::Skip;
 		return;
 	}
 
 	float ObserverDistanceSquared = 0.0f;
-	const int32 LODLevel = CalculateSimulationLOD(Entry.Location, ObserverLocations, ObserverDistanceSquared);
-	const float LODMultiplier = GetSimulationIntervalMultiplier(LODLevel);
-	Crowd->SimulationLOD = LODLevel;
-	Crowd->bUse3DMovement = Group.Config.MovementMode == EMassUnitCrowdMovementMode::Free3D;
-	Crowd->bConformToNavmeshHeight = Group.bUseNavigation
-		&& !Crowd->bUse3DMovement
-		&& Group.Config.bConformToNavmeshHeight;
-	Crowd->NavigationHeightOffset = Group.Config.NavigationHeightOffset;
+	Decision.SimulationLOD = CalculateSimulationLOD(Entry.Location, ObserverLocations, ObserverDistanceSquared);
+	Decision.LODMultiplier = GetSimulationIntervalMultiplier(Decision.SimulationLOD);
 
-	const bool bHasEngagementTarget = Group.bEngaged && Group.TargetActor.IsValid();
+	const bool bHasEngagementTarget = Group->bHasLiveEngagementTarget;
 	const bool bShouldSleep = !bHasEngagementTarget
 		&& !ObserverLocations.IsEmpty()
-		&& Group.Config.MaxSimulationDistance > 0.0f
-		&& ObserverDistanceSquared > FMath::Square(Group.Config.MaxSimulationDistance);
+		&& Group->Config.MaxSimulationDistance > 0.0f
+		&& ObserverDistanceSquared > FMath::Square(Group->Config.MaxSimulationDistance);
 	if (bShouldSleep)
 	{
-		SetUnitSleeping(Entry.Entity, true, CurrentTime);
+		Decision.Action = ECrowdDecisionAction::Sleep;
 		return;
 	}
-	if (Crowd->bSleeping)
-	{
-		SetUnitSleeping(Entry.Entity, false, CurrentTime);
-		bForceDecision = true;
-	}
 
-	if (State->CurrentState == EMassUnitState::Dead || State->CurrentState == EMassUnitState::Stunned)
+	if (Unit.bIncapacitated)
 	{
-		Crowd->SteeringDirection = FVector::ZeroVector;
+		Decision.bZeroSteering = true;
 		return;
 	}
+	const bool bSteeringDue = bForceDecision || CurrentTime >= Unit.NextSteeringUpdateTime;
 	if (bHasEngagementTarget)
 	{
-		if (bForceDecision || CurrentTime >= Crowd->NextSteeringUpdateTime)
+		if (bSteeringDue)
 		{
-			Crowd->SteeringDirection = CalculateSeparation(Entry, Group, Entries, Cells);
-			Crowd->NextSteeringUpdateTime = CurrentTime + (UpdateInterval * LODMultiplier);
+			Decision.SteeringDirection = CalculateSeparation(Decision, *Group);
+			Decision.bRecalculatedSteering = true;
 		}
-		UpdateEngagedUnit(Entry, Group, CurrentTime, bForceDecision);
+		Decision.Action = ECrowdDecisionAction::Engaged;
+		Decision.bForceDecision = bForceDecision;
 		return;
 	}
-	if (Group.bHoldAfterEngagement)
+	if (Group->bHoldAfterEngagement || Unit.InteractionEndTime > CurrentTime)
 	{
-		Crowd->SteeringDirection = FVector::ZeroVector;
+		Decision.bZeroSteering = true;
 		return;
 	}
+	Decision.bEndInteraction = Unit.InteractionEndTime > 0.0f;
 
-	if (Crowd->InteractionEndTime > CurrentTime)
-	{
-		Crowd->SteeringDirection = FVector::ZeroVector;
-		return;
-	}
-	if (Crowd->InteractionEndTime > 0.0f)
+	if (bSteeringDue)
 	{
-		Crowd->InteractionEndTime = 0.0f;
-		Crowd->InteractionPartner.Invalidate();
-		if (State->CurrentState == EMassUnitState::Interacting)
-		{
-			State->CurrentState = EMassUnitState::Idle;
-			State->StateTime = 0.0f;
-		}
+		Decision.SteeringDirection = CalculateSeparation(Decision, *Group);
+		Decision.bRecalculatedSteering = true;
 	}
 
-	if (bForceDecision || CurrentTime >= Crowd->NextSteeringUpdateTime)
+	bool bHasMovementTarget = Unit.bHasTargetLocation || Unit.bPathRequested || Unit.bPathValid;
+	const bool bUsesManagedAmbientPath = Group->bUseNavigation
+		&& Group->Config.MovementMode == EMassUnitCrowdMovementMode::Planar2D
+		&& Group->Config.bEnableManagedSubgroups
+		&& Group->Subgroups.IsValidIndex(Unit.SubgroupIndex)
+		&& !Group->Subgroups[Unit.SubgroupIndex].SharedPathPoints.IsEmpty();
+	if (bUsesManagedAmbientPath
+		&& Unit.SharedPathRevision != Group->Subgroups[Unit.SubgroupIndex].Revision
+		&& bHasMovementTarget)
 	{
-		Crowd->SteeringDirection = CalculateSeparation(Entry, Group, Entries, Cells);
-		Crowd->NextSteeringUpdateTime = CurrentTime + (UpdateInterval * LODMultiplier);
+		Decision.bClearMovement = true;
+		bHasMovementTarget = false;
+		bForceDecision = true;
 	}
 
-	const bool bUsesManagedAmbientPath = Group.bUseNavigation
-		&& Group.Config.MovementMode == EMassUnitCrowdMovementMode::Planar2D
-		&& Group.Config.bEnableManagedSubgroups
-		&& Group.Subgroups.IsValidIndex(Crowd->SubgroupIndex)
-		&& !Group.Subgroups[Crowd->SubgroupIndex].SharedPathPoints.IsEmpty();
-	if (bUsesManagedAmbientPath
-		&& Crowd->SharedPathRevision != Group.Subgroups[Crowd->SubgroupIndex].Revision
-		&& (Target->bHasTargetLocation || Navigation->bPathRequested || Navigation->bPathValid))
-	{
-		ClearMovement(Entry.Entity, true);
-		bForceDecision = true;
-	}
-
-	const bool bHasMovementTarget = Target->bHasTargetLocation || Navigation->bPathRequested || Navigation->bPathValid;
 	if (bHasMovementTarget)
 	{
-		const FVector Destination = Target->bHasTargetLocation ? Target->TargetLocation : Navigation->DestinationLocation;
+		const FVector Destination = Unit.bHasTargetLocation ? Unit.TargetLocation : Unit.NavigationDestination;
 		const FVector ToDestination = Destination - Entry.Location;
-		const float DistanceSquared = Crowd->bUse3DMovement ? ToDestination.SizeSquared() : ToDestination.SizeSquared2D();
-		const bool bReached = DistanceSquared <= FMath::Square(Group.AcceptanceRadius);
-		const bool bTimedOut = CurrentTime >= Crowd->NextDecisionTime;
+		const float DistanceSquared = Unit.bUse3DMovement ? ToDestination.SizeSquared() : ToDestination.SizeSquared2D();
+		const bool bReached = DistanceSquared <= FMath::Square(Group->AcceptanceRadius);
+		const bool bTimedOut = CurrentTime >= Unit.NextDecisionTime;
 		if (!bReached && !bTimedOut && !bForceDecision)
 		{
 			return;
 		}
 
-		ClearMovement(Entry.Entity, true);
-		Crowd->NextDecisionTime = CurrentTime;
+		Decision.bClearMovement = true;
 		if (!bForceDecision && bReached)
 		{
-			FRandomStream IdleStream = MakeRandomStream(Entry.Entity, Group, Crowd->DecisionSequence++);
-			Crowd->NextDecisionTime = CurrentTime
-				+ IdleStream.FRandRange(Group.Config.MinIdleTime, Group.Config.MaxIdleTime) * LODMultiplier;
+			FRandomStream IdleStream = MakeRandomStream(Entry.Entity, *Group, Unit.DecisionSequence);
+			Decision.IdleUntilTime = CurrentTime
+				+ IdleStream.FRandRange(Group->Config.MinIdleTime, Group->Config.MaxIdleTime) * Decision.LODMultiplier;
+			Decision.Action = ECrowdDecisionAction::Idle;
 			return;
 		}
 	}
+	else if (!bForceDecision && CurrentTime < Unit.NextDecisionTime)
+	{
+		return;
+	}
 
-	if (!bForceDecision && CurrentTime < Crowd->NextDecisionTime)
+	FRandomStream RandomStream = MakeRandomStream(Entry.Entity, *Group, Unit.DecisionSequence);
+	const bool bTryInteraction = Group->Config.bEnableInteractions
+		&& Group->Config.InteractionChance > 0.0f
+		&& RandomStream.FRand() <= Group->Config.InteractionChance;
+	Decision.InteractionStream = RandomStream;
+	if (bTryInteraction)
+	{
+		Decision.Partner = FindInteractionPartner(Decision, *Group, CurrentTime);
+	}
+	// Both fallbacks are resolved here as well: an earlier decision in this batch
+	// may claim the partner before this decision is applied.
+	Decision.bHasSubgroupDestination = CalculateManagedSubgroupDestination(
+		Entry,
+		Unit.SubgroupIndex,
+		*Group,
+		Decision.SubgroupDestination);
+	Decision.WanderDestination = ChooseWanderDestination(Entry.Location, Unit.SubgroupIndex, *Group, RandomStream);
+	Decision.WanderStream = RandomStream;
+	Decision.Action = ECrowdDecisionAction::Decide;
+}
+
+void UMassUnitCrowdSystem::ApplyUnitDecision(
+	const FCrowdUnitDecision& Decision,
+	FCrowdGroup& Group,
+	float CurrentTime)
+{
+	const FSpatialEntry& Entry = Decision.Entry;
+	if (!EntitySubsystem || !IsEntityValid(Entry.Entity))
 	{
 		return;
 	}
 
-	FRandomStream RandomStream = MakeRandomStream(Entry.Entity, Group, Crowd->DecisionSequence++);
-	if (Group.Config.bEnableInteractions
-		&& Group.Config.InteractionChance > 0.0f
-		&& RandomStream.FRand() <= Group.Config.InteractionChance)
+	LastStats.NeighborChecks += Decision.NeighborChecks;
+	if (Decision.bRebuiltNeighbors)
+	{
+		++LastStats.NeighborListsRebuilt;
+		if (Group.Config.NeighborListSkin > 0.0f)
+		{
+			FNeighborList& List = NeighborLists.FindOrAdd(Entry.Entity);
+			List.Neighbors = Decision.RebuiltNeighbors;
+			List.BuiltLocation = Entry.Location;
+			List.BuiltClock = Group.NeighborClock;
+			List.Radius = GetNeighborListRadius(Group);
+			List.Revision = Group.NeighborListRevision;
+		}
+	}
+
+	FCrowdSteeringWrite Steering;
+	Steering.Entity = Entry.Entity;
+	Steering.SteeringDirection = Decision.SteeringDirection;
+	Steering.NextSteeringUpdateTime = CurrentTime + (UpdateInterval * Decision.LODMultiplier);
+	Steering.GroupHandle = Entry.GroupHandle;
+	Steering.SimulationLOD = Decision.SimulationLOD;
+	Steering.ChunkOrdinal = Decision.ChunkOrdinal;
+	Steering.ChunkIndex = Decision.ChunkIndex;
+	Steering.bZeroSteering = Decision.bZeroSteering;
+	Steering.bRecalculatedSteering = Decision.bRecalculatedSteering;
+	Steering.bEngaged = Decision.Action == ECrowdDecisionAction::Engaged;
+	// Most decisions only refresh steering; the processor writes those through
+	// its chunk views after the apply phase.
+	if (Decision.Action == ECrowdDecisionAction::None
+		&& !Decision.bEndInteraction
+		&& !Decision.bClearMovement
+		&& Decision.ChunkOrdinal != INDEX_NONE)
+	{
+		SteeringWrites.Add(Steering);
+		return;
+	}
+
+	FMassEntityManager& EntityManager = EntitySubsystem->GetMutableEntityManager();
+	const FMassEntityHandle NativeHandle = Entry.Entity.ToMassEntityHandle();
+	FMassUnitCrowdFragment* Crowd = EntityManager.GetFragmentDataPtr<FMassUnitCrowdFragment>(NativeHandle);
+	FMassUnitStateFragment* State = EntityManager.GetFragmentDataPtr<FMassUnitStateFragment>(NativeHandle);
+	if (!Crowd || !State || !Crowd->bEnabled)
+	{
+		return;
+	}
+	if (Decision.Action == ECrowdDecisionAction::Sleep)
 	{
-		const FMassUnitEntityHandle Partner = FindInteractionPartner(Entry, Group, Entries, Cells, CurrentTime);
-		if (Partner.IsValid() && EntryByEntity.Contains(Partner))
+		Crowd->SimulationLOD = Decision.SimulationLOD;
+		CopyGroupMovementSettings(Group, *Crowd);
+		SetUnitSleeping(Entry.Entity, true, CurrentTime);
+		return;
+	}
+	if (!WriteSteering(Steering, Group, *Crowd, CurrentTime))
+	{
+		return;
+	}
+	if (Decision.bEndInteraction)
+	{
+		Crowd->InteractionEndTime = 0.0f;
+		Crowd->InteractionPartner.Invalidate();
+		if (State->CurrentState == EMassUnitState::Interacting)
 		{
-			BeginInteraction(Entry.Entity, Partner, Group, CurrentTime, RandomStream);
-			return;
+			State->CurrentState = EMassUnitState::Idle;
+			State->StateTime = 0.0f;
 		}
 	}
-	if (UpdateManagedSubgroupUnit(Entry, Group, CurrentTime, LODMultiplier))
+	if (Decision.bClearMovement)
+	{
+		ClearMovement(Entry.Entity, true);
+		Crowd->NextDecisionTime = CurrentTime;
+	}
+
+	switch (Decision.Action)
 	{
+	case ECrowdDecisionAction::Engaged:
+		UpdateEngagedUnit(Entry, Group, CurrentTime, Decision.bForceDecision);
+		return;
+	case ECrowdDecisionAction::Idle:
+		++Crowd->DecisionSequence;
+		Crowd->NextDecisionTime = Decision.IdleUntilTime;
+		return;
+	case ECrowdDecisionAction::Decide:
+		break;
+	default:
 		return;
 	}
 
-	AssignRandomDestination(Entry.Entity, Group, CurrentTime, LODMultiplier, RandomStream);
+	++Crowd->DecisionSequence;
+	if (Decision.Partner.IsValid() && IsInteractionCandidateAvailable(Decision.Partner, CurrentTime))
+	{
+		FRandomStream InteractionStream = Decision.InteractionStream;
+		BeginInteraction(Entry.Entity, Decision.Partner, Group, CurrentTime, InteractionStream);
+		return;
+	}
+	if (Decision.bHasSubgroupDestination
+		&& ApplyManagedSubgroupDestination(Entry, Group, Decision.SubgroupDestination, CurrentTime, Decision.LODMultiplier))
+	{
+		return;
+	}
+	FRandomStream SpeedStream = Decision.WanderStream;
+	AssignRandomDestination(Entry.Entity, Group, Decision.WanderDestination, CurrentTime, Decision.LODMultiplier, SpeedStream);
 }
 
-FVector UMassUnitCrowdSystem::CalculateSeparation(
-	const FSpatialEntry& Entry,
+bool UMassUnitCrowdSystem::WriteSteering(
+	const FCrowdSteeringWrite& Write,
 	const FCrowdGroup& Group,
-	const TArray<FSpatialEntry>& Entries,
-	const TMap<FIntVector, TArray<int32>>& Cells)
+	FMassUnitCrowdFragment& Crowd,
+	float CurrentTime)
+{
+	Crowd.SimulationLOD = Write.SimulationLOD;
+	CopyGroupMovementSettings(Group, Crowd);
+	// An earlier decision in this update may have claimed this unit as its partner.
+	if (!Write.bEngaged && Crowd.InteractionEndTime > CurrentTime)
+	{
+		Crowd.SteeringDirection = FVector::ZeroVector;
+		return false;
+	}
+	if (Write.bZeroSteering)
+	{
+		Crowd.SteeringDirection = FVector::ZeroVector;
+	}
+	if (Write.bRecalculatedSteering)
+	{
+		Crowd.SteeringDirection = Write.SteeringDirection;
+		Crowd.NextSteeringUpdateTime = Write.NextSteeringUpdateTime;
+	}
+	return true;
+}
+
+void UMassUnitCrowdSystem::FlushSteeringWrites()
+{
+	if (EntitySubsystem)
+	{
+		FMassEntityManager& EntityManager = EntitySubsystem->GetMutableEntityManager();
+		for (const FCrowdSteeringWrite& Write : SteeringWrites)
+		{
+			if (Write.bWritten || !IsEntityValid(Write.Entity))
+			{
+				continue;
+			}
+			FMassUnitCrowdFragment* Crowd = EntityManager.GetFragmentDataPtr<FMassUnitCrowdFragment>(Write.Entity.ToMassEntityHandle());
+			const FCrowdGroup* Group = Groups.Find(Write.GroupHandle);
+			if (Crowd && Group && Crowd->bEnabled)
+			{
+				WriteSteering(Write, *Group, *Crowd, UpdateTime);
+			}
+		}
+	}
+	SteeringWrites.Reset();
+	SteeringWriteCursor = 0;
+}
+
+void UMassUnitCrowdSystem::CopyGroupMovementSettings(const FCrowdGroup& Group, FMassUnitCrowdFragment& Crowd)
+{
+	Crowd.bUse3DMovement = Group.Config.MovementMode == EMassUnitCrowdMovementMode::Free3D;
+	Crowd.bConformToNavmeshHeight = Group.bUseNavigation
+		&& !Crowd.bUse3DMovement
+		&& Group.Config.bConformToNavmeshHeight;
+	Crowd.NavigationHeightOffset = Group.Config.NavigationHeightOffset;
+	Crowd.bUseReciprocalAvoidance = !Crowd.bUse3DMovement
+		&& Group.Config.AvoidanceMode == EMassUnitCrowdAvoidanceMode::ORCA;
+	Crowd.AvoidanceAgentRadius = Group.Config.AvoidanceAgentRadius;
+	Crowd.AvoidanceTimeHorizon = Group.Config.AvoidanceTimeHorizon;
+	Crowd.AvoidanceNeighborDistance = Group.Config.AvoidanceNeighborDistance;
+	Crowd.MaxAvoidanceNeighbors = Group.Config.MaxAvoidanceNeighbors;
+	if (!Crowd.bUseReciprocalAvoidance)
+	{
+		Crowd.bHasAvoidanceVelocity = false;
+	}
+}
+
+TConstArrayView<UMassUnitCrowdSystem::FCachedNeighbor> UMassUnitCrowdSystem::ResolveNeighborList(
+	FCrowdUnitDecision& Decision,
+	const FCrowdGroup& Group) const
+{
+	if (Decision.bRebuiltNeighbors)
+	{
+		return Decision.RebuiltNeighbors;
+	}
+
+	const FSpatialEntry& Entry = Decision.Entry;
+	const bool bUse3DMovement = Group.Config.MovementMode == EMassUnitCrowdMovementMode::Free3D;
+	const float Skin = Group.Config.NeighborListSkin;
+	const float Radius = GetNeighborListRadius(Group);
+	if (Skin > 0.0f)
+	{
+		// Verlet reuse: no unit outside the list can have come within the base
+		// radius until this unit plus its fastest group member covered the skin.
+		if (const FNeighborList* List = NeighborLists.Find(Entry.Entity))
+		{
+			const FVector Moved = Entry.Location - List->BuiltLocation;
+			const double Displacement = (bUse3DMovement ? Moved.Size() : Moved.Size2D())
+				+ (Group.NeighborClock - List->BuiltClock);
+			if (List->Revision == Group.NeighborListRevision && List->Radius >= Radius && Displacement <= Skin)
+			{
+				return List->Neighbors;
+			}
+		}
+	}
+
+	Decision.bRebuiltNeighbors = true;
+	const float RadiusSquared = FMath::Square(Radius);
+	SpatialHash.ForEachInRadius(Entry.Location, Radius, bUse3DMovement, [&](int32 EntryIndex, const FSpatialEntry& Candidate)
+	{
+		if (Candidate.Entity == Entry.Entity || Candidate.GroupHandle != Group.Handle)
+		{
+			return;
+		}
+		++Decision.NeighborChecks;
+		const FVector Delta = Candidate.Location - Entry.Location;
+		if ((bUse3DMovement ? Delta.SizeSquared() : Delta.SizeSquared2D()) <= RadiusSquared)
+		{
+			Decision.RebuiltNeighbors.Add({Candidate.Entity, EntryIndex});
+		}
+	});
+	return Decision.RebuiltNeighbors;
+}
+
+const UMassUnitCrowdSystem::FSpatialEntry* UMassUnitCrowdSystem::ResolveNeighbor(const FCachedNeighbor& Neighbor) const
+{
+	if (SpatialHash.IsValidIndex(Neighbor.EntryIndex) && SpatialHash.GetEntry(Neighbor.EntryIndex).Entity == Neighbor.Entity)
+	{
+		return &SpatialHash.GetEntry(Neighbor.EntryIndex);
+	}
+	const int32 EntryIndex = SpatialHash.FindEntryIndex(Neighbor.Entity);
+	return EntryIndex != INDEX_NONE ? &SpatialHash.GetEntry(EntryIndex) : nullptr;
+}
+
+float UMassUnitCrowdSystem::GetNeighborListRadius(const FCrowdGroup& Group)
+{
+	const float InteractionRadius = Group.Config.bEnableInteractions ? Group.Config.InteractionRadius : 0.0f;
+	return FMath::Max(Group.Config.SeparationRadius, InteractionRadius) + Group.Config.NeighborListSkin;
+}
+
+FVector UMassUnitCrowdSystem::CalculateSeparation(FCrowdUnitDecision& Decision, const FCrowdGroup& Group) const
 {
 	if (!Group.Config.bEnableSeparation || Group.Config.SeparationWeight <= 0.0f)
 	{
 		return FVector::ZeroVector;
 	}
+	// Reciprocal avoidance already keeps planar units apart every frame.
+	if (Group.Config.AvoidanceMode == EMassUnitCrowdAvoidanceMode::ORCA
+		&& Group.Config.MovementMode == EMassUnitCrowdMovementMode::Planar2D)
+	{
+		return FVector::ZeroVector;
+	}
 
+	const FSpatialEntry& Entry = Decision.Entry;
 	const float Radius = Group.Config.SeparationRadius;
 	const float RadiusSquared = FMath::Square(Radius);
-	const int32 CellRange = FMath::Max(1, FMath::CeilToInt(Radius / SpatialCellSize));
 	const bool bUse3DMovement = Group.Config.MovementMode == EMassUnitCrowdMovementMode::Free3D;
-	const FIntVector CenterCell = ToSpatialCell(Entry.Location, bUse3DMovement);
-	const int32 MinCellZ = bUse3DMovement ? CenterCell.Z - CellRange : 0;
-	const int32 MaxCellZ = bUse3DMovement ? CenterCell.Z + CellRange : 0;
 	FVector Separation = FVector::ZeroVector;
-	for (int32 CellX = CenterCell.X - CellRange; CellX <= CenterCell.X + CellRange; ++CellX)
+	for (const FCachedNeighbor& CachedNeighbor : ResolveNeighborList(Decision, Group))
 	{
-		for (int32 CellY = CenterCell.Y - CellRange; CellY <= CenterCell.Y + CellRange; ++CellY)
+		const FSpatialEntry* Neighbor = ResolveNeighbor(CachedNeighbor);
+		if (!Neighbor)
 		{
-			for (int32 CellZ = MinCellZ; CellZ <= MaxCellZ; ++CellZ)
-			{
-				const TArray<int32>* CellEntries = Cells.Find(FIntVector(CellX, CellY, CellZ));
-				if (!CellEntries)
-				{
-					continue;
-				}
-				for (const int32 EntryIndex : *CellEntries)
-				{
-					if (!Entries.IsValidIndex(EntryIndex)
-						|| Entries[EntryIndex].Entity == Entry.Entity
-						|| Entries[EntryIndex].GroupHandle != Group.Handle)
-					{
-						continue;
-					}
-					++LastStats.NeighborChecks;
-					const FVector Away = Entry.Location - Entries[EntryIndex].Location;
-					const float DistanceSquared = bUse3DMovement ? Away.SizeSquared() : Away.SizeSquared2D();
-					if (DistanceSquared <= UE_SMALL_NUMBER || DistanceSquared > RadiusSquared)
-					{
-						continue;
-					}
-					const float Distance = FMath::Sqrt(DistanceSquared);
-					const FVector AwayDirection = bUse3DMovement ? Away.GetSafeNormal() : Away.GetSafeNormal2D();
-					Separation += AwayDirection * (1.0f - (Distance / Radius));
-				}
-			}
+			continue;
+		}
+		++Decision.NeighborChecks;
+		const FVector Away = Entry.Location - Neighbor->Location;
+		const float DistanceSquared = bUse3DMovement ? Away.SizeSquared() : Away.SizeSquared2D();
+		if (DistanceSquared <= UE_SMALL_NUMBER || DistanceSquared > RadiusSquared)
+		{
+			continue;
 		}
+		const float Distance = FMath::Sqrt(DistanceSquared);
+		const FVector AwayDirection = bUse3DMovement ? Away.GetSafeNormal() : Away.GetSafeNormal2D();
+		Separation += AwayDirection * (1.0f - (Distance / Radius));
 	}
 	return Separation.GetClampedToMaxSize(1.0f) * Group.Config.SeparationWeight;
 }
 
 FMassUnitEntityHandle UMassUnitCrowdSystem::FindInteractionPartner(
-	const FSpatialEntry& Entry,
+	FCrowdUnitDecision& Decision,
 	const FCrowdGroup& Group,
-	const TArray<FSpatialEntry>& Entries,
-	const TMap<FIntVector, TArray<int32>>& Cells,
-	float CurrentTime)
+	float CurrentTime) const
 {
 	if (!EntitySubsystem)
 	{
 		return {};
 	}
 
-	const float RadiusSquared = FMath::Square(Group.Config.InteractionRadius);
-	const int32 CellRange = FMath::Max(1, FMath::CeilToInt(Group.Config.InteractionRadius / SpatialCellSize));
+	const FSpatialEntry& Entry = Decision.Entry;
 	const bool bUse3DMovement = Group.Config.MovementMode == EMassUnitCrowdMovementMode::Free3D;
-	const FIntVector CenterCell = ToSpatialCell(Entry.Location, bUse3DMovement);
-	const int32 MinCellZ = bUse3DMovement ? CenterCell.Z - CellRange : 0;
-	const int32 MaxCellZ = bUse3DMovement ? CenterCell.Z + CellRange : 0;
-	const FMassEntityManager& EntityManager = EntitySubsystem->GetEntityManager();
 	FMassUnitEntityHandle BestPartner;
-	float BestDistanceSquared = RadiusSquared;
-	for (int32 CellX = CenterCell.X - CellRange; CellX <= CenterCell.X + CellRange; ++CellX)
+	float BestDistanceSquared = FMath::Square(Group.Config.InteractionRadius);
+	for (const FCachedNeighbor& CachedNeighbor : ResolveNeighborList(Decision, Group))
 	{
-		for (int32 CellY = CenterCell.Y - CellRange; CellY <= CenterCell.Y + CellRange; ++CellY)
+		const FSpatialEntry* Candidate = ResolveNeighbor(CachedNeighbor);
+		if (!Candidate)
 		{
-			for (int32 CellZ = MinCellZ; CellZ <= MaxCellZ; ++CellZ)
-			{
-				const TArray<int32>* CellEntries = Cells.Find(FIntVector(CellX, CellY, CellZ));
-				if (!CellEntries)
-				{
-					continue;
-				}
-				for (const int32 EntryIndex : *CellEntries)
-				{
-					if (!Entries.IsValidIndex(EntryIndex))
-					{
-						continue;
-					}
-					const FSpatialEntry& Candidate = Entries[EntryIndex];
-					if (Candidate.Entity == Entry.Entity || Candidate.GroupHandle != Group.Handle)
-					{
-						continue;
-					}
-					++LastStats.NeighborChecks;
-					const FVector Delta = Entry.Location - Candidate.Location;
-					const float DistanceSquared = bUse3DMovement ? Delta.SizeSquared() : Delta.SizeSquared2D();
-					if (DistanceSquared > BestDistanceSquared)
-					{
-						continue;
-					}
-					const FMassUnitCrowdFragment* CandidateCrowd = EntityManager.GetFragmentDataPtr<FMassUnitCrowdFragment>(Candidate.Entity.ToMassEntityHandle());
-					const FMassUnitStateFragment* CandidateState = EntityManager.GetFragmentDataPtr<FMassUnitStateFragment>(Candidate.Entity.ToMassEntityHandle());
-					if (!CandidateCrowd || !CandidateState || !CandidateCrowd->bEnabled || CandidateCrowd->bSleeping
-						|| CandidateCrowd->InteractionEndTime > CurrentTime
-						|| CandidateState->CurrentState == EMassUnitState::Dead
-						|| CandidateState->CurrentState == EMassUnitState::Stunned)
-					{
-						continue;
-					}
-					BestPartner = Candidate.Entity;
-					BestDistanceSquared = DistanceSquared;
-				}
-			}
+			continue;
+		}
+		++Decision.NeighborChecks;
+		const FVector Delta = Entry.Location - Candidate->Location;
+		const float DistanceSquared = bUse3DMovement ? Delta.SizeSquared() : Delta.SizeSquared2D();
+		if (DistanceSquared > BestDistanceSquared)
+		{
+			continue;
+		}
+		if (!IsInteractionCandidateAvailable(Candidate->Entity, CurrentTime))
+		{
+			continue;
 		}
+		BestPartner = Candidate->Entity;
+		BestDistanceSquared = DistanceSquared;
 	}
 	return BestPartner;
 }
 
+bool UMassUnitCrowdSystem::IsInteractionCandidateAvailable(FMassUnitEntityHandle Candidate, float CurrentTime) const
+{
+	if (!EntitySubsystem || !IsEntityValid(Candidate))
+	{
+		return false;
+	}
+	const FMassEntityManager& EntityManager = EntitySubsystem->GetEntityManager();
+	const FMassUnitCrowdFragment* CandidateCrowd = EntityManager.GetFragmentDataPtr<FMassUnitCrowdFragment>(Candidate.ToMassEntityHandle());
+	const FMassUnitStateFragment* CandidateState = EntityManager.GetFragmentDataPtr<FMassUnitStateFragment>(Candidate.ToMassEntityHandle());
+	return CandidateCrowd && CandidateState && CandidateCrowd->bEnabled && !CandidateCrowd->bSleeping
+		&& CandidateCrowd->InteractionEndTime <= CurrentTime
+		&& CandidateState->CurrentState != EMassUnitState::Dead
+		&& CandidateState->CurrentState != EMassUnitState::Stunned;
+}
+
 void UMassUnitCrowdSystem::BeginInteraction(
 	FMassUnitEntityHandle UnitA,
 	FMassUnitEntityHandle UnitB,
@@ -1291,26 +2184,342 @@ void UMassUnitCrowdSystem::BeginInteraction(
 			(TransformA->GetTransform().GetLocation() + TransformB->GetTransform().GetLocation()) * 0.5f,
 			Crowd->SubgroupIndex);
 	}
-	OnCrowdInteractionStarted.Broadcast(FMassUnitHandle(UnitA), FMassUnitHandle(UnitB));
-#if ENABLE_DRAW_DEBUG
-	if (Group.Config.bEnableVisualDebug && World)
+	FDeferredEvent& Event = DeferredEvents.AddDefaulted_GetRef();
+	Event.Type = EDeferredEventType::Interaction;
+	Event.UnitA = UnitA;
+	Event.UnitB = UnitB;
+#if ENABLE_DRAW_DEBUG
+	if (Group.Config.bEnableVisualDebug && World)
+	{
+		DrawDebugLine(
+			World,
+			TransformA->GetTransform().GetLocation(),
+			TransformB->GetTransform().GetLocation(),
+			FColor::Orange,
+			false,
+			FMath::Max(0.1f, Duration),
+			0,
+			2.0f);
+	}
+#endif
+}
+
+FVector UMassUnitCrowdSystem::ChooseWanderDestination(
+	const FVector& CurrentLocation,
+	int32 SubgroupIndex,
+	const FCrowdGroup& Group,
+	FRandomStream& RandomStream) const
+{
+	FVector PooledDestination;
+	if (Group.Subgroups.IsValidIndex(SubgroupIndex)
+		&& PickWanderPoint(
+			Group.Subgroups[SubgroupIndex].WanderPoints,
+			CurrentLocation,
+			Group.Config.MinWanderDistance,
+			RandomStream,
+			PooledDestination))
+	{
+		return PooledDestination;
+	}
+
+	const FVector WanderCenter = CalculateSubgroupWanderCenter(SubgroupIndex, Group);
+	const float WanderRadius = Group.Config.bEnableManagedSubgroups && Group.SubgroupCount > 1
+		? Group.Config.WanderRadius * Group.Config.SubgroupWanderRadiusScale
+		: Group.Config.WanderRadius;
+	FVector Destination = CurrentLocation;
+	for (int32 Attempt = 0; Attempt < 4; ++Attempt)
+	{
+		if (Group.Config.MovementMode == EMassUnitCrowdMovementMode::Free3D)
+		{
+			const float Radius = FMath::Pow(RandomStream.FRand(), 1.0f / 3.0f) * WanderRadius;
+			Destination = WanderCenter + RandomStream.VRand() * Radius;
+		}
+		else
+		{
+			const float Angle = RandomStream.FRandRange(0.0f, 2.0f * UE_PI);
+			const float Radius = FMath::Sqrt(RandomStream.FRand()) * WanderRadius;
+			Destination = WanderCenter + FVector(FMath::Cos(Angle) * Radius, FMath::Sin(Angle) * Radius, 0.0f);
+			Destination.Z = CurrentLocation.Z;
+		}
+		const FVector ToDestination = Destination - CurrentLocation;
+		const float DistanceSquared = Group.Config.MovementMode == EMassUnitCrowdMovementMode::Free3D
+			? ToDestination.SizeSquared()
+			: ToDestination.SizeSquared2D();
+		if (DistanceSquared >= FMath::Square(Group.Config.MinWanderDistance))
+		{
+			break;
+		}
+	}
+	return Destination;
+}
+
+bool UMassUnitCrowdSystem::UsesWanderPools(const FCrowdGroup& Group) const
+{
+	return NavigationSystem
+		&& Group.bUseNavigation
+		&& Group.Config.MovementMode == EMassUnitCrowdMovementMode::Planar2D
+		&& Group.Config.WanderPointPoolSize > 0;
+}
+
+float UMassUnitCrowdSystem::GetWanderPoolRadius(const FCrowdGroup& Group)
+{
+	return Group.Config.bEnableManagedSubgroups && Group.SubgroupCount > 1
+		? Group.Config.WanderRadius * Group.Config.SubgroupWanderRadiusScale
+		: Group.Config.WanderRadius;
+}
+
+void UMassUnitCrowdSystem::BuildWanderPools(FCrowdGroup& Group)
+{
+	for (FCrowdSubgroupState& Subgroup : Group.Subgroups)
+	{
+		Subgroup.WanderPoints.Reset();
+	}
+	PendingWanderPools.RemoveAll([&Group](const FWanderPoolBuild& Build)
+	{
+		return Build.GroupHandle == Group.Handle;
+	});
+	if (!UsesWanderPools(Group))
+	{
+		return;
+	}
+	if (!NavigationSystem->GetNavigationData())
+	{
+		NavigationSystem->UpdateNavigationData(World);
+	}
+	if (!NavigationSystem->GetNavigationData())
+	{
+		// Decisions sample the wander disk freely until navigation data is
+		// generated; HandleNavigationAreasRebuilt queues the pools then.
+		return;
+	}
+	for (int32 SubgroupIndex = 0; SubgroupIndex < Group.Subgroups.Num(); ++SubgroupIndex)
+	{
+		QueueWanderPoolBuild(Group.Handle, SubgroupIndex);
+	}
+}
+
+void UMassUnitCrowdSystem::QueueWanderPoolBuild(int32 GroupHandle, int32 SubgroupIndex)
+{
+	FWanderPoolBuild* Build = PendingWanderPools.FindByPredicate([GroupHandle, SubgroupIndex](const FWanderPoolBuild& Pending)
+	{
+		return Pending.GroupHandle == GroupHandle && Pending.SubgroupIndex == SubgroupIndex;
+	});
+	if (!Build)
+	{
+		Build = &PendingWanderPools.AddDefaulted_GetRef();
+		Build->GroupHandle = GroupHandle;
+		Build->SubgroupIndex = SubgroupIndex;
+	}
+	// A build that was partway through restarts against the new navmesh or center.
+	Build->Samples.Reset();
+	Build->WanderPoints.Reset();
+	Build->NextSample = 0;
+	Build->bSampled = false;
+}
+
+void UMassUnitCrowdSystem::ProcessWanderPoolBuilds()
+{
+	int32 ProjectionBudget = WanderPointProjectionsPerUpdate;
+	while (!PendingWanderPools.IsEmpty()
+		&& ProjectionBudget > 0
+		&& (ProjectionBudget == WanderPointProjectionsPerUpdate || HasUpdateBudget())
+		&& NavigationSystem
+		&& NavigationSystem->GetNavigationData())
+	{
+		FWanderPoolBuild& Build = PendingWanderPools[0];
+		FCrowdGroup* Group = Groups.Find(Build.GroupHandle);
+		if (!Group || !Group->Subgroups.IsValidIndex(Build.SubgroupIndex) || !UsesWanderPools(*Group))
+		{
+			PendingWanderPools.RemoveAt(0);
+			continue;
+		}
+		if (!Build.bSampled)
+		{
+			SampleWanderPool(*Group, Build);
+		}
+		for (; Build.NextSample < Build.Samples.Num() && ProjectionBudget > 0; ++Build.NextSample, --ProjectionBudget)
+		{
+			FVector Projected;
+			if (NavigationSystem->ProjectPointToNavigation(Build.WanderCenter + FVector(Build.Samples[Build.NextSample], 0.0f), Projected))
+			{
+				Build.WanderPoints.Add(Projected);
+			}
+		}
+		if (Build.NextSample < Build.Samples.Num())
+		{
+			break;
+		}
+		Group->Subgroups[Build.SubgroupIndex].WanderPoints = MoveTemp(Build.WanderPoints);
+		PendingWanderPools.RemoveAt(0);
+	}
+	LastStats.WanderPoolsPending = PendingWanderPools.Num();
+}
+
+void UMassUnitCrowdSystem::SampleWanderPool(const FCrowdGroup& Group, FWanderPoolBuild& Build) const
+{
+	const int32 PoolSize = Group.Config.WanderPointPoolSize;
+	const float WanderRadius = FMath::Max(1.0f, GetWanderPoolRadius(Group));
+	// A maximal Poisson-disk set with spacing d fills a disk of radius R with
+	// about 2 R^2 / d^2 points.
+	const float Spacing = WanderRadius * FMath::Sqrt(2.0f / static_cast<float>(PoolSize));
+	const float SpacingSquared = FMath::Square(Spacing);
+	constexpr int32 CandidatesPerSample = 30;
+
+	// Background grid of cells with diagonal Spacing, so each cell holds at most
+	// one sample and the distance test only visits the 5x5 cells around a candidate.
+	const float CellSize = Spacing * UE_INV_SQRT_2;
+	const int32 GridSize = FMath::CeilToInt(2.0f * WanderRadius / CellSize) + 1;
+	TArray<int32> Grid;
+	Grid.Init(INDEX_NONE, GridSize * GridSize);
+	const auto ToGridCell = [WanderRadius, CellSize, GridSize](const FVector2D& Sample)
+	{
+		return FIntPoint(
+			FMath::Clamp(FMath::FloorToInt((Sample.X + WanderRadius) / CellSize), 0, GridSize - 1),
+			FMath::Clamp(FMath::FloorToInt((Sample.Y + WanderRadius) / CellSize), 0, GridSize - 1));
+	};
+
+	Build.WanderCenter = CalculateSubgroupWanderCenter(Build.SubgroupIndex, Group);
+	FRandomStream PoolStream(static_cast<int32>(HashCombine(
+		HashCombine(::GetTypeHash(Group.Config.RandomSeed), ::GetTypeHash(Build.SubgroupIndex)),
+		GetTypeHash(Build.WanderCenter))));
+
+	// Bridson's dart throwing around the accepted samples, bounded by the wander disk.
+	TArray<FVector2D>& Samples = Build.Samples;
+	TArray<int32> ActiveSamples;
+	Samples.Reset(PoolSize);
+	ActiveSamples.Reserve(PoolSize);
+	const FIntPoint OriginCell = ToGridCell(FVector2D::ZeroVector);
+	Grid[OriginCell.Y * GridSize + OriginCell.X] = Samples.Add(FVector2D::ZeroVector);
+	ActiveSamples.Add(0);
+	while (!ActiveSamples.IsEmpty() && Samples.Num() < PoolSize)
+	{
+		const int32 ActiveSlot = PoolStream.RandHelper(ActiveSamples.Num());
+		const FVector2D Origin = Samples[ActiveSamples[ActiveSlot]];
+		bool bAccepted = false;
+		for (int32 Attempt = 0; Attempt < CandidatesPerSample && !bAccepted; ++Attempt)
+		{
+			const float Angle = PoolStream.FRandRange(0.0f, 2.0f * UE_PI);
+			const float Distance = PoolStream.FRandRange(Spacing, 2.0f * Spacing);
+			const FVector2D Candidate = Origin + FVector2D(FMath::Cos(Angle), FMath::Sin(Angle)) * Distance;
+			if (Candidate.SizeSquared() > FMath::Square(WanderRadius))
+			{
+				continue;
+			}
+			const FIntPoint Cell = ToGridCell(Candidate);
+			bool bTooClose = false;
+			for (int32 Y = FMath::Max(0, Cell.Y - 2); Y <= FMath::Min(GridSize - 1, Cell.Y + 2) && !bTooClose; ++Y)
+			{
+				for (int32 X = FMath::Max(0, Cell.X - 2); X <= FMath::Min(GridSize - 1, Cell.X + 2) && !bTooClose; ++X)
+				{
+					const int32 Neighbor = Grid[Y * GridSize + X];
+					bTooClose = Neighbor != INDEX_NONE && FVector2D::DistSquared(Samples[Neighbor], Candidate) < SpacingSquared;
+				}
+			}
+			if (bTooClose)
+			{
+				continue;
+			}
+			const int32 SampleIndex = Samples.Add(Candidate);
+			Grid[Cell.Y * GridSize + Cell.X] = SampleIndex;
+			ActiveSamples.Add(SampleIndex);
+			bAccepted = true;
+		}
+		if (!bAccepted)
+		{
+			ActiveSamples.RemoveAtSwap(ActiveSlot);
+		}
+	}
+	Build.WanderPoints.Reset(Samples.Num());
+	Build.NextSample = 0;
+	Build.bSampled = true;
+}
+
+bool UMassUnitCrowdSystem::PickWanderPoint(
+	TConstArrayView<FVector> WanderPoints,
+	const FVector& CurrentLocation,
+	float MinDistance,
+	FRandomStream& RandomStream,
+	FVector& OutPoint)
+{
+	if (WanderPoints.IsEmpty())
+	{
+		return false;
+	}
+	for (int32 Attempt = 0; Attempt < 4; ++Attempt)
+	{
+		OutPoint = WanderPoints[RandomStream.RandHelper(WanderPoints.Num())];
+		if (FVector::DistSquared2D(OutPoint, CurrentLocation) >= FMath::Square(MinDistance))
+		{
+			break;
+		}
+	}
+	return true;
+}
+
+void UMassUnitCrowdSystem::HandleNavigationAreasRebuilt(TConstArrayView<FBox> RebuiltAreas)
+{
+	// Stale corridors and wander pools are only marked here; the budgeted
+	// refresh passes rebuild them. No areas means the whole navmesh changed.
+	for (TPair<int32, FCrowdGroup>& Pair : Groups)
+	{
+		FCrowdGroup& Group = Pair.Value;
+		if (UsesWanderPools(Group))
+		{
+			const float PoolRadiusSquared = FMath::Square(GetWanderPoolRadius(Group));
+			for (int32 SubgroupIndex = 0; SubgroupIndex < Group.Subgroups.Num(); ++SubgroupIndex)
+			{
+				const FVector WanderCenter = CalculateSubgroupWanderCenter(SubgroupIndex, Group);
+				const bool bPoolDirty = RebuiltAreas.IsEmpty() || Algo::AnyOf(RebuiltAreas, [&WanderCenter, PoolRadiusSquared](const FBox& Area)
+				{
+					const FVector2D Closest(
+						FMath::Clamp(WanderCenter.X, Area.Min.X, Area.Max.X),
+						FMath::Clamp(WanderCenter.Y, Area.Min.Y, Area.Max.Y));
+					return FVector2D::DistSquared(Closest, FVector2D(WanderCenter)) <= PoolRadiusSquared;
+				});
+				if (bPoolDirty)
+				{
+					QueueWanderPoolBuild(Group.Handle, SubgroupIndex);
+				}
+			}
+		}
+		for (FCrowdSubgroupState& Subgroup : Group.Subgroups)
+		{
+			if (Subgroup.bUsesNavmesh && PathCrossesAreas(Subgroup.SharedPathPoints, RebuiltAreas))
+			{
+				Subgroup.NextPathRefreshTime = 0.0f;
+			}
+		}
+		if (Group.bSharedPathUsesNavmesh && PathCrossesAreas(Group.SharedPathPoints, RebuiltAreas))
+		{
+			Group.bSharedPathStale = true;
+		}
+	}
+}
+
+bool UMassUnitCrowdSystem::PathCrossesAreas(TConstArrayView<FVector> PathPoints, TConstArrayView<FBox> Areas)
+{
+	for (int32 PointIndex = 0; PointIndex < PathPoints.Num(); ++PointIndex)
 	{
-		DrawDebugLine(
-			World,
-			TransformA->GetTransform().GetLocation(),
-			TransformB->GetTransform().GetLocation(),
-			FColor::Orange,
-			false,
-			FMath::Max(0.1f, Duration),
-			0,
-			2.0f);
+		const FVector& SegmentStart = PathPoints[PointIndex];
+		const FVector& SegmentEnd = PathPoints[FMath::Min(PointIndex + 1, PathPoints.Num() - 1)];
+		for (const FBox& Area : Areas)
+		{
+			// Corridor points may sit above the navmesh by the height offset; pad the area vertically.
+			const FBox Column = Area.ExpandBy(FVector(0.0f, 0.0f, 500.0f));
+			if (Column.IsInside(SegmentStart)
+				|| FMath::LineBoxIntersection(Column, SegmentStart, SegmentEnd, SegmentEnd - SegmentStart))
+			{
+				return true;
+			}
+		}
 	}
-#endif
+	return false;
 }
 
 bool UMassUnitCrowdSystem::AssignRandomDestination(
 	FMassUnitEntityHandle Entity,
 	FCrowdGroup& Group,
+	const FVector& Destination,
 	float CurrentTime,
 	float LODIntervalMultiplier,
 	FRandomStream& RandomStream)
@@ -1330,39 +2539,14 @@ bool UMassUnitCrowdSystem::AssignRandomDestination(
 	}
 
 	const FVector CurrentLocation = Transform->GetTransform().GetLocation();
-	const FVector WanderCenter = CalculateSubgroupWanderCenter(Entity, Group);
-	const float WanderRadius = Group.Config.bEnableManagedSubgroups && Group.SubgroupCount > 1
-		? Group.Config.WanderRadius * Group.Config.SubgroupWanderRadiusScale
-		: Group.Config.WanderRadius;
-	FVector Destination = CurrentLocation;
-	for (int32 Attempt = 0; Attempt < 4; ++Attempt)
-	{
-		if (Group.Config.MovementMode == EMassUnitCrowdMovementMode::Free3D)
-		{
-			const float Radius = FMath::Pow(RandomStream.FRand(), 1.0f / 3.0f) * WanderRadius;
-			Destination = WanderCenter + RandomStream.VRand() * Radius;
-		}
-		else
-		{
-			const float Angle = RandomStream.FRandRange(0.0f, 2.0f * UE_PI);
-			const float Radius = FMath::Sqrt(RandomStream.FRand()) * WanderRadius;
-			Destination = WanderCenter + FVector(FMath::Cos(Angle) * Radius, FMath::Sin(Angle) * Radius, 0.0f);
-			Destination.Z = CurrentLocation.Z;
-		}
-		const FVector ToDestination = Destination - CurrentLocation;
-		const float DistanceSquared = Group.Config.MovementMode == EMassUnitCrowdMovementMode::Free3D
-			? ToDestination.SizeSquared()
-			: ToDestination.SizeSquared2D();
-		if (DistanceSquared >= FMath::Square(Group.Config.MinWanderDistance))
-		{
-			break;
-		}
-	}
-
 	const bool bCanUsePlanarNavigation = Group.bUseNavigation
 		&& Group.Config.MovementMode == EMassUnitCrowdMovementMode::Planar2D;
 	const bool bAssigned = bCanUsePlanarNavigation && NavigationSystem
-		? NavigationSystem->RequestPathInternal(Entity, Destination, Group.AcceptanceRadius)
+		? NavigationSystem->RequestPathInternal(
+			Entity,
+			Destination,
+			Group.AcceptanceRadius,
+			LODIntervalMultiplier > 1.0f ? EMassUnitPathPriority::Low : EMassUnitPathPriority::Normal)
 		: UnitManager->SetUnitDestination(FMassUnitHandle(Entity), Destination, Group.AcceptanceRadius);
 	if (!bAssigned)
 	{
@@ -1431,24 +2615,209 @@ void UMassUnitCrowdSystem::ClearMovement(FMassUnitEntityHandle Entity, bool bSet
 	}
 }
 
-void UMassUnitCrowdSystem::SetUnitSleeping(FMassUnitEntityHandle Entity, bool bSleeping, float CurrentTime) const
+void UMassUnitCrowdSystem::SetUnitSleeping(FMassUnitEntityHandle Entity, bool bSleeping, float CurrentTime)
 {
 	if (!EntitySubsystem || !IsEntityValid(Entity))
 	{
 		return;
 	}
-	FMassUnitCrowdFragment* Crowd = EntitySubsystem->GetMutableEntityManager().GetFragmentDataPtr<FMassUnitCrowdFragment>(Entity.ToMassEntityHandle());
-	if (!Crowd || Crowd->bSleeping == bSleeping)
+	FMassEntityManager& EntityManager = EntitySubsystem->GetMutableEntityManager();
+	FMassUnitCrowdFragment* Crowd = EntityManager.GetFragmentDataPtr<FMassUnitCrowdFragment>(Entity.ToMassEntityHandle());
+	const FMassUnitTransformFragment* Transform = EntityManager.GetFragmentDataPtr<FMassUnitTransformFragment>(Entity.ToMassEntityHandle());
+	if (!Crowd || !Transform || Crowd->bSleeping == bSleeping)
 	{
 		return;
 	}
 	Crowd->bSleeping = bSleeping;
 	Crowd->SteeringDirection = FVector::ZeroVector;
 	Crowd->NextDecisionTime = CurrentTime;
+	Crowd->NextSteeringUpdateTime = CurrentTime;
+
+	// Sleeping units leave the spatial hash for the dormant grid, so the
+	// scheduler, separation, and partner searches never visit them.
+	const FVector Location = Transform->GetTransform().GetLocation();
+	const int32* FoundGroupHandle = UnitToGroup.Find(Entity);
+	const int32 GroupHandle = FoundGroupHandle ? *FoundGroupHandle : INDEX_NONE;
+	FCrowdGroup* Group = Groups.Find(GroupHandle);
 	if (bSleeping)
 	{
 		ClearMovement(Entity, true);
+		const int32 EntryIndex = SpatialHash.FindEntryIndex(Entity);
+		const bool bLiving = EntryIndex == INDEX_NONE || SpatialHash.GetEntry(EntryIndex).bLiving;
+		SpatialHash.Remove(Entity);
+		NeighborLists.Remove(Entity);
+		const FIntPoint Cell = ToDormantCell(Location);
+		DormantCells.FindOrAdd(Cell).Add({Entity, Location, GroupHandle, bLiving});
+		DormantCellByUnit.Add(Entity, Cell);
+		if (Group)
+		{
+			++Group->DormantUnits;
+		}
+		return;
+	}
+
+	bool bLiving = true;
+	RemoveDormantUnit(Entity, &bLiving);
+	if (Group)
+	{
+		SpatialHash.SetLiving(SpatialHash.Add(Entity, GroupHandle, Location, Crowd->bUse3DMovement), bLiving);
+		++Group->NeighborListRevision;
+		++LastStats.UnitsWoken;
+	}
+}
+
+void UMassUnitCrowdSystem::WakeDormantUnits(
+	const TArray<FVector>& ObserverLocations,
+	float CurrentTime,
+	int32 OnlyGroupHandle)
+{
+	if (DormantCellByUnit.IsEmpty())
+	{
+		return;
+	}
+
+	// Groups that can no longer sleep wake every dormant member directly;
+	// the rest share one observer test against each occupied coarse cell.
+	TArray<FMassUnitEntityHandle> UnitsToWake;
+	float MaxWakeDistance = 0.0f;
+	auto WakesWholeGroup = [&ObserverLocations](const FCrowdGroup& Group)
+	{
+		return ObserverLocations.IsEmpty()
+			|| Group.Config.MaxSimulationDistance <= 0.0f
+			|| (Group.bEngaged && Group.TargetActor.IsValid());
+	};
+	for (const TPair<int32, FCrowdGroup>& Pair : Groups)
+	{
+		const FCrowdGroup& Group = Pair.Value;
+		if (Group.DormantUnits == 0 || Group.bPaused || (OnlyGroupHandle != INDEX_NONE && Pair.Key != OnlyGroupHandle))
+		{
+			continue;
+		}
+		if (!WakesWholeGroup(Group))
+		{
+			MaxWakeDistance = FMath::Max(MaxWakeDistance, Group.Config.MaxSimulationDistance);
+			continue;
+		}
+		for (const FMassUnitEntityHandle Entity : Group.Units)
+		{
+			if (DormantCellByUnit.Contains(Entity))
+			{
+				UnitsToWake.Add(Entity);
+			}
+		}
+	}
+
+	TArray<FMassUnitEntityHandle> UnitsToPrune;
+	const float MaxWakeDistanceSquared = FMath::Square(MaxWakeDistance);
+	const int32 PrunePhase = DormantPrunePhase++ % DormantPruneStride;
+	int32 CellOrdinal = 0;
+	for (const TPair<FIntPoint, TArray<FDormantUnit>>& Cell : DormantCells)
+	{
+		const bool bPruneCell = OnlyGroupHandle == INDEX_NONE && CellOrdinal++ % DormantPruneStride == PrunePhase;
+		if (bPruneCell)
+		{
+			for (const FDormantUnit& Unit : Cell.Value)
+			{
+				if (!IsEntityValid(Unit.Entity))
+				{
+					UnitsToPrune.Add(Unit.Entity);
+				}
+			}
+		}
+		if (MaxWakeDistance <= 0.0f)
+		{
+			continue;
+		}
+
+		// Planar distance to the cell rectangle is a lower bound for every
+		// unit inside it, whether the group moves in 2D or 3D.
+		const FVector2D CellMin(Cell.Key.X * DormantCellSize, Cell.Key.Y * DormantCellSize);
+		const FVector2D CellMax = CellMin + FVector2D(DormantCellSize);
+		bool bObserverInRange = false;
+		for (const FVector& Observer : ObserverLocations)
+		{
+			const double DeltaX = FMath::Max3(CellMin.X - Observer.X, 0.0, Observer.X - CellMax.X);
+			const double DeltaY = FMath::Max3(CellMin.Y - Observer.Y, 0.0, Observer.Y - CellMax.Y);
+			if (DeltaX * DeltaX + DeltaY * DeltaY <= MaxWakeDistanceSquared)
+			{
+				bObserverInRange = true;
+				break;
+			}
+		}
+		if (!bObserverInRange)
+		{
+			continue;
+		}
+		for (const FDormantUnit& Unit : Cell.Value)
+		{
+			const FCrowdGroup* Group = Groups.Find(Unit.GroupHandle);
+			if (!Group
+				|| Group->bPaused
+				|| (OnlyGroupHandle != INDEX_NONE && Unit.GroupHandle != OnlyGroupHandle)
+				|| WakesWholeGroup(*Group))
+			{
+				continue;
+			}
+			const float WakeDistanceSquared = FMath::Square(Group->Config.MaxSimulationDistance);
+			for (const FVector& Observer : ObserverLocations)
+			{
+				if (FVector::DistSquared(Unit.Location, Observer) <= WakeDistanceSquared)
+				{
+					UnitsToWake.Add(Unit.Entity);
+					break;
+				}
+			}
+		}
+	}
+
+	for (const FMassUnitEntityHandle Entity : UnitsToPrune)
+	{
+		RemoveUnitFromPreviousGroup(Entity);
+	}
+	for (const FMassUnitEntityHandle Entity : UnitsToWake)
+	{
+		SetUnitSleeping(Entity, false, CurrentTime);
+	}
+}
+
+bool UMassUnitCrowdSystem::RemoveDormantUnit(FMassUnitEntityHandle Entity, bool* bOutLiving)
+{
+	FIntPoint Cell;
+	if (!DormantCellByUnit.RemoveAndCopyValue(Entity, Cell))
+	{
+		return false;
+	}
+	if (TArray<FDormantUnit>* Units = DormantCells.Find(Cell))
+	{
+		const int32 UnitIndex = Units->IndexOfByPredicate([Entity](const FDormantUnit& Unit)
+		{
+			return Unit.Entity == Entity;
+		});
+		if (UnitIndex != INDEX_NONE)
+		{
+			if (FCrowdGroup* Group = Groups.Find((*Units)[UnitIndex].GroupHandle))
+			{
+				--Group->DormantUnits;
+			}
+			if (bOutLiving)
+			{
+				*bOutLiving = (*Units)[UnitIndex].bLiving;
+			}
+			Units->RemoveAtSwap(UnitIndex, 1, EAllowShrinking::No);
+		}
+		if (Units->IsEmpty())
+		{
+			DormantCells.Remove(Cell);
+		}
 	}
+	return true;
+}
+
+FIntPoint UMassUnitCrowdSystem::ToDormantCell(const FVector& Location) const
+{
+	return FIntPoint(
+		FMath::FloorToInt(Location.X / DormantCellSize),
+		FMath::FloorToInt(Location.Y / DormantCellSize));
 }
 
 void UMassUnitCrowdSystem::ResetCrowdFragment(FMassUnitEntityHandle Entity, bool bStopUnit) const
@@ -1478,6 +2847,11 @@ void UMassUnitCrowdSystem::ResetCrowdFragment(FMassUnitEntityHandle Entity, bool
 void UMassUnitCrowdSystem::RemoveUnitFromPreviousGroup(FMassUnitEntityHandle Entity)
 {
 	int32 PreviousGroupHandle = INDEX_NONE;
+	const int32 EntryIndex = SpatialHash.FindEntryIndex(Entity);
+	bool bWasLiving = EntryIndex != INDEX_NONE && SpatialHash.GetEntry(EntryIndex).bLiving;
+	SpatialHash.Remove(Entity);
+	RemoveDormantUnit(Entity, &bWasLiving);
+	NeighborLists.Remove(Entity);
 	if (!UnitToGroup.RemoveAndCopyValue(Entity, PreviousGroupHandle))
 	{
 		return;
@@ -1485,6 +2859,10 @@ void UMassUnitCrowdSystem::RemoveUnitFromPreviousGroup(FMassUnitEntityHandle Ent
 	if (FCrowdGroup* PreviousGroup = Groups.Find(PreviousGroupHandle))
 	{
 		PreviousGroup->Units.Remove(Entity);
+		if (bWasLiving)
+		{
+			AdjustLivingMembers(*PreviousGroup, -1);
+		}
 		if (PreviousGroup->Units.IsEmpty())
 		{
 			Groups.Remove(PreviousGroupHandle);
@@ -1492,6 +2870,15 @@ void UMassUnitCrowdSystem::RemoveUnitFromPreviousGroup(FMassUnitEntityHandle Ent
 	}
 }
 
+void UMassUnitCrowdSystem::AdjustLivingMembers(FCrowdGroup& Group, int32 Delta)
+{
+	Group.LivingMembers += Delta;
+	if (Group.bEngaged)
+	{
+		EngagedUnitCount += Delta;
+	}
+}
+
 void UMassUnitCrowdSystem::UpdateGroupEngagements(float CurrentTime)
 {
 	TArray<int32> GroupHandles;
@@ -1516,8 +2903,7 @@ void UMassUnitCrowdSystem::UpdateGroupEngagements(float CurrentTime)
 
 			if (Group->EngagementConfig.bAutoDeactivate
 				&& Group->EngagementConfig.ActivationMode != EMassUnitCrowdActivationMode::Always
-				&& CalculateClosestLivingUnitDistanceSquared(*Group, TargetActor->GetActorLocation())
-					> FMath::Square(Group->EngagementConfig.DeactivationDistance))
+				&& !HasLivingUnitWithin(*Group, TargetActor->GetActorLocation(), Group->EngagementConfig.DeactivationDistance))
 			{
 				const bool bReturnToWander = Group->EngagementConfig.bReturnToWanderOnDeactivate;
 				DeactivateCrowdGroupEngagement(GroupHandle, bReturnToWander);
@@ -1698,7 +3084,11 @@ bool UMassUnitCrowdSystem::UpdateEngagedUnit(
 	bool bAssigned = false;
 	if (bCanUsePlanarNavigation && !Group.EngagementConfig.bUseSharedNavigationPath)
 	{
-		bAssigned = NavigationSystem->RequestPathInternal(Entry.Entity, Destination, Group.AcceptanceRadius);
+		bAssigned = NavigationSystem->RequestPathInternal(
+			Entry.Entity,
+			Destination,
+			Group.AcceptanceRadius,
+			EMassUnitPathPriority::High);
 		if (bAssigned)
 		{
 			++LastStats.PerUnitPathsRequested;
@@ -1764,36 +3154,67 @@ bool UMassUnitCrowdSystem::RefreshSharedNavigationPath(
 	const bool bTargetMovedEnough = TargetMovement.SizeSquared2D()
 		>= FMath::Square(Group.EngagementConfig.SharedPathRepathDistance);
 	if (!bForceRefresh
+		&& !Group.bSharedPathStale
 		&& ((!Group.SharedPathPoints.IsEmpty() && !bTargetMovedEnough)
 			|| CurrentTime < Group.NextSharedPathUpdateTime))
 	{
 		return false;
 	}
 
+	Group.bSharedPathStale = false;
 	Group.NextSharedPathUpdateTime = CurrentTime + Group.EngagementConfig.SharedPathRepathInterval;
 	const FVector GroupAnchor = CalculateGroupAnchor(Group);
-	TArray<FVector> NewPathPoints;
-	bool bUsesNavmesh = false;
-	if (!NavigationSystem->FindSharedPath(
+	CancelSharedPathQuery(Group.PendingSharedPathQuery, Group.SharedPathRequestSerial);
+	const int32 Serial = ++Group.SharedPathRequestSerial;
+	++LastStats.SharedPathsBuilt;
+	const uint32 QueryId = NavigationSystem->FindSharedPathAsync(
 		GroupAnchor,
 		Group.LastTargetLocation,
-		NewPathPoints,
-		&bUsesNavmesh)
-		|| NewPathPoints.IsEmpty())
+		[WeakThis = TWeakObjectPtr<UMassUnitCrowdSystem>(this), GroupHandle = Group.Handle, Serial, GroupAnchor, TargetLocation = Group.LastTargetLocation](
+			TArray<FVector>&& PathPoints,
+			bool bUsesNavmesh)
+		{
+			if (UMassUnitCrowdSystem* CrowdSystem = WeakThis.Get())
+			{
+				CrowdSystem->HandleSharedPathBuilt(GroupHandle, Serial, GroupAnchor, TargetLocation, MoveTemp(PathPoints), bUsesNavmesh);
+			}
+		});
+	if (Group.SharedPathRequestSerial == Serial && QueryId != 0)
 	{
-		return false;
+		Group.PendingSharedPathQuery = QueryId;
 	}
+	return true;
+}
 
-	Group.SharedPathPoints = MoveTemp(NewPathPoints);
-	Group.bSharedPathUsesNavmesh = bUsesNavmesh;
-	Group.SharedPathTargetLocation = Group.LastTargetLocation;
-	++LastStats.SharedPathsBuilt;
+void UMassUnitCrowdSystem::HandleSharedPathBuilt(
+	int32 GroupHandle,
+	int32 Serial,
+	const FVector& Anchor,
+	const FVector& TargetLocation,
+	TArray<FVector>&& PathPoints,
+	bool bUsesNavmesh)
+{
+	FCrowdGroup* Group = Groups.Find(GroupHandle);
+	if (!Group || Group->SharedPathRequestSerial != Serial)
+	{
+		return;
+	}
+	Group->PendingSharedPathQuery = 0;
+	if (PathPoints.IsEmpty() || !Group->bEngaged)
+	{
+		return;
+	}
+
+	// Members keep steering along the previous corridor until this point.
+	Group->SharedPathPoints = MoveTemp(PathPoints);
+	Group->bSharedPathUsesNavmesh = bUsesNavmesh;
+	Group->SharedPathTargetLocation = TargetLocation;
 
 #if ENABLE_DRAW_DEBUG
-	if (Group.EngagementConfig.bEnableVisualDebug && World)
+	if (Group->EngagementConfig.bEnableVisualDebug && World)
 	{
-		FVector PreviousPoint = GroupAnchor;
-		for (const FVector& PathPoint : Group.SharedPathPoints)
+		FVector PreviousPoint = Anchor;
+		for (const FVector& PathPoint : Group->SharedPathPoints)
 		{
 			DrawDebugLine(
 				World,
@@ -1801,24 +3222,23 @@ bool UMassUnitCrowdSystem::RefreshSharedNavigationPath(
 				PathPoint,
 				FColor::Purple,
 				false,
-				Group.EngagementConfig.SharedPathRepathInterval + 0.1f,
+				Group->EngagementConfig.SharedPathRepathInterval + 0.1f,
 				0,
 				4.0f);
 			PreviousPoint = PathPoint;
 		}
 		DrawDebugSphere(
 			World,
-			Group.LastTargetLocation,
+			TargetLocation,
 			75.0f,
 			12,
 			FColor::Red,
 			false,
-			Group.EngagementConfig.SharedPathRepathInterval + 0.1f,
+			Group->EngagementConfig.SharedPathRepathInterval + 0.1f,
 			0,
 			2.0f);
 	}
 #endif
-	return true;
 }
 
 FVector UMassUnitCrowdSystem::CalculateSharedPathDestination(
@@ -1869,31 +3289,9 @@ FVector UMassUnitCrowdSystem::CalculatePathLookAheadDestination(
 
 FVector UMassUnitCrowdSystem::CalculateGroupAnchor(const FCrowdGroup& Group) const
 {
-	if (!EntitySubsystem)
-	{
-		return Group.Center;
-	}
-
-	const FMassEntityManager& EntityManager = EntitySubsystem->GetEntityManager();
-	FVector Anchor = FVector::ZeroVector;
-	int32 LivingUnitCount = 0;
-	for (const FMassUnitEntityHandle Entity : Group.Units)
-	{
-		if (!IsEntityValid(Entity))
-		{
-			continue;
-		}
-		const FMassEntityHandle NativeHandle = Entity.ToMassEntityHandle();
-		const FMassUnitStateFragment* State = EntityManager.GetFragmentDataPtr<FMassUnitStateFragment>(NativeHandle);
-		const FMassUnitTransformFragment* Transform = EntityManager.GetFragmentDataPtr<FMassUnitTransformFragment>(NativeHandle);
-		if (!Transform || (State && State->CurrentState == EMassUnitState::Dead))
-		{
-			continue;
-		}
-		Anchor += Transform->GetTransform().GetLocation();
-		++LivingUnitCount;
-	}
-	return LivingUnitCount > 0 ? Anchor / static_cast<float>(LivingUnitCount) : Group.Center;
+	return Group.LivingUnits > 0
+		? Group.LivingLocationSum / static_cast<double>(Group.LivingUnits)
+		: Group.Center;
 }
 
 void UMassUnitCrowdSystem::RequestActorAttack(
@@ -1908,27 +3306,25 @@ void UMassUnitCrowdSystem::RequestActorAttack(
 	}
 	++LastStats.AttacksRequested;
 
+	// Damage and effects are applied when the event is flushed; a kill must not run inside the processor.
+	FDeferredEvent Event;
+	Event.Type = EDeferredEventType::Attack;
+	Event.UnitA = Entity;
+	Event.Actor = TargetActor;
+	Event.Damage = Damage;
 	const bool bCanApplyAuthoritativeGameplay = World && World->GetNetMode() != NM_Client;
 	if (bCanApplyAuthoritativeGameplay && Group.EngagementConfig.bApplyActorDamage && Damage > 0.0f)
 	{
-		TSubclassOf<UDamageType> DamageType = Group.EngagementConfig.DamageTypeClass;
-		if (!DamageType)
+		Event.DamageType = Group.EngagementConfig.DamageTypeClass;
+		if (!Event.DamageType)
 		{
-			DamageType = UDamageType::StaticClass();
+			Event.DamageType = UDamageType::StaticClass();
 		}
-		UGameplayStatics::ApplyDamage(TargetActor, Damage, nullptr, nullptr, DamageType);
 	}
-	if (bCanApplyAuthoritativeGameplay && IsValid(TargetActor) && Group.EngagementConfig.GameplayEffectToTarget)
+	if (bCanApplyAuthoritativeGameplay)
 	{
-		if (UAbilitySystemComponent* TargetAbilitySystem = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(TargetActor))
-		{
-			FGameplayEffectContextHandle EffectContext = TargetAbilitySystem->MakeEffectContext();
-			EffectContext.AddSourceObject(this);
-			TargetAbilitySystem->BP_ApplyGameplayEffectToSelf(
-				Group.EngagementConfig.GameplayEffectToTarget,
-				Group.EngagementConfig.GameplayEffectLevel,
-				EffectContext);
-		}
+		Event.GameplayEffect = Group.EngagementConfig.GameplayEffectToTarget;
+		Event.GameplayEffectLevel = Group.EngagementConfig.GameplayEffectLevel;
 	}
 	if (EntitySubsystem)
 	{
@@ -1939,7 +3335,7 @@ void UMassUnitCrowdSystem::RequestActorAttack(
 			TargetActor->GetActorLocation(),
 			Crowd ? Crowd->SubgroupIndex : INDEX_NONE);
 	}
-	OnCrowdAttackRequested.Broadcast(FMassUnitHandle(Entity), IsValid(TargetActor) ? TargetActor : nullptr, Damage);
+	DeferredEvents.Add(MoveTemp(Event));
 }
 
 void UMassUnitCrowdSystem::RequestPresentationCue(
@@ -1963,7 +3359,59 @@ void UMassUnitCrowdSystem::RequestPresentationCue(
 		return;
 	}
 	*NextCueTime = CurrentTime + Group.Config.GroupCueCooldown;
-	OnCrowdCueRequested.Broadcast(Group.Handle, SubgroupIndex, Cue, WorldLocation);
+	FDeferredEvent& Event = DeferredEvents.AddDefaulted_GetRef();
+	Event.Type = EDeferredEventType::Cue;
+	Event.GroupHandle = Group.Handle;
+	Event.SubgroupIndex = SubgroupIndex;
+	Event.Cue = Cue;
+	Event.Location = WorldLocation;
+}
+
+void UMassUnitCrowdSystem::FlushDeferredEvents()
+{
+	if (bUpdatingCrowds || bFlushingEvents)
+	{
+		return;
+	}
+	TGuardValue<bool> FlushGuard(bFlushingEvents, true);
+	// Handlers may raise more events; they are appended and run in this same flush.
+	for (int32 EventIndex = 0; EventIndex < DeferredEvents.Num(); ++EventIndex)
+	{
+		const FDeferredEvent Event = DeferredEvents[EventIndex];
+		AActor* Actor = Event.Actor.Get();
+		switch (Event.Type)
+		{
+		case EDeferredEventType::Attack:
+			if (IsValid(Actor) && Event.DamageType)
+			{
+				UGameplayStatics::ApplyDamage(Actor, Event.Damage, nullptr, nullptr, Event.DamageType);
+			}
+			if (IsValid(Actor) && Event.GameplayEffect)
+			{
+				if (UAbilitySystemComponent* TargetAbilitySystem = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(Actor))
+				{
+					FGameplayEffectContextHandle EffectContext = TargetAbilitySystem->MakeEffectContext();
+					EffectContext.AddSourceObject(this);
+					TargetAbilitySystem->BP_ApplyGameplayEffectToSelf(Event.GameplayEffect, Event.GameplayEffectLevel, EffectContext);
+				}
+			}
+			OnCrowdAttackRequested.Broadcast(FMassUnitHandle(Event.UnitA), IsValid(Actor) ? Actor : nullptr, Event.Damage);
+			break;
+		case EDeferredEventType::Interaction:
+			OnCrowdInteractionStarted.Broadcast(FMassUnitHandle(Event.UnitA), FMassUnitHandle(Event.UnitB));
+			break;
+		case EDeferredEventType::EngagementStarted:
+			OnCrowdEngagementStarted.Broadcast(Event.GroupHandle, Actor);
+			break;
+		case EDeferredEventType::EngagementEnded:
+			OnCrowdEngagementEnded.Broadcast(Event.GroupHandle, Actor);
+			break;
+		case EDeferredEventType::Cue:
+			OnCrowdCueRequested.Broadcast(Event.GroupHandle, Event.SubgroupIndex, Event.Cue, Event.Location);
+			break;
+		}
+	}
+	DeferredEvents.Reset();
 }
 
 AActor* UMassUnitCrowdSystem::FindClosestPlayerTarget(const FVector& Origin, float MaxDistance) const
@@ -1995,35 +3443,65 @@ AActor* UMassUnitCrowdSystem::FindClosestPlayerTarget(const FVector& Origin, flo
 	return BestTarget;
 }
 
-float UMassUnitCrowdSystem::CalculateClosestLivingUnitDistanceSquared(
-	const FCrowdGroup& Group,
-	const FVector& Location) const
+bool UMassUnitCrowdSystem::HasLivingUnitWithin(const FCrowdGroup& Group, const FVector& Location, float Radius) const
 {
-	if (!EntitySubsystem)
+	if (Group.LivingUnits <= 0 || !Group.LivingBounds.IsValid)
 	{
-		return TNumericLimits<float>::Max();
+		return false;
 	}
 	const bool bUse3DMovement = Group.Config.MovementMode == EMassUnitCrowdMovementMode::Free3D;
-	const FMassEntityManager& EntityManager = EntitySubsystem->GetEntityManager();
-	float ClosestDistanceSquared = TNumericLimits<float>::Max();
+	const float RadiusSquared = FMath::Square(Radius);
+	auto DistanceSquared = [bUse3DMovement](const FVector& Delta)
+	{
+		return bUse3DMovement ? Delta.SizeSquared() : Delta.SizeSquared2D();
+	};
+
+	// The nearest and farthest points of the living bounds bracket the closest
+	// living unit, which settles the common cases without visiting members.
+	const FBox& Bounds = Group.LivingBounds;
+	if (DistanceSquared(Bounds.GetClosestPointTo(Location) - Location) > RadiusSquared)
+	{
+		return false;
+	}
+	const FVector FarthestDelta(
+		FMath::Max(FMath::Abs(Location.X - Bounds.Min.X), FMath::Abs(Location.X - Bounds.Max.X)),
+		FMath::Max(FMath::Abs(Location.Y - Bounds.Min.Y), FMath::Abs(Location.Y - Bounds.Max.Y)),
+		FMath::Max(FMath::Abs(Location.Z - Bounds.Min.Z), FMath::Abs(Location.Z - Bounds.Max.Z)));
+	if (DistanceSquared(FarthestDelta) <= RadiusSquared)
+	{
+		return true;
+	}
+
 	for (const FMassUnitEntityHandle Entity : Group.Units)
 	{
-		if (!IsEntityValid(Entity))
+		const int32 EntryIndex = SpatialHash.FindEntryIndex(Entity);
+		if (EntryIndex == INDEX_NONE)
 		{
 			continue;
 		}
-		const FMassEntityHandle NativeHandle = Entity.ToMassEntityHandle();
-		const FMassUnitStateFragment* State = EntityManager.GetFragmentDataPtr<FMassUnitStateFragment>(NativeHandle);
-		const FMassUnitTransformFragment* Transform = EntityManager.GetFragmentDataPtr<FMassUnitTransformFragment>(NativeHandle);
-		if (!Transform || (State && State->CurrentState == EMassUnitState::Dead))
+		const FSpatialEntry& Entry = SpatialHash.GetEntry(EntryIndex);
+		if (Entry.bLiving && DistanceSquared(Entry.Location - Location) <= RadiusSquared)
 		{
-			continue;
+			return true;
+		}
+	}
+	// Dormant members are part of the bounds too.
+	if (Group.DormantUnits > 0)
+	{
+		for (const FMassUnitEntityHandle Entity : Group.Units)
+		{
+			const FIntPoint* Cell = DormantCellByUnit.Find(Entity);
+			const TArray<FDormantUnit>* Units = Cell ? DormantCells.Find(*Cell) : nullptr;
+			const FDormantUnit* Unit = Units
+				? Units->FindByPredicate([Entity](const FDormantUnit& Candidate) { return Candidate.Entity == Entity; })
+				: nullptr;
+			if (Unit && Unit->bLiving && DistanceSquared(Unit->Location - Location) <= RadiusSquared)
+			{
+				return true;
+			}
 		}
-		const FVector Delta = Transform->GetTransform().GetLocation() - Location;
-		const float DistanceSquared = bUse3DMovement ? Delta.SizeSquared() : Delta.SizeSquared2D();
-		ClosestDistanceSquared = FMath::Min(ClosestDistanceSquared, DistanceSquared);
 	}
-	return ClosestDistanceSquared;
+	return false;
 }
 
 FVector UMassUnitCrowdSystem::CalculateFollowOffset(
@@ -2055,23 +3533,6 @@ FVector UMassUnitCrowdSystem::CalculateFollowOffset(
 	return FVector(FMath::Cos(Angle) * Radius, FMath::Sin(Angle) * Radius, 0.0f);
 }
 
-FVector UMassUnitCrowdSystem::CalculateSubgroupWanderCenter(
-	FMassUnitEntityHandle Entity,
-	const FCrowdGroup& Group) const
-{
-	if (!Group.Config.bEnableManagedSubgroups || Group.SubgroupCount <= 1 || !EntitySubsystem)
-	{
-		return Group.Center;
-	}
-	const FMassUnitCrowdFragment* Crowd = EntitySubsystem->GetEntityManager().GetFragmentDataPtr<FMassUnitCrowdFragment>(
-		Entity.ToMassEntityHandle());
-	if (!Crowd)
-	{
-		return Group.Center;
-	}
-	return CalculateSubgroupWanderCenter(Crowd->SubgroupIndex, Group);
-}
-
 FVector UMassUnitCrowdSystem::CalculateSubgroupWanderCenter(
 	int32 SubgroupIndex,
 	const FCrowdGroup& Group) const
@@ -2135,18 +3596,11 @@ float UMassUnitCrowdSystem::GetSimulationIntervalMultiplier(int32 LODLevel) cons
 	return FMath::Max(1.0f, SimulationLODIntervalMultipliers[Index]);
 }
 
-FIntVector UMassUnitCrowdSystem::ToSpatialCell(const FVector& Location, bool bUse3DMovement) const
-{
-	return FIntVector(
-		FMath::FloorToInt(Location.X / SpatialCellSize),
-		FMath::FloorToInt(Location.Y / SpatialCellSize),
-		bUse3DMovement ? FMath::FloorToInt(Location.Z / SpatialCellSize) : 0);
-}
-
 FMassUnitCrowdConfig UMassUnitCrowdSystem::SanitizeConfig(const FMassUnitCrowdConfig& Config)
 {
 	FMassUnitCrowdConfig Result = Config;
 	Result.WanderRadius = FMath::Max(1.0f, Result.WanderRadius);
+	Result.WanderPointPoolSize = FMath::Clamp(Result.WanderPointPoolSize, 0, 512);
 	Result.MinWanderDistance = FMath::Clamp(Result.MinWanderDistance, 0.0f, Result.WanderRadius);
 	Result.MinIdleTime = FMath::Max(0.0f, Result.MinIdleTime);
 	Result.MaxIdleTime = FMath::Max(Result.MinIdleTime, Result.MaxIdleTime);
@@ -2155,6 +3609,11 @@ FMassUnitCrowdConfig UMassUnitCrowdSystem::SanitizeConfig(const FMassUnitCrowdCo
 	Result.MaxMoveSpeedMultiplier = FMath::Clamp(Result.MaxMoveSpeedMultiplier, Result.MinMoveSpeedMultiplier, 4.0f);
 	Result.SeparationRadius = FMath::Max(1.0f, Result.SeparationRadius);
 	Result.SeparationWeight = FMath::Clamp(Result.SeparationWeight, 0.0f, 4.0f);
+	Result.NeighborListSkin = FMath::Max(0.0f, Result.NeighborListSkin);
+	Result.AvoidanceAgentRadius = FMath::Max(1.0f, Result.AvoidanceAgentRadius);
+	Result.AvoidanceTimeHorizon = FMath::Max(0.1f, Result.AvoidanceTimeHorizon);
+	Result.AvoidanceNeighborDistance = FMath::Max(1.0f, Result.AvoidanceNeighborDistance);
+	Result.MaxAvoidanceNeighbors = FMath::Clamp(Result.MaxAvoidanceNeighbors, 1, 16);
 	Result.InteractionChance = FMath::Clamp(Result.InteractionChance, 0.0f, 1.0f);
 	Result.InteractionRadius = FMath::Max(1.0f, Result.InteractionRadius);
 	Result.MinInteractionTime = FMath::Max(0.0f, Result.MinInteractionTime);
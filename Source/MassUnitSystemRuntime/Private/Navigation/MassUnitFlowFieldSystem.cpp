@@ -0,0 +1,657 @@
+// Copyright Digi Logic Labs LLC. All Rights Reserved.
+
+#include "Navigation/MassUnitFlowFieldSystem.h"
+
+#include "Config/MassUnitSystemSettings.h"
+#include "Core/MassUnitSystemRuntime.h"
+#include "Entity/MassUnitFragments.h"
+#include "MassEntityManager.h"
+#include "MassEntitySubsystem.h"
+#include "NavigationData.h"
+#include "NavigationSystem.h"
+#include "Navigation/MassUnitNavigationSystem.h"
+
+namespace
+{
+	constexpr uint8 GoalDirection = 8;
+	constexpr uint8 UnreachableDirection = 255;
+	constexpr int32 SteeringLookaheadCells = 2;
+
+	// Orthogonal neighbors first, then diagonals. OppositeDirection maps each
+	// offset to the one pointing back at the cell it was relaxed from.
+	const FIntPoint NeighborOffsets[8] = {
+		FIntPoint(1, 0), FIntPoint(-1, 0), FIntPoint(0, 1), FIntPoint(0, -1),
+		FIntPoint(1, 1), FIntPoint(1, -1), FIntPoint(-1, 1), FIntPoint(-1, -1)};
+	const uint8 OppositeDirection[8] = {1, 0, 3, 2, 7, 6, 5, 4};
+
+	struct FOpenCell
+	{
+		float Cost = 0.0f;
+		int32 Index = INDEX_NONE;
+	};
+
+	struct FOpenCellPredicate
+	{
+		bool operator()(const FOpenCell& A, const FOpenCell& B) const
+		{
+			return A.Cost < B.Cost;
+		}
+	};
+}
+
+void UMassUnitFlowFieldSystem::Initialize(
+	UWorld* InWorld,
+	UMassEntitySubsystem* InEntitySubsystem,
+	UMassUnitEntityManager* InUnitManager,
+	UMassUnitNavigationSystem* InNavigationSystem)
+{
+	World = InWorld;
+	EntitySubsystem = InEntitySubsystem;
+	UnitManager = InUnitManager;
+	NavigationSystem = InNavigationSystem;
+	const UMassUnitSystemSettings* Settings = GetDefault<UMassUnitSystemSettings>();
+	CellSize = Settings ? FMath::Max(10.0f, Settings->FlowFieldCellSize) : 100.0f;
+	ProjectionHeight = Settings ? FMath::Max(1.0f, Settings->FlowFieldProjectionHeight) : 250.0f;
+	MaxFieldTiles = Settings ? FMath::Max(1, Settings->MaxFlowFieldTiles) : 256;
+	MaxCachedFields = Settings ? FMath::Max(1, Settings->MaxCachedFlowFields) : 16;
+	PublishSnapshot();
+	if (NavigationSystem)
+	{
+		NavigationAreasRebuiltHandle = NavigationSystem->OnNavigationAreasRebuilt.AddUObject(
+			this,
+			&UMassUnitFlowFieldSystem::HandleNavigationAreasRebuilt);
+	}
+}
+
+void UMassUnitFlowFieldSystem::Deinitialize()
+{
+	if (NavigationSystem)
+	{
+		NavigationSystem->OnNavigationAreasRebuilt.Remove(NavigationAreasRebuiltHandle);
+	}
+	NavigationAreasRebuiltHandle.Reset();
+	ClearCache();
+	NavigationSystem = nullptr;
+	UnitManager = nullptr;
+	EntitySubsystem = nullptr;
+	World = nullptr;
+}
+
+int32 UMassUnitFlowFieldSystem::MoveUnitsToLocation(
+	const TArray<FMassUnitHandle>& Units,
+	FVector Destination,
+	float AcceptanceRadius)
+{
+	TArray<FMassUnitEntityHandle> Entities;
+	Entities.Reserve(Units.Num());
+	for (const FMassUnitHandle& Unit : Units)
+	{
+		Entities.Add(Unit.EntityHandle);
+	}
+	return MoveUnitsToLocationInternal(Entities, Destination, AcceptanceRadius);
+}
+
+int32 UMassUnitFlowFieldSystem::MoveUnitsToLocationInternal(
+	TConstArrayView<FMassUnitEntityHandle> Entities,
+	const FVector& Destination,
+	float AcceptanceRadius)
+{
+	if (!EntitySubsystem || !UnitManager || !NavigationSystem || Entities.IsEmpty())
+	{
+		return 0;
+	}
+
+	FMassEntityManager& EntityManager = EntitySubsystem->GetMutableEntityManager();
+	TArray<FMassUnitEntityHandle> ValidEntities;
+	ValidEntities.Reserve(Entities.Num());
+	FBox Bounds(ForceInit);
+	for (const FMassUnitEntityHandle Entity : Entities)
+	{
+		if (!Entity.IsValid() || !EntityManager.IsEntityValid(Entity.ToMassEntityHandle()))
+		{
+			continue;
+		}
+		if (const FMassUnitTransformFragment* Transform = EntityManager.GetFragmentDataPtr<FMassUnitTransformFragment>(Entity.ToMassEntityHandle()))
+		{
+			Bounds += Transform->GetTransform().GetLocation();
+			ValidEntities.Add(Entity);
+		}
+	}
+	if (ValidEntities.IsEmpty())
+	{
+		return 0;
+	}
+	NavigationSystem->CancelPathsInternal(ValidEntities);
+
+	FVector Goal = Destination;
+	const bool bProjectedGoal = NavigationSystem->ProjectPointToNavigation(Destination, Goal);
+	const int32 FieldHandle = bProjectedGoal ? FindOrBuildField(Goal, Bounds) : INDEX_NONE;
+	const UMassUnitSystemSettings* Settings = GetDefault<UMassUnitSystemSettings>();
+	if (FieldHandle == INDEX_NONE && Settings && !Settings->bFallbackToDirectPath)
+	{
+		return 0;
+	}
+
+	int32 CommandedCount = 0;
+	for (const FMassUnitEntityHandle Entity : ValidEntities)
+	{
+		if (!UnitManager->SetUnitDestination(FMassUnitHandle(Entity), Goal, AcceptanceRadius))
+		{
+			continue;
+		}
+		if (FieldHandle != INDEX_NONE)
+		{
+			if (FMassUnitNavigationFragment* Navigation = EntityManager.GetFragmentDataPtr<FMassUnitNavigationFragment>(Entity.ToMassEntityHandle()))
+			{
+				Navigation->FlowFieldHandle = FieldHandle;
+				Navigation->bPathUsesNavmesh = true;
+			}
+		}
+		++CommandedCount;
+	}
+	return CommandedCount;
+}
+
+int32 UMassUnitFlowFieldSystem::FindOrBuildField(const FVector& Destination, const FBox& Bounds)
+{
+	if (!World || !NavigationSystem || !NavigationSystem->GetNavigationSystem() || !NavigationSystem->GetNavigationData())
+	{
+		return INDEX_NONE;
+	}
+
+	const FIntPoint GoalCell = ToCell(Destination);
+	const FIntPoint GoalTile(
+		FMath::FloorToInt(static_cast<float>(GoalCell.X) / TileCells),
+		FMath::FloorToInt(static_cast<float>(GoalCell.Y) / TileCells));
+	FIntPoint MinTile = GoalTile;
+	FIntPoint MaxTile = GoalTile;
+	if (Bounds.IsValid)
+	{
+		const FIntPoint MinCell = ToCell(Bounds.Min);
+		const FIntPoint MaxCell = ToCell(Bounds.Max);
+		MinTile = MinTile.ComponentMin(FIntPoint(
+			FMath::FloorToInt(static_cast<float>(MinCell.X) / TileCells),
+			FMath::FloorToInt(static_cast<float>(MinCell.Y) / TileCells)));
+		MaxTile = MaxTile.ComponentMax(FIntPoint(
+			FMath::FloorToInt(static_cast<float>(MaxCell.X) / TileCells),
+			FMath::FloorToInt(static_cast<float>(MaxCell.Y) / TileCells)));
+	}
+	// One tile of margin lets units route around obstacles at the edge of the group.
+	MinTile -= FIntPoint(1, 1);
+	MaxTile += FIntPoint(1, 1);
+
+	const FIntVector FieldKey(GoalCell.X, GoalCell.Y, ToHeightBand(Destination.Z));
+	FFlowField* Field = nullptr;
+	int32 FieldHandle = INDEX_NONE;
+	if (const int32* ExistingHandle = FieldByGoalCell.Find(FieldKey))
+	{
+		FieldHandle = *ExistingHandle;
+		Field = Fields.Find(FieldHandle);
+	}
+	if (Field)
+	{
+		MinTile = MinTile.ComponentMin(Field->MinTile);
+		MaxTile = MaxTile.ComponentMax(Field->MaxTile);
+	}
+
+	// Clamp oversized requests to a square around the goal. Units outside the
+	// field steer straight at the destination until they enter it.
+	const int32 MaxSpan = FMath::Max(1, FMath::FloorToInt(FMath::Sqrt(static_cast<float>(MaxFieldTiles))));
+	if ((MaxTile.X - MinTile.X + 1) * (MaxTile.Y - MinTile.Y + 1) > MaxFieldTiles)
+	{
+		const int32 HalfSpan = (MaxSpan - 1) / 2;
+		MinTile = MinTile.ComponentMax(GoalTile - FIntPoint(HalfSpan, HalfSpan));
+		MaxTile = MaxTile.ComponentMin(MinTile + FIntPoint(MaxSpan - 1, MaxSpan - 1));
+	}
+
+	const double CurrentTime = World->GetTimeSeconds();
+	if (Field && Field->MinTile == MinTile && Field->MaxTile == MaxTile)
+	{
+		Field->LastUsedTime = CurrentTime;
+		return FieldHandle;
+	}
+	if (!Field)
+	{
+		FieldHandle = NextFieldHandle++;
+		Field = &Fields.Add(FieldHandle);
+		FieldByGoalCell.Add(FieldKey, FieldHandle);
+	}
+	Field->Goal = Destination;
+	Field->GoalCell = GoalCell;
+	Field->MinTile = MinTile;
+	Field->MaxTile = MaxTile;
+	Field->HeightBand = FieldKey.Z;
+	Field->LastUsedTime = CurrentTime;
+	// Built within the per-frame tile budget like a navmesh rebuild, so a move
+	// order never projects the whole field at once. Until it is integrated,
+	// units steer straight at the goal, or keep the directions of the field
+	// before it was widened.
+	if (!Field->bRebuildPending)
+	{
+		Field->bRebuildPending = true;
+		PendingFieldRebuilds.Add(FieldHandle);
+	}
+	EvictLeastRecentlyUsedFields();
+	return FieldHandle;
+}
+
+UMassUnitFlowFieldSystem::FSnapshotRef UMassUnitFlowFieldSystem::GetSnapshot() const
+{
+	FRWScopeLock Lock(SnapshotLock, SLT_ReadOnly);
+	return Snapshot;
+}
+
+bool UMassUnitFlowFieldSystem::SampleSteeringPoint(
+	int32 FieldHandle,
+	const FVector& Location,
+	FVector& OutSteeringPoint) const
+{
+	return GetSnapshot()->SampleSteeringPoint(FieldHandle, Location, OutSteeringPoint);
+}
+
+bool FMassUnitFlowFieldSnapshot::SampleSteeringPoint(
+	int32 FieldHandle,
+	const FVector& Location,
+	FVector& OutSteeringPoint) const
+{
+	constexpr int32 TileCells = UMassUnitFlowFieldSystem::TileCells;
+	const FFieldPtr* FoundField = FieldHandle != INDEX_NONE ? Fields.Find(FieldHandle) : nullptr;
+	const FField* Field = FoundField ? FoundField->Get() : nullptr;
+	if (!Field || Field->Directions.IsEmpty())
+	{
+		return false;
+	}
+
+	const FIntPoint Origin = Field->MinTile * TileCells;
+	const int32 Width = (Field->MaxTile.X - Field->MinTile.X + 1) * TileCells;
+	const int32 Height = (Field->MaxTile.Y - Field->MinTile.Y + 1) * TileCells;
+	FIntPoint Cell = FIntPoint(
+		FMath::FloorToInt(Location.X / CellSize),
+		FMath::FloorToInt(Location.Y / CellSize)) - Origin;
+	if (Cell.X < 0 || Cell.Y < 0 || Cell.X >= Width || Cell.Y >= Height)
+	{
+		return false;
+	}
+
+	int32 CellIndex = Cell.Y * Width + Cell.X;
+	if (Field->Directions[CellIndex] == UnreachableDirection)
+	{
+		return false;
+	}
+	for (int32 Step = 0; Step < SteeringLookaheadCells; ++Step)
+	{
+		const uint8 Direction = Field->Directions[CellIndex];
+		if (Direction == GoalDirection)
+		{
+			OutSteeringPoint = Field->Goal;
+			return true;
+		}
+		Cell += NeighborOffsets[Direction];
+		CellIndex = Cell.Y * Width + Cell.X;
+	}
+	OutSteeringPoint = FVector(
+		(static_cast<float>(Origin.X + Cell.X) + 0.5f) * CellSize,
+		(static_cast<float>(Origin.Y + Cell.Y) + 0.5f) * CellSize,
+		Field->Heights[CellIndex]);
+	return true;
+}
+
+void UMassUnitFlowFieldSystem::RebuildDirtyFields()
+{
+	int32 TileBudget = MaxTileBuildsPerFrame;
+	while (!PendingFieldRebuilds.IsEmpty())
+	{
+		FFlowField* Field = Fields.Find(PendingFieldRebuilds[0]);
+		if (!Field || !Field->bRebuildPending)
+		{
+			PendingFieldRebuilds.RemoveAt(0, EAllowShrinking::No);
+			continue;
+		}
+		if (!BuildFieldTiles(*Field, TileBudget))
+		{
+			return;
+		}
+		IntegrateField(*Field);
+		Field->bRebuildPending = false;
+		PendingFieldRebuilds.RemoveAt(0, EAllowShrinking::No);
+		PublishSnapshot();
+		return;
+	}
+}
+
+void UMassUnitFlowFieldSystem::ClearCache()
+{
+	WalkTiles.Reset();
+	Fields.Reset();
+	FieldByGoalCell.Reset();
+	PendingFieldRebuilds.Reset();
+	PublishSnapshot();
+}
+
+void UMassUnitFlowFieldSystem::HandleNavigationAreasRebuilt(TConstArrayView<FBox> RebuiltAreas)
+{
+	// Keep field handles stable so units mid-move keep following their order;
+	// fields keep their directions until RebuildDirtyFields replaces them.
+	TSet<FWalkTileKey> DroppedTiles;
+	const float TileSize = CellSize * TileCells;
+	for (auto TileIt = WalkTiles.CreateIterator(); TileIt; ++TileIt)
+	{
+		const FWalkTileKey& TileKey = TileIt.Key();
+		const FVector TileMin(TileKey.X * TileSize, TileKey.Y * TileSize, (TileKey.Z - 1.5f) * ProjectionHeight);
+		const FBox TileBounds(TileMin, TileMin + FVector(TileSize, TileSize, ProjectionHeight * 4.0f));
+		// No areas means the rebuilt bounds are unknown.
+		bool bDirty = RebuiltAreas.IsEmpty();
+		for (int32 AreaIndex = 0; !bDirty && AreaIndex < RebuiltAreas.Num(); ++AreaIndex)
+		{
+			bDirty = RebuiltAreas[AreaIndex].Intersect(TileBounds);
+		}
+		if (bDirty)
+		{
+			DroppedTiles.Add(TileKey);
+			TileIt.RemoveCurrent();
+		}
+	}
+	if (DroppedTiles.IsEmpty())
+	{
+		return;
+	}
+	for (TPair<int32, FFlowField>& Pair : Fields)
+	{
+		FFlowField& Field = Pair.Value;
+		if (Field.bRebuildPending)
+		{
+			continue;
+		}
+		for (const FWalkTileKey& TileKey : Field.TileKeys)
+		{
+			if (DroppedTiles.Contains(TileKey))
+			{
+				Field.bRebuildPending = true;
+				PendingFieldRebuilds.Add(Pair.Key);
+				break;
+			}
+		}
+	}
+}
+
+FIntPoint UMassUnitFlowFieldSystem::ToCell(const FVector& Location) const
+{
+	return FIntPoint(
+		FMath::FloorToInt(Location.X / CellSize),
+		FMath::FloorToInt(Location.Y / CellSize));
+}
+
+int32 UMassUnitFlowFieldSystem::ToHeightBand(float Z) const
+{
+	return FMath::FloorToInt(Z / (ProjectionHeight * 2.0f));
+}
+
+UMassUnitFlowFieldSystem::FWalkTileKey UMassUnitFlowFieldSystem::ToWalkTileKey(const FIntPoint& Tile, float ReferenceZ) const
+{
+	return FWalkTileKey(Tile.X, Tile.Y, FMath::FloorToInt(ReferenceZ / ProjectionHeight));
+}
+
+void UMassUnitFlowFieldSystem::BuildWalkTile(const FWalkTileKey& TileKey)
+{
+	FWalkTile& WalkTile = WalkTiles.Add(TileKey);
+	WalkTile.Heights.SetNumZeroed(TileCells * TileCells);
+	WalkTile.Walkable.SetNumZeroed(TileCells * TileCells);
+	UNavigationSystemV1* NavSys = NavigationSystem ? NavigationSystem->GetNavigationSystem() : nullptr;
+	ANavigationData* NavData = NavigationSystem ? NavigationSystem->GetNavigationData() : nullptr;
+	if (!NavSys || !NavData)
+	{
+		return;
+	}
+
+	// The band is centered within half a band of the reference height and the
+	// nearest navmesh wins, so a floor above or below only shows through where
+	// the reference surface has none.
+	const float BandCenterZ = (static_cast<float>(TileKey.Z) + 0.5f) * ProjectionHeight;
+	const FVector Extent(CellSize * 0.5f, CellSize * 0.5f, ProjectionHeight * 2.0f);
+	for (int32 LocalY = 0; LocalY < TileCells; ++LocalY)
+	{
+		for (int32 LocalX = 0; LocalX < TileCells; ++LocalX)
+		{
+			const FVector CellCenter(
+				(static_cast<float>(TileKey.X * TileCells + LocalX) + 0.5f) * CellSize,
+				(static_cast<float>(TileKey.Y * TileCells + LocalY) + 0.5f) * CellSize,
+				BandCenterZ);
+			FNavLocation Projected;
+			if (NavSys->ProjectPointToNavigation(CellCenter, Projected, Extent, NavData))
+			{
+				const int32 LocalIndex = LocalY * TileCells + LocalX;
+				WalkTile.Heights[LocalIndex] = Projected.Location.Z;
+				WalkTile.Walkable[LocalIndex] = 1;
+			}
+		}
+	}
+}
+
+bool UMassUnitFlowFieldSystem::BuildFieldTiles(FFlowField& Field, int32& TileBudget)
+{
+	const int32 TilesX = Field.MaxTile.X - Field.MinTile.X + 1;
+	const int32 TilesY = Field.MaxTile.Y - Field.MinTile.Y + 1;
+	Field.TileKeys.Init(FWalkTileKey(0, 0, TNumericLimits<int32>::Min()), TilesX * TilesY);
+
+	// Breadth-first from the goal tile. Each tile is projected around the mean
+	// navmesh height along the edge of the tile it was reached from, so the
+	// band follows the ground instead of staying at the goal's height.
+	TArray<float> ReferenceZ;
+	ReferenceZ.Init(Field.Goal.Z, TilesX * TilesY);
+	TArray<uint8> Visited;
+	Visited.SetNumZeroed(TilesX * TilesY);
+	TArray<FIntPoint> Frontier;
+	const FIntPoint GoalTile(
+		FMath::Clamp(FMath::FloorToInt(static_cast<float>(Field.GoalCell.X) / TileCells), Field.MinTile.X, Field.MaxTile.X),
+		FMath::Clamp(FMath::FloorToInt(static_cast<float>(Field.GoalCell.Y) / TileCells), Field.MinTile.Y, Field.MaxTile.Y));
+	Frontier.Add(GoalTile - Field.MinTile);
+	Visited[Frontier[0].Y * TilesX + Frontier[0].X] = 1;
+	for (int32 FrontierIndex = 0; FrontierIndex < Frontier.Num(); ++FrontierIndex)
+	{
+		const FIntPoint Local = Frontier[FrontierIndex];
+		const int32 TileIndex = Local.Y * TilesX + Local.X;
+		const FWalkTileKey TileKey = ToWalkTileKey(Field.MinTile + Local, ReferenceZ[TileIndex]);
+		if (!WalkTiles.Contains(TileKey))
+		{
+			if (TileBudget <= 0)
+			{
+				return false;
+			}
+			--TileBudget;
+			BuildWalkTile(TileKey);
+		}
+		Field.TileKeys[TileIndex] = TileKey;
+
+		const FWalkTile& WalkTile = WalkTiles.FindChecked(TileKey);
+		for (int32 Direction = 0; Direction < 4; ++Direction)
+		{
+			const FIntPoint& Offset = NeighborOffsets[Direction];
+			const FIntPoint Neighbor = Local + Offset;
+			if (Neighbor.X < 0 || Neighbor.Y < 0 || Neighbor.X >= TilesX || Neighbor.Y >= TilesY
+				|| Visited[Neighbor.Y * TilesX + Neighbor.X])
+			{
+				continue;
+			}
+			// Walk the edge shared with the neighbor; without walkable cells there
+			// the neighbor inherits this tile's reference.
+			float EdgeHeightSum = 0.0f;
+			int32 EdgeCellCount = 0;
+			for (int32 EdgeIndex = 0; EdgeIndex < TileCells; ++EdgeIndex)
+			{
+				const int32 LocalX = Offset.X > 0 ? TileCells - 1 : (Offset.X < 0 ? 0 : EdgeIndex);
+				const int32 LocalY = Offset.Y > 0 ? TileCells - 1 : (Offset.Y < 0 ? 0 : EdgeIndex);
+				const int32 LocalIndex = LocalY * TileCells + LocalX;
+				if (WalkTile.Walkable[LocalIndex])
+				{
+					EdgeHeightSum += WalkTile.Heights[LocalIndex];
+					++EdgeCellCount;
+				}
+			}
+			const int32 NeighborIndex = Neighbor.Y * TilesX + Neighbor.X;
+			ReferenceZ[NeighborIndex] = EdgeCellCount > 0 ? EdgeHeightSum / EdgeCellCount : ReferenceZ[TileIndex];
+			Visited[NeighborIndex] = 1;
+			Frontier.Add(Neighbor);
+		}
+	}
+	return true;
+}
+
+void UMassUnitFlowFieldSystem::IntegrateField(FFlowField& Field)
+{
+	++FieldBuildCount;
+	const FIntPoint Origin = Field.MinTile * TileCells;
+	const int32 Width = (Field.MaxTile.X - Field.MinTile.X + 1) * TileCells;
+	const int32 Height = (Field.MaxTile.Y - Field.MinTile.Y + 1) * TileCells;
+	const int32 CellCount = Width * Height;
+	// Integrated into a new object; published snapshots keep the previous one.
+	const TSharedRef<FMassUnitFlowFieldSnapshot::FField, ESPMode::ThreadSafe> Integrated = MakeShared<FMassUnitFlowFieldSnapshot::FField, ESPMode::ThreadSafe>();
+	Field.Integrated = Integrated;
+	Integrated->Goal = Field.Goal;
+	Integrated->MinTile = Field.MinTile;
+	Integrated->MaxTile = Field.MaxTile;
+	TArray<uint8>& Directions = Integrated->Directions;
+	TArray<float>& Heights = Integrated->Heights;
+	Directions.Init(UnreachableDirection, CellCount);
+	Heights.SetNumZeroed(CellCount);
+
+	TArray<uint8> Walkable;
+	Walkable.SetNumZeroed(CellCount);
+	const int32 TilesX = Field.MaxTile.X - Field.MinTile.X + 1;
+	for (int32 TileY = Field.MinTile.Y; TileY <= Field.MaxTile.Y; ++TileY)
+	{
+		for (int32 TileX = Field.MinTile.X; TileX <= Field.MaxTile.X; ++TileX)
+		{
+			const int32 TileIndex = (TileY - Field.MinTile.Y) * TilesX + (TileX - Field.MinTile.X);
+			const FWalkTile* WalkTile = Field.TileKeys.IsValidIndex(TileIndex) ? WalkTiles.Find(Field.TileKeys[TileIndex]) : nullptr;
+			if (!WalkTile)
+			{
+				continue;
+			}
+			const int32 BaseX = (TileX - Field.MinTile.X) * TileCells;
+			const int32 BaseY = (TileY - Field.MinTile.Y) * TileCells;
+			for (int32 LocalY = 0; LocalY < TileCells; ++LocalY)
+			{
+				const int32 RowStart = (BaseY + LocalY) * Width + BaseX;
+				FMemory::Memcpy(&Heights[RowStart], &WalkTile->Heights[LocalY * TileCells], TileCells * sizeof(float));
+				FMemory::Memcpy(&Walkable[RowStart], &WalkTile->Walkable[LocalY * TileCells], TileCells * sizeof(uint8));
+			}
+		}
+	}
+
+	const FIntPoint GoalLocal = Field.GoalCell - Origin;
+	if (GoalLocal.X < 0 || GoalLocal.Y < 0 || GoalLocal.X >= Width || GoalLocal.Y >= Height)
+	{
+		return;
+	}
+	const int32 GoalIndex = GoalLocal.Y * Width + GoalLocal.X;
+	// The goal was projected onto the navmesh even if its cell center was not.
+	Walkable[GoalIndex] = 1;
+	Heights[GoalIndex] = Field.Goal.Z;
+	Directions[GoalIndex] = GoalDirection;
+
+	// Dijkstra from the goal. Steps steeper than one cell per cell are treated
+	// as walls, and diagonals may not cut blocked corners.
+	TArray<float> Costs;
+	Costs.Init(TNumericLimits<float>::Max(), CellCount);
+	Costs[GoalIndex] = 0.0f;
+	TArray<FOpenCell> Open;
+	Open.HeapPush(FOpenCell{0.0f, GoalIndex}, FOpenCellPredicate());
+	const float MaxStepHeight = CellSize;
+	while (!Open.IsEmpty())
+	{
+		FOpenCell Current;
+		Open.HeapPop(Current, FOpenCellPredicate(), EAllowShrinking::No);
+		if (Current.Cost > Costs[Current.Index])
+		{
+			continue;
+		}
+		const int32 CurrentX = Current.Index % Width;
+		const int32 CurrentY = Current.Index / Width;
+		for (int32 NeighborDirection = 0; NeighborDirection < 8; ++NeighborDirection)
+		{
+			const FIntPoint& Offset = NeighborOffsets[NeighborDirection];
+			const int32 NeighborX = CurrentX + Offset.X;
+			const int32 NeighborY = CurrentY + Offset.Y;
+			if (NeighborX < 0 || NeighborY < 0 || NeighborX >= Width || NeighborY >= Height)
+			{
+				continue;
+			}
+			const int32 NeighborIndex = NeighborY * Width + NeighborX;
+			if (!Walkable[NeighborIndex]
+				|| FMath::Abs(Heights[NeighborIndex] - Heights[Current.Index]) > MaxStepHeight)
+			{
+				continue;
+			}
+			const bool bDiagonal = Offset.X != 0 && Offset.Y != 0;
+			if (bDiagonal
+				&& (!Walkable[CurrentY * Width + NeighborX] || !Walkable[NeighborY * Width + CurrentX]))
+			{
+				continue;
+			}
+			const float NeighborCost = Current.Cost + (bDiagonal ? UE_SQRT_2 : 1.0f);
+			if (NeighborCost < Costs[NeighborIndex])
+			{
+				Costs[NeighborIndex] = NeighborCost;
+				Directions[NeighborIndex] = OppositeDirection[NeighborDirection];
+				Open.HeapPush(FOpenCell{NeighborCost, NeighborIndex}, FOpenCellPredicate());
+			}
+		}
+	}
+}
+
+void UMassUnitFlowFieldSystem::EvictLeastRecentlyUsedFields()
+{
+	if (Fields.Num() <= MaxCachedFields)
+	{
+		return;
+	}
+	while (Fields.Num() > MaxCachedFields)
+	{
+		int32 OldestHandle = INDEX_NONE;
+		double OldestTime = TNumericLimits<double>::Max();
+		for (const TPair<int32, FFlowField>& Pair : Fields)
+		{
+			if (Pair.Value.LastUsedTime < OldestTime)
+			{
+				OldestTime = Pair.Value.LastUsedTime;
+				OldestHandle = Pair.Key;
+			}
+		}
+		const FFlowField& Oldest = Fields.FindChecked(OldestHandle);
+		FieldByGoalCell.Remove(FIntVector(Oldest.GoalCell.X, Oldest.GoalCell.Y, Oldest.HeightBand));
+		Fields.Remove(OldestHandle);
+	}
+	PublishSnapshot();
+
+	// Drop walkability tiles that no surviving field uses.
+	TSet<FWalkTileKey> ReferencedTiles;
+	for (const TPair<int32, FFlowField>& Pair : Fields)
+	{
+		ReferencedTiles.Append(Pair.Value.TileKeys);
+	}
+	for (auto TileIt = WalkTiles.CreateIterator(); TileIt; ++TileIt)
+	{
+		if (!ReferencedTiles.Contains(TileIt.Key()))
+		{
+			TileIt.RemoveCurrent();
+		}
+	}
+}
+
+void UMassUnitFlowFieldSystem::PublishSnapshot()
+{
+	// Fields are shared, so a snapshot only copies their references; readers
+	// holding the previous snapshot keep it alive until their pass ends.
+	TSharedRef<FMassUnitFlowFieldSnapshot, ESPMode::ThreadSafe> NewSnapshot = MakeShared<FMassUnitFlowFieldSnapshot, ESPMode::ThreadSafe>();
+	NewSnapshot->CellSize = CellSize;
+	NewSnapshot->Fields.Reserve(Fields.Num());
+	for (const TPair<int32, FFlowField>& Pair : Fields)
+	{
+		if (Pair.Value.Integrated)
+		{
+			NewSnapshot->Fields.Add(Pair.Key, Pair.Value.Integrated);
+		}
+	}
+	FRWScopeLock Lock(SnapshotLock, SLT_Write);
+	Snapshot = NewSnapshot;
+}
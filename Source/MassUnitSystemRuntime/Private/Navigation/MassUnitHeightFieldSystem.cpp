@@ -0,0 +1,280 @@
+// Copyright Digi Logic Labs LLC. All Rights Reserved.
+
+#include "Navigation/MassUnitHeightFieldSystem.h"
+
+#include "Config/MassUnitSystemSettings.h"
+#include "Engine/World.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/ScopeRWLock.h"
+#include "NavigationData.h"
+#include "NavigationSystem.h"
+#include "Navigation/MassUnitNavigationSystem.h"
+
+bool FMassUnitHeightFieldSnapshot::SampleHeight(const FVector& Location, float& OutHeight, TSet<FIntVector>* OutMissingTiles) const
+{
+	if (CellSize <= 0.0f)
+	{
+		return false;
+	}
+
+	// Cell heights sit at cell centers; blend the four centers around Location.
+	const float GridX = Location.X / CellSize - 0.5f;
+	const float GridY = Location.Y / CellSize - 0.5f;
+	const FIntPoint BaseCell(FMath::FloorToInt(GridX), FMath::FloorToInt(GridY));
+	const float AlphaX = GridX - static_cast<float>(BaseCell.X);
+	const float AlphaY = GridY - static_cast<float>(BaseCell.Y);
+	const int32 HeightBand = ToHeightBand(Location.Z);
+	float Corners[4];
+	bool bAllValid = true;
+	for (int32 Corner = 0; Corner < 4; ++Corner)
+	{
+		bAllValid &= GetCellHeight(BaseCell + FIntPoint(Corner & 1, Corner >> 1), HeightBand, Corners[Corner], OutMissingTiles);
+	}
+	if (bAllValid)
+	{
+		OutHeight = FMath::BiLerp(Corners[0], Corners[1], Corners[2], Corners[3], AlphaX, AlphaY);
+		return true;
+	}
+
+	// At a ledge or the edge of the ground, hold the height of the cell the unit stands in.
+	const FIntPoint NearestCell(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+	return GetCellHeight(NearestCell, HeightBand, OutHeight, OutMissingTiles);
+}
+
+FIntVector FMassUnitHeightFieldSnapshot::ToTileKey(const FVector& Location) const
+{
+	const float TileSize = FMath::Max(CellSize, 1.0f) * UMassUnitHeightFieldSystem::TileCells;
+	return FIntVector(
+		FMath::FloorToInt(Location.X / TileSize),
+		FMath::FloorToInt(Location.Y / TileSize),
+		ToHeightBand(Location.Z));
+}
+
+bool FMassUnitHeightFieldSnapshot::GetCellHeight(
+	const FIntPoint& Cell,
+	int32 HeightBand,
+	float& OutHeight,
+	TSet<FIntVector>* OutMissingTiles) const
+{
+	constexpr int32 TileCells = UMassUnitHeightFieldSystem::TileCells;
+	const FIntVector TileKey(
+		FMath::FloorToInt(static_cast<float>(Cell.X) / TileCells),
+		FMath::FloorToInt(static_cast<float>(Cell.Y) / TileCells),
+		HeightBand);
+	const FTilePtr* Tile = Tiles.Find(TileKey);
+	if (!Tile)
+	{
+		if (OutMissingTiles)
+		{
+			OutMissingTiles->Add(TileKey);
+		}
+		return false;
+	}
+	const int32 LocalIndex = (Cell.Y - TileKey.Y * TileCells) * TileCells + (Cell.X - TileKey.X * TileCells);
+	if (!(*Tile)->Valid[LocalIndex])
+	{
+		return false;
+	}
+	OutHeight = (*Tile)->Heights[LocalIndex];
+	return true;
+}
+
+void UMassUnitHeightFieldSystem::Initialize(UWorld* InWorld, UMassUnitNavigationSystem* InNavigationSystem)
+{
+	World = InWorld;
+	NavigationSystem = InNavigationSystem;
+	const UMassUnitSystemSettings* Settings = GetDefault<UMassUnitSystemSettings>();
+	CellSize = Settings ? FMath::Max(0.0f, Settings->HeightFieldCellSize) : 100.0f;
+	ProjectionHeight = Settings ? FMath::Max(1.0f, Settings->FlowFieldProjectionHeight) : 250.0f;
+	Tiles.Empty(Settings ? FMath::Max(1, Settings->MaxHeightFieldTiles) : 1024);
+	TileBuildCount = 0;
+	PublishSnapshot();
+	if (NavigationSystem)
+	{
+		NavigationAreasRebuiltHandle = NavigationSystem->OnNavigationAreasRebuilt.AddUObject(
+			this,
+			&UMassUnitHeightFieldSystem::HandleNavigationAreasRebuilt);
+	}
+}
+
+void UMassUnitHeightFieldSystem::Deinitialize()
+{
+	if (NavigationSystem)
+	{
+		NavigationSystem->OnNavigationAreasRebuilt.Remove(NavigationAreasRebuiltHandle);
+	}
+	NavigationAreasRebuiltHandle.Reset();
+	ClearCache();
+	NavigationSystem = nullptr;
+	World = nullptr;
+}
+
+UMassUnitHeightFieldSystem::FSnapshotRef UMassUnitHeightFieldSystem::GetSnapshot() const
+{
+	FRWScopeLock Lock(SnapshotLock, SLT_ReadOnly);
+	return Snapshot;
+}
+
+void UMassUnitHeightFieldSystem::ReportTileUse(const TSet<FIntVector>& UsedTiles, const TSet<FIntVector>& MissingTiles)
+{
+	if (UsedTiles.IsEmpty() && MissingTiles.IsEmpty())
+	{
+		return;
+	}
+	FScopeLock Lock(&ReportLock);
+	ReportedUsedTiles.Append(UsedTiles);
+	ReportedMissingTiles.Append(MissingTiles);
+}
+
+void UMassUnitHeightFieldSystem::BuildRequestedTiles()
+{
+	check(IsInGameThread());
+	TSet<FIntVector> UsedTiles;
+	TSet<FIntVector> MissingTiles;
+	{
+		FScopeLock Lock(&ReportLock);
+		UsedTiles = MoveTemp(ReportedUsedTiles);
+		MissingTiles = MoveTemp(ReportedMissingTiles);
+		ReportedUsedTiles.Reset();
+		ReportedMissingTiles.Reset();
+	}
+	for (const FIntVector& TileKey : UsedTiles)
+	{
+		Tiles.FindAndTouch(TileKey);
+	}
+	if (MissingTiles.IsEmpty() || !World || CellSize <= 0.0f)
+	{
+		return;
+	}
+
+	// Tiles left over past the budget are reported again by the next pass
+	// that still needs them, so nothing queues up behind units that moved on.
+	int32 Built = 0;
+	for (const FIntVector& TileKey : MissingTiles)
+	{
+		if (Built >= MaxTileBuildsPerFrame)
+		{
+			break;
+		}
+		if (Tiles.Contains(TileKey))
+		{
+			continue;
+		}
+		if (Tiles.Num() >= Tiles.Max())
+		{
+			Tiles.RemoveLeastRecent();
+		}
+		Tiles.Add(TileKey, BuildTile(TileKey));
+		++Built;
+	}
+	if (Built > 0)
+	{
+		PublishSnapshot();
+	}
+}
+
+void UMassUnitHeightFieldSystem::ClearCache()
+{
+	Tiles.Empty(Tiles.Max());
+	PublishSnapshot();
+}
+
+void UMassUnitHeightFieldSystem::HandleNavigationAreasRebuilt(TConstArrayView<FBox> RebuiltAreas)
+{
+	// No areas means the rebuilt bounds are unknown. Dropped tiles rebuild as
+	// units report them missing again.
+	if (RebuiltAreas.IsEmpty())
+	{
+		ClearCache();
+		return;
+	}
+	// A tile covers the vertical range its cell projections and traces searched.
+	const float TileSize = CellSize * TileCells;
+	TArray<FIntVector, TInlineAllocator<16>> DroppedTiles;
+	for (TLruCache<FIntVector, FTilePtr>::TConstIterator It(Tiles); It; ++It)
+	{
+		const FIntVector& TileKey = It.Key();
+		const FVector TileMin(TileKey.X * TileSize, TileKey.Y * TileSize, (TileKey.Z * 2.0f - 0.5f) * ProjectionHeight);
+		const FBox TileBounds(TileMin, TileMin + FVector(TileSize, TileSize, ProjectionHeight * 3.0f));
+		for (const FBox& Area : RebuiltAreas)
+		{
+			if (Area.Intersect(TileBounds))
+			{
+				DroppedTiles.Add(TileKey);
+				break;
+			}
+		}
+	}
+	if (DroppedTiles.IsEmpty())
+	{
+		return;
+	}
+	for (const FIntVector& TileKey : DroppedTiles)
+	{
+		Tiles.Remove(TileKey);
+	}
+	PublishSnapshot();
+}
+
+void UMassUnitHeightFieldSystem::PublishSnapshot()
+{
+	// Tiles are shared, so a snapshot only copies their references; readers
+	// holding the previous snapshot keep it alive until their pass ends.
+	TSharedRef<FMassUnitHeightFieldSnapshot, ESPMode::ThreadSafe> NewSnapshot = MakeShared<FMassUnitHeightFieldSnapshot, ESPMode::ThreadSafe>();
+	NewSnapshot->CellSize = CellSize;
+	NewSnapshot->ProjectionHeight = ProjectionHeight;
+	NewSnapshot->Tiles.Reserve(Tiles.Num());
+	for (TLruCache<FIntVector, FTilePtr>::TConstIterator It(Tiles); It; ++It)
+	{
+		NewSnapshot->Tiles.Add(It.Key(), It.Value());
+	}
+	FRWScopeLock Lock(SnapshotLock, SLT_Write);
+	Snapshot = NewSnapshot;
+}
+
+UMassUnitHeightFieldSystem::FTilePtr UMassUnitHeightFieldSystem::BuildTile(const FIntVector& TileKey)
+{
+	++TileBuildCount;
+	UNavigationSystemV1* NavSys = NavigationSystem ? NavigationSystem->GetNavigationSystem() : nullptr;
+	ANavigationData* NavData = NavigationSystem ? NavigationSystem->GetNavigationData() : nullptr;
+
+	TSharedRef<FTile, ESPMode::ThreadSafe> Tile = MakeShared<FTile, ESPMode::ThreadSafe>();
+	Tile->Heights.SetNumZeroed(TileCells * TileCells);
+	Tile->Valid.SetNumZeroed(TileCells * TileCells);
+	// Bands overlap by half a band so ground near a band edge still resolves.
+	const float BandCenterZ = (static_cast<float>(TileKey.Z) + 0.5f) * ProjectionHeight * 2.0f;
+	const FVector Extent(CellSize * 0.5f, CellSize * 0.5f, ProjectionHeight * 1.5f);
+	const FCollisionObjectQueryParams GroundObjects(ECC_WorldStatic);
+	const FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(MassUnitHeightField), false);
+	for (int32 LocalY = 0; LocalY < TileCells; ++LocalY)
+	{
+		for (int32 LocalX = 0; LocalX < TileCells; ++LocalX)
+		{
+			const int32 LocalIndex = LocalY * TileCells + LocalX;
+			const FVector CellCenter(
+				(static_cast<float>(TileKey.X * TileCells + LocalX) + 0.5f) * CellSize,
+				(static_cast<float>(TileKey.Y * TileCells + LocalY) + 0.5f) * CellSize,
+				BandCenterZ);
+			FNavLocation Projected;
+			if (NavSys && NavData && NavSys->ProjectPointToNavigation(CellCenter, Projected, Extent, NavData))
+			{
+				Tile->Heights[LocalIndex] = Projected.Location.Z;
+				Tile->Valid[LocalIndex] = 1;
+				continue;
+			}
+			// Landscape and other static ground cover cells without navmesh, once per cell.
+			FHitResult Hit;
+			if (World->LineTraceSingleByObjectType(
+				Hit,
+				CellCenter + FVector(0.0f, 0.0f, Extent.Z),
+				CellCenter - FVector(0.0f, 0.0f, Extent.Z),
+				GroundObjects,
+				TraceParams))
+			{
+				Tile->Heights[LocalIndex] = Hit.ImpactPoint.Z;
+				Tile->Valid[LocalIndex] = 1;
+			}
+		}
+	}
+	return Tile;
+}
@@ -2,36 +2,90 @@
 
 #include "Navigation/MassUnitNavigationSystem.h"
 
+#include "Algo/Reverse.h"
 #include "Config/MassUnitSystemSettings.h"
 #include "Core/MassUnitSystemRuntime.h"
+#include "CoreGlobals.h"
+#include "Engine/World.h"
 #include "Entity/MassUnitFragments.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/PlatformTime.h"
 #include "MassEntityManager.h"
 #include "MassEntitySubsystem.h"
+#include "NavMesh/NavMeshPath.h"
+#include "NavMesh/RecastNavMesh.h"
 #include "NavigationData.h"
 #include "NavigationSystem.h"
 
+namespace
+{
+	// Winding order, so the opposite of direction D is (D + 4) % 8.
+	const FIntPoint ClusterDirections[8] = {
+		FIntPoint(1, 0), FIntPoint(1, 1), FIntPoint(0, 1), FIntPoint(-1, 1),
+		FIntPoint(-1, 0), FIntPoint(-1, -1), FIntPoint(0, -1), FIntPoint(1, -1)};
+}
+
 void UMassUnitNavigationSystem::Initialize(UWorld* InWorld, UMassEntitySubsystem* InEntitySubsystem)
 {
 	World = InWorld;
 	EntitySubsystem = InEntitySubsystem;
 	const UMassUnitSystemSettings* Settings = GetDefault<UMassUnitSystemSettings>();
 	MaxPathRequestsPerFrame = Settings ? FMath::Max(1, Settings->MaxPathRequestsPerFrame) : 100;
+	PathRequestBudgetSeconds = Settings ? FMath::Max(0.0f, Settings->PathRequestBudgetMs) * 0.001 : 0.001;
+	PathCoalesceCellSize = Settings ? FMath::Max(0.0f, Settings->PathCoalesceCellSize) : 500.0f;
+	HierarchicalPathDistance = Settings ? FMath::Max(0.0f, Settings->HierarchicalPathDistance) : 20000.0f;
+	PathClusterSize = Settings ? FMath::Max(1000.0f, Settings->PathClusterSize) : 5000.0f;
+	PathIndexCellSize = Settings ? FMath::Max(100.0f, Settings->RepathIndexCellSize) : 1000.0f;
+	PathCache.Empty(Settings ? FMath::Max(0, Settings->MaxCachedPaths) : 512);
+	PathCacheBytes = 0;
+	PathCacheHits = 0;
+	PathCacheMisses = 0;
+	CoalescedPathRequests = 0;
+	RepathsRequested = 0;
+	LatencySamples.Reset();
+	NextLatencySample = 0;
+	DeadlineMisses = 0;
+	BudgetExhaustedFrames = 0;
+	// Dirty areas are reported for every world; a foreign area only costs a few spurious repaths.
+	NavigationDirtyHandle = UNavigationSystemV1::NavigationDirtyEvent.AddUObject(
+		this,
+		&UMassUnitNavigationSystem::HandleNavigationDirty);
 	UpdateNavigationData(InWorld);
 }
 
 void UMassUnitNavigationSystem::Deinitialize()
 {
-	TArray<uint32> PendingPathIds;
-	PendingPathOwners.GenerateKeyArray(PendingPathIds);
-	PendingPathOwners.Reset();
 	if (NavigationSystem)
 	{
-		for (const uint32 PathId : PendingPathIds)
+		NavigationSystem->OnNavigationGenerationFinishedDelegate.RemoveDynamic(
+			this,
+			&UMassUnitNavigationSystem::HandleNavigationGenerationFinished);
+		for (const TPair<uint32, FPendingPath>& Pair : PendingPaths)
 		{
-			NavigationSystem->AbortAsyncFindPathRequest(PathId);
+			NavigationSystem->AbortAsyncFindPathRequest(Pair.Key);
+		}
+		for (const TPair<uint32, FPendingSharedPath>& Pair : PendingSharedPaths)
+		{
+			NavigationSystem->AbortAsyncFindPathRequest(Pair.Key);
 		}
 	}
-	PathRequestQueue.Reset();
+	PendingPaths.Reset();
+	PendingSharedPaths.Reset();
+	PendingPathIds.Reset();
+	PathRequestHeap.Empty();
+	QueuedRequestTickets.Reset();
+	ObserverLocations.Reset();
+	HierarchicalRoutes.Reset();
+	PathClusters.Reset();
+	ClearPathCache();
+	UNavigationSystemV1::NavigationDirtyEvent.Remove(NavigationDirtyHandle);
+	NavigationDirtyHandle.Reset();
+	IndexedPaths.Reset();
+	PathIndex.Reset();
+	DirtyAreas.Reset();
+	StalePaths.Empty();
+	OnNavigationAreasRebuilt.Clear();
 	NavigationData = nullptr;
 	NavigationSystem = nullptr;
 	EntitySubsystem = nullptr;
@@ -43,11 +97,199 @@ void UMassUnitNavigationSystem::UpdateNavigationData(UWorld* InWorld)
 	World = InWorld;
 	NavigationSystem = InWorld ? FNavigationSystem::GetCurrent<UNavigationSystemV1>(InWorld) : nullptr;
 	NavigationData = NavigationSystem ? NavigationSystem->GetDefaultNavDataInstance(FNavigationSystem::DontCreate) : nullptr;
+	if (NavigationSystem)
+	{
+		NavigationSystem->OnNavigationGenerationFinishedDelegate.AddUniqueDynamic(
+			this,
+			&UMassUnitNavigationSystem::HandleNavigationGenerationFinished);
+	}
+}
+
+void UMassUnitNavigationSystem::ClearPathCache()
+{
+	PathCache.Empty(PathCache.Max());
+	PathCacheBytes = 0;
 }
 
-bool UMassUnitNavigationSystem::RequestPath(FMassUnitHandle UnitHandle, const FVector& Destination, float AcceptanceRadius)
+void UMassUnitNavigationSystem::HandleNavigationGenerationFinished(ANavigationData* NavData)
 {
-	return RequestPathInternal(UnitHandle.EntityHandle, Destination, AcceptanceRadius);
+	// Rebuilt tiles reissue polygon references and may reroute corridors or
+	// open and close cluster links. Routes keep their waypoints; each refined
+	// window is queried against the new navmesh.
+	ClearPathCache();
+	InvalidatePathClusters();
+	if (!DirtyAreas.IsEmpty())
+	{
+		CollectStalePaths();
+	}
+	OnNavigationAreasRebuilt.Broadcast(DirtyAreas);
+	DirtyAreas.Reset();
+}
+
+void UMassUnitNavigationSystem::InvalidatePathClusters()
+{
+	if (PathClusters.IsEmpty())
+	{
+		return;
+	}
+	// A full rebuild reports no areas; nothing of the old graph can be trusted.
+	if (DirtyAreas.IsEmpty())
+	{
+		PathClusters.Reset();
+		return;
+	}
+
+	// Links are tested along paths that can leave both clusters, so clusters
+	// one cell beyond a rebuilt area are dropped as well.
+	TArray<FIntPoint, TInlineAllocator<64>> RemovedCells;
+	for (auto ClusterIt = PathClusters.CreateIterator(); ClusterIt; ++ClusterIt)
+	{
+		const FIntPoint& Cell = ClusterIt.Key();
+		for (const FBox& Area : DirtyAreas)
+		{
+			const FIntPoint MinCell = ToClusterCell(Area.Min) - FIntPoint(1, 1);
+			const FIntPoint MaxCell = ToClusterCell(Area.Max) + FIntPoint(1, 1);
+			if (Cell.X >= MinCell.X && Cell.X <= MaxCell.X && Cell.Y >= MinCell.Y && Cell.Y <= MaxCell.Y)
+			{
+				RemovedCells.Add(Cell);
+				ClusterIt.RemoveCurrent();
+				break;
+			}
+		}
+	}
+
+	// A surviving neighbor must test its link to a rebuilt cluster again.
+	for (const FIntPoint& Cell : RemovedCells)
+	{
+		for (int32 Direction = 0; Direction < UE_ARRAY_COUNT(ClusterDirections); ++Direction)
+		{
+			if (FPathCluster* Neighbor = PathClusters.Find(Cell + ClusterDirections[Direction]))
+			{
+				const uint8 ReverseLinkBit = 1 << ((Direction + 4) % UE_ARRAY_COUNT(ClusterDirections));
+				Neighbor->TestedLinks &= ~ReverseLinkBit;
+				Neighbor->OpenLinks &= ~ReverseLinkBit;
+			}
+		}
+	}
+}
+
+void UMassUnitNavigationSystem::HandleNavigationDirty(const FBox& DirtyBounds)
+{
+	if (!DirtyBounds.IsValid)
+	{
+		return;
+	}
+	// Many small areas between rebuilds collapse into their union.
+	if (DirtyAreas.Num() >= MaxDirtyAreas)
+	{
+		FBox Union(ForceInit);
+		for (const FBox& Area : DirtyAreas)
+		{
+			Union += Area;
+		}
+		DirtyAreas.Reset();
+		DirtyAreas.Add(Union);
+	}
+	DirtyAreas.Add(DirtyBounds);
+}
+
+void UMassUnitNavigationSystem::CollectStalePaths()
+{
+	if (IndexedPaths.IsEmpty() || !EntitySubsystem)
+	{
+		return;
+	}
+	const FMassEntityManager& EntityManager = EntitySubsystem->GetEntityManager();
+	TSet<FMassUnitEntityHandle> Collected;
+	for (const FBox& Area : DirtyAreas)
+	{
+		const FIntPoint MinCell = ToPathIndexCell(Area.Min);
+		const FIntPoint MaxCell = ToPathIndexCell(Area.Max);
+		for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; ++CellY)
+		{
+			for (int32 CellX = MinCell.X; CellX <= MaxCell.X; ++CellX)
+			{
+				TArray<FIndexedPathRef>* Refs = PathIndex.Find(FIntPoint(CellX, CellY));
+				if (!Refs)
+				{
+					continue;
+				}
+				for (const FIndexedPathRef& Ref : *Refs)
+				{
+					const FIndexedPath* Indexed = IndexedPaths.Find(Ref.Entity);
+					if (!Indexed || Indexed->Serial != Ref.Serial || Collected.Contains(Ref.Entity))
+					{
+						continue;
+					}
+					// Paths replaced outside this service (direct destinations, flow fields) drop out here.
+					const FMassUnitNavigationFragment* Navigation = IsEntityValid(Ref.Entity)
+						? EntityManager.GetFragmentDataPtr<FMassUnitNavigationFragment>(Ref.Entity.ToMassEntityHandle())
+						: nullptr;
+					if (!Navigation
+						|| !Navigation->bPathValid
+						|| !Navigation->bPathUsesNavmesh
+						|| Navigation->FlowFieldHandle != INDEX_NONE
+						|| !Navigation->DestinationLocation.Equals(Indexed->Destination, 1.0f))
+					{
+						if (!Navigation)
+						{
+							HierarchicalRoutes.Remove(Ref.Entity);
+						}
+						IndexedPaths.Remove(Ref.Entity);
+						continue;
+					}
+					Collected.Add(Ref.Entity);
+					StalePaths.Add(Ref);
+				}
+				// Every live path in this cell is now either queued for a repath or gone.
+				PathIndex.Remove(FIntPoint(CellX, CellY));
+			}
+		}
+	}
+}
+
+void UMassUnitNavigationSystem::RequeueStalePaths()
+{
+	// Time-sliced so one opened gate does not flood the queue ahead of new orders.
+	for (int32 Requeued = 0; Requeued < MaxRepathsPerFrame && !StalePaths.IsEmpty();)
+	{
+		const FIndexedPathRef Ref = StalePaths.PopFrontValue();
+		const FIndexedPath* Indexed = IndexedPaths.Find(Ref.Entity);
+		if (!Indexed
+			|| Indexed->Serial != Ref.Serial
+			|| QueuedRequestTickets.Contains(Ref.Entity)
+			|| PendingPathIds.Contains(Ref.Entity)
+			|| !IsEntityValid(Ref.Entity))
+		{
+			continue;
+		}
+		// A long route is replanned from its cluster graph; the unit keeps its
+		// current corridor until the new one lands.
+		FVector Destination = Indexed->Destination;
+		float AcceptanceRadius = Indexed->AcceptanceRadius;
+		EMassUnitPathPriority Priority = Indexed->Priority;
+		FHierarchicalRoute Route;
+		if (HierarchicalRoutes.RemoveAndCopyValue(Ref.Entity, Route))
+		{
+			Destination = Route.Destination;
+			AcceptanceRadius = Route.AcceptanceRadius;
+			Priority = Route.Priority;
+		}
+		IndexedPaths.Remove(Ref.Entity);
+		EnqueuePathRequest(Ref.Entity, Destination, AcceptanceRadius, Priority);
+		++RepathsRequested;
+		++Requeued;
+	}
+}
+
+bool UMassUnitNavigationSystem::RequestPath(
+	FMassUnitHandle UnitHandle,
+	const FVector& Destination,
+	float AcceptanceRadius,
+	EMassUnitPathPriority Priority,
+	float MaxLatency)
+{
+	return RequestPathInternal(UnitHandle.EntityHandle, Destination, AcceptanceRadius, Priority, MaxLatency);
 }
 
 bool UMassUnitNavigationSystem::CancelPath(FMassUnitHandle UnitHandle)
@@ -62,32 +304,201 @@ bool UMassUnitNavigationSystem::CancelPathInternal(FMassUnitEntityHandle Entity)
 		return false;
 	}
 
-	PathRequestQueue.RemoveAll([Entity](const FPathRequest& Existing) { return Existing.Entity == Entity; });
-	TArray<uint32> PendingPathIds;
-	for (const TPair<uint32, FMassUnitEntityHandle>& Pair : PendingPathOwners)
+	QueuedRequestTickets.Remove(Entity);
+	HierarchicalRoutes.Remove(Entity);
+	IndexedPaths.Remove(Entity);
+	AbortPendingPath(Entity);
+	CompactPathRequestHeap();
+
+	if (FMassUnitNavigationFragment* Navigation = EntitySubsystem->GetMutableEntityManager().GetFragmentDataPtr<FMassUnitNavigationFragment>(Entity.ToMassEntityHandle()))
 	{
-		if (Pair.Value == Entity)
-		{
-			PendingPathIds.Add(Pair.Key);
-		}
+		Navigation->ResetPath();
+	}
+	return true;
+}
+
+void UMassUnitNavigationSystem::CancelPathsInternal(TConstArrayView<FMassUnitEntityHandle> Entities)
+{
+	if (QueuedRequestTickets.IsEmpty() && PendingPathIds.IsEmpty() && HierarchicalRoutes.IsEmpty())
+	{
+		return;
+	}
+	for (const FMassUnitEntityHandle Entity : Entities)
+	{
+		QueuedRequestTickets.Remove(Entity);
+		HierarchicalRoutes.Remove(Entity);
+		AbortPendingPath(Entity);
+	}
+	CompactPathRequestHeap();
+}
+
+void UMassUnitNavigationSystem::ForgetUnitsInternal(TConstArrayView<FMassUnitEntityHandle> Entities)
+{
+	// Queue entries and index cells of these units go stale with their tickets
+	// and serials and are dropped when next visited.
+	for (const FMassUnitEntityHandle Entity : Entities)
+	{
+		QueuedRequestTickets.Remove(Entity);
+		HierarchicalRoutes.Remove(Entity);
+		IndexedPaths.Remove(Entity);
+		AbortPendingPath(Entity);
+	}
+	CompactPathRequestHeap();
+}
+
+void UMassUnitNavigationSystem::AbortPendingPath(FMassUnitEntityHandle Entity)
+{
+	uint32 PathId = 0;
+	if (!PendingPathIds.RemoveAndCopyValue(Entity, PathId))
+	{
+		return;
 	}
-	for (const uint32 PathId : PendingPathIds)
+	FPendingPath* PendingPath = PendingPaths.Find(PathId);
+	if (!PendingPath)
 	{
-		PendingPathOwners.Remove(PathId);
+		return;
+	}
+	PendingPath->Members.RemoveAllSwap([Entity](const FPathMember& Member) { return Member.Entity == Entity; });
+	// A coalesced query keeps running while any other member still waits on it.
+	if (PendingPath->Members.IsEmpty())
+	{
+		PendingPaths.Remove(PathId);
 		if (NavigationSystem)
 		{
 			NavigationSystem->AbortAsyncFindPathRequest(PathId);
 		}
 	}
+}
 
-	if (FMassUnitNavigationFragment* Navigation = EntitySubsystem->GetMutableEntityManager().GetFragmentDataPtr<FMassUnitNavigationFragment>(Entity.ToMassEntityHandle()))
+bool UMassUnitNavigationSystem::PopPathRequest(FPathRequest& OutRequest)
+{
+	while (!PathRequestHeap.IsEmpty())
 	{
-		Navigation->ResetPath();
+		PathRequestHeap.HeapPop(OutRequest, EAllowShrinking::No);
+		const uint32* Ticket = QueuedRequestTickets.Find(OutRequest.Entity);
+		if (Ticket && *Ticket == OutRequest.Ticket)
+		{
+			QueuedRequestTickets.Remove(OutRequest.Entity);
+			return true;
+		}
 	}
-	return true;
+	return false;
 }
 
-bool UMassUnitNavigationSystem::RequestPathInternal(FMassUnitEntityHandle Entity, const FVector& Destination, float AcceptanceRadius)
+void UMassUnitNavigationSystem::RequeuePathRequest(const FPathRequest& Request)
+{
+	// The target time is unchanged, so the request is still first in line next frame.
+	QueuedRequestTickets.Add(Request.Entity, Request.Ticket);
+	PathRequestHeap.HeapPush(Request);
+}
+
+void UMassUnitNavigationSystem::CompactPathRequestHeap()
+{
+	// Every live ticket has exactly one heap entry, so the rest are stale.
+	if (PathRequestHeap.Num() < MinHeapCompactionSize || PathRequestHeap.Num() <= QueuedRequestTickets.Num() * 2)
+	{
+		return;
+	}
+	PathRequestHeap.RemoveAllSwap([this](const FPathRequest& Request)
+	{
+		const uint32* Ticket = QueuedRequestTickets.Find(Request.Entity);
+		return !Ticket || *Ticket != Request.Ticket;
+	}, EAllowShrinking::No);
+	PathRequestHeap.Heapify();
+}
+
+double UMassUnitNavigationSystem::GetObserverWait(FMassUnitEntityHandle Entity)
+{
+	if (ObserverFrame != GFrameCounter)
+	{
+		ObserverFrame = GFrameCounter;
+		ObserverLocations.Reset();
+		if (World)
+		{
+			for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+			{
+				const APlayerController* Controller = It->Get();
+				if (!Controller)
+				{
+					continue;
+				}
+				if (const APawn* Pawn = Controller->GetPawn())
+				{
+					ObserverLocations.Add(Pawn->GetActorLocation());
+				}
+				else
+				{
+					FVector ViewLocation;
+					FRotator ViewRotation;
+					Controller->GetPlayerViewPoint(ViewLocation, ViewRotation);
+					ObserverLocations.Add(ViewLocation);
+				}
+			}
+		}
+	}
+	if (ObserverLocations.IsEmpty() || !EntitySubsystem)
+	{
+		return 0.0;
+	}
+	const FMassUnitTransformFragment* Transform = EntitySubsystem->GetEntityManager().GetFragmentDataPtr<FMassUnitTransformFragment>(Entity.ToMassEntityHandle());
+	if (!Transform)
+	{
+		return 0.0;
+	}
+	const FVector Location = Transform->GetTransform().GetLocation();
+	float NearestDistanceSquared = TNumericLimits<float>::Max();
+	for (const FVector& Observer : ObserverLocations)
+	{
+		NearestDistanceSquared = FMath::Min(NearestDistanceSquared, static_cast<float>(FVector::DistSquared(Location, Observer)));
+	}
+	return MaxObserverWaitSeconds * FMath::Min(1.0f, FMath::Sqrt(NearestDistanceSquared) / ObserverWaitDistance);
+}
+
+void UMassUnitNavigationSystem::RecordQueueLatency(const FPathRequest& Request, double Now)
+{
+	if (Request.Deadline > 0.0 && Now > Request.Deadline)
+	{
+		++DeadlineMisses;
+	}
+	const float Latency = static_cast<float>(Now - Request.EnqueueTime);
+	if (LatencySamples.Num() < MaxLatencySamples)
+	{
+		LatencySamples.Add(Latency);
+		return;
+	}
+	LatencySamples[NextLatencySample] = Latency;
+	NextLatencySample = (NextLatencySample + 1) % MaxLatencySamples;
+}
+
+FMassUnitPathQueueStats UMassUnitNavigationSystem::GetPathQueueStats() const
+{
+	FMassUnitPathQueueStats Stats;
+	Stats.SampleCount = LatencySamples.Num();
+	Stats.DeadlineMisses = DeadlineMisses;
+	Stats.BudgetExhaustedFrames = BudgetExhaustedFrames;
+	if (LatencySamples.IsEmpty())
+	{
+		return Stats;
+	}
+	TArray<float> Sorted = LatencySamples;
+	Sorted.Sort();
+	auto Percentile = [&Sorted](float Fraction)
+	{
+		const int32 Index = FMath::Clamp(FMath::CeilToInt(Fraction * Sorted.Num()) - 1, 0, Sorted.Num() - 1);
+		return Sorted[Index] * 1000.0f;
+	};
+	Stats.P50LatencyMs = Percentile(0.50f);
+	Stats.P95LatencyMs = Percentile(0.95f);
+	Stats.P99LatencyMs = Percentile(0.99f);
+	return Stats;
+}
+
+bool UMassUnitNavigationSystem::RequestPathInternal(
+	FMassUnitEntityHandle Entity,
+	const FVector& Destination,
+	float AcceptanceRadius,
+	EMassUnitPathPriority Priority,
+	float MaxLatency)
 {
 	if (!IsEntityValid(Entity))
 	{
@@ -108,6 +519,7 @@ bool UMassUnitNavigationSystem::RequestPathInternal(FMassUnitEntityHandle Entity
 	Navigation->bPathRequested = true;
 	Navigation->bPathValid = false;
 	Navigation->bPathUsesNavmesh = false;
+	Navigation->FlowFieldHandle = INDEX_NONE;
 	if (FMassUnitTargetFragment* Target = EntityManager.GetFragmentDataPtr<FMassUnitTargetFragment>(Entity.ToMassEntityHandle()))
 	{
 		Target->TargetEntity.Invalidate();
@@ -115,25 +527,37 @@ bool UMassUnitNavigationSystem::RequestPathInternal(FMassUnitEntityHandle Entity
 		Target->bHasTargetLocation = true;
 	}
 
-	PathRequestQueue.RemoveAll([Entity](const FPathRequest& Existing) { return Existing.Entity == Entity; });
-	TArray<uint32> SupersededPathIds;
-	for (const TPair<uint32, FMassUnitEntityHandle>& Pair : PendingPathOwners)
-	{
-		if (Pair.Value == Entity)
-		{
-			SupersededPathIds.Add(Pair.Key);
-		}
-	}
-	for (const uint32 PathId : SupersededPathIds)
+	HierarchicalRoutes.Remove(Entity);
+	IndexedPaths.Remove(Entity);
+	EnqueuePathRequest(Entity, Destination, Navigation->AcceptanceRadius, Priority, MaxLatency);
+	return true;
+}
+
+void UMassUnitNavigationSystem::EnqueuePathRequest(
+	FMassUnitEntityHandle Entity,
+	const FVector& Destination,
+	float AcceptanceRadius,
+	EMassUnitPathPriority Priority,
+	float MaxLatency)
+{
+	// Issuing a new ticket supersedes any queued request without searching for it.
+	AbortPendingPath(Entity);
+	const uint32 Ticket = ++NextRequestTicket;
+	QueuedRequestTickets.Add(Entity, Ticket);
+	const int32 Band = FMath::Clamp(static_cast<int32>(Priority), 0, NumPathPriorities - 1);
+
+	// Earliest target time first. Waiting lets older low-band work overtake
+	// newer high-band work, so no band starves; a deadline caps the wait.
+	FPathRequest Request{Entity, Destination, AcceptanceRadius, Ticket, static_cast<EMassUnitPathPriority>(Band)};
+	Request.EnqueueTime = FPlatformTime::Seconds();
+	Request.TargetTime = Request.EnqueueTime + BandWaitSeconds[Band] + GetObserverWait(Entity);
+	if (MaxLatency > 0.0f)
 	{
-		PendingPathOwners.Remove(PathId);
-		if (NavigationSystem)
-		{
-			NavigationSystem->AbortAsyncFindPathRequest(PathId);
-		}
+		Request.Deadline = Request.EnqueueTime + MaxLatency;
+		Request.TargetTime = FMath::Min(Request.TargetTime, Request.Deadline);
 	}
-	PathRequestQueue.Add({Entity, Destination, Navigation->AcceptanceRadius});
-	return true;
+	PathRequestHeap.HeapPush(Request);
+	CompactPathRequestHeap();
 }
 
 bool UMassUnitNavigationSystem::FindSharedPath(
@@ -151,72 +575,130 @@ bool UMassUnitNavigationSystem::FindSharedPath(
 	{
 		return false;
 	}
-	if (!NavigationSystem || !NavigationData)
-	{
-		UpdateNavigationData(World);
-	}
 
 	const UMassUnitSystemSettings* Settings = GetDefault<UMassUnitSystemSettings>();
 	const bool bUseDirectFallback = !Settings || Settings->bFallbackToDirectPath;
-	if (!NavigationSystem || !NavigationData)
+	FNavLocation ProjectedStart;
+	FNavLocation ProjectedDestination;
+	if (ProjectSharedPathEnds(Start, Destination, ProjectedStart, ProjectedDestination))
 	{
-		if (bUseDirectFallback)
+		FPathFindingQuery Query(nullptr, *NavigationData, ProjectedStart.Location, ProjectedDestination.Location);
+		const FPathFindingResult Result = NavigationSystem->FindPathSync(
+			FNavAgentProperties::DefaultProperties,
+			MoveTemp(Query));
+		if (Result.IsSuccessful() && Result.Path.IsValid())
 		{
-			OutPathPoints.Add(Destination);
-			return true;
+			for (const FNavPathPoint& Point : Result.Path->GetPathPoints())
+			{
+				OutPathPoints.Add(Point.Location);
+			}
+			if (!OutPathPoints.IsEmpty())
+			{
+				if (bOutUsesNavmesh)
+				{
+					*bOutUsesNavmesh = true;
+				}
+				return true;
+			}
 		}
-		return false;
 	}
 
-	FNavLocation ProjectedStart;
-	FNavLocation ProjectedDestination;
-	const FVector QueryExtent = NavigationData->GetDefaultQueryExtent();
-	const bool bProjectedStart = NavigationSystem->ProjectPointToNavigation(
-		Start,
-		ProjectedStart,
-		QueryExtent,
-		NavigationData);
-	const bool bProjectedDestination = NavigationSystem->ProjectPointToNavigation(
-		Destination,
-		ProjectedDestination,
-		QueryExtent,
-		NavigationData);
-	if (!bProjectedStart || !bProjectedDestination)
+	if (bUseDirectFallback)
 	{
-		if (bUseDirectFallback)
-		{
-			OutPathPoints.Add(Destination);
-			return true;
-		}
-		return false;
+		OutPathPoints.Add(Destination);
+		return true;
 	}
+	return false;
+}
 
-	FPathFindingQuery Query(nullptr, *NavigationData, ProjectedStart.Location, ProjectedDestination.Location);
-	const FPathFindingResult Result = NavigationSystem->FindPathSync(
-		FNavAgentProperties::DefaultProperties,
-		MoveTemp(Query));
-	if (Result.IsSuccessful() && Result.Path.IsValid())
+uint32 UMassUnitNavigationSystem::FindSharedPathAsync(
+	const FVector& Start,
+	const FVector& Destination,
+	FMassUnitSharedPathCallback&& OnComplete)
+{
+	if (!OnComplete)
 	{
-		for (const FNavPathPoint& Point : Result.Path->GetPathPoints())
-		{
-			OutPathPoints.Add(Point.Location);
-		}
-		if (!OutPathPoints.IsEmpty())
+		return 0;
+	}
+	if (World)
+	{
+		FNavLocation ProjectedStart;
+		FNavLocation ProjectedDestination;
+		if (ProjectSharedPathEnds(Start, Destination, ProjectedStart, ProjectedDestination))
 		{
-			if (bOutUsesNavmesh)
+			FPathFindingQuery Query(nullptr, *NavigationData, ProjectedStart.Location, ProjectedDestination.Location);
+			const FNavPathQueryDelegate Delegate = FNavPathQueryDelegate::CreateUObject(this, &UMassUnitNavigationSystem::HandleSharedPathComplete);
+			const uint32 QueryId = NavigationSystem->FindPathAsync(FNavAgentProperties::DefaultProperties, MoveTemp(Query), Delegate);
+			if (QueryId != INVALID_NAVQUERYID)
 			{
-				*bOutUsesNavmesh = true;
+				PendingSharedPaths.Add(QueryId, {Destination, MoveTemp(OnComplete)});
+				return QueryId;
 			}
-			return true;
 		}
 	}
 
-	if (bUseDirectFallback)
+	// Nothing to wait for; complete with the same result FindSharedPath would give.
+	const UMassUnitSystemSettings* Settings = GetDefault<UMassUnitSystemSettings>();
+	TArray<FVector> PathPoints;
+	if (World && (!Settings || Settings->bFallbackToDirectPath))
 	{
-		OutPathPoints.Add(Destination);
-		return true;
+		PathPoints.Add(Destination);
 	}
-	return false;
+	OnComplete(MoveTemp(PathPoints), false);
+	return 0;
+}
+
+void UMassUnitNavigationSystem::CancelSharedPath(uint32 QueryId)
+{
+	if (PendingSharedPaths.Remove(QueryId) > 0 && NavigationSystem)
+	{
+		NavigationSystem->AbortAsyncFindPathRequest(QueryId);
+	}
+}
+
+bool UMassUnitNavigationSystem::ProjectSharedPathEnds(
+	const FVector& Start,
+	const FVector& Destination,
+	FNavLocation& OutStart,
+	FNavLocation& OutDestination)
+{
+	if (!NavigationSystem || !NavigationData)
+	{
+		UpdateNavigationData(World);
+	}
+	if (!NavigationSystem || !NavigationData)
+	{
+		return false;
+	}
+
+	const FVector QueryExtent = NavigationData->GetDefaultQueryExtent();
+	return NavigationSystem->ProjectPointToNavigation(Start, OutStart, QueryExtent, NavigationData)
+		&& NavigationSystem->ProjectPointToNavigation(Destination, OutDestination, QueryExtent, NavigationData);
+}
+
+void UMassUnitNavigationSystem::HandleSharedPathComplete(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path)
+{
+	FPendingSharedPath PendingSharedPath;
+	if (!PendingSharedPaths.RemoveAndCopyValue(QueryId, PendingSharedPath))
+	{
+		return;
+	}
+
+	TArray<FVector> PathPoints;
+	if (Result == ENavigationQueryResult::Success && Path.IsValid())
+	{
+		for (const FNavPathPoint& Point : Path->GetPathPoints())
+		{
+			PathPoints.Add(Point.Location);
+		}
+	}
+	const bool bUsesNavmesh = !PathPoints.IsEmpty();
+	const UMassUnitSystemSettings* Settings = GetDefault<UMassUnitSystemSettings>();
+	if (!bUsesNavmesh && (!Settings || Settings->bFallbackToDirectPath))
+	{
+		PathPoints.Add(PendingSharedPath.Destination);
+	}
+	PendingSharedPath.OnComplete(MoveTemp(PathPoints), bUsesNavmesh);
 }
 
 bool UMassUnitNavigationSystem::ProjectPointToNavigation(
@@ -251,43 +733,79 @@ bool UMassUnitNavigationSystem::ProjectPointToNavigation(
 
 void UMassUnitNavigationSystem::ProcessPathRequests()
 {
-	if (PathRequestQueue.IsEmpty())
+	if (!StalePaths.IsEmpty())
+	{
+		RequeueStalePaths();
+	}
+	if (!HierarchicalRoutes.IsEmpty())
 	{
+		RefineHierarchicalRoutes();
+	}
+	if (QueuedRequestTickets.IsEmpty())
+	{
+		PathRequestHeap.Reset();
 		return;
 	}
 	if (!NavigationSystem || !NavigationData)
 	{
 		UpdateNavigationData(World);
 	}
+	ClusterLinkTestsThisFrame = 0;
 
-	const UMassUnitSystemSettings* Settings = GetDefault<UMassUnitSystemSettings>();
-	const bool bUseDirectFallback = !Settings || Settings->bFallbackToDirectPath;
-	const int32 RequestCount = FMath::Min(MaxPathRequestsPerFrame, PathRequestQueue.Num());
-	for (int32 Index = 0; Index < RequestCount; ++Index)
+	// Requests that start in the same coalescing cell and end on the same
+	// polygon share one query; every member keeps its own end points.
+	struct FQueryBatch
 	{
-		const FPathRequest Request = PathRequestQueue[0];
-		PathRequestQueue.RemoveAt(0, 1, EAllowShrinking::No);
+		FVector Start = FVector::ZeroVector;
+		FVector Destination = FVector::ZeroVector;
+		FPendingPath PendingPath;
+	};
+	TArray<FQueryBatch> Batches;
+	TMap<TPair<FIntVector, NavNodeRef>, int32> BatchByKey;
+	const int32 MaxServedRequests = MaxPathRequestsPerFrame * RequestsPerQuerySlot;
+	ServeStartTime = FPlatformTime::Seconds();
+	FPathRequest Request;
+	// Requests whose cluster route is deferred go back after the loop, so one
+	// long request never blocks the others and is not popped twice.
+	TArray<FPathRequest> DeferredRequests;
+	TArray<FVector> CachedInteriorPoints;
+	for (int32 Served = 0; Served < MaxServedRequests; ++Served)
+	{
+		// Projection and cache lookups dominate; stop once this frame's share is spent.
+		const double Now = FPlatformTime::Seconds();
+		if (Served > 0 && PathRequestBudgetSeconds > 0.0 && Now - ServeStartTime >= PathRequestBudgetSeconds)
+		{
+			++BudgetExhaustedFrames;
+			break;
+		}
+		if (!PopPathRequest(Request))
+		{
+			break;
+		}
+		if (Batches.Num() >= MaxPathRequestsPerFrame)
+		{
+			// Every query slot is taken; the request keeps its place for the next frame.
+			RequeuePathRequest(Request);
+			break;
+		}
 		if (!IsEntityValid(Request.Entity))
 		{
 			continue;
 		}
 
+		// Latency is sampled once per request, when it is resolved or handed
+		// to a query; a deferred request is sampled when it is finally served.
 		if (!NavigationSystem || !NavigationData)
 		{
-			if (bUseDirectFallback)
-			{
-				SetDirectPath(Request.Entity, Request.Destination, Request.AcceptanceRadius);
-			}
-			else
-			{
-				MarkPathFailed(Request.Entity);
-			}
+			RecordQueueLatency(Request, Now);
+			ResolveWithoutNavmesh(Request.Entity, Request.Destination, Request.AcceptanceRadius);
 			continue;
 		}
 
 		const FMassUnitTransformFragment* Transform = EntitySubsystem->GetEntityManager().GetFragmentDataPtr<FMassUnitTransformFragment>(Request.Entity.ToMassEntityHandle());
 		if (!Transform)
 		{
+			RecordQueueLatency(Request, Now);
 			MarkPathFailed(Request.Entity);
 			continue;
 		}
@@ -306,98 +824,617 @@ void UMassUnitNavigationSystem::ProcessPathRequests()
 			NavigationData);
 		if (!bProjectedStart || !bProjectedDestination)
 		{
-			if (bUseDirectFallback)
-			{
-				SetDirectPath(Request.Entity, Request.Destination, Request.AcceptanceRadius);
-			}
-			else
-			{
-				MarkPathFailed(Request.Entity);
-			}
+			RecordQueueLatency(Request, Now);
+			ResolveWithoutNavmesh(Request.Entity, Request.Destination, Request.AcceptanceRadius);
 			continue;
 		}
 
+		// A hierarchical route narrows the query to its next window; the
+		// fragments keep the ordered goal so gameplay never sees a window end.
+		const FVector FinalDestination = ProjectedDestination.Location;
+		if (!SelectRouteSegment(Request, ProjectedStart.Location, ProjectedDestination))
+		{
+			DeferredRequests.Add(Request);
+			continue;
+		}
+		RecordQueueLatency(Request, Now);
 		if (FMassUnitNavigationFragment* Navigation = EntitySubsystem->GetMutableEntityManager().GetFragmentDataPtr<FMassUnitNavigationFragment>(Request.Entity.ToMassEntityHandle()))
 		{
-			Navigation->DestinationLocation = ProjectedDestination.Location;
+			Navigation->DestinationLocation = FinalDestination;
 		}
 		if (FMassUnitTargetFragment* Target = EntitySubsystem->GetMutableEntityManager().GetFragmentDataPtr<FMassUnitTargetFragment>(Request.Entity.ToMassEntityHandle()))
 		{
-			Target->TargetLocation = ProjectedDestination.Location;
+			Target->TargetLocation = FinalDestination;
 		}
-		FPathFindingQuery Query(nullptr, *NavigationData, ProjectedStart.Location, ProjectedDestination.Location);
-		const FNavPathQueryDelegate Delegate = FNavPathQueryDelegate::CreateUObject(this, &UMassUnitNavigationSystem::HandlePathRequestComplete);
-		const uint32 PathId = NavigationSystem->FindPathAsync(FNavAgentProperties::DefaultProperties, MoveTemp(Query), Delegate);
-		if (PathId != INVALID_NAVQUERYID)
+		const FPathMember Member{Request.Entity, ProjectedStart.Location, ProjectedDestination.Location, FinalDestination, Request.AcceptanceRadius, Request.Priority};
+		if (PathCache.Max() > 0)
 		{
-			PendingPathOwners.Add(PathId, Request.Entity);
+			const FPathCacheKey Key{ProjectedStart.NodeRef, ProjectedDestination.NodeRef, NavigationData->GetUniqueID()};
+			const FCachedPath* CachedPath = PathCache.FindAndTouch(Key);
+			if (CachedPath && BuildCachedCorridor(*CachedPath, Member, CachedInteriorPoints))
+			{
+				++PathCacheHits;
+				ApplyCorridor(Member, CachedInteriorPoints);
+				continue;
+			}
 		}
-		else if (bUseDirectFallback)
+
+		int32 BatchIndex = INDEX_NONE;
+		const bool bCoalesce = PathCoalesceCellSize > 0.0f && ProjectedDestination.NodeRef != INVALID_NAVNODEREF;
+		const TPair<FIntVector, NavNodeRef> BatchKey(
+			FIntVector(
+				FMath::FloorToInt(ProjectedStart.Location.X / PathCoalesceCellSize),
+				FMath::FloorToInt(ProjectedStart.Location.Y / PathCoalesceCellSize),
+				FMath::FloorToInt(ProjectedStart.Location.Z / PathCoalesceCellSize)),
+			ProjectedDestination.NodeRef);
+		if (bCoalesce)
 		{
-			SetDirectPath(Request.Entity, Request.Destination, Request.AcceptanceRadius);
+			if (const int32* ExistingBatch = BatchByKey.Find(BatchKey))
+			{
+				BatchIndex = *ExistingBatch;
+			}
+		}
+		if (BatchIndex == INDEX_NONE)
+		{
+			BatchIndex = Batches.AddDefaulted();
+			Batches[BatchIndex].Start = ProjectedStart.Location;
+			Batches[BatchIndex].Destination = ProjectedDestination.Location;
+			if (bCoalesce)
+			{
+				BatchByKey.Add(BatchKey, BatchIndex);
+			}
 		}
 		else
 		{
-			MarkPathFailed(Request.Entity);
+			++CoalescedPathRequests;
+		}
+		Batches[BatchIndex].PendingPath.Members.Add(Member);
+		if (PathCache.Max() > 0)
+		{
+			++PathCacheMisses;
 		}
 	}
+
+	for (const FPathRequest& DeferredRequest : DeferredRequests)
+	{
+		RequeuePathRequest(DeferredRequest);
+	}
+	for (FQueryBatch& Batch : Batches)
+	{
+		DispatchPathQuery(Batch.Start, Batch.Destination, MoveTemp(Batch.PendingPath));
+	}
+}
+
+void UMassUnitNavigationSystem::DispatchPathQuery(const FVector& Start, const FVector& Destination, FPendingPath&& PendingPath)
+{
+	PendingPath.QueryStart = Start;
+	uint32 PathId = INVALID_NAVQUERYID;
+	if (NavigationSystem && NavigationData)
+	{
+		FPathFindingQuery Query(nullptr, *NavigationData, Start, Destination);
+		const FNavPathQueryDelegate Delegate = FNavPathQueryDelegate::CreateUObject(this, &UMassUnitNavigationSystem::HandlePathRequestComplete);
+		PathId = NavigationSystem->FindPathAsync(FNavAgentProperties::DefaultProperties, MoveTemp(Query), Delegate);
+	}
+	if (PathId != INVALID_NAVQUERYID)
+	{
+		for (const FPathMember& Member : PendingPath.Members)
+		{
+			PendingPathIds.Add(Member.Entity, PathId);
+		}
+		PendingPaths.Add(PathId, MoveTemp(PendingPath));
+		return;
+	}
+	for (const FPathMember& Member : PendingPath.Members)
+	{
+		ResolveWithoutNavmesh(Member.Entity, Member.FinalDestination, Member.AcceptanceRadius);
+	}
+}
+
+void UMassUnitNavigationSystem::DispatchMemberQuery(const FPathMember& Member)
+{
+	FPendingPath PendingPath;
+	PendingPath.Members.Add(Member);
+	DispatchPathQuery(Member.Start, Member.Destination, MoveTemp(PendingPath));
+}
+
+bool UMassUnitNavigationSystem::CanFollowCorridor(const FPathMember& Member, TConstArrayView<FVector> InteriorPoints) const
+{
+	if (!NavigationData)
+	{
+		return false;
+	}
+	// Interior corners are shared; only the unit's own entry and exit legs differ from the query's.
+	FVector HitLocation;
+	const FSharedConstNavQueryFilter Filter = NavigationData->GetDefaultQueryFilter();
+	if (InteriorPoints.IsEmpty())
+	{
+		return !NavigationData->Raycast(Member.Start, Member.Destination, HitLocation, Filter);
+	}
+	return !NavigationData->Raycast(Member.Start, InteriorPoints[0], HitLocation, Filter)
+		&& !NavigationData->Raycast(InteriorPoints.Last(), Member.Destination, HitLocation, Filter);
 }
 
 void UMassUnitNavigationSystem::HandlePathRequestComplete(uint32 PathId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path)
 {
-	FMassUnitEntityHandle Entity;
-	if (!PendingPathOwners.RemoveAndCopyValue(PathId, Entity) || !IsEntityValid(Entity))
+	FPendingPath PendingPath;
+	if (!PendingPaths.RemoveAndCopyValue(PathId, PendingPath))
 	{
 		return;
 	}
-	if (Result == ENavigationQueryResult::Success && Path.IsValid())
+
+	const bool bSucceeded = Result == ENavigationQueryResult::Success && Path.IsValid() && !Path->GetPathPoints().IsEmpty();
+	// A partial corridor ends where the navmesh stops short of the goal. It
+	// only holds for the query's own start, so it is neither cached nor shared.
+	const bool bPartial = bSucceeded && Path->IsPartial();
+	TArray<FVector> InteriorPoints;
+	FVector PartialEnd = FVector::ZeroVector;
+	if (bSucceeded)
+	{
+		const TArray<FNavPathPoint>& Points = Path->GetPathPoints();
+		InteriorPoints.Reserve(FMath::Max(0, Points.Num() - 2));
+		for (int32 PointIndex = 1; PointIndex < Points.Num() - 1; ++PointIndex)
+		{
+			InteriorPoints.Add(Points[PointIndex].Location);
+		}
+		PartialEnd = Points.Last().Location;
+		if (!bPartial)
+		{
+			CachePath(Path);
+		}
+	}
+
+	for (const FPathMember& Member : PendingPath.Members)
+	{
+		PendingPathIds.Remove(Member.Entity);
+		if (!IsEntityValid(Member.Entity))
+		{
+			continue;
+		}
+		if (!bSucceeded)
+		{
+			ResolveWithoutNavmesh(Member.Entity, Member.FinalDestination, Member.AcceptanceRadius);
+			continue;
+		}
+		// Coalesced members share a start cell, not a start polygon, so a wall
+		// can separate them from the corridor; those members query alone.
+		const bool bQueriedMember = Member.Start.Equals(PendingPath.QueryStart);
+		if (bPartial)
+		{
+			if (bQueriedMember)
+			{
+				ApplyCorridor(Member, InteriorPoints, &PartialEnd);
+			}
+			else
+			{
+				DispatchMemberQuery(Member);
+			}
+			continue;
+		}
+		if (bQueriedMember || CanFollowCorridor(Member, InteriorPoints))
+		{
+			ApplyCorridor(Member, InteriorPoints);
+		}
+		else
+		{
+			DispatchMemberQuery(Member);
+		}
+	}
+}
+
+void UMassUnitNavigationSystem::ApplyCorridor(const FPathMember& Member, TConstArrayView<FVector> InteriorPoints, const FVector* PartialEnd)
+{
+	if (!IsEntityValid(Member.Entity))
+	{
+		return;
+	}
+	FMassUnitNavigationFragment* Navigation = EntitySubsystem->GetMutableEntityManager().GetFragmentDataPtr<FMassUnitNavigationFragment>(Member.Entity.ToMassEntityHandle());
+	if (!Navigation)
 	{
-		UpdateEntityWithPath(Entity, Path);
 		return;
 	}
 
-	FMassUnitNavigationFragment* Navigation = EntitySubsystem->GetMutableEntityManager().GetFragmentDataPtr<FMassUnitNavigationFragment>(Entity.ToMassEntityHandle());
+	// Shared corners between the unit's own entry and exit points. A partial
+	// corridor stops at the end of the navmesh and a hierarchical window at its
+	// goal; the destination stays the ordered goal so a rebuild that connects
+	// it repaths the unit.
+	const FVector& End = PartialEnd ? *PartialEnd : Member.Destination;
+	Navigation->PathPoints.Reset(InteriorPoints.Num() + 2);
+	Navigation->PathPoints.Add(Member.Start);
+	Navigation->PathPoints.Append(InteriorPoints.GetData(), InteriorPoints.Num());
+	Navigation->PathPoints.Add(End);
+	Navigation->CurrentPathIndex = 0;
+	Navigation->FlowFieldHandle = INDEX_NONE;
+	Navigation->bPathRequested = false;
+	Navigation->bPathValid = true;
+	Navigation->bPathUsesNavmesh = true;
+	Navigation->DestinationLocation = Member.FinalDestination;
+	if (FMassUnitTargetFragment* Target = EntitySubsystem->GetMutableEntityManager().GetFragmentDataPtr<FMassUnitTargetFragment>(Member.Entity.ToMassEntityHandle()))
+	{
+		Target->TargetLocation = PartialEnd ? *PartialEnd : Member.FinalDestination;
+		Target->bHasTargetLocation = true;
+	}
+	IndexPath(Member, Navigation->PathPoints);
+}
+
+void UMassUnitNavigationSystem::IndexPath(const FPathMember& Member, TConstArrayView<FVector> PathPoints)
+{
+	FIndexedPath& Indexed = IndexedPaths.FindOrAdd(Member.Entity);
+	Indexed.Destination = Member.FinalDestination;
+	Indexed.AcceptanceRadius = Member.AcceptanceRadius;
+	Indexed.Priority = Member.Priority;
+	Indexed.Serial = ++NextIndexSerial;
+	const uint32 Serial = Indexed.Serial;
+
+	// Sample each segment at half-cell steps; a corridor corner rarely clips a
+	// cell corner, and a missed corner only delays that unit's repath.
+	TArray<FIntPoint, TInlineAllocator<32>> Cells;
+	const float Step = PathIndexCellSize * 0.5f;
+	for (int32 PointIndex = 0; PointIndex < PathPoints.Num(); ++PointIndex)
+	{
+		const FVector& SegmentStart = PathPoints[PointIndex];
+		const FVector& SegmentEnd = PathPoints[FMath::Min(PointIndex + 1, PathPoints.Num() - 1)];
+		const int32 Steps = FMath::CeilToInt(FVector::Dist2D(SegmentStart, SegmentEnd) / Step);
+		for (int32 StepIndex = 0; StepIndex <= Steps; ++StepIndex)
+		{
+			const FVector Sample = Steps > 0
+				? FMath::Lerp(SegmentStart, SegmentEnd, static_cast<float>(StepIndex) / static_cast<float>(Steps))
+				: SegmentStart;
+			Cells.AddUnique(ToPathIndexCell(Sample));
+		}
+	}
+
+	for (const FIntPoint& Cell : Cells)
+	{
+		TArray<FIndexedPathRef>& Refs = PathIndex.FindOrAdd(Cell);
+		// Superseded entries are not removed eagerly; prune them as the cell grows.
+		if (Refs.Num() >= 16 && FMath::IsPowerOfTwo(Refs.Num()))
+		{
+			Refs.RemoveAllSwap([this](const FIndexedPathRef& Ref)
+			{
+				const FIndexedPath* Current = IndexedPaths.Find(Ref.Entity);
+				if (Current && Current->Serial == Ref.Serial && !IsEntityValid(Ref.Entity))
+				{
+					HierarchicalRoutes.Remove(Ref.Entity);
+					IndexedPaths.Remove(Ref.Entity);
+					return true;
+				}
+				return !Current || Current->Serial != Ref.Serial;
+			});
+		}
+		Refs.Add({Member.Entity, Serial});
+	}
+}
+
+void UMassUnitNavigationSystem::ResolveWithoutNavmesh(FMassUnitEntityHandle Entity, const FVector& Destination, float AcceptanceRadius)
+{
+	HierarchicalRoutes.Remove(Entity);
 	const UMassUnitSystemSettings* Settings = GetDefault<UMassUnitSystemSettings>();
-	if (Navigation && (!Settings || Settings->bFallbackToDirectPath))
+	if (!Settings || Settings->bFallbackToDirectPath)
 	{
-		SetDirectPath(Entity, Navigation->DestinationLocation, Navigation->AcceptanceRadius);
+		SetDirectPath(Entity, Destination, AcceptanceRadius);
 	}
-	else if (Navigation)
+	else
 	{
 		MarkPathFailed(Entity);
 	}
 }
 
-void UMassUnitNavigationSystem::UpdateEntityWithPath(FMassUnitEntityHandle Entity, const FNavPathSharedPtr& Path)
+void UMassUnitNavigationSystem::CachePath(const FNavPathSharedPtr& Path)
 {
-	if (!IsEntityValid(Entity) || !Path.IsValid())
+	const FNavMeshPath* NavMeshPath = Path.IsValid() ? Path->CastPath<FNavMeshPath>() : nullptr;
+	if (PathCache.Max() <= 0 || !NavigationData || !NavMeshPath || NavMeshPath->PathCorridor.IsEmpty())
 	{
 		return;
 	}
-	FMassUnitNavigationFragment* Navigation = EntitySubsystem->GetMutableEntityManager().GetFragmentDataPtr<FMassUnitNavigationFragment>(Entity.ToMassEntityHandle());
-	if (!Navigation)
+	const FPathCacheKey Key{NavMeshPath->PathCorridor[0], NavMeshPath->PathCorridor.Last(), NavigationData->GetUniqueID()};
+	if (const FCachedPath* Existing = PathCache.Find(Key))
 	{
-		return;
+		PathCacheBytes -= GetCachedPathBytes(*Existing);
+		PathCache.Remove(Key);
+	}
+	else if (PathCache.Num() >= PathCache.Max())
+	{
+		PathCacheBytes -= GetCachedPathBytes(PathCache.RemoveLeastRecent());
 	}
 
-	Navigation->PathPoints.Reset();
-	for (const FNavPathPoint& Point : Path->GetPathPoints())
+	FCachedPath CachedPath;
+	CachedPath.Corridor = NavMeshPath->PathCorridor;
+	PathCacheBytes += GetCachedPathBytes(CachedPath);
+	PathCache.Add(Key, MoveTemp(CachedPath));
+}
+
+bool UMassUnitNavigationSystem::BuildCachedCorridor(
+	const FCachedPath& CachedPath,
+	const FPathMember& Member,
+	TArray<FVector>& OutInteriorPoints) const
+{
+	// Replaying the cached corners would let a new start in the same polygon
+	// cut a corner through a wall; pulling the string again through the same
+	// polygons gives the corners this start actually needs.
+	const ARecastNavMesh* NavMesh = Cast<ARecastNavMesh>(NavigationData);
+	TArray<FNavPathPoint> Points;
+	if (!NavMesh || !NavMesh->FindStraightPath(Member.Start, Member.Destination, CachedPath.Corridor, Points) || Points.Num() < 2)
 	{
-		Navigation->PathPoints.Add(Point.Location);
+		return false;
 	}
-	Navigation->CurrentPathIndex = Navigation->PathPoints.IsEmpty() ? INDEX_NONE : 0;
-	Navigation->bPathRequested = false;
-	Navigation->bPathValid = !Navigation->PathPoints.IsEmpty();
-	Navigation->bPathUsesNavmesh = Navigation->bPathValid;
-	if (Navigation->bPathValid)
+	OutInteriorPoints.Reset(Points.Num() - 2);
+	for (int32 PointIndex = 1; PointIndex < Points.Num() - 1; ++PointIndex)
+	{
+		OutInteriorPoints.Add(Points[PointIndex].Location);
+	}
+	return true;
+}
+
+int64 UMassUnitNavigationSystem::GetCachedPathBytes(const FCachedPath& CachedPath)
+{
+	return sizeof(FPathCacheKey) + sizeof(FCachedPath) + CachedPath.Corridor.GetAllocatedSize();
+}
+
+void UMassUnitNavigationSystem::RefineHierarchicalRoutes()
+{
+	for (auto RouteIt = HierarchicalRoutes.CreateIterator(); RouteIt; ++RouteIt)
+	{
+		const FMassUnitEntityHandle Entity = RouteIt.Key();
+		if (!IsEntityValid(Entity))
+		{
+			RouteIt.RemoveCurrent();
+			continue;
+		}
+		if (QueuedRequestTickets.Contains(Entity) || PendingPathIds.Contains(Entity))
+		{
+			continue;
+		}
+		const FMassUnitNavigationFragment* Navigation = EntitySubsystem->GetEntityManager().GetFragmentDataPtr<FMassUnitNavigationFragment>(Entity.ToMassEntityHandle());
+		if (!Navigation)
+		{
+			RouteIt.RemoveCurrent();
+			continue;
+		}
+		// Queue the next window once the unit is on the last leg of its refined
+		// corridor; it keeps following that corridor until the new one lands.
+		if (Navigation->bPathValid && Navigation->CurrentPathIndex < Navigation->PathPoints.Num() - 1)
+		{
+			continue;
+		}
+		const FHierarchicalRoute& Route = RouteIt.Value();
+		EnqueuePathRequest(Entity, Route.Destination, Route.AcceptanceRadius, Route.Priority);
+	}
+}
+
+bool UMassUnitNavigationSystem::SelectRouteSegment(const FPathRequest& Request, const FVector& Start, FNavLocation& InOutGoal)
+{
+	FHierarchicalRoute* Route = HierarchicalRoutes.Find(Request.Entity);
+	if (!Route)
+	{
+		if (HierarchicalPathDistance <= 0.0f || FVector::Dist2D(Start, InOutGoal.Location) <= HierarchicalPathDistance)
+		{
+			return true;
+		}
+		TArray<FVector> Waypoints;
+		const EClusterRouteResult Result = PlanClusterRoute(Start, InOutGoal.Location, Waypoints);
+		if (Result == EClusterRouteResult::Deferred)
+		{
+			return false;
+		}
+		if (Result == EClusterRouteResult::NotFound || Waypoints.Num() <= RefinedClusterCount)
+		{
+			return true;
+		}
+		Route = &HierarchicalRoutes.Add(Request.Entity);
+		Route->Waypoints = MoveTemp(Waypoints);
+		Route->Destination = Request.Destination;
+		Route->AcceptanceRadius = Request.AcceptanceRadius;
+		Route->Priority = Request.Priority;
+	}
+
+	// The final window heads for the goal itself and retires the route.
+	const int32 SegmentEnd = Route->NextWaypoint + RefinedClusterCount - 1;
+	FNavLocation SegmentGoal;
+	if (SegmentEnd >= Route->Waypoints.Num() - 1
+		|| !NavigationSystem->ProjectPointToNavigation(
+			Route->Waypoints[SegmentEnd],
+			SegmentGoal,
+			NavigationData->GetDefaultQueryExtent(),
+			NavigationData))
+	{
+		HierarchicalRoutes.Remove(Request.Entity);
+		return true;
+	}
+	Route->NextWaypoint = SegmentEnd + 1;
+	InOutGoal = SegmentGoal;
+	return true;
+}
+
+UMassUnitNavigationSystem::EClusterRouteResult UMassUnitNavigationSystem::PlanClusterRoute(
+	const FVector& Start,
+	const FVector& Goal,
+	TArray<FVector>& OutWaypoints)
+{
+	const FIntPoint StartCell = ToClusterCell(Start);
+	const FIntPoint GoalCell = ToClusterCell(Goal);
+	const FPathCluster* StartCluster = FindOrBuildCluster(StartCell, Start.Z);
+	const bool bStartWalkable = StartCluster && StartCluster->bWalkable;
+	const FPathCluster* GoalCluster = FindOrBuildCluster(GoalCell, Goal.Z);
+	if (!StartCluster || !GoalCluster)
+	{
+		return EClusterRouteResult::Deferred;
+	}
+	if (!bStartWalkable || !GoalCluster->bWalkable)
+	{
+		return EClusterRouteResult::NotFound;
+	}
+
+	struct FOpenCluster
+	{
+		FIntPoint Cell;
+		float Cost = 0.0f;
+		float Estimate = 0.0f;
+
+		bool operator<(const FOpenCluster& Other) const { return Estimate < Other.Estimate; }
+	};
+	auto Heuristic = [this, GoalCell](const FIntPoint& Cell)
+	{
+		return FVector2D(Cell - GoalCell).Size() * PathClusterSize;
+	};
+
+	TArray<FOpenCluster> Open;
+	TMap<FIntPoint, float> CostSoFar;
+	TMap<FIntPoint, FIntPoint> CameFrom;
+	Open.HeapPush({StartCell, 0.0f, Heuristic(StartCell)});
+	CostSoFar.Add(StartCell, 0.0f);
+	for (int32 Expansions = 0; !Open.IsEmpty() && Expansions < MaxClusterExpansions; ++Expansions)
+	{
+		FOpenCluster Current;
+		Open.HeapPop(Current);
+		if (Current.Cell == GoalCell)
+		{
+			// Start and goal clusters are covered by the unit's own entry and exit legs.
+			for (FIntPoint Cell = CameFrom.FindChecked(GoalCell); Cell != StartCell; Cell = CameFrom.FindChecked(Cell))
+			{
+				OutWaypoints.Add(PathClusters.FindChecked(Cell).Location);
+			}
+			Algo::Reverse(OutWaypoints);
+			return EClusterRouteResult::Found;
+		}
+		if (Current.Cost > CostSoFar.FindChecked(Current.Cell))
+		{
+			continue;
+		}
+
+		for (int32 Direction = 0; Direction < UE_ARRAY_COUNT(ClusterDirections); ++Direction)
+		{
+			bool bLinked = false;
+			if (!TryGetClusterLink(Current.Cell, Direction, PathClusters.FindChecked(Current.Cell).Location.Z, bLinked))
+			{
+				return EClusterRouteResult::Deferred;
+			}
+			if (!bLinked)
+			{
+				continue;
+			}
+			const FIntPoint Neighbor = Current.Cell + ClusterDirections[Direction];
+			const float Cost = Current.Cost + FVector::Dist(
+				PathClusters.FindChecked(Current.Cell).Location,
+				PathClusters.FindChecked(Neighbor).Location);
+			const float* KnownCost = CostSoFar.Find(Neighbor);
+			if (KnownCost && *KnownCost <= Cost)
+			{
+				continue;
+			}
+			CostSoFar.Add(Neighbor, Cost);
+			CameFrom.Add(Neighbor, Current.Cell);
+			Open.HeapPush({Neighbor, Cost, Cost + Heuristic(Neighbor)});
+		}
+	}
+	return EClusterRouteResult::NotFound;
+}
+
+bool UMassUnitNavigationSystem::TryGetClusterLink(const FIntPoint& Cell, int32 Direction, float ReferenceZ, bool& bOutLinked)
+{
+	const FIntPoint NeighborCell = Cell + ClusterDirections[Direction];
+	const uint8 LinkBit = 1 << Direction;
+	const uint8 ReverseLinkBit = 1 << ((Direction + 4) % UE_ARRAY_COUNT(ClusterDirections));
+	const FPathCluster* KnownCluster = PathClusters.Find(Cell);
+	if (KnownCluster && (KnownCluster->TestedLinks & LinkBit))
+	{
+		bOutLinked = (KnownCluster->OpenLinks & LinkBit) != 0;
+		return true;
+	}
+
+	// Build the neighbor first; adding to the map may move existing clusters.
+	const FPathCluster* NeighborCluster = FindOrBuildCluster(NeighborCell, ReferenceZ);
+	if (!NeighborCluster)
+	{
+		return false;
+	}
+	const FVector NeighborLocation = NeighborCluster->Location;
+	const bool bNeighborWalkable = NeighborCluster->bWalkable;
+	const FPathCluster* Cluster = FindOrBuildCluster(Cell, ReferenceZ);
+	if (!Cluster)
 	{
-		Navigation->DestinationLocation = Navigation->PathPoints.Last();
-		if (FMassUnitTargetFragment* Target = EntitySubsystem->GetMutableEntityManager().GetFragmentDataPtr<FMassUnitTargetFragment>(Entity.ToMassEntityHandle()))
+		return false;
+	}
+	bOutLinked = false;
+	if (Cluster->bWalkable && bNeighborWalkable)
+	{
+		if (!HasClusterBudget())
+		{
+			return false;
+		}
+		++ClusterLinkTestsThisFrame;
+		FVector HitLocation;
+		bOutLinked = !NavigationData->Raycast(Cluster->Location, NeighborLocation, HitLocation, NavigationData->GetDefaultQueryFilter());
+		if (!bOutLinked)
 		{
-			Target->TargetLocation = Navigation->DestinationLocation;
-			Target->bHasTargetLocation = true;
+			// A short detour around a local obstacle still links the clusters.
+			FPathFindingQuery Query(nullptr, *NavigationData, Cluster->Location, NeighborLocation);
+			Query.CostLimit = FVector::Dist(Cluster->Location, NeighborLocation) * 3.0f;
+			const FPathFindingResult Result = NavigationSystem->FindPathSync(FNavAgentProperties::DefaultProperties, MoveTemp(Query));
+			bOutLinked = Result.IsSuccessful() && Result.Path.IsValid() && !Result.Path->IsPartial();
 		}
 	}
+
+	FPathCluster& MutableCluster = PathClusters.FindChecked(Cell);
+	FPathCluster& MutableNeighbor = PathClusters.FindChecked(NeighborCell);
+	MutableCluster.TestedLinks |= LinkBit;
+	MutableNeighbor.TestedLinks |= ReverseLinkBit;
+	if (bOutLinked)
+	{
+		MutableCluster.OpenLinks |= LinkBit;
+		MutableNeighbor.OpenLinks |= ReverseLinkBit;
+	}
+	return true;
+}
+
+const UMassUnitNavigationSystem::FPathCluster* UMassUnitNavigationSystem::FindOrBuildCluster(const FIntPoint& Cell, float ReferenceZ)
+{
+	if (const FPathCluster* Existing = PathClusters.Find(Cell))
+	{
+		return Existing;
+	}
+	// Each projection searches a whole cluster's extent, so building shares the link-test budget.
+	if (!HasClusterBudget())
+	{
+		return nullptr;
+	}
+
+	FPathCluster& Cluster = PathClusters.Add(Cell);
+	const float HalfSize = PathClusterSize * 0.5f;
+	const FVector Center(
+		(static_cast<float>(Cell.X) + 0.5f) * PathClusterSize,
+		(static_cast<float>(Cell.Y) + 0.5f) * PathClusterSize,
+		ReferenceZ);
+	FNavLocation Projected;
+	Cluster.bWalkable = NavigationSystem->ProjectPointToNavigation(
+		Center,
+		Projected,
+		FVector(HalfSize, HalfSize, HalfSize),
+		NavigationData);
+	Cluster.Location = Projected.Location;
+	return &Cluster;
+}
+
+bool UMassUnitNavigationSystem::HasClusterBudget() const
+{
+	if (ClusterLinkTestsThisFrame >= MaxClusterLinkTestsPerFrame)
+	{
+		return false;
+	}
+	return PathRequestBudgetSeconds <= 0.0 || FPlatformTime::Seconds() - ServeStartTime < PathRequestBudgetSeconds;
+}
+
+FIntPoint UMassUnitNavigationSystem::ToClusterCell(const FVector& Location) const
+{
+	return FIntPoint(
+		FMath::FloorToInt(Location.X / PathClusterSize),
+		FMath::FloorToInt(Location.Y / PathClusterSize));
+}
+
+FIntPoint UMassUnitNavigationSystem::ToPathIndexCell(const FVector& Location) const
+{
+	return FIntPoint(
+		FMath::FloorToInt(Location.X / PathIndexCellSize),
+		FMath::FloorToInt(Location.Y / PathIndexCellSize));
 }
 
 bool UMassUnitNavigationSystem::SetDirectPath(FMassUnitEntityHandle Entity, const FVector& Destination, float AcceptanceRadius)
@@ -411,10 +1448,12 @@ bool UMassUnitNavigationSystem::SetDirectPath(FMassUnitEntityHandle Entity, cons
 	{
 		return false;
 	}
+	IndexedPaths.Remove(Entity);
 	Navigation->DestinationLocation = Destination;
 	Navigation->AcceptanceRadius = FMath::Max(1.0f, AcceptanceRadius);
 	Navigation->PathPoints = {Destination};
 	Navigation->CurrentPathIndex = 0;
+	Navigation->FlowFieldHandle = INDEX_NONE;
 	Navigation->bPathRequested = false;
 	Navigation->bPathValid = true;
 	Navigation->bPathUsesNavmesh = false;
@@ -427,13 +1466,10 @@ void UMassUnitNavigationSystem::MarkPathFailed(FMassUnitEntityHandle Entity)
 	{
 		return;
 	}
+	IndexedPaths.Remove(Entity);
 	if (FMassUnitNavigationFragment* Navigation = EntitySubsystem->GetMutableEntityManager().GetFragmentDataPtr<FMassUnitNavigationFragment>(Entity.ToMassEntityHandle()))
 	{
-		Navigation->PathPoints.Reset();
-		Navigation->CurrentPathIndex = INDEX_NONE;
-		Navigation->bPathRequested = false;
-		Navigation->bPathValid = false;
-		Navigation->bPathUsesNavmesh = false;
+		Navigation->ResetPath();
 	}
 }
 
@@ -0,0 +1,121 @@
+// Copyright Digi Logic Labs LLC. All Rights Reserved.
+
+#include "Visual/MassUnitVisualBuffers.h"
+
+void FMassUnitVisualBuffers::SetNum(int32 SlotCount)
+{
+	const int32 OldCount = Num();
+	if (SlotCount == OldCount)
+	{
+		return;
+	}
+	Positions.SetNumZeroed(SlotCount);
+	Velocities.SetNumZeroed(SlotCount);
+	Scales.SetNumZeroed(SlotCount);
+	Rotations.SetNum(SlotCount);
+	TeamColors.SetNumZeroed(SlotCount);
+	TeamIDs.SetNumZeroed(SlotCount);
+	AnimationIndices.SetNumZeroed(SlotCount);
+	AnimationTimes.SetNumZeroed(SlotCount);
+	LODLevels.SetNumZeroed(SlotCount);
+	VisibilityFlags.SetNumZeroed(SlotCount);
+	SlotRevisions.SetNumZeroed(SlotCount);
+	for (int32 Slot = OldCount; Slot < SlotCount; ++Slot)
+	{
+		Rotations[Slot] = FQuat::Identity;
+		SlotRevisions[Slot] = Revision;
+	}
+}
+
+void FMassUnitVisualBuffers::Reset()
+{
+	SetNum(0);
+	Revision = 1;
+}
+
+void FMassUnitVisualBuffers::Write(int32 Slot, const FSample& Sample)
+{
+	AnimationTimes[Slot] = Sample.AnimationTime;
+	if (VisibilityFlags[Slot] != 0.0f
+		&& Positions[Slot] == Sample.Position
+		&& Velocities[Slot] == Sample.Velocity
+		&& Scales[Slot] == Sample.Scale
+		&& Rotations[Slot] == Sample.Rotation
+		&& TeamColors[Slot] == Sample.TeamColor
+		&& TeamIDs[Slot] == Sample.TeamID
+		&& AnimationIndices[Slot] == Sample.AnimationIndex
+		&& LODLevels[Slot] == Sample.LODLevel)
+	{
+		return;
+	}
+	Positions[Slot] = Sample.Position;
+	Velocities[Slot] = Sample.Velocity;
+	Scales[Slot] = Sample.Scale;
+	Rotations[Slot] = Sample.Rotation;
+	TeamColors[Slot] = Sample.TeamColor;
+	TeamIDs[Slot] = Sample.TeamID;
+	AnimationIndices[Slot] = Sample.AnimationIndex;
+	LODLevels[Slot] = Sample.LODLevel;
+	VisibilityFlags[Slot] = 1.0f;
+	SlotRevisions[Slot] = Revision;
+}
+
+void FMassUnitVisualBuffers::Hide(int32 Slot)
+{
+	if (VisibilityFlags[Slot] != 0.0f)
+	{
+		VisibilityFlags[Slot] = 0.0f;
+		SlotRevisions[Slot] = Revision;
+	}
+}
+
+int32 FMassUnitVisualBuffers::CountChangedSince(uint32 SyncedRevision) const
+{
+	int32 ChangedCount = 0;
+	for (const uint32 SlotRevision : SlotRevisions)
+	{
+		ChangedCount += SlotRevision > SyncedRevision ? 1 : 0;
+	}
+	return ChangedCount;
+}
+
+int32 FMassUnitVisualBuffers::CopyToFrame(FMassUnitVisualFrame& Frame) const
+{
+	const int32 SlotCount = Num();
+	const bool bResized = Frame.Num() != SlotCount;
+	if (bResized)
+	{
+		Frame.Positions.SetNumUninitialized(SlotCount);
+		Frame.Velocities.SetNumUninitialized(SlotCount);
+		Frame.Scales.SetNumUninitialized(SlotCount);
+		Frame.Rotations.SetNumUninitialized(SlotCount);
+		Frame.TeamColors.SetNumUninitialized(SlotCount);
+		Frame.TeamIDs.SetNumUninitialized(SlotCount);
+		Frame.AnimationIndices.SetNumUninitialized(SlotCount);
+		Frame.AnimationTimes.SetNumUninitialized(SlotCount);
+		Frame.LODLevels.SetNumUninitialized(SlotCount);
+		Frame.VisibilityFlags.SetNumUninitialized(SlotCount);
+	}
+
+	int32 CopiedSlots = 0;
+	for (int32 Slot = 0; Slot < SlotCount; ++Slot)
+	{
+		if (!bResized && !HasChangedSince(Slot, Frame.Revision))
+		{
+			continue;
+		}
+		Frame.Positions[Slot] = FVector3f(Positions[Slot]);
+		Frame.Velocities[Slot] = FVector3f(Velocities[Slot]);
+		Frame.Scales[Slot] = FVector3f(Scales[Slot]);
+		Frame.Rotations[Slot] = FQuat4f(Rotations[Slot]);
+		Frame.TeamColors[Slot] = FVector3f(TeamColors[Slot]);
+		Frame.TeamIDs[Slot] = TeamIDs[Slot];
+		Frame.AnimationIndices[Slot] = AnimationIndices[Slot];
+		Frame.LODLevels[Slot] = LODLevels[Slot];
+		Frame.VisibilityFlags[Slot] = VisibilityFlags[Slot];
+		++CopiedSlots;
+	}
+	FMemory::Memcpy(Frame.AnimationTimes.GetData(), AnimationTimes.GetData(), SlotCount * sizeof(float));
+	Frame.Revision = Revision;
+	return CopiedSlots * (BytesPerSlot - static_cast<int32>(sizeof(float))) + SlotCount * static_cast<int32>(sizeof(float));
+}
@@ -0,0 +1,447 @@
+// Copyright Digi Logic Labs LLC. All Rights Reserved.
+
+#include "Visual/NiagaraDataInterfaceMassUnits.h"
+
+#include "Core/MassUnitSubsystem.h"
+#include "NiagaraCompileHashVisitor.h"
+#include "NiagaraGpuComputeDispatchInterface.h"
+#include "NiagaraShaderParametersBuilder.h"
+#include "NiagaraSystemInstance.h"
+#include "NiagaraTypes.h"
+#include "RenderGraphBuilder.h"
+#include "RenderingThread.h"
+#include "Visual/MassUnitVisualBuffers.h"
+#include "Visual/NiagaraUnitSystem.h"
+#include "VectorVM.h"
+
+namespace UE::MassUnitSystem::NiagaraMassUnits
+{
+	using FFrameRef = TSharedPtr<const FMassUnitVisualFrame, ESPMode::ThreadSafe>;
+
+	const FName GetNumUnitsName(TEXT("GetNumUnits"));
+	const FName GetUnitTransformName(TEXT("GetUnitTransform"));
+	const FName GetUnitVelocityName(TEXT("GetUnitVelocity"));
+	const FName GetUnitTeamName(TEXT("GetUnitTeam"));
+	const FName GetUnitAnimationName(TEXT("GetUnitAnimation"));
+
+	/** Bump when the generated HLSL changes so cached GPU scripts recompile. */
+	constexpr int32 ShaderVersion = 1;
+
+	/**
+	 * Layout of the UnitDataStride float4 elements per unit:
+	 * position + visibility, rotation, scale + team id, velocity + animation
+	 * index, team color + animation time, LOD level.
+	 */
+	constexpr int32 UnitDataStride = UNiagaraDataInterfaceMassUnits::UnitDataStride;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FShaderParameters, )
+		SHADER_PARAMETER(int32, NumUnits)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<float4>, UnitData)
+	END_SHADER_PARAMETER_STRUCT()
+
+	struct FInstanceData
+	{
+		TWeakObjectPtr<UNiagaraUnitSystem> Source;
+		FFrameRef Frame;
+	};
+
+	struct FRenderData
+	{
+		FFrameRef Frame;
+	};
+
+	struct FProxy : public FNiagaraDataInterfaceProxy
+	{
+		struct FInstanceData_RT
+		{
+			FFrameRef Frame;
+			TRefCountPtr<FRDGPooledBuffer> UnitData;
+			uint32 UploadedRevision = 0;
+			int32 NumUnits = 0;
+		};
+
+		TMap<FNiagaraSystemInstanceID, FInstanceData_RT> InstanceData_RT;
+
+		virtual int32 PerInstanceDataPassedToRenderThreadSize() const override { return sizeof(FRenderData); }
+
+		virtual void ConsumePerInstanceDataFromGameThread(void* PerInstanceData, const FNiagaraSystemInstanceID& Instance) override
+		{
+			FRenderData* RenderData = static_cast<FRenderData*>(PerInstanceData);
+			InstanceData_RT.FindOrAdd(Instance).Frame = MoveTemp(RenderData->Frame);
+			RenderData->~FRenderData();
+		}
+
+		virtual void PreStage(const FNDIGpuComputePreStageContext& Context) override
+		{
+			FInstanceData_RT* Instance = InstanceData_RT.Find(Context.GetSystemInstanceID());
+			if (!Instance || !Instance->Frame.IsValid())
+			{
+				return;
+			}
+			if (Instance->Frame->Revision == Instance->UploadedRevision)
+			{
+				Instance->Frame.Reset();
+				return;
+			}
+
+			const FMassUnitVisualFrame& Frame = *Instance->Frame;
+			const int32 NumElements = FMath::Max(1, Frame.Num()) * UnitDataStride;
+			FRDGBuilder& GraphBuilder = Context.GetGraphBuilder();
+			if (Instance->UnitData.IsValid() && Instance->UnitData->Desc.NumElements < static_cast<uint32>(NumElements))
+			{
+				Instance->UnitData.SafeRelease();
+			}
+			FRDGBufferRef UnitData = Instance->UnitData.IsValid()
+				? GraphBuilder.RegisterExternalBuffer(Instance->UnitData)
+				: GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateBufferDesc(sizeof(FVector4f), NumElements), TEXT("NiagaraMassUnits.UnitData"));
+
+			// The one copy on this path: the shared frame packed straight into graph upload memory.
+			FVector4f* Packed = GraphBuilder.AllocPODArray<FVector4f>(NumElements);
+			FMemory::Memzero(Packed, NumElements * sizeof(FVector4f));
+			for (int32 Unit = 0; Unit < Frame.Num(); ++Unit)
+			{
+				FVector4f* UnitElements = Packed + Unit * UnitDataStride;
+				UnitElements[0] = FVector4f(Frame.Positions[Unit], Frame.VisibilityFlags[Unit]);
+				UnitElements[1] = FVector4f(Frame.Rotations[Unit].X, Frame.Rotations[Unit].Y, Frame.Rotations[Unit].Z, Frame.Rotations[Unit].W);
+				UnitElements[2] = FVector4f(Frame.Scales[Unit], Frame.TeamIDs[Unit]);
+				UnitElements[3] = FVector4f(Frame.Velocities[Unit], Frame.AnimationIndices[Unit]);
+				UnitElements[4] = FVector4f(Frame.TeamColors[Unit], Frame.AnimationTimes[Unit]);
+				UnitElements[5] = FVector4f(Frame.LODLevels[Unit], 0.0f, 0.0f, 0.0f);
+			}
+			GraphBuilder.QueueBufferUpload(UnitData, Packed, NumElements * sizeof(FVector4f), ERDGInitialDataFlags::NoCopy);
+			if (!Instance->UnitData.IsValid())
+			{
+				Instance->UnitData = GraphBuilder.ConvertToExternalBuffer(UnitData);
+			}
+			Instance->NumUnits = Frame.Num();
+			Instance->UploadedRevision = Frame.Revision;
+			// Drop the reference once packed so the game thread can refill the frame.
+			Instance->Frame.Reset();
+		}
+	};
+
+	FNiagaraFunctionSignature MakeSignature(UClass* Class, FName Name)
+	{
+		FNiagaraFunctionSignature Signature;
+		Signature.Name = Name;
+		Signature.bMemberFunction = true;
+		Signature.bRequiresContext = false;
+		Signature.bSupportsCPU = true;
+		Signature.bSupportsGPU = true;
+		Signature.Inputs.Emplace(FNiagaraTypeDefinition(Class), TEXT("MassUnits"));
+		if (Name != GetNumUnitsName)
+		{
+			Signature.Inputs.Emplace(FNiagaraTypeDefinition::GetIntDef(), TEXT("Index"));
+		}
+		return Signature;
+	}
+
+	const FMassUnitVisualFrame* GetFrame(const FInstanceData* InstanceData)
+	{
+		return InstanceData && InstanceData->Frame.IsValid() ? InstanceData->Frame.Get() : nullptr;
+	}
+
+	void ResolveSource(FInstanceData& InstanceData, FNiagaraSystemInstance* SystemInstance)
+	{
+		if (InstanceData.Source.IsValid() || !SystemInstance)
+		{
+			return;
+		}
+		if (UMassUnitSubsystem* UnitSubsystem = UMassUnitSubsystem::Get(SystemInstance->GetWorld()))
+		{
+			if (UNiagaraUnitSystem* NiagaraSystem = UnitSubsystem->GetNiagaraSystem())
+			{
+				InstanceData.Source = NiagaraSystem;
+				NiagaraSystem->AddVisualFrameReader();
+			}
+		}
+	}
+}
+
+using namespace UE::MassUnitSystem::NiagaraMassUnits;
+
+UNiagaraDataInterfaceMassUnits::UNiagaraDataInterfaceMassUnits()
+{
+	Proxy.Reset(new FProxy());
+}
+
+void UNiagaraDataInterfaceMassUnits::PostInitProperties()
+{
+	Super::PostInitProperties();
+	if (HasAnyFlags(RF_ClassDefaultObject))
+	{
+		const ENiagaraTypeRegistryFlags Flags = ENiagaraTypeRegistryFlags::AllowAnyVariable | ENiagaraTypeRegistryFlags::AllowParameter;
+		FNiagaraTypeRegistry::Register(FNiagaraTypeDefinition(GetClass()), Flags);
+	}
+}
+
+int32 UNiagaraDataInterfaceMassUnits::PerInstanceDataSize() const
+{
+	return sizeof(FInstanceData);
+}
+
+bool UNiagaraDataInterfaceMassUnits::InitPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance)
+{
+	FInstanceData* InstanceData = new (PerInstanceData) FInstanceData();
+	ResolveSource(*InstanceData, SystemInstance);
+	return true;
+}
+
+void UNiagaraDataInterfaceMassUnits::DestroyPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance)
+{
+	FInstanceData* InstanceData = static_cast<FInstanceData*>(PerInstanceData);
+	if (UNiagaraUnitSystem* Source = InstanceData->Source.Get())
+	{
+		Source->RemoveVisualFrameReader();
+	}
+	InstanceData->~FInstanceData();
+
+	ENQUEUE_RENDER_COMMAND(RemoveMassUnitsInstance)(
+		[RT_Proxy = GetProxyAs<FProxy>(), InstanceID = SystemInstance->GetId()](FRHICommandListImmediate&)
+		{
+			RT_Proxy->InstanceData_RT.Remove(InstanceID);
+		});
+}
+
+bool UNiagaraDataInterfaceMassUnits::PerInstanceTick(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance, float DeltaSeconds)
+{
+	FInstanceData* InstanceData = static_cast<FInstanceData*>(PerInstanceData);
+	ResolveSource(*InstanceData, SystemInstance);
+	const UNiagaraUnitSystem* Source = InstanceData->Source.Get();
+	InstanceData->Frame = Source ? Source->GetPublishedVisualFrame() : nullptr;
+	return false;
+}
+
+void UNiagaraDataInterfaceMassUnits::ProvidePerInstanceDataForRenderThread(
+	void* DataForRenderThread,
+	void* PerInstanceData,
+	const FNiagaraSystemInstanceID& SystemInstance)
+{
+	const FInstanceData* InstanceData = static_cast<const FInstanceData*>(PerInstanceData);
+	new (DataForRenderThread) FRenderData{InstanceData->Frame};
+}
+
+#if WITH_EDITORONLY_DATA
+void UNiagaraDataInterfaceMassUnits::GetFunctionsInternal(TArray<FNiagaraFunctionSignature>& OutFunctions) const
+{
+	FNiagaraFunctionSignature& NumUnits = OutFunctions.Add_GetRef(MakeSignature(GetClass(), GetNumUnitsName));
+	NumUnits.Outputs.Emplace(FNiagaraTypeDefinition::GetIntDef(), TEXT("NumUnits"));
+
+	FNiagaraFunctionSignature& Transform = OutFunctions.Add_GetRef(MakeSignature(GetClass(), GetUnitTransformName));
+	Transform.Outputs.Emplace(FNiagaraTypeDefinition::GetVec3Def(), TEXT("Position"));
+	Transform.Outputs.Emplace(FNiagaraTypeDefinition::GetQuatDef(), TEXT("Rotation"));
+	Transform.Outputs.Emplace(FNiagaraTypeDefinition::GetVec3Def(), TEXT("Scale"));
+	Transform.Outputs.Emplace(FNiagaraTypeDefinition::GetBoolDef(), TEXT("Visible"));
+
+	FNiagaraFunctionSignature& Velocity = OutFunctions.Add_GetRef(MakeSignature(GetClass(), GetUnitVelocityName));
+	Velocity.Outputs.Emplace(FNiagaraTypeDefinition::GetVec3Def(), TEXT("Velocity"));
+
+	FNiagaraFunctionSignature& Team = OutFunctions.Add_GetRef(MakeSignature(GetClass(), GetUnitTeamName));
+	Team.Outputs.Emplace(FNiagaraTypeDefinition::GetIntDef(), TEXT("TeamID"));
+	Team.Outputs.Emplace(FNiagaraTypeDefinition::GetVec3Def(), TEXT("TeamColor"));
+
+	FNiagaraFunctionSignature& Animation = OutFunctions.Add_GetRef(MakeSignature(GetClass(), GetUnitAnimationName));
+	Animation.Outputs.Emplace(FNiagaraTypeDefinition::GetIntDef(), TEXT("AnimationIndex"));
+	Animation.Outputs.Emplace(FNiagaraTypeDefinition::GetFloatDef(), TEXT("AnimationTime"));
+	Animation.Outputs.Emplace(FNiagaraTypeDefinition::GetIntDef(), TEXT("LODLevel"));
+}
+
+bool UNiagaraDataInterfaceMassUnits::AppendCompileHash(FNiagaraCompileHashVisitor* InVisitor) const
+{
+	bool bSuccess = Super::AppendCompileHash(InVisitor);
+	bSuccess &= InVisitor->UpdatePOD(TEXT("NiagaraDataInterfaceMassUnitsVersion"), ShaderVersion);
+	return bSuccess;
+}
+
+void UNiagaraDataInterfaceMassUnits::GetParameterDefinitionHLSL(const FNiagaraDataInterfaceGPUParamInfo& ParamInfo, FString& OutHLSL)
+{
+	const FString& Symbol = ParamInfo.DataInterfaceHLSLSymbol;
+	OutHLSL += FString::Printf(TEXT("int %s_NumUnits;\n"), *Symbol);
+	OutHLSL += FString::Printf(TEXT("Buffer<float4> %s_UnitData;\n"), *Symbol);
+}
+
+bool UNiagaraDataInterfaceMassUnits::GetFunctionHLSL(
+	const FNiagaraDataInterfaceGPUParamInfo& ParamInfo,
+	const FNiagaraDataInterfaceGeneratedFunction& FunctionInfo,
+	int FunctionInstanceIndex,
+	FString& OutHLSL)
+{
+	const TCHAR* Symbol = *ParamInfo.DataInterfaceHLSLSymbol;
+	const TCHAR* Name = *FunctionInfo.InstanceName;
+	if (FunctionInfo.DefinitionName == GetNumUnitsName)
+	{
+		OutHLSL += FString::Printf(TEXT("void %s(out int OutNumUnits) { OutNumUnits = %s_NumUnits; }\n"), Name, Symbol);
+		return true;
+	}
+
+	// Out-of-range indices read zeroes, which also reports the unit as hidden.
+	auto ReadElement = [Symbol](int32 Offset)
+	{
+		return FString::Printf(
+			TEXT("(Index >= 0 && Index < %s_NumUnits ? %s_UnitData[Index * %d + %d] : float4(0, 0, 0, 0))"),
+			Symbol,
+			Symbol,
+			UnitDataStride,
+			Offset);
+	};
+	if (FunctionInfo.DefinitionName == GetUnitTransformName)
+	{
+		OutHLSL += FString::Printf(TEXT("void %s(int Index, out float3 OutPosition, out float4 OutRotation, out float3 OutScale, out bool OutVisible)\n{\n"), Name);
+		OutHLSL += FString::Printf(TEXT("\tfloat4 PositionData = %s;\n"), *ReadElement(0));
+		OutHLSL += TEXT("\tOutPosition = PositionData.xyz;\n\tOutVisible = PositionData.w > 0.5f;\n");
+		OutHLSL += FString::Printf(TEXT("\tOutRotation = %s;\n"), *ReadElement(1));
+		OutHLSL += FString::Printf(TEXT("\tOutScale = %s.xyz;\n}\n"), *ReadElement(2));
+		return true;
+	}
+	if (FunctionInfo.DefinitionName == GetUnitVelocityName)
+	{
+		OutHLSL += FString::Printf(TEXT("void %s(int Index, out float3 OutVelocity) { OutVelocity = %s.xyz; }\n"), Name, *ReadElement(3));
+		return true;
+	}
+	if (FunctionInfo.DefinitionName == GetUnitTeamName)
+	{
+		OutHLSL += FString::Printf(TEXT("void %s(int Index, out int OutTeamID, out float3 OutTeamColor)\n{\n"), Name);
+		OutHLSL += FString::Printf(TEXT("\tOutTeamID = (int)%s.w;\n"), *ReadElement(2));
+		OutHLSL += FString::Printf(TEXT("\tOutTeamColor = %s.xyz;\n}\n"), *ReadElement(4));
+		return true;
+	}
+	if (FunctionInfo.DefinitionName == GetUnitAnimationName)
+	{
+		OutHLSL += FString::Printf(TEXT("void %s(int Index, out int OutAnimationIndex, out float OutAnimationTime, out int OutLODLevel)\n{\n"), Name);
+		OutHLSL += FString::Printf(TEXT("\tOutAnimationIndex = (int)%s.w;\n"), *ReadElement(3));
+		OutHLSL += FString::Printf(TEXT("\tOutAnimationTime = %s.w;\n"), *ReadElement(4));
+		OutHLSL += FString::Printf(TEXT("\tOutLODLevel = (int)%s.x;\n}\n"), *ReadElement(5));
+		return true;
+	}
+	return false;
+}
+#endif
+
+void UNiagaraDataInterfaceMassUnits::BuildShaderParameters(FNiagaraShaderParametersBuilder& ShaderParametersBuilder) const
+{
+	ShaderParametersBuilder.AddNestedStruct<FShaderParameters>();
+}
+
+void UNiagaraDataInterfaceMassUnits::SetShaderParameters(const FNiagaraDataInterfaceSetShaderParametersContext& Context) const
+{
+	FProxy& DIProxy = Context.GetProxy<FProxy>();
+	FShaderParameters* Parameters = Context.GetParameterNestedStruct<FShaderParameters>();
+	FRDGBuilder& GraphBuilder = Context.GetGraphBuilder();
+	const FProxy::FInstanceData_RT* Instance = DIProxy.InstanceData_RT.Find(Context.GetSystemInstanceID());
+	if (Instance && Instance->UnitData.IsValid())
+	{
+		Parameters->NumUnits = Instance->NumUnits;
+		Parameters->UnitData = GraphBuilder.CreateSRV(GraphBuilder.RegisterExternalBuffer(Instance->UnitData), PF_A32B32G32R32F);
+	}
+	else
+	{
+		Parameters->NumUnits = 0;
+		Parameters->UnitData = Context.GetComputeDispatchInterface().GetEmptyBufferSRV(GraphBuilder, PF_A32B32G32R32F);
+	}
+}
+
+void UNiagaraDataInterfaceMassUnits::GetVMExternalFunction(
+	const FVMExternalFunctionBindingInfo& BindingInfo,
+	void* InstanceData,
+	FVMExternalFunction& OutFunc)
+{
+	if (BindingInfo.Name == GetNumUnitsName)
+	{
+		OutFunc = FVMExternalFunction::CreateUObject(this, &UNiagaraDataInterfaceMassUnits::VMGetNumUnits);
+	}
+	else if (BindingInfo.Name == GetUnitTransformName)
+	{
+		OutFunc = FVMExternalFunction::CreateUObject(this, &UNiagaraDataInterfaceMassUnits::VMGetUnitTransform);
+	}
+	else if (BindingInfo.Name == GetUnitVelocityName)
+	{
+		OutFunc = FVMExternalFunction::CreateUObject(this, &UNiagaraDataInterfaceMassUnits::VMGetUnitVelocity);
+	}
+	else if (BindingInfo.Name == GetUnitTeamName)
+	{
+		OutFunc = FVMExternalFunction::CreateUObject(this, &UNiagaraDataInterfaceMassUnits::VMGetUnitTeam);
+	}
+	else if (BindingInfo.Name == GetUnitAnimationName)
+	{
+		OutFunc = FVMExternalFunction::CreateUObject(this, &UNiagaraDataInterfaceMassUnits::VMGetUnitAnimation);
+	}
+}
+
+void UNiagaraDataInterfaceMassUnits::VMGetNumUnits(FVectorVMExternalFunctionContext& Context)
+{
+	VectorVM::FUserPtrHandler<FInstanceData> InstanceData(Context);
+	FNDIOutputParam<int32> OutNumUnits(Context);
+	const FMassUnitVisualFrame* Frame = GetFrame(InstanceData.Get());
+	const int32 NumUnits = Frame ? Frame->Num() : 0;
+	for (int32 Instance = 0; Instance < Context.GetNumInstances(); ++Instance)
+	{
+		OutNumUnits.SetAndAdvance(NumUnits);
+	}
+}
+
+void UNiagaraDataInterfaceMassUnits::VMGetUnitTransform(FVectorVMExternalFunctionContext& Context)
+{
+	VectorVM::FUserPtrHandler<FInstanceData> InstanceData(Context);
+	FNDIInputParam<int32> InIndex(Context);
+	FNDIOutputParam<FVector3f> OutPosition(Context);
+	FNDIOutputParam<FQuat4f> OutRotation(Context);
+	FNDIOutputParam<FVector3f> OutScale(Context);
+	FNDIOutputParam<bool> OutVisible(Context);
+	const FMassUnitVisualFrame* Frame = GetFrame(InstanceData.Get());
+	for (int32 Instance = 0; Instance < Context.GetNumInstances(); ++Instance)
+	{
+		const int32 Index = InIndex.GetAndAdvance();
+		const bool bValid = Frame && Frame->Positions.IsValidIndex(Index);
+		OutPosition.SetAndAdvance(bValid ? Frame->Positions[Index] : FVector3f::ZeroVector);
+		OutRotation.SetAndAdvance(bValid ? Frame->Rotations[Index] : FQuat4f::Identity);
+		OutScale.SetAndAdvance(bValid ? Frame->Scales[Index] : FVector3f::ZeroVector);
+		OutVisible.SetAndAdvance(bValid && Frame->VisibilityFlags[Index] > 0.5f);
+	}
+}
+
+void UNiagaraDataInterfaceMassUnits::VMGetUnitVelocity(FVectorVMExternalFunctionContext& Context)
+{
+	VectorVM::FUserPtrHandler<FInstanceData> InstanceData(Context);
+	FNDIInputParam<int32> InIndex(Context);
+	FNDIOutputParam<FVector3f> OutVelocity(Context);
+	const FMassUnitVisualFrame* Frame = GetFrame(InstanceData.Get());
+	for (int32 Instance = 0; Instance < Context.GetNumInstances(); ++Instance)
+	{
+		const int32 Index = InIndex.GetAndAdvance();
+		OutVelocity.SetAndAdvance(Frame && Frame->Velocities.IsValidIndex(Index) ? Frame->Velocities[Index] : FVector3f::ZeroVector);
+	}
+}
+
+void UNiagaraDataInterfaceMassUnits::VMGetUnitTeam(FVectorVMExternalFunctionContext& Context)
+{
+	VectorVM::FUserPtrHandler<FInstanceData> InstanceData(Context);
+	FNDIInputParam<int32> InIndex(Context);
+	FNDIOutputParam<int32> OutTeamID(Context);
+	FNDIOutputParam<FVector3f> OutTeamColor(Context);
+	const FMassUnitVisualFrame* Frame = GetFrame(InstanceData.Get());
+	for (int32 Instance = 0; Instance < Context.GetNumInstances(); ++Instance)
+	{
+		const int32 Index = InIndex.GetAndAdvance();
+		const bool bValid = Frame && Frame->TeamIDs.IsValidIndex(Index);
+		OutTeamID.SetAndAdvance(bValid ? static_cast<int32>(Frame->TeamIDs[Index]) : 0);
+		OutTeamColor.SetAndAdvance(bValid ? Frame->TeamColors[Index] : FVector3f::ZeroVector);
+	}
+}
+
+void UNiagaraDataInterfaceMassUnits::VMGetUnitAnimation(FVectorVMExternalFunctionContext& Context)
+{
+	VectorVM::FUserPtrHandler<FInstanceData> InstanceData(Context);
+	FNDIInputParam<int32> InIndex(Context);
+	FNDIOutputParam<int32> OutAnimationIndex(Context);
+	FNDIOutputParam<float> OutAnimationTime(Context);
+	FNDIOutputParam<int32> OutLODLevel(Context);
+	const FMassUnitVisualFrame* Frame = GetFrame(InstanceData.Get());
+	for (int32 Instance = 0; Instance < Context.GetNumInstances(); ++Instance)
+	{
+		const int32 Index = InIndex.GetAndAdvance();
+		const bool bValid = Frame && Frame->AnimationIndices.IsValidIndex(Index);
+		OutAnimationIndex.SetAndAdvance(bValid ? static_cast<int32>(Frame->AnimationIndices[Index]) : 0);
+		OutAnimationTime.SetAndAdvance(bValid ? Frame->AnimationTimes[Index] : 0.0f);
+		OutLODLevel.SetAndAdvance(bValid ? static_cast<int32>(Frame->LODLevels[Index]) : 0);
+	}
+}
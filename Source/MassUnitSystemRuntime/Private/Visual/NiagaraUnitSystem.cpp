@@ -5,37 +5,62 @@
 #include "Components/InstancedStaticMeshComponent.h"
 #include "Config/MassUnitSystemSettings.h"
 #include "Core/MassUnitSystemRuntime.h"
+#include "CoreGlobals.h"
 #include "Engine/StaticMesh.h"
+#include "Engine/Texture2D.h"
 #include "Engine/World.h"
 #include "Entity/MassUnitFragments.h"
+#include "HAL/PlatformTime.h"
 #include "MassEntityManager.h"
 #include "MassEntitySubsystem.h"
 #include "MassUnitCommonFragments.h"
+#include "Materials/MaterialInstanceDynamic.h"
 #include "NiagaraComponent.h"
+#include "NiagaraDataInterfaceArrayFloat.h"
 #include "NiagaraDataInterfaceArrayFunctionLibrary.h"
 #include "NiagaraFunctionLibrary.h"
 #include "NiagaraSystem.h"
+#include "Misc/ScopeLock.h"
+#include "Visual/NiagaraDataInterfaceMassUnits.h"
 #include "Visual/VertexAnimationManager.h"
 
-void UNiagaraUnitSystem::Initialize(UWorld* InWorld, UMassEntitySubsystem* InEntitySubsystem)
+void UNiagaraUnitSystem::Initialize(UWorld* InWorld, UMassEntitySubsystem* InEntitySubsystem, UMassUnitEntityManager* InUnitManager)
 {
 	World = InWorld;
 	EntitySubsystem = InEntitySubsystem;
+	UnitManager = InUnitManager;
 	InstancedMeshTopologyRevision = 0;
+	ObservedSlotReleaseCount = UnitManager ? UnitManager->GetRenderSlotReleaseCount() : 0;
+	UploadedSlotCount = INDEX_NONE;
 	const UMassUnitSystemSettings* Settings = GetDefault<UMassUnitSystemSettings>();
 	if (Settings)
 	{
 		MaxUnits = FMath::Max(1, Settings->MaxUnits);
 		UpdateFrequency = FMath::Max(0.0f, Settings->VisualUpdateInterval);
 		bEnableInstancedFallback = Settings->bEnableInstancedMeshFallback;
+		bUploadUnitArrays = Settings->bUploadNiagaraUnitArrays;
 		NiagaraSystemAsset = Settings->DefaultNiagaraSystem.LoadSynchronous();
 		FallbackStaticMesh = Settings->FallbackStaticMesh.LoadSynchronous();
+		ImpostorCardMesh = Settings->ImpostorCardMesh.LoadSynchronous();
 	}
 	if (!FallbackStaticMesh && bEnableInstancedFallback)
 	{
 		FallbackStaticMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
 	}
+	if (!ImpostorCardMesh && bEnableInstancedFallback)
+	{
+		ImpostorCardMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Plane.Plane"));
+	}
+	if (ImpostorCardMesh)
+	{
+		const FVector CardExtent = ImpostorCardMesh->GetBounds().BoxExtent;
+		ImpostorCardWidth = FMath::Max(UE_KINDA_SMALL_NUMBER, 2.0f * FMath::Max(CardExtent.X, CardExtent.Y));
+	}
 	CreateNiagaraSystem();
+	if (!NiagaraComponent && bEnableInstancedFallback)
+	{
+		CreateTeamPaletteTexture();
+	}
 	VertexAnimationManager = NewObject<UVertexAnimationManager>(this);
 	VertexAnimationManager->Initialize();
 }
@@ -46,11 +71,11 @@ void UNiagaraUnitSystem::Deinitialize()
 	{
 		NiagaraComponent->DestroyComponent();
 	}
-	for (const TPair<TObjectPtr<UStaticMesh>, TObjectPtr<UInstancedStaticMeshComponent>>& Pair : InstancedMeshComponents)
+	for (UInstancedStaticMeshComponent* Component : InstancedMeshComponents)
 	{
-		if (Pair.Value)
+		if (Component)
 		{
-			Pair.Value->DestroyComponent();
+			Component->DestroyComponent();
 		}
 	}
 	if (VertexAnimationManager)
@@ -58,11 +83,27 @@ void UNiagaraUnitSystem::Deinitialize()
 		VertexAnimationManager->Deinitialize();
 	}
 	InstancedMeshComponents.Reset();
+	InstancedMeshBatches.Reset();
+	InstanceSlots.Reset();
 	InstancedMeshTopologyRevision = 0;
+	TeamPaletteIndices.Reset();
+	TeamPaletteColors.Reset();
+	bTeamPaletteDirty = false;
+	TeamPaletteTexture = nullptr;
+	VisualBuffers.Reset();
+	PendingAnimationTextures.Reset();
+	UploadStats = FMassUnitVisualUploadStats();
+	bUnitArraysBound = false;
+	UploadedSlotCount = INDEX_NONE;
+	UploadedArrayRevision = 0;
+	VisualFrames[0].Reset();
+	VisualFrames[1].Reset();
 	VertexAnimationManager = nullptr;
 	NiagaraComponent = nullptr;
 	NiagaraSystemAsset = nullptr;
 	FallbackStaticMesh = nullptr;
+	ImpostorCardMesh = nullptr;
+	UnitManager = nullptr;
 	EntitySubsystem = nullptr;
 	World = nullptr;
 }
@@ -80,16 +121,11 @@ void UNiagaraUnitSystem::UpdateUnitVisualsByHandles(const TArray<FMassUnitHandle
 
 void UNiagaraUnitSystem::UpdateUnitVisuals(const TArray<FMassUnitEntityHandle>& Entities)
 {
-	if (!World || !EntitySubsystem)
+	if (!EntitySubsystem || !IsVisualUpdateDue())
 	{
 		return;
 	}
-	const float CurrentTime = World->GetTimeSeconds();
-	if (CurrentTime - LastUpdateTime < UpdateFrequency)
-	{
-		return;
-	}
-	LastUpdateTime = CurrentTime;
+	LastUpdateTime = World->GetTimeSeconds();
 	if (NiagaraComponent)
 	{
 		UpdateNiagaraData(Entities);
@@ -100,6 +136,76 @@ void UNiagaraUnitSystem::UpdateUnitVisuals(const TArray<FMassUnitEntityHandle>&
 	}
 }
 
+bool UNiagaraUnitSystem::PrepareVisualGather()
+{
+	if (!NiagaraComponent || !UnitManager || !IsVisualUpdateDue())
+	{
+		return false;
+	}
+	SyncVisualSlots();
+	return true;
+}
+
+void UNiagaraUnitSystem::SyncVisualSlots()
+{
+	const TConstArrayView<FMassUnitEntityHandle> SlotOwners = UnitManager->GetRenderSlotOwners();
+	VisualBuffers.SetNum(FMath::Min(SlotOwners.Num(), MaxUnits));
+	if (ObservedSlotReleaseCount != UnitManager->GetRenderSlotReleaseCount())
+	{
+		ObservedSlotReleaseCount = UnitManager->GetRenderSlotReleaseCount();
+		for (int32 Slot = 0; Slot < VisualBuffers.Num(); ++Slot)
+		{
+			if (!SlotOwners[Slot].IsValid())
+			{
+				VisualBuffers.Hide(Slot);
+			}
+		}
+	}
+}
+
+void UNiagaraUnitSystem::WriteVisualSample(
+	int32 Slot,
+	const FMassUnitTransformFragment& Transform,
+	const FMassUnitVelocityFragment& Velocity,
+	const FMassUnitVisualFragment& Visual,
+	const FMassUnitTeamFragment& Team,
+	const FMassUnitStateFragment& State)
+{
+	if (VisualBuffers.IsValidIndex(Slot))
+	{
+		StoreVisualSample(Slot, Transform, Velocity, Visual, Team, State, ResolveAnimationIndexDeferred(Visual, State));
+	}
+}
+
+void UNiagaraUnitSystem::FinishVisualGather(double GatherSeconds)
+{
+	if (VertexAnimationManager)
+	{
+		for (const TPair<FGameplayTag, UTexture2D*>& Pair : PendingAnimationTextures)
+		{
+			VertexAnimationManager->RegisterAnimationTexture(Pair.Key, Pair.Value);
+		}
+	}
+	PendingAnimationTextures.Reset();
+	LastGatherSeconds = GatherSeconds;
+	VisualGatherFrame = GFrameCounter;
+}
+
+TSharedPtr<const FMassUnitVisualFrame, ESPMode::ThreadSafe> UNiagaraUnitSystem::GetPublishedVisualFrame() const
+{
+	return VisualFrames[PublishedFrameIndex];
+}
+
+void UNiagaraUnitSystem::AddVisualFrameReader()
+{
+	++VisualFrameReaderCount;
+}
+
+void UNiagaraUnitSystem::RemoveVisualFrameReader()
+{
+	VisualFrameReaderCount = FMath::Max(0, VisualFrameReaderCount - 1);
+}
+
 void UNiagaraUnitSystem::SetLODLevel(int32 LODLevel)
 {
 	CurrentLODLevel = FMath::Max(0, LODLevel);
@@ -112,16 +218,31 @@ void UNiagaraUnitSystem::SetLODLevel(int32 LODLevel)
 int32 UNiagaraUnitSystem::GetInstancedMeshInstanceCount() const
 {
 	int32 InstanceCount = 0;
-	for (const TPair<TObjectPtr<UStaticMesh>, TObjectPtr<UInstancedStaticMeshComponent>>& Pair : InstancedMeshComponents)
+	for (const UInstancedStaticMeshComponent* Component : InstancedMeshComponents)
 	{
-		if (Pair.Value)
+		if (Component)
 		{
-			InstanceCount += Pair.Value->GetInstanceCount();
+			InstanceCount += Component->GetInstanceCount();
 		}
 	}
 	return InstanceCount;
 }
 
+int32 UNiagaraUnitSystem::GetImpostorInstanceCount() const
+{
+	int32 InstanceCount = 0;
+	for (const TPair<FInstancedMeshKey, FInstancedMeshBatch>& Pair : InstancedMeshBatches)
+	{
+		InstanceCount += Pair.Key.ImpostorMaterial ? Pair.Value.Owners.Num() : 0;
+	}
+	return InstanceCount;
+}
+
+bool UNiagaraUnitSystem::IsVisualUpdateDue() const
+{
+	return World && World->GetTimeSeconds() - LastUpdateTime >= UpdateFrequency;
+}
+
 void UNiagaraUnitSystem::CreateNiagaraSystem()
 {
 	if (!World || !NiagaraSystemAsset)
@@ -146,84 +267,156 @@ void UNiagaraUnitSystem::CreateNiagaraSystem()
 	{
 		NiagaraComponent->SetIntParameter(TEXT("MaxUnits"), MaxUnits);
 		NiagaraComponent->SetIntParameter(TEXT("LODLevel"), CurrentLODLevel);
+		// Systems that read the Mass Units data interface declare no Unit* arrays; skip the copies entirely.
+		bUnitArraysBound = bUploadUnitArrays
+			&& UNiagaraFunctionLibrary::GetDataInterface<UNiagaraDataInterfaceArrayFloat3>(NiagaraComponent, TEXT("UnitPositions")) != nullptr;
 	}
 }
 
 void UNiagaraUnitSystem::UpdateNiagaraData(const TArray<FMassUnitEntityHandle>& Entities)
 {
-	if (!NiagaraComponent || !EntitySubsystem)
+	if (!NiagaraComponent || !UnitManager)
 	{
 		return;
 	}
-	const FMassEntityManager& EntityManager = EntitySubsystem->GetEntityManager();
-	TArray<FVector> Positions;
-	TArray<FVector> Velocities;
-	TArray<FVector> Scales;
-	TArray<FQuat> Rotations;
-	TArray<FVector> TeamColors;
-	TArray<float> TeamIDs;
-	TArray<float> AnimationIndices;
-	TArray<float> AnimationTimes;
-	TArray<float> LODLevels;
-	TArray<float> VisibilityFlags;
-	const int32 Count = FMath::Min(MaxUnits, Entities.Num());
-	Positions.Reserve(Count);
-	Velocities.Reserve(Count);
-	Scales.Reserve(Count);
-	Rotations.Reserve(Count);
+	if (VisualGatherFrame != GFrameCounter)
+	{
+		// Direct calls and worlds without Mass processing gather on the game thread.
+		GatherVisualSamples(Entities);
+	}
+	UploadVisualBuffers();
+}
 
-	for (int32 Index = 0; Index < Count; ++Index)
+void UNiagaraUnitSystem::GatherVisualSamples(const TArray<FMassUnitEntityHandle>& Entities)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	SyncVisualSlots();
+	const FMassEntityManager& EntityManager = EntitySubsystem->GetEntityManager();
+	for (const FMassUnitEntityHandle& Entity : Entities)
 	{
-		const FMassEntityHandle NativeHandle = Entities[Index].ToMassEntityHandle();
+		const FMassEntityHandle NativeHandle = Entity.ToMassEntityHandle();
 		if (!EntityManager.IsEntityValid(NativeHandle))
 		{
 			continue;
 		}
+		const FMassUnitRenderSlotFragment* RenderSlot = EntityManager.GetFragmentDataPtr<FMassUnitRenderSlotFragment>(NativeHandle);
 		const FMassUnitTransformFragment* Transform = EntityManager.GetFragmentDataPtr<FMassUnitTransformFragment>(NativeHandle);
 		const FMassUnitVelocityFragment* Velocity = EntityManager.GetFragmentDataPtr<FMassUnitVelocityFragment>(NativeHandle);
 		const FMassUnitVisualFragment* Visual = EntityManager.GetFragmentDataPtr<FMassUnitVisualFragment>(NativeHandle);
 		const FMassUnitTeamFragment* Team = EntityManager.GetFragmentDataPtr<FMassUnitTeamFragment>(NativeHandle);
 		const FMassUnitStateFragment* State = EntityManager.GetFragmentDataPtr<FMassUnitStateFragment>(NativeHandle);
-		if (!Transform || !Velocity || !Visual || !Team || !State || !Visual->bIsVisible || Visual->bUseSkeletalMesh)
+		if (!RenderSlot || !VisualBuffers.IsValidIndex(RenderSlot->Slot) || !Transform || !Velocity || !Visual || !Team || !State)
 		{
 			continue;
 		}
+		StoreVisualSample(RenderSlot->Slot, *Transform, *Velocity, *Visual, *Team, *State, ResolveAnimationIndex(*Visual, *State));
+	}
+	FinishVisualGather(FPlatformTime::Seconds() - StartTime);
+}
 
-		const FTransform& UnitTransform = Transform->GetTransform();
-		Positions.Add(UnitTransform.GetLocation());
-		Velocities.Add(Velocity->Value);
-		Scales.Add(UnitTransform.GetScale3D());
-		Rotations.Add(UnitTransform.GetRotation());
-		TeamColors.Add(FVector(Team->TeamColor.R, Team->TeamColor.G, Team->TeamColor.B));
-		TeamIDs.Add(static_cast<float>(Team->TeamID));
-		AnimationIndices.Add(static_cast<float>(ResolveAnimationIndex(*Visual, *State)));
-		AnimationTimes.Add(State->StateTime);
-		LODLevels.Add(static_cast<float>(Visual->LODLevel));
-		VisibilityFlags.Add(1.0f);
-	}
-
-	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayVector(NiagaraComponent, TEXT("UnitPositions"), Positions);
-	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayVector(NiagaraComponent, TEXT("UnitVelocities"), Velocities);
-	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayVector(NiagaraComponent, TEXT("UnitScales"), Scales);
-	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayQuat(NiagaraComponent, TEXT("UnitRotations"), Rotations);
-	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayVector(NiagaraComponent, TEXT("UnitTeamColors"), TeamColors);
-	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayFloat(NiagaraComponent, TEXT("UnitTeamIDs"), TeamIDs);
-	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayFloat(NiagaraComponent, TEXT("UnitAnimationIndices"), AnimationIndices);
-	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayFloat(NiagaraComponent, TEXT("UnitAnimationTimes"), AnimationTimes);
-	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayFloat(NiagaraComponent, TEXT("UnitLODLevels"), LODLevels);
-	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayFloat(NiagaraComponent, TEXT("UnitVisibilityFlags"), VisibilityFlags);
-	NiagaraComponent->SetIntParameter(TEXT("UnitCount"), Positions.Num());
+void UNiagaraUnitSystem::StoreVisualSample(
+	int32 Slot,
+	const FMassUnitTransformFragment& Transform,
+	const FMassUnitVelocityFragment& Velocity,
+	const FMassUnitVisualFragment& Visual,
+	const FMassUnitTeamFragment& Team,
+	const FMassUnitStateFragment& State,
+	int32 AnimationIndex)
+{
+	if (!Visual.bIsVisible || Visual.bUseSkeletalMesh)
+	{
+		VisualBuffers.Hide(Slot);
+		return;
+	}
+	const FTransform& UnitTransform = Transform.GetTransform();
+	FMassUnitVisualBuffers::FSample Sample;
+	Sample.Position = UnitTransform.GetLocation();
+	Sample.Velocity = Velocity.Value;
+	Sample.Scale = UnitTransform.GetScale3D();
+	Sample.Rotation = UnitTransform.GetRotation();
+	Sample.TeamColor = FVector(Team.TeamColor.R, Team.TeamColor.G, Team.TeamColor.B);
+	Sample.TeamID = static_cast<float>(Team.TeamID);
+	Sample.AnimationIndex = static_cast<float>(AnimationIndex);
+	Sample.AnimationTime = State.StateTime;
+	Sample.LODLevel = static_cast<float>(Visual.LODLevel);
+	VisualBuffers.Write(Slot, Sample);
+}
+
+void UNiagaraUnitSystem::UploadVisualBuffers()
+{
+	const int32 SlotCount = VisualBuffers.Num();
+	UploadStats.DirtySlots = VisualBuffers.CountChangedSince(VisualBuffers.GetRevision() - 1);
+	UploadStats.SlotCount = SlotCount;
+	UploadStats.GatherMs = static_cast<float>(LastGatherSeconds * 1000.0);
+	UploadStats.UploadBytes = 0;
+	if (bUnitArraysBound)
+	{
+		UploadStats.UploadBytes += UploadUnitArrays();
+	}
+	if (VisualFrameReaderCount > 0)
+	{
+		UploadStats.UploadBytes += PublishVisualFrame();
+	}
+	VisualBuffers.AdvanceRevision();
+}
+
+int32 UNiagaraUnitSystem::UploadUnitArrays()
+{
+	// An array data interface re-sends the whole array whenever any element is
+	// set, so per-slot writes cost the same upload plus a parameter lookup per
+	// value. The arrays go up whole, and only when a slot changed.
+	const int32 SlotCount = VisualBuffers.Num();
+	int32 UploadBytes = 0;
+	if (SlotCount != UploadedSlotCount || VisualBuffers.CountChangedSince(UploadedArrayRevision) > 0)
+	{
+		UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayVector(NiagaraComponent, TEXT("UnitPositions"), VisualBuffers.Positions);
+		UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayVector(NiagaraComponent, TEXT("UnitVelocities"), VisualBuffers.Velocities);
+		UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayVector(NiagaraComponent, TEXT("UnitScales"), VisualBuffers.Scales);
+		UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayQuat(NiagaraComponent, TEXT("UnitRotations"), VisualBuffers.Rotations);
+		UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayVector(NiagaraComponent, TEXT("UnitTeamColors"), VisualBuffers.TeamColors);
+		UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayFloat(NiagaraComponent, TEXT("UnitTeamIDs"), VisualBuffers.TeamIDs);
+		UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayFloat(NiagaraComponent, TEXT("UnitAnimationIndices"), VisualBuffers.AnimationIndices);
+		UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayFloat(NiagaraComponent, TEXT("UnitLODLevels"), VisualBuffers.LODLevels);
+		UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayFloat(NiagaraComponent, TEXT("UnitVisibilityFlags"), VisualBuffers.VisibilityFlags);
+		UploadBytes += SlotCount * (FMassUnitVisualBuffers::BytesPerSlot - static_cast<int32>(sizeof(float)));
+		if (SlotCount != UploadedSlotCount)
+		{
+			NiagaraComponent->SetIntParameter(TEXT("UnitCount"), SlotCount);
+			UploadedSlotCount = SlotCount;
+		}
+	}
+	// Animation clocks advance every frame for every unit.
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayFloat(NiagaraComponent, TEXT("UnitAnimationTimes"), VisualBuffers.AnimationTimes);
+	UploadBytes += SlotCount * static_cast<int32>(sizeof(float));
+	UploadedArrayRevision = VisualBuffers.GetRevision();
+	return UploadBytes;
+}
+
+int32 UNiagaraUnitSystem::PublishVisualFrame()
+{
+	// Refill the frame readers released last; one still held by a reader is replaced instead.
+	const int32 BackFrameIndex = 1 - PublishedFrameIndex;
+	TSharedPtr<FMassUnitVisualFrame, ESPMode::ThreadSafe>& BackFrame = VisualFrames[BackFrameIndex];
+	if (!BackFrame.IsValid() || !BackFrame.IsUnique())
+	{
+		BackFrame = MakeShared<FMassUnitVisualFrame, ESPMode::ThreadSafe>();
+	}
+	VisualBuffers.CopyToFrame(*BackFrame);
+	PublishedFrameIndex = BackFrameIndex;
+	// The render thread packs every newer frame into one buffer, whole.
+	return BackFrame->Num() * UNiagaraDataInterfaceMassUnits::UnitDataStride * static_cast<int32>(sizeof(FVector4f));
 }
 
 void UNiagaraUnitSystem::UpdateInstancedMeshData(const TArray<FMassUnitEntityHandle>& Entities)
 {
-	if (!EntitySubsystem)
+	if (!EntitySubsystem || !World)
 	{
 		return;
 	}
 	const FMassEntityManager& EntityManager = EntitySubsystem->GetEntityManager();
-	TMap<UStaticMesh*, TArray<FTransform>> InstancesByMesh;
-	TMap<UStaticMesh*, TArray<float>> CustomDataByMesh;
+	// Kept in double: a float clock loses the start-phase tolerance after about a day of uptime.
+	const double CurrentTime = World->GetTimeSeconds();
+	++InstanceUpdateStamp;
 	const int32 Count = FMath::Min(MaxUnits, Entities.Num());
 	for (int32 Index = 0; Index < Count; ++Index)
 	{
@@ -240,77 +433,185 @@ void UNiagaraUnitSystem::UpdateInstancedMeshData(const TArray<FMassUnitEntityHan
 		{
 			continue;
 		}
-		UStaticMesh* Mesh = Visual->StaticMesh ? Visual->StaticMesh.Get() : FallbackStaticMesh.Get();
-		if (Mesh)
+		const FInstancedMeshKey Bucket = ResolveInstancedMeshBucket(*Visual);
+		if (!Bucket.Mesh)
+		{
+			continue;
+		}
+		// The animation start phase stays fixed while a state plays, so custom data
+		// only changes with the animation, LOD, team, or a health step.
+		const float CustomData[InstancedCustomDataFloatCount] = {
+			UE::MassUnitSystem::InstanceData::Pack(
+				ResolveAnimationIndex(*Visual, *State),
+				Visual->LODLevel,
+				ResolveTeamPaletteIndex(*Team),
+				State->MaxHealth > UE_SMALL_NUMBER ? State->Health / State->MaxHealth : 0.0f),
+			UE::MassUnitSystem::InstanceData::PackStartPhase(CurrentTime - State->StateTime)
+		};
+		FTransform InstanceTransform = Transform->GetTransform();
+		if (Bucket.ImpostorMaterial)
 		{
-			InstancesByMesh.FindOrAdd(Mesh).Add(Transform->GetTransform());
-			TArray<float>& CustomData = CustomDataByMesh.FindOrAdd(Mesh);
-			CustomData.Reserve(InstancesByMesh[Mesh].Num() * InstancedCustomDataFloatCount);
-			CustomData.Add(static_cast<float>(ResolveAnimationIndex(*Visual, *State)));
-			CustomData.Add(State->StateTime);
-			CustomData.Add(static_cast<float>(Visual->LODLevel));
-			CustomData.Add(static_cast<float>(Team->TeamID));
-			CustomData.Add(Team->TeamColor.R);
-			CustomData.Add(Team->TeamColor.G);
-			CustomData.Add(Team->TeamColor.B);
-			CustomData.Add(State->MaxHealth > UE_SMALL_NUMBER ? State->Health / State->MaxHealth : 0.0f);
+			// Cards keep the unit's facing so the material can pick the matching atlas view.
+			const float CardScale = Visual->ImpostorSize * InstanceTransform.GetScale3D().GetAbsMax() / ImpostorCardWidth;
+			InstanceTransform.SetLocation(InstanceTransform.TransformPosition(Visual->ImpostorCenter));
+			InstanceTransform.SetScale3D(FVector(CardScale));
 		}
+		UpdateInstanceSlot(Entities[Index], Bucket, InstanceTransform, CustomData);
 	}
 
-	static const TArray<FTransform> EmptyTransforms;
-	for (const TPair<TObjectPtr<UStaticMesh>, TObjectPtr<UInstancedStaticMeshComponent>>& Pair : InstancedMeshComponents)
+	// Units left out of this update were destroyed, hidden, or handed to a skeletal mesh.
+	for (auto It = InstanceSlots.CreateIterator(); It; ++It)
 	{
-		const TArray<FTransform>* DesiredTransforms = InstancesByMesh.Find(Pair.Key.Get());
-		const TArray<float>* DesiredCustomData = CustomDataByMesh.Find(Pair.Key.Get());
-		static const TArray<float> EmptyCustomData;
-		SynchronizeInstancedMeshComponent(
-			Pair.Value,
-			DesiredTransforms ? *DesiredTransforms : EmptyTransforms,
-			DesiredCustomData ? *DesiredCustomData : EmptyCustomData);
+		if (It.Value().UpdateStamp != InstanceUpdateStamp)
+		{
+			RemoveInstanceSlot(It.Value());
+			It.RemoveCurrent();
+		}
 	}
-	for (const TPair<UStaticMesh*, TArray<FTransform>>& Pair : InstancesByMesh)
+
+	InstancedTransformUpdateCount = 0;
+	InstancedCustomDataUpdateCount = 0;
+	for (TPair<FInstancedMeshKey, FInstancedMeshBatch>& Pair : InstancedMeshBatches)
 	{
-		UInstancedStaticMeshComponent* Component = GetOrCreateInstancedMeshComponent(Pair.Key);
-		if (!Component)
+		SynchronizeInstancedMeshBatch(Pair.Key, Pair.Value);
+	}
+	UploadTeamPalette();
+}
+
+UNiagaraUnitSystem::FInstancedMeshKey UNiagaraUnitSystem::ResolveInstancedMeshBucket(const FMassUnitVisualFragment& Visual) const
+{
+	FInstancedMeshKey Bucket;
+	if (Visual.bUseImpostor && ImpostorCardMesh && Visual.ImpostorMaterial)
+	{
+		Bucket.Mesh = ImpostorCardMesh;
+		Bucket.ImpostorMaterial = Visual.ImpostorMaterial;
+		Bucket.bCastShadow = false;
+		return Bucket;
+	}
+	Bucket.Mesh = Visual.StaticMesh ? Visual.StaticMesh.Get() : FallbackStaticMesh.Get();
+	if (!Visual.StaticMeshLODs.IsEmpty())
+	{
+		const int32 LODIndex = FMath::Clamp(Visual.LODLevel, 0, Visual.StaticMeshLODs.Num() - 1);
+		if (UStaticMesh* LODMesh = Visual.StaticMeshLODs[LODIndex])
 		{
-			continue;
+			Bucket.Mesh = LODMesh;
 		}
-		if (Component->GetInstanceCount() == 0)
+		Bucket.bCastShadow = (Visual.NoShadowLODMask & (1u << LODIndex)) == 0;
+	}
+	return Bucket;
+}
+
+void UNiagaraUnitSystem::UpdateInstanceSlot(
+	FMassUnitEntityHandle Entity,
+	const FInstancedMeshKey& Bucket,
+	const FTransform& Transform,
+	const float* CustomData)
+{
+	auto MarkDirty = [](FInstancedMeshBatch& Batch, int32 Index, uint8 Flags)
+	{
+		if (Batch.DirtyFlags[Index] == 0)
 		{
-			SynchronizeInstancedMeshComponent(Component, Pair.Value, CustomDataByMesh.FindChecked(Pair.Key));
+			Batch.DirtyIndices.Add(Index);
 		}
+		Batch.DirtyFlags[Index] |= Flags;
+	};
+
+	FInstanceSlot* Slot = InstanceSlots.Find(Entity);
+	if (Slot && Slot->Bucket != Bucket)
+	{
+		RemoveInstanceSlot(*Slot);
+		InstanceSlots.Remove(Entity);
+		Slot = nullptr;
+	}
+	if (!Slot)
+	{
+		FInstancedMeshBatch& Batch = InstancedMeshBatches.FindOrAdd(Bucket);
+		Slot = &InstanceSlots.Add(Entity);
+		Slot->Bucket = Bucket;
+		Slot->Index = Batch.Owners.Add(Entity);
+		Batch.Transforms.Add(Transform);
+		Batch.CustomData.Append(CustomData, InstancedCustomDataFloatCount);
+		Batch.DirtyFlags.Add(0);
+		MarkDirty(Batch, Slot->Index, InstanceTransformDirty | InstanceCustomDataDirty);
+		Slot->UpdateStamp = InstanceUpdateStamp;
+		return;
+	}
+
+	Slot->UpdateStamp = InstanceUpdateStamp;
+	FInstancedMeshBatch& Batch = InstancedMeshBatches.FindChecked(Bucket);
+	if (!Batch.Transforms[Slot->Index].Equals(Transform))
+	{
+		Batch.Transforms[Slot->Index] = Transform;
+		MarkDirty(Batch, Slot->Index, InstanceTransformDirty);
+	}
+	float* StoredCustomData = Batch.CustomData.GetData() + Slot->Index * InstancedCustomDataFloatCount;
+	bool bCustomDataChanged = false;
+	for (int32 Float = 0; Float < InstancedCustomDataFloatCount; ++Float)
+	{
+		// The start phase is derived from two clocks; ignore rounding drift between updates.
+		const float Tolerance = Float == 1 ? 0.01f / UE::MassUnitSystem::InstanceData::AnimationPhasePeriod : 0.0f;
+		bCustomDataChanged |= FMath::Abs(StoredCustomData[Float] - CustomData[Float]) > Tolerance;
+	}
+	if (bCustomDataChanged)
+	{
+		FMemory::Memcpy(StoredCustomData, CustomData, InstancedCustomDataFloatCount * sizeof(float));
+		MarkDirty(Batch, Slot->Index, InstanceCustomDataDirty);
 	}
 }
 
-void UNiagaraUnitSystem::SynchronizeInstancedMeshComponent(
-	UInstancedStaticMeshComponent* Component,
-	const TArray<FTransform>& WorldTransforms,
-	const TArray<float>& CustomData)
+void UNiagaraUnitSystem::RemoveInstanceSlot(const FInstanceSlot& Slot)
 {
-	if (!Component)
+	FInstancedMeshBatch* Batch = InstancedMeshBatches.Find(Slot.Bucket);
+	if (!Batch || !Batch->Owners.IsValidIndex(Slot.Index))
 	{
 		return;
 	}
 
-	const int32 ExistingCount = Component->GetInstanceCount();
-	const int32 DesiredCount = WorldTransforms.Num();
-	const int32 SharedCount = FMath::Min(ExistingCount, DesiredCount);
-	if (SharedCount > 0)
+	// Swap the last instance into the freed index so every other instance keeps its slot.
+	const int32 LastIndex = Batch->Owners.Num() - 1;
+	if (Slot.Index != LastIndex)
 	{
-		Component->BatchUpdateInstancesTransforms(
-			0,
-			MakeArrayView(WorldTransforms).Left(SharedCount),
-			true,
-			false,
-			false);
+		const FMassUnitEntityHandle MovedOwner = Batch->Owners[LastIndex];
+		Batch->Owners[Slot.Index] = MovedOwner;
+		Batch->Transforms[Slot.Index] = Batch->Transforms[LastIndex];
+		FMemory::Memcpy(
+			Batch->CustomData.GetData() + Slot.Index * InstancedCustomDataFloatCount,
+			Batch->CustomData.GetData() + LastIndex * InstancedCustomDataFloatCount,
+			InstancedCustomDataFloatCount * sizeof(float));
+		InstanceSlots.FindChecked(MovedOwner).Index = Slot.Index;
+		if (Batch->DirtyFlags[Slot.Index] == 0)
+		{
+			Batch->DirtyIndices.Add(Slot.Index);
+		}
+		Batch->DirtyFlags[Slot.Index] = InstanceTransformDirty | InstanceCustomDataDirty;
+	}
+	Batch->Owners.Pop(EAllowShrinking::No);
+	Batch->Transforms.Pop(EAllowShrinking::No);
+	Batch->CustomData.SetNum(LastIndex * InstancedCustomDataFloatCount, EAllowShrinking::No);
+	Batch->DirtyFlags.Pop(EAllowShrinking::No);
+}
+
+void UNiagaraUnitSystem::SynchronizeInstancedMeshBatch(const FInstancedMeshKey& Bucket, FInstancedMeshBatch& Batch)
+{
+	const int32 DesiredCount = Batch.Owners.Num();
+	UInstancedStaticMeshComponent* Component = DesiredCount > 0
+		? GetOrCreateInstancedMeshComponent(Bucket, Batch)
+		: Batch.Component;
+	if (!Component)
+	{
+		FMemory::Memzero(Batch.DirtyFlags.GetData(), Batch.DirtyFlags.Num());
+		Batch.DirtyIndices.Reset();
+		return;
 	}
 
+	// Only the tail of the instance list ever changes topology.
+	const int32 ExistingCount = Component->GetInstanceCount();
 	if (DesiredCount > ExistingCount)
 	{
 		const int32 AddedCount = DesiredCount - ExistingCount;
 		Component->PreAllocateInstancesMemory(AddedCount);
 		TArray<FTransform> AddedTransforms;
-		AddedTransforms.Append(WorldTransforms.GetData() + ExistingCount, AddedCount);
+		AddedTransforms.Append(Batch.Transforms.GetData() + ExistingCount, AddedCount);
 		Component->AddInstances(AddedTransforms, false, true, false);
 		++InstancedMeshTopologyRevision;
 	}
@@ -326,9 +627,54 @@ void UNiagaraUnitSystem::SynchronizeInstancedMeshComponent(
 		++InstancedMeshTopologyRevision;
 	}
 
-	if (DesiredCount > 0 && CustomData.Num() == DesiredCount * InstancedCustomDataFloatCount)
+	MovedInstanceScratch.Reset();
+	int32 CustomDataUpdates = 0;
+	for (const int32 InstanceIndex : Batch.DirtyIndices)
+	{
+		if (InstanceIndex >= DesiredCount)
+		{
+			continue;
+		}
+		uint8& Flags = Batch.DirtyFlags[InstanceIndex];
+		// Freshly added instances already carry their transform.
+		if ((Flags & InstanceTransformDirty) && InstanceIndex < ExistingCount)
+		{
+			MovedInstanceScratch.Add(InstanceIndex);
+		}
+		if (Flags & InstanceCustomDataDirty)
+		{
+			Component->SetCustomData(
+				InstanceIndex,
+				MakeArrayView(Batch.CustomData).Slice(InstanceIndex * InstancedCustomDataFloatCount, InstancedCustomDataFloatCount),
+				false);
+			++CustomDataUpdates;
+		}
+		Flags = 0;
+	}
+	Batch.DirtyIndices.Reset();
+
+	// Moved instances go up in contiguous runs.
+	MovedInstanceScratch.Sort();
+	for (int32 RunStart = 0; RunStart < MovedInstanceScratch.Num();)
+	{
+		int32 RunEnd = RunStart + 1;
+		while (RunEnd < MovedInstanceScratch.Num() && MovedInstanceScratch[RunEnd] == MovedInstanceScratch[RunEnd - 1] + 1)
+		{
+			++RunEnd;
+		}
+		Component->BatchUpdateInstancesTransforms(
+			MovedInstanceScratch[RunStart],
+			MakeArrayView(Batch.Transforms).Slice(MovedInstanceScratch[RunStart], RunEnd - RunStart),
+			true,
+			false,
+			false);
+		RunStart = RunEnd;
+	}
+	InstancedTransformUpdateCount += MovedInstanceScratch.Num();
+	InstancedCustomDataUpdateCount += CustomDataUpdates;
+	if (!MovedInstanceScratch.IsEmpty() || ExistingCount != DesiredCount || CustomDataUpdates > 0)
 	{
-		Component->SetCustomData(0, DesiredCount - 1, CustomData, true);
+		Component->MarkRenderStateDirty();
 	}
 
 	const bool bShouldBeVisible = DesiredCount > 0;
@@ -338,15 +684,17 @@ void UNiagaraUnitSystem::SynchronizeInstancedMeshComponent(
 	}
 }
 
-UInstancedStaticMeshComponent* UNiagaraUnitSystem::GetOrCreateInstancedMeshComponent(UStaticMesh* Mesh)
+UInstancedStaticMeshComponent* UNiagaraUnitSystem::GetOrCreateInstancedMeshComponent(
+	const FInstancedMeshKey& Bucket,
+	FInstancedMeshBatch& Batch)
 {
-	if (!Mesh || !World)
+	if (Batch.Component)
 	{
-		return nullptr;
+		return Batch.Component;
 	}
-	if (UInstancedStaticMeshComponent* Existing = InstancedMeshComponents.FindRef(Mesh))
+	if (!Bucket.Mesh || !World)
 	{
-		return Existing;
+		return nullptr;
 	}
 	UInstancedStaticMeshComponent* Component = NewObject<UInstancedStaticMeshComponent>(World);
 	if (!Component)
@@ -357,13 +705,91 @@ UInstancedStaticMeshComponent* UNiagaraUnitSystem::GetOrCreateInstancedMeshCompo
 	Component->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 	Component->SetGenerateOverlapEvents(false);
 	Component->SetCanEverAffectNavigation(false);
+	Component->SetCastShadow(Bucket.bCastShadow);
 	Component->SetNumCustomDataFloats(InstancedCustomDataFloatCount);
-	Component->SetStaticMesh(Mesh);
+	Component->SetStaticMesh(Bucket.Mesh);
+	if (Bucket.ImpostorMaterial)
+	{
+		Component->SetMaterial(0, Bucket.ImpostorMaterial);
+	}
+	if (TeamPaletteTexture)
+	{
+		static const FName TeamPaletteParameter(TEXT("TeamPalette"));
+		for (int32 MaterialIndex = 0; MaterialIndex < Component->GetNumMaterials(); ++MaterialIndex)
+		{
+			UTexture* DefaultPalette = nullptr;
+			const UMaterialInterface* Material = Component->GetMaterial(MaterialIndex);
+			if (Material && Material->GetTextureParameterValue(FHashedMaterialParameterInfo(TeamPaletteParameter), DefaultPalette))
+			{
+				if (UMaterialInstanceDynamic* PaletteMaterial = Component->CreateDynamicMaterialInstance(MaterialIndex))
+				{
+					PaletteMaterial->SetTextureParameterValue(TeamPaletteParameter, TeamPaletteTexture);
+				}
+			}
+		}
+	}
 	Component->RegisterComponentWithWorld(World);
-	InstancedMeshComponents.Add(Mesh, Component);
+	InstancedMeshComponents.Add(Component);
+	Batch.Component = Component;
 	return Component;
 }
 
+int32 UNiagaraUnitSystem::ResolveTeamPaletteIndex(const FMassUnitTeamFragment& Team)
+{
+	const FColor Color = Team.TeamColor.ToFColor(true);
+	const uint64 Key = static_cast<uint64>(static_cast<uint32>(Team.TeamID)) << 32 | Color.DWColor();
+	if (const int32* Existing = TeamPaletteIndices.Find(Key))
+	{
+		return *Existing;
+	}
+	if (TeamPaletteIndices.Num() >= TeamPaletteColors.Num())
+	{
+		// Teams past the palette size share its last entry.
+		return TeamPaletteColors.Num() - 1;
+	}
+	const int32 PaletteIndex = TeamPaletteIndices.Add(Key, TeamPaletteIndices.Num());
+	TeamPaletteColors[PaletteIndex] = Color;
+	bTeamPaletteDirty = true;
+	return PaletteIndex;
+}
+
+void UNiagaraUnitSystem::CreateTeamPaletteTexture()
+{
+	TeamPaletteColors.Init(FColor::White, UE::MassUnitSystem::InstanceData::TeamPaletteSize);
+	TeamPaletteTexture = UTexture2D::CreateTransient(TeamPaletteColors.Num(), 1, PF_B8G8R8A8, TEXT("MassUnitTeamPalette"));
+	if (!TeamPaletteTexture)
+	{
+		return;
+	}
+	TeamPaletteTexture->Filter = TF_Nearest;
+	TeamPaletteTexture->AddressX = TA_Clamp;
+	TeamPaletteTexture->AddressY = TA_Clamp;
+	TeamPaletteTexture->SRGB = true;
+	TeamPaletteTexture->UpdateResource();
+	bTeamPaletteDirty = true;
+}
+
+void UNiagaraUnitSystem::UploadTeamPalette()
+{
+	if (!bTeamPaletteDirty || !TeamPaletteTexture)
+	{
+		return;
+	}
+	bTeamPaletteDirty = false;
+
+	// The render thread frees its copy of the region and texels once the upload ran.
+	const int32 PaletteBytes = TeamPaletteColors.Num() * sizeof(FColor);
+	uint8* Texels = new uint8[PaletteBytes];
+	FMemory::Memcpy(Texels, TeamPaletteColors.GetData(), PaletteBytes);
+	FUpdateTextureRegion2D* Region = new FUpdateTextureRegion2D(0, 0, 0, 0, TeamPaletteColors.Num(), 1);
+	TeamPaletteTexture->UpdateTextureRegions(0, 1, Region, PaletteBytes, sizeof(FColor), Texels,
+		[](uint8* SrcData, const FUpdateTextureRegion2D* Regions)
+		{
+			delete[] SrcData;
+			delete Regions;
+		});
+}
+
 int32 UNiagaraUnitSystem::ResolveAnimationIndex(
 	const FMassUnitVisualFragment& Visual,
 	const FMassUnitStateFragment& State)
@@ -379,3 +805,21 @@ int32 UNiagaraUnitSystem::ResolveAnimationIndex(
 	const int32 AnimationIndex = VertexAnimationManager->GetAnimationIndex(Visual.CurrentAnimation);
 	return AnimationIndex != INDEX_NONE ? AnimationIndex : static_cast<int32>(State.CurrentState);
 }
+
+int32 UNiagaraUnitSystem::ResolveAnimationIndexDeferred(
+	const FMassUnitVisualFragment& Visual,
+	const FMassUnitStateFragment& State)
+{
+	if (!VertexAnimationManager)
+	{
+		return static_cast<int32>(State.CurrentState);
+	}
+	if (Visual.VertexAnimationTexture && Visual.CurrentAnimation.IsValid()
+		&& VertexAnimationManager->GetAnimationTexture(Visual.CurrentAnimation) != Visual.VertexAnimationTexture)
+	{
+		FScopeLock Lock(&PendingAnimationTexturesLock);
+		PendingAnimationTextures.Add(Visual.CurrentAnimation, Visual.VertexAnimationTexture);
+	}
+	const int32 AnimationIndex = VertexAnimationManager->GetAnimationIndex(Visual.CurrentAnimation);
+	return AnimationIndex != INDEX_NONE ? AnimationIndex : static_cast<int32>(State.CurrentState);
+}
@@ -31,6 +31,14 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Performance", meta = (ClampMin = "1", UIMin = "1"))
 	int32 MaxPathRequestsPerFrame = 100;
 
+	/**
+	 * Wall-clock budget for serving queued navigation requests in one world tick. Requests are served earliest
+	 * target time first, so the budget cuts off background work before units near an observer. Zero disables
+	 * the time budget so only Max Path Requests Per Frame applies.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Performance", meta = (ClampMin = "0.0", ForceUnits = "ms"))
+	float PathRequestBudgetMs = 1.0f;
+
 	/** Maximum new shared crowd/subgroup navmesh corridors built during one crowd update. */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Performance", meta = (ClampMin = "1", UIMin = "1"))
 	int32 MaxSharedPathBuildsPerCrowdUpdate = 8;
@@ -43,9 +51,21 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Performance", meta = (ClampMin = "0.02", ForceUnits = "s"))
 	float CrowdUpdateInterval = 0.1f;
 
-	/** Maximum crowd units that can receive a decision/steering update during one crowd timer callback. */
+	/**
+	 * Hard cap on crowd units that can receive a decision/steering update during one crowd update.
+	 * Decisions are evaluated on worker threads, so this mostly bounds the serial apply cost.
+	 */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Performance", meta = (ClampMin = "1", UIMin = "1"))
-	int32 MaxCrowdUnitsPerUpdate = 500;
+	int32 MaxCrowdUnitsPerUpdate = 2000;
+
+	/**
+	 * Wall-clock budget for one crowd update. Units are served most overdue first, with a head start for
+	 * engaged and observer-near units, and the update stops between batches once the budget is spent. Deferred
+	 * units keep aging until they are served. Zero disables
+	 * the time budget so only the unit and path-build caps apply.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Performance", meta = (ClampMin = "0.0", ForceUnits = "ms"))
+	float CrowdUpdateBudgetMs = 2.0f;
 
 	/** Two-dimensional spatial-hash cell size used for separation and interaction neighbor searches. */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Performance", meta = (ClampMin = "10.0", ForceUnits = "cm"))
@@ -55,6 +75,13 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "LOD", meta = (ForceUnits = "cm"))
 	TArray<float> LODDistanceThresholds;
 
+	/**
+	 * Exit-distance multiplier for visual LOD thresholds. A unit keeps its current LOD until it passes the
+	 * threshold by this factor, so instanced units do not swap meshes while hovering at a boundary.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "LOD", meta = (ClampMin = "1.0", ClampMax = "2.0"))
+	float LODDistanceHysteresis = 1.1f;
+
 	/** Per-LOD intervals for recomputing distance visibility. The final entry is used beyond the last visual threshold. */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "LOD", meta = (ForceUnits = "s"))
 	TArray<float> VisibilityLODUpdateIntervals;
@@ -67,6 +94,13 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Crowd LOD")
 	TArray<float> CrowdSimulationLODIntervalMultipliers;
 
+	/**
+	 * Planar cell size of the dormant grid that holds sleeping crowd units. Each crowd update tests observers
+	 * against occupied cells only, so larger cells make dormant crowds cheaper at the cost of coarser wake checks.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Crowd LOD", meta = (ClampMin = "500.0", ForceUnits = "cm"))
+	float CrowdDormantCellSize = 5000.0f;
+
 	/** Units with a skeletal mesh use it inside this distance when pool capacity permits. */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "LOD", meta = (ClampMin = "0.0", ForceUnits = "cm"))
 	float SkeletalMeshDistance = 300.0f;
@@ -83,6 +117,10 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Rendering")
 	TSoftObjectPtr<UNiagaraSystem> DefaultNiagaraSystem;
 
+	/** Push the Unit* array parameters each update. Disable when the Niagara system reads the Mass Units data interface instead. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Rendering")
+	bool bUploadNiagaraUnitArrays = true;
+
 	/** Use instanced static meshes when no Niagara system is configured or can be loaded. */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Rendering")
 	bool bEnableInstancedMeshFallback = true;
@@ -91,16 +129,93 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Rendering")
 	TSoftObjectPtr<UStaticMesh> FallbackStaticMesh;
 
+	/**
+	 * Card drawn for units in the impostor tier, scaled to each template's mesh bounds. The template's impostor
+	 * material is responsible for turning it toward the camera. If unset, the engine plane is used.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Rendering")
+	TSoftObjectPtr<UStaticMesh> ImpostorCardMesh;
+
+	/**
+	 * Navmesh corridors kept for reuse, keyed by start and goal polygon. Later requests between the same
+	 * polygons skip the path query. The least recently used corridor is evicted first; zero disables the cache.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Navigation", meta = (ClampMin = "0", UIMin = "0"))
+	int32 MaxCachedPaths = 512;
+
+	/**
+	 * Queued path requests that start in the same cell of this size and end on the same navmesh polygon share one
+	 * query; each unit gets its own entry and exit segment. Zero disables coalescing.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Navigation", meta = (ClampMin = "0.0", ForceUnits = "cm"))
+	float PathCoalesceCellSize = 500.0f;
+
+	/**
+	 * Requests whose start and goal lie farther apart than this are planned over a coarse navmesh cluster graph
+	 * first. Only the next few clusters are refined into a detailed corridor as the unit advances. Zero disables.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Navigation", meta = (ClampMin = "0.0", ForceUnits = "cm"))
+	float HierarchicalPathDistance = 20000.0f;
+
+	/** Planar size of one cluster in the hierarchical planner's graph. Links between clusters are tested lazily and cached. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Navigation", meta = (ClampMin = "1000.0", ForceUnits = "cm"))
+	float PathClusterSize = 5000.0f;
+
+	/**
+	 * Planar cell size of the index that finds navmesh corridors crossing a rebuilt area. Smaller cells requeue
+	 * fewer corridors that only pass near the area, at the cost of more index entries per corridor.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Navigation", meta = (ClampMin = "100.0", ForceUnits = "cm"))
+	float RepathIndexCellSize = 1000.0f;
+
 	/** If no nav data exists, use a direct two-point path instead of rejecting movement requests. */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Navigation")
 	bool bFallbackToDirectPath = true;
 
+	/** Grid resolution of the shared flow fields built for mass move orders. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Navigation", meta = (ClampMin = "10.0", ForceUnits = "cm"))
+	float FlowFieldCellSize = 100.0f;
+
+	/** Vertical half-extent used when projecting flow-field and height-field cells onto the navmesh. Also sets the height band shared tiles are keyed by. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Navigation", meta = (ClampMin = "1.0", ForceUnits = "cm"))
+	float FlowFieldProjectionHeight = 250.0f;
+
+	/** Largest flow field, in 16 x 16-cell tiles. Units outside a clamped field steer straight at the destination. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Navigation", meta = (ClampMin = "1", UIMin = "1"))
+	int32 MaxFlowFieldTiles = 256;
+
+	/** Flow fields kept for reuse. The least recently ordered destination is evicted first. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Navigation", meta = (ClampMin = "1", UIMin = "1"))
+	int32 MaxCachedFlowFields = 16;
+
+	/** Grid resolution of the cached ground heights that planar crowd units conform to. Zero disables the height field. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Navigation", meta = (ClampMin = "0.0", ForceUnits = "cm"))
+	float HeightFieldCellSize = 100.0f;
+
+	/** Height tiles of 16 x 16 cells kept in memory. The least recently sampled tile is evicted first. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Navigation", meta = (ClampMin = "1", UIMin = "1"))
+	int32 MaxHeightFieldTiles = 1024;
+
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Debug")
 	bool bEnableDebugVisualization = false;
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Debug", meta = (ClampMin = "0.0", ForceUnits = "s"))
 	float DebugVisualizationDuration = 0.0f;
 
+	/**
+	 * Recounts crowd population from fragments after every crowd update and logs any drift from the
+	 * incrementally maintained statistics. Costs a full pass over registered units; debugging only.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Debug")
+	bool bAuditCrowdStats = false;
+
+	/**
+	 * Scores and decides crowd units on worker threads. Results are applied serially in the same order either
+	 * way, so turning this off only moves the decide phase onto the game thread; debugging only.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Debug")
+	bool bParallelCrowdDecisions = true;
+
 	/** Optional project catalog. These assets are not spawned automatically. */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, Category = "Units")
 	TArray<TSoftObjectPtr<UUnitConfigDataAsset>> UnitConfigurations;
@@ -12,6 +12,8 @@ class UMassEntitySubsystem;
 class UMassUnitBehaviorIntegration;
 class UMassUnitCrowdSystem;
 class UMassUnitEntityManager;
+class UMassUnitFlowFieldSystem;
+class UMassUnitHeightFieldSystem;
 class UMassUnitNavigationSystem;
 class UNiagaraUnitSystem;
 class UUnitGameplayEventSystem;
@@ -43,6 +45,12 @@ public:
 	UFUNCTION(BlueprintPure, Category = "Mass Unit System")
 	UMassUnitNavigationSystem* GetNavigationSystem() const { return NavigationSystem; }
 
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System")
+	UMassUnitFlowFieldSystem* GetFlowFieldSystem() const { return FlowFieldSystem; }
+
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System")
+	UMassUnitHeightFieldSystem* GetHeightFieldSystem() const { return HeightFieldSystem; }
+
 	UFUNCTION(BlueprintPure, Category = "Mass Unit System")
 	UNiagaraUnitSystem* GetNiagaraSystem() const { return NiagaraSystem; }
 
@@ -76,6 +84,12 @@ private:
 	UPROPERTY(Transient)
 	TObjectPtr<UMassUnitNavigationSystem> NavigationSystem = nullptr;
 
+	UPROPERTY(Transient)
+	TObjectPtr<UMassUnitFlowFieldSystem> FlowFieldSystem = nullptr;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UMassUnitHeightFieldSystem> HeightFieldSystem = nullptr;
+
 	UPROPERTY(Transient)
 	TObjectPtr<UNiagaraUnitSystem> NiagaraSystem = nullptr;
 
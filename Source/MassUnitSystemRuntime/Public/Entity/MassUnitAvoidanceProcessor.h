@@ -0,0 +1,51 @@
+// Copyright Digi Logic Labs LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityQuery.h"
+#include "MassProcessor.h"
+#include "MassUnitAvoidanceProcessor.generated.h"
+
+/**
+ * Optimal reciprocal collision avoidance (ORCA) for crowd units whose group
+ * opts in. A serial pass snapshots agents into structure-of-arrays buffers
+ * sorted by grid cell; a parallel chunk pass then solves each unit's
+ * collision-free velocity against its closest bounded neighbors. The
+ * movement processor consumes the result later in the same frame.
+ */
+UCLASS()
+class MASSUNITSYSTEMRUNTIME_API UMassUnitAvoidanceProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	UMassUnitAvoidanceProcessor();
+	virtual void ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager) override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+	struct FCellRange
+	{
+		int32 Start = 0;
+		int32 Num = 0;
+	};
+
+	FMassEntityQuery EntityQuery;
+
+	// Per-frame agent snapshot, reused between frames. Sorted by cell so each
+	// cell's agents are contiguous for the neighbor kernel.
+	TArray<float> PositionX;
+	TArray<float> PositionY;
+	TArray<float> VelocityX;
+	TArray<float> VelocityY;
+	TArray<float> PreferredVelocityX;
+	TArray<float> PreferredVelocityY;
+	TArray<float> MaxSpeeds;
+	TArray<float> Radii;
+	TArray<int32> SortedSlotByAgent;
+	TMap<FIntPoint, FCellRange> Cells;
+	float CellSize = 300.0f;
+
+	void SortAgentsByCell();
+};
@@ -0,0 +1,31 @@
+// Copyright Digi Logic Labs LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityQuery.h"
+#include "MassProcessor.h"
+#include "MassUnitCrowdProcessor.generated.h"
+
+/**
+ * Drives UMassUnitCrowdSystem from the Mass phase scheduler. When a crowd
+ * update is due, registered unit locations are streamed into the crowd
+ * spatial hash from contiguous chunk memory, decision inputs are captured
+ * from the same chunk views when units are scheduled, and steering results
+ * are written back through mutable chunk views, so the movement processor
+ * sees them in the same frame. Gameplay events raised by the update are
+ * queued and dispatched after processing by UMassUnitSubsystem::Tick.
+ */
+UCLASS()
+class MASSUNITSYSTEMRUNTIME_API UMassUnitCrowdProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	UMassUnitCrowdProcessor();
+	virtual void ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager) override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+	FMassEntityQuery EntityQuery;
+};
@@ -135,6 +135,13 @@ public:
 	FMassUnitEntityHandle CreateUnitFromTemplateInternal(UUnitTemplate* Template, const FTransform& SpawnTransform);
 	void DestroyUnitInternal(FMassUnitEntityHandle EntityHandle);
 	const TArray<FMassUnitEntityHandle>& GetAllUnitsInternal() const { return AllUnits; }
+
+	/** Owner of each render slot; free slots hold an invalid handle. Slots are reused after their unit is destroyed. */
+	TConstArrayView<FMassUnitEntityHandle> GetRenderSlotOwners() const { return RenderSlotOwners; }
+
+	/** Increments whenever a render slot is freed, so visual buffers know when to hide stale slots. */
+	int32 GetRenderSlotReleaseCount() const { return RenderSlotReleaseCount; }
+
 	TArray<FMassUnitEntityHandle> GetUnitsByTypeInternal(FGameplayTag UnitType) const;
 	TArray<FMassUnitEntityHandle> GetUnitsByTeamInternal(int32 TeamID) const;
 	bool ApplyDamageInternal(
@@ -144,6 +151,9 @@ public:
 		bool bDeferEvents = false);
 	void PruneInvalidUnits();
 
+	/** Returns and clears the units destroyed or pruned since the last call. */
+	TArray<FMassUnitEntityHandle> ConsumeRemovedUnits() { return MoveTemp(RemovedUnits); }
+
 	UMassEntitySubsystem* GetEntitySubsystem() const { return EntitySubsystem; }
 	const TMap<FGameplayTag, TArray<FMassUnitEntityHandle>>& GetUnitTypeMap() const { return UnitTypeMap; }
 	const TMap<int32, TArray<FMassUnitEntityHandle>>& GetTeamMap() const { return TeamMap; }
@@ -160,6 +170,12 @@ private:
 	TArray<FMassUnitEntityHandle> AllUnits;
 	TMap<FGameplayTag, TArray<FMassUnitEntityHandle>> UnitTypeMap;
 	TMap<int32, TArray<FMassUnitEntityHandle>> TeamMap;
+	TArray<FMassUnitEntityHandle> RenderSlotOwners;
+	TArray<int32> FreeRenderSlots;
+	int32 RenderSlotReleaseCount = 0;
+	TArray<FMassUnitEntityHandle> RemovedUnits;
 
 	void RemoveHandleFromIndexes(FMassUnitEntityHandle EntityHandle);
+	int32 AllocateRenderSlot(FMassUnitEntityHandle EntityHandle);
+	void ReleaseRenderSlot(FMassUnitEntityHandle EntityHandle, int32 Slot);
 };
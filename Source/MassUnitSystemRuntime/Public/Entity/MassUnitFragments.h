@@ -10,6 +10,7 @@
 #include "MassEntityTypes.h"
 #include "MassUnitFragments.generated.h"
 
+class UMaterialInterface;
 class USkeletalMesh;
 class UStaticMesh;
 class UTexture2D;
@@ -165,6 +166,10 @@ struct MASSUNITSYSTEMRUNTIME_API FMassUnitVisualFragment : public FMassFragment
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Mass Unit")
 	bool bWantsSkeletalMesh = false;
 
+	/** Set by visibility beyond the last LOD threshold when the unit has an impostor card. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Mass Unit")
+	bool bUseImpostor = false;
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Mass Unit")
 	float ViewerDistanceSquared = 0.0f;
 
@@ -192,6 +197,24 @@ struct MASSUNITSYSTEMRUNTIME_API FMassUnitVisualFragment : public FMassFragment
 	UPROPERTY(Transient)
 	TObjectPtr<UStaticMesh> StaticMesh = nullptr;
 
+	/** Template meshes per visual LOD; the last entry covers farther LODs and null entries use StaticMesh. */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UStaticMesh>> StaticMeshLODs;
+
+	/** Bit N turns shadow casting off for instances drawn with StaticMeshLODs entry N. */
+	UPROPERTY(Transient)
+	uint32 NoShadowLODMask = 0;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UMaterialInterface> ImpostorMaterial = nullptr;
+
+	/** Local-space center and edge length of the impostor card; both match the StaticMesh bounds the atlas was captured from. */
+	UPROPERTY(Transient)
+	FVector ImpostorCenter = FVector::ZeroVector;
+
+	UPROPERTY(Transient)
+	float ImpostorSize = 0.0f;
+
 	UPROPERTY(Transient)
 	TObjectPtr<UTexture2D> VertexAnimationTexture = nullptr;
 
@@ -249,6 +272,10 @@ struct MASSUNITSYSTEMRUNTIME_API FMassUnitNavigationFragment : public FMassFragm
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mass Unit", meta = (ClampMin = "1.0", ForceUnits = "cm"))
 	float AcceptanceRadius = 50.0f;
 
+	/** Shared UMassUnitFlowFieldSystem field steering this unit toward DestinationLocation, or INDEX_NONE. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Mass Unit")
+	int32 FlowFieldHandle = INDEX_NONE;
+
 	bool HasReachedDestination() const
 	{
 		return bPathValid && PathPoints.IsValidIndex(CurrentPathIndex) == false;
@@ -258,6 +285,7 @@ struct MASSUNITSYSTEMRUNTIME_API FMassUnitNavigationFragment : public FMassFragm
 	{
 		PathPoints.Reset();
 		CurrentPathIndex = INDEX_NONE;
+		FlowFieldHandle = INDEX_NONE;
 		bPathRequested = false;
 		bPathValid = false;
 		bPathUsesNavmesh = false;
@@ -279,7 +307,15 @@ struct MASSUNITSYSTEMRUNTIME_API FMassUnitVisualizationLODFragment : public FMas
 	int32 LODLevel = 0;
 };
 
-/** Lightweight state used by the timer-driven crowd service and movement processor. */
+/** Index of the unit in the shared visual buffers, held for the unit's whole lifetime. */
+USTRUCT()
+struct MASSUNITSYSTEMRUNTIME_API FMassUnitRenderSlotFragment : public FMassFragment
+{
+	GENERATED_BODY()
+	int32 Slot = INDEX_NONE;
+};
+
+/** Lightweight state used by the crowd service, crowd processor, and movement processor. */
 USTRUCT()
 struct MASSUNITSYSTEMRUNTIME_API FMassUnitCrowdFragment : public FMassFragment
 {
@@ -300,10 +336,20 @@ struct MASSUNITSYSTEMRUNTIME_API FMassUnitCrowdFragment : public FMassFragment
 	int32 DecisionSequence = 0;
 	int32 SimulationLOD = 0;
 	float NavigationHeightOffset = 0.0f;
+	/** Collision-free planar velocity chosen by UMassUnitAvoidanceProcessor this frame. */
+	FVector AvoidanceVelocity = FVector::ZeroVector;
+	float AvoidanceAgentRadius = 0.0f;
+	float AvoidanceTimeHorizon = 0.0f;
+	float AvoidanceNeighborDistance = 0.0f;
+	int32 MaxAvoidanceNeighbors = 0;
+	/** Transient slot in the avoidance processor's per-frame agent snapshot. */
+	int32 AvoidanceAgentIndex = INDEX_NONE;
 	bool bEnabled = false;
 	bool bSleeping = false;
 	bool bUse3DMovement = false;
 	bool bConformToNavmeshHeight = false;
+	bool bUseReciprocalAvoidance = false;
+	bool bHasAvoidanceVelocity = false;
 
 	void Reset()
 	{
@@ -322,10 +368,18 @@ struct MASSUNITSYSTEMRUNTIME_API FMassUnitCrowdFragment : public FMassFragment
 		DecisionSequence = 0;
 		SimulationLOD = 0;
 		NavigationHeightOffset = 0.0f;
+		AvoidanceVelocity = FVector::ZeroVector;
+		AvoidanceAgentRadius = 0.0f;
+		AvoidanceTimeHorizon = 0.0f;
+		AvoidanceNeighborDistance = 0.0f;
+		MaxAvoidanceNeighbors = 0;
+		AvoidanceAgentIndex = INDEX_NONE;
 		bEnabled = false;
 		bSleeping = false;
 		bUse3DMovement = false;
 		bConformToNavmeshHeight = false;
+		bUseReciprocalAvoidance = false;
+		bHasAvoidanceVelocity = false;
 	}
 };
 
@@ -0,0 +1,23 @@
+// Copyright Digi Logic Labs LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityQuery.h"
+#include "MassProcessor.h"
+#include "MassUnitVisualGatherProcessor.generated.h"
+
+/** Copies render-facing fragments into the Niagara representation's slot buffers, one chunk per worker. */
+UCLASS()
+class MASSUNITSYSTEMRUNTIME_API UMassUnitVisualGatherProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	UMassUnitVisualGatherProcessor();
+	virtual void ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager) override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+	FMassEntityQuery EntityQuery;
+};
@@ -10,10 +10,26 @@
 
 class UScriptStruct;
 class UAnimationAsset;
+class UMaterialInterface;
 class USkeletalMesh;
 class UStaticMesh;
 class UTexture2D;
 
+/** Static mesh drawn by the instanced path at one visual LOD. */
+USTRUCT(BlueprintType)
+struct MASSUNITSYSTEMRUNTIME_API FUnitTemplateMeshLOD
+{
+    GENERATED_BODY()
+
+    /** Mesh for this LOD. Unset entries fall back to the template's Static Mesh. */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Unit Template|Visual")
+    TSoftObjectPtr<UStaticMesh> Mesh;
+
+    /** Whether instances drawn at this LOD cast shadows. */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Unit Template|Visual")
+    bool bCastShadow = true;
+};
+
 /**
  * Template for creating units in the Mass Unit System
  */
@@ -88,6 +104,28 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Unit Template|Visual")
     TSoftObjectPtr<UStaticMesh> StaticMesh;
 
+    /**
+     * Optional instanced representation per visual LOD. Entry N is drawn at LOD N and the last entry
+     * covers every farther LOD. When empty, Static Mesh is drawn with shadows at every LOD.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Unit Template|Visual")
+    TArray<FUnitTemplateMeshLOD> StaticMeshLODs;
+
+    /** Hemi-octahedral view atlas of Static Mesh, written by the MassUnitImpostor commandlet. */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Unit Template|Visual|Impostor")
+    TSoftObjectPtr<UTexture2D> ImpostorTexture;
+
+    /** Views along each side of the impostor atlas. */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Unit Template|Visual|Impostor", meta = (ClampMin = "2", ClampMax = "32"))
+    int32 ImpostorFramesPerAxis = 8;
+
+    /**
+     * Card material that samples the impostor atlas. Units beyond the last LOD distance threshold are drawn
+     * as one instanced card with this material instead of Static Mesh. Unset disables the impostor tier.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Unit Template|Visual|Impostor")
+    TSoftObjectPtr<UMaterialInterface> ImpostorMaterial;
+
     /** Vertex animation texture for the unit */
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Unit Template|Visual")
     TSoftObjectPtr<UTexture2D> VertexAnimationTexture;
@@ -0,0 +1,139 @@
+// Copyright Digi Logic Labs LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Entity/MassEntityFallback.h"
+
+/**
+ * Persistent uniform-grid index for registered crowd units.
+ *
+ * Entries live in one dense array and are linked into their cell through
+ * intrusive indices, so a location refresh only touches the grid when a unit
+ * crosses a cell boundary. Cells are stored in a flat open-addressing table;
+ * nothing is reallocated or rehashed between crowd updates.
+ */
+class MASSUNITSYSTEMRUNTIME_API FMassUnitCrowdSpatialHash
+{
+public:
+	struct FEntry
+	{
+		FMassUnitEntityHandle Entity;
+		FVector Location = FVector::ZeroVector;
+		FIntVector Cell = FIntVector::ZeroValue;
+		int32 GroupHandle = INDEX_NONE;
+		int32 CellSlot = INDEX_NONE;
+		int32 PreviousInCell = INDEX_NONE;
+		int32 NextInCell = INDEX_NONE;
+		bool bUse3DMovement = false;
+		/** Refreshed with the location; dead units stay indexed but are left out of group aggregates. */
+		bool bLiving = true;
+	};
+
+	void Initialize(float InCellSize);
+	void Reset();
+
+	/** Adds or re-parents an entity and returns its dense entry index. */
+	int32 Add(FMassUnitEntityHandle Entity, int32 GroupHandle, const FVector& Location, bool bUse3DMovement);
+
+	/** Removes an entity. The last entry is swapped into the freed index. */
+	bool Remove(FMassUnitEntityHandle Entity);
+
+	/** Stores a fresh location and relinks the entry only when its cell changed. Returns true on a cell change. */
+	bool UpdateLocation(int32 EntryIndex, const FVector& Location);
+
+	void SetLiving(int32 EntryIndex, bool bLiving) { Entries[EntryIndex].bLiving = bLiving; }
+
+	int32 FindEntryIndex(FMassUnitEntityHandle Entity) const;
+	int32 Num() const { return Entries.Num(); }
+	bool IsEmpty() const { return Entries.IsEmpty(); }
+	bool IsValidIndex(int32 EntryIndex) const { return Entries.IsValidIndex(EntryIndex); }
+	const FEntry& GetEntry(int32 EntryIndex) const { return Entries[EntryIndex]; }
+	const TArray<FEntry>& GetEntries() const { return Entries; }
+	int32 GetNum3DEntries() const { return Num3DEntries; }
+	float GetCellSize() const { return CellSize; }
+	/** Slots in the open-addressing cell table; bounded by the live cells, not by every cell ever visited. */
+	int32 GetCellTableCapacity() const { return CellSlots.Num(); }
+	FIntVector ToCell(const FVector& Location, bool bUse3DMovement) const;
+
+	/**
+	 * Visits every entry in the cells overlapping a cube (or planar square) of
+	 * Radius around Location. Planar queries only visit the Z = 0 cell layer.
+	 * Very wide queries fall back to one linear pass over the dense entries.
+	 */
+	template <typename FunctorType>
+	void ForEachInRadius(const FVector& Location, float Radius, bool bUse3DMovement, FunctorType&& Visitor) const
+	{
+		if (Entries.IsEmpty())
+		{
+			return;
+		}
+		const float RangeInCells = FMath::Max(1.0f, FMath::CeilToFloat(Radius * InverseCellSize));
+		const int32 CellRange = static_cast<int32>(FMath::Min(RangeInCells, 1048576.0f));
+		const FIntVector CenterCell = ToCell(Location, bUse3DMovement);
+		const int32 MinCellZ = bUse3DMovement ? CenterCell.Z - CellRange : 0;
+		const int32 MaxCellZ = bUse3DMovement ? CenterCell.Z + CellRange : 0;
+		const int64 Span = 2 * static_cast<int64>(CellRange) + 1;
+		const int64 CellsToVisit = Span * Span * (static_cast<int64>(MaxCellZ) - MinCellZ + 1);
+		if (CellsToVisit > static_cast<int64>(Entries.Num()))
+		{
+			for (int32 EntryIndex = 0; EntryIndex < Entries.Num(); ++EntryIndex)
+			{
+				const FEntry& Entry = Entries[EntryIndex];
+				if (FMath::Abs(Entry.Cell.X - CenterCell.X) <= CellRange
+					&& FMath::Abs(Entry.Cell.Y - CenterCell.Y) <= CellRange
+					&& Entry.Cell.Z >= MinCellZ && Entry.Cell.Z <= MaxCellZ)
+				{
+					Visitor(EntryIndex, Entry);
+				}
+			}
+			return;
+		}
+
+		for (int32 CellX = CenterCell.X - CellRange; CellX <= CenterCell.X + CellRange; ++CellX)
+		{
+			for (int32 CellY = CenterCell.Y - CellRange; CellY <= CenterCell.Y + CellRange; ++CellY)
+			{
+				for (int32 CellZ = MinCellZ; CellZ <= MaxCellZ; ++CellZ)
+				{
+					const int32 Slot = FindCellSlot(FIntVector(CellX, CellY, CellZ));
+					if (Slot == INDEX_NONE)
+					{
+						continue;
+					}
+					for (int32 EntryIndex = CellSlots[Slot].Head; EntryIndex != INDEX_NONE;)
+					{
+						const FEntry& Entry = Entries[EntryIndex];
+						const int32 NextIndex = Entry.NextInCell;
+						Visitor(EntryIndex, Entry);
+						EntryIndex = NextIndex;
+					}
+				}
+			}
+		}
+	}
+
+private:
+	struct FCellSlot
+	{
+		FIntVector Key = FIntVector::ZeroValue;
+		int32 Head = INDEX_NONE;
+		int32 Count = 0;
+		bool bOccupied = false;
+	};
+
+	TArray<FEntry> Entries;
+	TMap<FMassUnitEntityHandle, int32> EntryByEntity;
+	TArray<FCellSlot> CellSlots;
+	int32 OccupiedCellSlots = 0;
+	int32 Num3DEntries = 0;
+	float CellSize = 200.0f;
+	float InverseCellSize = 1.0f / 200.0f;
+
+	static uint32 HashCell(const FIntVector& Cell);
+	int32 FindCellSlot(const FIntVector& Cell) const;
+	int32 FindOrAddCellSlot(const FIntVector& Cell);
+	void LinkIntoCell(int32 EntryIndex);
+	void UnlinkFromCell(int32 EntryIndex);
+	void RebuildCellTable();
+};
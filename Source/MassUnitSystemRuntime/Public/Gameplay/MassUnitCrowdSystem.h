@@ -4,9 +4,14 @@
 
 #include "CoreMinimal.h"
 #include "Entity/MassUnitEntityManager.h"
+#include "Gameplay/MassUnitCrowdSpatialHash.h"
 #include "MassUnitCrowdSystem.generated.h"
 
 class UMassEntitySubsystem;
+struct FMassUnitCrowdFragment;
+struct FMassUnitNavigationFragment;
+struct FMassUnitStateFragment;
+struct FMassUnitTargetFragment;
 class UMassUnitNavigationSystem;
 class AActor;
 class UDamageType;
@@ -20,6 +25,14 @@ enum class EMassUnitCrowdMovementMode : uint8
 	Free3D UMETA(DisplayName = "Free 3D")
 };
 
+/** Local avoidance used while crowd units move. */
+UENUM(BlueprintType)
+enum class EMassUnitCrowdAvoidanceMode : uint8
+{
+	Separation UMETA(DisplayName = "Separation Steering"),
+	ORCA UMETA(DisplayName = "Reciprocal Velocity Obstacles (ORCA)")
+};
+
 /** Defines how an engagement-enabled group acquires its first player target. */
 UENUM(BlueprintType)
 enum class EMassUnitCrowdActivationMode : uint8
@@ -51,7 +64,7 @@ struct MASSUNITSYSTEMRUNTIME_API FMassUnitCrowdConfig
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd|Movement")
 	EMassUnitCrowdMovementMode MovementMode = EMassUnitCrowdMovementMode::Planar2D;
 
-	/** Follow native navmesh elevation in Planar2D navigation mode without per-unit ground traces. */
+	/** Follow ground elevation in Planar2D navigation mode from the cached height field, without per-unit ground traces. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd|Movement", meta = (EditCondition = "MovementMode == EMassUnitCrowdMovementMode::Planar2D"))
 	bool bConformToNavmeshHeight = true;
 
@@ -91,6 +104,14 @@ struct MASSUNITSYSTEMRUNTIME_API FMassUnitCrowdConfig
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd|Wander", meta = (ClampMin = "0.0", ForceUnits = "cm"))
 	float MinWanderDistance = 300.0f;
 
+	/**
+	 * Navmesh-projected wander points precomputed with Poisson-disk spacing
+	 * around each wander center of a Planar 2D navigation group. Destinations
+	 * are drawn from the pool; zero samples the wander disk freely instead.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd|Wander", meta = (ClampMin = "0", ClampMax = "512", UIMin = "0"))
+	int32 WanderPointPoolSize = 48;
+
 	/** Minimum pause after reaching a destination before selecting another one. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd|Wander", meta = (ClampMin = "0.0", ForceUnits = "s"))
 	float MinIdleTime = 0.5f;
@@ -123,6 +144,36 @@ struct MASSUNITSYSTEMRUNTIME_API FMassUnitCrowdConfig
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd|Avoidance", meta = (EditCondition = "bEnableSeparation", ClampMin = "0.0", ClampMax = "4.0"))
 	float SeparationWeight = 1.25f;
 
+	/**
+	 * Verlet skin added to the separation and interaction radii when caching each unit's neighbor list. A list is
+	 * reused until the unit plus its fastest group member could have covered this distance; zero rescans every decision.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd|Avoidance", meta = (ClampMin = "0.0", ForceUnits = "cm"))
+	float NeighborListSkin = 100.0f;
+
+	/**
+	 * Separation adds a repulsion vector at crowd-update rate. ORCA solves every frame for a velocity that
+	 * avoids reciprocal collisions within the time horizon. ORCA applies to Planar 2D groups; Free 3D keeps separation.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd|Avoidance")
+	EMassUnitCrowdAvoidanceMode AvoidanceMode = EMassUnitCrowdAvoidanceMode::Separation;
+
+	/** Body radius each unit reserves for itself when solving reciprocal avoidance. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd|Avoidance", meta = (EditCondition = "AvoidanceMode == EMassUnitCrowdAvoidanceMode::ORCA", ClampMin = "1.0", ForceUnits = "cm"))
+	float AvoidanceAgentRadius = 45.0f;
+
+	/** How far ahead collisions are anticipated. Longer horizons react earlier but produce more conservative velocities. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd|Avoidance", meta = (EditCondition = "AvoidanceMode == EMassUnitCrowdAvoidanceMode::ORCA", ClampMin = "0.1", ForceUnits = "s"))
+	float AvoidanceTimeHorizon = 1.0f;
+
+	/** Neighbors farther than this are ignored by the avoidance solver. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd|Avoidance", meta = (EditCondition = "AvoidanceMode == EMassUnitCrowdAvoidanceMode::ORCA", ClampMin = "1.0", ForceUnits = "cm"))
+	float AvoidanceNeighborDistance = 300.0f;
+
+	/** Closest neighbors considered per unit. Bounds the per-frame solver cost in dense crowds. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd|Avoidance", meta = (EditCondition = "AvoidanceMode == EMassUnitCrowdAvoidanceMode::ORCA", ClampMin = "1", ClampMax = "16", UIMin = "1", UIMax = "16"))
+	int32 MaxAvoidanceNeighbors = 8;
+
 	/** Enables occasional paired social pauses. Interactions broadcast a Blueprint event and do not imply combat. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd|Interaction")
 	bool bEnableInteractions = true;
@@ -279,6 +330,14 @@ struct MASSUNITSYSTEMRUNTIME_API FMassUnitCrowdStats
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crowd")
 	int32 SleepingUnits = 0;
 
+	/** Coarse dormant-grid cells that currently hold sleeping units. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crowd")
+	int32 DormantCells = 0;
+
+	/** Sleeping units returned to the active set by the most recent update. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crowd")
+	int32 UnitsWoken = 0;
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crowd")
 	int32 UnitsUpdated = 0;
 
@@ -291,26 +350,71 @@ struct MASSUNITSYSTEMRUNTIME_API FMassUnitCrowdStats
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crowd")
 	int32 NeighborChecks = 0;
 
+	/** Cached neighbor lists rebuilt from spatial-hash cells by the most recent update. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crowd")
+	int32 NeighborListsRebuilt = 0;
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crowd|Engagement")
 	int32 EngagedGroups = 0;
 
+	/** Living members of engaged groups, awake or sleeping. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crowd|Engagement")
 	int32 EngagedUnits = 0;
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crowd|Engagement")
 	int32 AttacksRequested = 0;
 
-	/** Group-level navmesh corridor queries issued by the most recent update. */
+	/** Group-level navmesh corridor queries requested by the most recent update. They land asynchronously. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crowd|Engagement")
 	int32 SharedPathsBuilt = 0;
 
-	/** Managed ambient subgroup corridors built by the most recent update. */
+	/** Managed ambient subgroup corridors requested by the most recent update. They land asynchronously. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crowd|Navigation")
 	int32 AmbientSharedPathsBuilt = 0;
 
 	/** Per-entity navmesh requests issued when shared navigation is explicitly disabled. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crowd|Engagement")
 	int32 PerUnitPathsRequested = 0;
+
+	/** Subgroup wander pools still waiting for, or partway through, a navmesh rebuild after the most recent update. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crowd|Navigation")
+	int32 WanderPoolsPending = 0;
+
+	/** Due units left for a later update because the time budget or unit cap ran out. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crowd|Cost")
+	int32 UnitsDeferred = 0;
+
+	/** Wall-clock cost of the whole update, in milliseconds. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crowd|Cost")
+	float UpdateMs = 0.0f;
+
+	/** Engagement activation, target sampling, and engaged corridor builds. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crowd|Cost")
+	float EngagementMs = 0.0f;
+
+	/** Observer wake checks over the dormant grid. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crowd|Cost")
+	float DormantMs = 0.0f;
+
+	/** Ambient subgroup corridor builds. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crowd|Cost")
+	float SharedPathMs = 0.0f;
+
+	/** Wander pool sampling and navmesh projection. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crowd|Cost")
+	float WanderPoolMs = 0.0f;
+
+	/** Priority scoring and ordering of due units. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crowd|Cost")
+	float ScheduleMs = 0.0f;
+
+	/** Parallel decide phase, summed over batches. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crowd|Cost")
+	float DecideMs = 0.0f;
+
+	/** Serial apply phase, summed over batches. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crowd|Cost")
+	float ApplyMs = 0.0f;
 };
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(
@@ -337,9 +441,11 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_FourParams(
 	FVector, WorldLocation);
 
 /**
- * World-owned, timer-driven behavior LOD for lightweight ambient crowds.
- * Smooth movement remains in the native Mass processor; this service only
- * performs budgeted decisions, spatial-hash steering, and interaction events.
+ * World-owned behavior LOD for lightweight ambient crowds, scheduled by
+ * UMassUnitCrowdProcessor. Smooth movement remains in the native Mass
+ * processor; this service only performs budgeted decisions, spatial-hash
+ * steering, and interaction events. Group state is kept here, keyed by group
+ * handle, so group membership never splits the unit archetype.
  */
 UCLASS(BlueprintType)
 class MASSUNITSYSTEMRUNTIME_API UMassUnitCrowdSystem : public UObject
@@ -354,6 +460,41 @@ public:
 		UMassUnitNavigationSystem* InNavigationSystem);
 	void Deinitialize();
 
+	/** Advances the crowd update clock by one frame. Returns true when a budgeted update is due. */
+	bool AdvanceUpdateClock(float DeltaTime);
+
+	/** Stores a registered unit's current location and liveness. UMassUnitCrowdProcessor calls this from its chunk pass. */
+	void SyncUnitLocation(FMassUnitEntityHandle Entity, const FVector& Location, bool bLiving);
+
+	/**
+	 * Budgeted crowd update, driven by UMassUnitCrowdProcessor after unit
+	 * locations are synced for this frame. BeginCrowdUpdate refreshes group
+	 * state and returns false when nothing needs scheduling. Otherwise the
+	 * processor calls ScheduleUnit for every awake unit from its chunk pass,
+	 * then DecideScheduledUnits, then WriteChunkSteering per chunk to store
+	 * steering-only results through fragment views, then FinishCrowdUpdate.
+	 */
+	bool BeginCrowdUpdate();
+	void ScheduleUnit(
+		FMassUnitEntityHandle Entity,
+		const FMassUnitCrowdFragment& Crowd,
+		const FMassUnitStateFragment& State,
+		const FMassUnitTargetFragment& Target,
+		const FMassUnitNavigationFragment& Navigation,
+		int32 ChunkOrdinal,
+		int32 ChunkIndex);
+	void DecideScheduledUnits();
+	bool HasPendingSteeringWrites() const { return SteeringWriteCursor < SteeringWrites.Num(); }
+	void WriteChunkSteering(int32 ChunkOrdinal, TConstArrayView<FMassEntityHandle> Entities, TArrayView<FMassUnitCrowdFragment> Crowds);
+	void FinishCrowdUpdate();
+
+	/**
+	 * Applies the actor damage and broadcasts the events queued by crowd
+	 * updates. UMassUnitSubsystem calls this after Mass processing, since
+	 * handlers may create or destroy entities.
+	 */
+	void FlushDeferredEvents();
+
 	/** Registers valid handles as one independently configurable crowd group. */
 	UFUNCTION(BlueprintCallable, Category = "Mass Unit System|Crowd", meta = (ReturnDisplayName = "Crowd Group Handle"))
 	int32 RegisterCrowdGroup(
@@ -385,6 +526,10 @@ public:
 	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Crowd")
 	int32 GetCrowdGroupUnitCount(int32 CrowdGroupHandle) const;
 
+	/** Centroid and bounds of the group's living members, awake or sleeping, as of the last spatial sync. False when none are alive. */
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Crowd")
+	bool GetCrowdGroupLivingBounds(int32 CrowdGroupHandle, FVector& OutCentroid, FBox& OutBounds) const;
+
 	/** Number of deterministic managed subgroups currently represented by this parent crowd. */
 	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Crowd|Subgroups")
 	int32 GetCrowdGroupSubgroupCount(int32 CrowdGroupHandle) const;
@@ -395,6 +540,10 @@ public:
 	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Crowd|Subgroups")
 	TArray<FMassUnitHandle> GetCrowdSubgroupUnits(int32 CrowdGroupHandle, int32 SubgroupIndex) const;
 
+	/** Navmesh-projected wander points currently used by a subgroup. Empty while its first pool is still building. */
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Crowd|Subgroups")
+	TArray<FVector> GetCrowdSubgroupWanderPoints(int32 CrowdGroupHandle, int32 SubgroupIndex) const;
+
 	/** Enables or updates player engagement for an existing group. Ambient behavior remains unchanged until configured. */
 	UFUNCTION(BlueprintCallable, Category = "Mass Unit System|Crowd|Engagement")
 	bool ConfigureCrowdGroupEngagement(
@@ -461,6 +610,12 @@ private:
 		int32 DecisionSequence = 0;
 		int32 Revision = 0;
 		bool bUsesNavmesh = false;
+		/** In-flight corridor query; members keep following SharedPathPoints until it lands. */
+		uint32 PendingPathQuery = 0;
+		/** Bumped per request and cancellation so a superseded corridor is never applied. */
+		int32 PathRequestSerial = 0;
+		/** Navmesh-projected wander points around this subgroup's wander center; empty when sampling freely. */
+		TArray<FVector> WanderPoints;
 	};
 
 	struct FCrowdGroup
@@ -487,13 +642,223 @@ private:
 		bool bSharedPathUsesNavmesh = false;
 		float NextTargetRefreshTime = 0.0f;
 		float NextSharedPathUpdateTime = 0.0f;
+		uint32 PendingSharedPathQuery = 0;
+		int32 SharedPathRequestSerial = 0;
+		/** Set when the navmesh under SharedPathPoints was rebuilt; the next refresh ignores the repath distance and interval. */
+		bool bSharedPathStale = false;
+		/** Snapshot of bEngaged && TargetActor.IsValid() taken before the parallel decide phase. */
+		bool bHasLiveEngagementTarget = false;
+		/** Members currently parked in the dormant grid. */
+		int32 DormantUnits = 0;
+		/**
+		 * Members not yet known to be dead, awake or sleeping. Adjusted when a
+		 * member joins, leaves, dies, or revives, never recounted.
+		 */
+		int32 LivingMembers = 0;
+		/** Upper bound, in centimeters, on how far any member has moved; advanced once per crowd update. */
+		double NeighborClock = 0.0;
+		/** Largest single-sync step of any member since the clock last advanced. */
+		float PendingNeighborStep = 0.0f;
+		/** Bumped when members enter the spatial hash, which cached neighbor lists cannot account for. */
+		int32 NeighborListRevision = 0;
+		/**
+		 * Living members as of the last spatial sync. Dormant members count at
+		 * their parked location, so sleeping and waking leave these unchanged.
+		 */
+		FVector LivingLocationSum = FVector::ZeroVector;
+		FBox LivingBounds = FBox(ForceInit);
+		int32 LivingUnits = 0;
+	};
+
+	/** A sleeping unit parked outside the spatial hash. */
+	struct FDormantUnit
+	{
+		FMassUnitEntityHandle Entity;
+		FVector Location = FVector::ZeroVector;
+		int32 GroupHandle = INDEX_NONE;
+		bool bLiving = true;
+	};
+
+	using FSpatialEntry = FMassUnitCrowdSpatialHash::FEntry;
+
+	struct FCachedNeighbor
+	{
+		FMassUnitEntityHandle Entity;
+		/** Dense hash index at build time; re-resolved when a removal swapped another entry into it. */
+		int32 EntryIndex = INDEX_NONE;
+	};
+
+	using FNeighborArray = TArray<FCachedNeighbor, TInlineAllocator<16>>;
+
+	/**
+	 * Same-group units within Radius of BuiltLocation when the list was built.
+	 * Separation and interaction-partner search both read it instead of
+	 * rescanning hash cells.
+	 */
+	struct FNeighborList
+	{
+		FNeighborArray Neighbors;
+		FVector BuiltLocation = FVector::ZeroVector;
+		double BuiltClock = 0.0;
+		float Radius = 0.0f;
+		int32 Revision = INDEX_NONE;
+	};
+
+	enum class ECrowdDecisionAction : uint8
+	{
+		None,
+		Skip,
+		Sleep,
+		Engaged,
+		Idle,
+		Decide
+	};
+
+	/** Fragment values read by the schedule and decide phases, captured once per update. */
+	struct FCrowdUnitInputs
+	{
+		FVector TargetLocation = FVector::ZeroVector;
+		FVector NavigationDestination = FVector::ZeroVector;
+		float NextDecisionTime = 0.0f;
+		float NextSteeringUpdateTime = 0.0f;
+		float InteractionEndTime = 0.0f;
+		int32 SubgroupIndex = 0;
+		int32 SharedPathRevision = INDEX_NONE;
+		int32 DecisionSequence = 0;
+		bool bEnabled = false;
+		bool bUse3DMovement = false;
+		bool bIncapacitated = false;
+		bool bHasTargetLocation = false;
+		bool bPathRequested = false;
+		bool bPathValid = false;
+
+		void Capture(
+			const FMassUnitCrowdFragment& Crowd,
+			const FMassUnitStateFragment& State,
+			const FMassUnitTargetFragment& Target,
+			const FMassUnitNavigationFragment& Navigation);
+	};
+
+	/**
+	 * Outcome of the read-only decide phase for one unit. Workers only fill
+	 * their own slot; every fragment, navigation, and group mutation happens
+	 * when the decision is applied on the game thread.
+	 */
+	struct FCrowdUnitDecision
+	{
+		FSpatialEntry Entry;
+		FCrowdUnitInputs Inputs;
+		/** Fresh neighbor list gathered by this decision; stored when the decision is applied. */
+		FNeighborArray RebuiltNeighbors;
+		FVector SteeringDirection = FVector::ZeroVector;
+		FVector SubgroupDestination = FVector::ZeroVector;
+		FVector WanderDestination = FVector::ZeroVector;
+		FMassUnitEntityHandle Partner;
+		FRandomStream InteractionStream;
+		FRandomStream WanderStream;
+		float LODMultiplier = 1.0f;
+		float IdleUntilTime = 0.0f;
+		int32 SimulationLOD = 0;
+		int32 NeighborChecks = 0;
+		ECrowdDecisionAction Action = ECrowdDecisionAction::None;
+		bool bRecalculatedSteering = false;
+		bool bRebuiltNeighbors = false;
+		bool bZeroSteering = false;
+		bool bEndInteraction = false;
+		bool bClearMovement = false;
+		bool bForceDecision = false;
+		bool bHasSubgroupDestination = false;
+		/** Where the processor's chunk pass found the unit; INDEX_NONE outside the processor. */
+		int32 ChunkOrdinal = INDEX_NONE;
+		int32 ChunkIndex = INDEX_NONE;
 	};
 
-	struct FSpatialEntry
+	/**
+	 * A decision that only refreshes steering. The processor writes it through
+	 * chunk fragment views; any it cannot match is written by handle.
+	 */
+	struct FCrowdSteeringWrite
 	{
 		FMassUnitEntityHandle Entity;
+		FVector SteeringDirection = FVector::ZeroVector;
+		float NextSteeringUpdateTime = 0.0f;
+		int32 GroupHandle = INDEX_NONE;
+		int32 SimulationLOD = 0;
+		int32 ChunkOrdinal = INDEX_NONE;
+		int32 ChunkIndex = INDEX_NONE;
+		bool bZeroSteering = false;
+		bool bRecalculatedSteering = false;
+		bool bEngaged = false;
+		bool bWritten = false;
+	};
+
+	/** Batches smaller than this are decided inline rather than dispatched to workers. */
+	static constexpr int32 MinParallelDecisionCount = 64;
+
+	/** Units decided and applied between two checks of the update time budget. */
+	static constexpr int32 DecisionBatchSize = 256;
+
+	/** Dormant-grid cells validated per update are one in this many, so destroyed sleepers are pruned lazily. */
+	static constexpr int32 DormantPruneStride = 16;
+
+	/** Wander points projected to the navmesh per crowd update, across all pending pool builds. */
+	static constexpr int32 WanderPointProjectionsPerUpdate = 128;
+
+	/**
+	 * A subgroup wander pool being rebuilt. The subgroup keeps its previous
+	 * points until every sample is projected, then swaps the new set in.
+	 */
+	struct FWanderPoolBuild
+	{
+		int32 GroupHandle = INDEX_NONE;
+		int32 SubgroupIndex = INDEX_NONE;
+		FVector WanderCenter = FVector::ZeroVector;
+		TArray<FVector2D> Samples;
+		TArray<FVector> WanderPoints;
+		int32 NextSample = 0;
+		bool bSampled = false;
+	};
+
+	enum class EDeferredEventType : uint8
+	{
+		Attack,
+		Interaction,
+		EngagementStarted,
+		EngagementEnded,
+		Cue
+	};
+
+	/**
+	 * A gameplay side effect raised while units are decided. Damage and event
+	 * handlers can spawn or destroy units, which Mass forbids while a
+	 * processor runs, so they wait for FlushDeferredEvents.
+	 */
+	struct FDeferredEvent
+	{
+		EDeferredEventType Type = EDeferredEventType::Cue;
+		FMassUnitEntityHandle UnitA;
+		FMassUnitEntityHandle UnitB;
+		TWeakObjectPtr<AActor> Actor;
+		TSubclassOf<UDamageType> DamageType;
+		TSubclassOf<UGameplayEffect> GameplayEffect;
 		FVector Location = FVector::ZeroVector;
 		int32 GroupHandle = INDEX_NONE;
+		int32 SubgroupIndex = INDEX_NONE;
+		float Damage = 0.0f;
+		float GameplayEffectLevel = 0.0f;
+		EMassUnitCrowdCue Cue = EMassUnitCrowdCue::MovementStarted;
+	};
+
+	struct FScheduledUnit
+	{
+		FMassUnitEntityHandle Entity;
+		FCrowdUnitInputs Inputs;
+		/** Spatial-hash index at scheduling time; only valid until the first decision is applied. */
+		int32 EntryIndex = INDEX_NONE;
+		int32 ChunkOrdinal = INDEX_NONE;
+		int32 ChunkIndex = INDEX_NONE;
+		float Priority = 0.0f;
+		bool bDue = false;
 	};
 
 	UPROPERTY(Transient)
@@ -508,79 +873,147 @@ private:
 	UPROPERTY(Transient)
 	TObjectPtr<UMassUnitNavigationSystem> NavigationSystem = nullptr;
 
+	FDelegateHandle NavigationAreasRebuiltHandle;
 	TMap<int32, FCrowdGroup> Groups;
 	TMap<FMassUnitEntityHandle, int32> UnitToGroup;
-	FTimerHandle UpdateTimer;
+	FMassUnitCrowdSpatialHash SpatialHash;
+	/** Sleeping units by coarse planar cell. Per-update crowd work never visits them; only observer wake checks do. */
+	TMap<FIntPoint, TArray<FDormantUnit>> DormantCells;
+	TMap<FMassUnitEntityHandle, FIntPoint> DormantCellByUnit;
+	TMap<FMassUnitEntityHandle, FNeighborList> NeighborLists;
+	TArray<FCrowdUnitDecision> PendingDecisions;
+	TArray<FScheduledUnit> ScheduledUnits;
+	TArray<FCrowdSteeringWrite> SteeringWrites;
+	TArray<FWanderPoolBuild> PendingWanderPools;
+	TArray<FDeferredEvent> DeferredEvents;
+	int32 SteeringWriteCursor = 0;
+	TArray<FVector> UpdateObserverLocations;
+	double UpdateStartTime = 0.0;
+	float UpdateTime = 0.0f;
 	FMassUnitCrowdStats LastStats;
+	/** Sum of LivingMembers over engaged groups; moved on engage, disengage, join, leave, and death. */
+	int32 EngagedUnitCount = 0;
 	int32 NextGroupHandle = 1;
 	int32 UpdateCursor = 0;
-	int32 MaxUnitsPerUpdate = 500;
+	int32 DormantPrunePhase = 0;
+	float DormantCellSize = 5000.0f;
+	int32 MaxUnitsPerUpdate = 2000;
 	int32 MaxSharedPathBuildsPerUpdate = 8;
 	float UpdateInterval = 0.1f;
-	float SpatialCellSize = 200.0f;
+	float TimeUntilNextUpdate = 0.0f;
+	double UpdateBudgetSeconds = 0.002;
+	double UpdateDeadline = 0.0;
 	bool bUpdatingCrowds = false;
+	bool bFlushingEvents = false;
+	bool bAuditPopulationStats = false;
+	bool bParallelDecisions = true;
 	TArray<float> SimulationLODDistances;
 	TArray<float> SimulationLODIntervalMultipliers;
 
-	void StartTimerIfNeeded();
-	void StopTimerIfIdle();
-	void UpdateCrowds();
 	void PruneInvalidUnits();
-	void BuildSpatialData(
-		TArray<FSpatialEntry>& OutEntries,
-		TMap<FIntVector, TArray<int32>>& OutCells,
-		TMap<FMassUnitEntityHandle, int32>& OutEntryByEntity) const;
+	void SyncSpatialHash();
+	void SyncEntryLocation(int32 EntryIndex, const FVector& Location, bool bLiving);
+	void RefreshGroupAggregates();
+	void AdvanceNeighborClocks();
 	void BuildObserverLocations(TArray<FVector>& OutObserverLocations) const;
-	void RefreshPopulationStats(const TArray<FSpatialEntry>& Entries);
+	void RefreshPopulationStats();
 	void RefreshManagedSubgroupPaths(
 		float CurrentTime,
-		const TArray<FSpatialEntry>& Entries,
 		int32 OnlyGroupHandle = INDEX_NONE,
 		bool bForceRefresh = false);
-	bool UpdateManagedSubgroupUnit(
+	bool CalculateManagedSubgroupDestination(
+		const FSpatialEntry& Entry,
+		int32 SubgroupIndex,
+		const FCrowdGroup& Group,
+		FVector& OutDestination) const;
+	bool ApplyManagedSubgroupDestination(
 		const FSpatialEntry& Entry,
 		FCrowdGroup& Group,
+		const FVector& Destination,
 		float CurrentTime,
 		float LODIntervalMultiplier);
-	void UpdateUnit(
-		const FSpatialEntry& Entry,
-		FCrowdGroup& Group,
-		const TArray<FSpatialEntry>& Entries,
-		const TMap<FIntVector, TArray<int32>>& Cells,
-		const TMap<FMassUnitEntityHandle, int32>& EntryByEntity,
+	int32 ScheduleUnits(const TArray<FVector>& ObserverLocations, float CurrentTime);
+	bool CaptureUnitInputs(FMassUnitEntityHandle Entity, FCrowdUnitInputs& OutInputs) const;
+	void ScoreScheduledUnit(FScheduledUnit& Unit, const TArray<FVector>& ObserverLocations, float CurrentTime) const;
+	bool HasUpdateBudget() const { return FPlatformTime::Seconds() < UpdateDeadline; }
+	void RefreshLiveEngagementTargets();
+	void ProcessPendingDecisions(const TArray<FVector>& ObserverLocations, float CurrentTime, bool bForceDecision);
+	void DecideUnit(
+		FCrowdUnitDecision& Decision,
 		const TArray<FVector>& ObserverLocations,
 		float CurrentTime,
-		bool bForceDecision);
-	FVector CalculateSeparation(
-		const FSpatialEntry& Entry,
-		const FCrowdGroup& Group,
-		const TArray<FSpatialEntry>& Entries,
-		const TMap<FIntVector, TArray<int32>>& Cells);
-	FMassUnitEntityHandle FindInteractionPartner(
-		const FSpatialEntry& Entry,
-		const FCrowdGroup& Group,
-		const TArray<FSpatialEntry>& Entries,
-		const TMap<FIntVector, TArray<int32>>& Cells,
-		float CurrentTime);
+		bool bForceDecision) const;
+	void ApplyUnitDecision(const FCrowdUnitDecision& Decision, FCrowdGroup& Group, float CurrentTime);
+	/** Returns false when an earlier decision claimed the unit as an interaction partner. */
+	static bool WriteSteering(const FCrowdSteeringWrite& Write, const FCrowdGroup& Group, FMassUnitCrowdFragment& Crowd, float CurrentTime);
+	void FlushSteeringWrites();
+	TConstArrayView<FCachedNeighbor> ResolveNeighborList(FCrowdUnitDecision& Decision, const FCrowdGroup& Group) const;
+	const FSpatialEntry* ResolveNeighbor(const FCachedNeighbor& Neighbor) const;
+	static float GetNeighborListRadius(const FCrowdGroup& Group);
+	FVector CalculateSeparation(FCrowdUnitDecision& Decision, const FCrowdGroup& Group) const;
+	FMassUnitEntityHandle FindInteractionPartner(FCrowdUnitDecision& Decision, const FCrowdGroup& Group, float CurrentTime) const;
+	bool IsInteractionCandidateAvailable(FMassUnitEntityHandle Candidate, float CurrentTime) const;
 	void BeginInteraction(
 		FMassUnitEntityHandle UnitA,
 		FMassUnitEntityHandle UnitB,
 		FCrowdGroup& Group,
 		float CurrentTime,
 		FRandomStream& RandomStream);
+	FVector ChooseWanderDestination(
+		const FVector& CurrentLocation,
+		int32 SubgroupIndex,
+		const FCrowdGroup& Group,
+		FRandomStream& RandomStream) const;
+	/** Queues every subgroup pool of the group for a budgeted rebuild. */
+	void BuildWanderPools(FCrowdGroup& Group);
+	void QueueWanderPoolBuild(int32 GroupHandle, int32 SubgroupIndex);
+	bool UsesWanderPools(const FCrowdGroup& Group) const;
+	void ProcessWanderPoolBuilds();
+	void SampleWanderPool(const FCrowdGroup& Group, FWanderPoolBuild& Build) const;
+	static float GetWanderPoolRadius(const FCrowdGroup& Group);
+	static bool PickWanderPoint(
+		TConstArrayView<FVector> WanderPoints,
+		const FVector& CurrentLocation,
+		float MinDistance,
+		FRandomStream& RandomStream,
+		FVector& OutPoint);
+	void HandleNavigationAreasRebuilt(TConstArrayView<FBox> RebuiltAreas);
+	static bool PathCrossesAreas(TConstArrayView<FVector> PathPoints, TConstArrayView<FBox> Areas);
 	bool AssignRandomDestination(
 		FMassUnitEntityHandle Entity,
 		FCrowdGroup& Group,
+		const FVector& Destination,
 		float CurrentTime,
 		float LODIntervalMultiplier,
 		FRandomStream& RandomStream);
 	void ClearMovement(FMassUnitEntityHandle Entity, bool bSetIdle) const;
-	void SetUnitSleeping(FMassUnitEntityHandle Entity, bool bSleeping, float CurrentTime) const;
+	void SetUnitSleeping(FMassUnitEntityHandle Entity, bool bSleeping, float CurrentTime);
+	void WakeDormantUnits(const TArray<FVector>& ObserverLocations, float CurrentTime, int32 OnlyGroupHandle = INDEX_NONE);
+	bool RemoveDormantUnit(FMassUnitEntityHandle Entity, bool* bOutLiving = nullptr);
+	FIntPoint ToDormantCell(const FVector& Location) const;
+	void AuditPopulationStats() const;
+	static void CopyGroupMovementSettings(const FCrowdGroup& Group, FMassUnitCrowdFragment& Crowd);
 	void ResetCrowdFragment(FMassUnitEntityHandle Entity, bool bStopUnit) const;
 	void RemoveUnitFromPreviousGroup(FMassUnitEntityHandle Entity);
+	void AdjustLivingMembers(FCrowdGroup& Group, int32 Delta);
 	void UpdateGroupEngagements(float CurrentTime);
 	bool UpdateEngagedUnit(const FSpatialEntry& Entry, FCrowdGroup& Group, float CurrentTime, bool bForceDecision);
 	bool RefreshSharedNavigationPath(FCrowdGroup& Group, float CurrentTime, bool bForceRefresh = false);
+	void HandleSubgroupPathBuilt(
+		int32 GroupHandle,
+		int32 SubgroupIndex,
+		int32 Serial,
+		const FVector& Anchor,
+		TArray<FVector>&& PathPoints,
+		bool bUsesNavmesh);
+	void HandleSharedPathBuilt(
+		int32 GroupHandle,
+		int32 Serial,
+		const FVector& Anchor,
+		const FVector& TargetLocation,
+		TArray<FVector>&& PathPoints,
+		bool bUsesNavmesh);
+	void CancelSharedPathQuery(uint32& QueryId, int32& Serial) const;
 	FVector CalculateSharedPathDestination(const FSpatialEntry& Entry, const FCrowdGroup& Group) const;
 	static FVector CalculatePathLookAheadDestination(
 		const FVector& Location,
@@ -594,14 +1027,12 @@ private:
 		const FVector& WorldLocation,
 		int32 SubgroupIndex = INDEX_NONE);
 	AActor* FindClosestPlayerTarget(const FVector& Origin, float MaxDistance) const;
-	float CalculateClosestLivingUnitDistanceSquared(const FCrowdGroup& Group, const FVector& Location) const;
+	bool HasLivingUnitWithin(const FCrowdGroup& Group, const FVector& Location, float Radius) const;
 	FVector CalculateFollowOffset(FMassUnitEntityHandle Entity, const FCrowdGroup& Group) const;
-	FVector CalculateSubgroupWanderCenter(FMassUnitEntityHandle Entity, const FCrowdGroup& Group) const;
 	FVector CalculateSubgroupWanderCenter(int32 SubgroupIndex, const FCrowdGroup& Group) const;
 	FRandomStream MakeRandomStream(FMassUnitEntityHandle Entity, const FCrowdGroup& Group, int32 DecisionSequence) const;
 	int32 CalculateSimulationLOD(const FVector& Location, const TArray<FVector>& ObserverLocations, float& OutDistanceSquared) const;
 	float GetSimulationIntervalMultiplier(int32 LODLevel) const;
-	FIntVector ToSpatialCell(const FVector& Location, bool bUse3DMovement) const;
 	static FMassUnitCrowdConfig SanitizeConfig(const FMassUnitCrowdConfig& Config);
 	static FMassUnitPlayerEngagementConfig SanitizeEngagementConfig(const FMassUnitPlayerEngagementConfig& Config);
 	bool IsEntityValid(FMassUnitEntityHandle Entity) const;
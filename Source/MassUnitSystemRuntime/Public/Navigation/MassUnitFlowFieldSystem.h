@@ -0,0 +1,201 @@
+// Copyright Digi Logic Labs LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Entity/MassUnitEntityManager.h"
+#include "HAL/CriticalSection.h"
+#include "MassUnitFlowFieldSystem.generated.h"
+
+class UMassEntitySubsystem;
+class UMassUnitEntityManager;
+class UMassUnitNavigationSystem;
+
+/**
+ * Flow fields integrated as of one game-thread update. A published snapshot
+ * never changes, so the movement and avoidance processors sample it from any
+ * thread without locking.
+ */
+class MASSUNITSYSTEMRUNTIME_API FMassUnitFlowFieldSnapshot
+{
+public:
+	struct FField
+	{
+		FVector Goal = FVector::ZeroVector;
+		FIntPoint MinTile = FIntPoint::ZeroValue;
+		FIntPoint MaxTile = FIntPoint::ZeroValue;
+		/** Neighbor index toward the goal per cell, row-major over the tile rectangle. */
+		TArray<uint8> Directions;
+		/** Navmesh height per cell, copied from the walkability tiles. */
+		TArray<float> Heights;
+	};
+
+	using FFieldPtr = TSharedPtr<const FField, ESPMode::ThreadSafe>;
+
+	/**
+	 * Resolves the next steering waypoint for a unit at Location. Returns false
+	 * for evicted or not yet integrated fields, locations outside the field and
+	 * unreachable cells; callers steer straight at the unit's destination then.
+	 */
+	bool SampleSteeringPoint(int32 FieldHandle, const FVector& Location, FVector& OutSteeringPoint) const;
+
+	int32 Num() const { return Fields.Num(); }
+
+private:
+	friend class UMassUnitFlowFieldSystem;
+
+	TMap<int32, FFieldPtr> Fields;
+	float CellSize = 100.0f;
+};
+
+/**
+ * Shared grid flow fields for mass move orders.
+ *
+ * One field is integrated per destination over a navmesh-projected grid, then
+ * every unit ordered there samples it in the movement processor, so a move
+ * order costs one field build regardless of unit count. Walkability is stored
+ * in fixed-size tiles that are shared by every cached field. Each tile is
+ * projected around a height taken from the navmesh of the tile it was reached
+ * from, so fields follow slopes and ramps. New, widened, and invalidated
+ * fields are built a few tiles per frame; rebuilt navmesh areas drop only the
+ * tiles they overlap. Readers only see immutable snapshots, and a field enters
+ * the snapshot once it has been integrated.
+ */
+UCLASS(BlueprintType)
+class MASSUNITSYSTEMRUNTIME_API UMassUnitFlowFieldSystem : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	/** Cells along one edge of a walkability or direction tile. */
+	static constexpr int32 TileCells = 16;
+
+	/** Walkability tiles projected per frame while building or rebuilding fields. */
+	static constexpr int32 MaxTileBuildsPerFrame = 4;
+
+	void Initialize(
+		UWorld* InWorld,
+		UMassEntitySubsystem* InEntitySubsystem,
+		UMassUnitEntityManager* InUnitManager,
+		UMassUnitNavigationSystem* InNavigationSystem);
+	void Deinitialize();
+
+	/**
+	 * Orders every unit to one destination through a shared flow field. Queued
+	 * per-unit path requests for these units are cancelled. Without usable
+	 * navigation data, units receive the configured direct fallback instead.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Mass Unit System|Navigation", meta = (ReturnDisplayName = "Commanded Unit Count"))
+	int32 MoveUnitsToLocation(const TArray<FMassUnitHandle>& Units, FVector Destination, float AcceptanceRadius = 50.0f);
+
+	int32 MoveUnitsToLocationInternal(TConstArrayView<FMassUnitEntityHandle> Entities, const FVector& Destination, float AcceptanceRadius);
+
+	using FSnapshotRef = TSharedRef<const FMassUnitFlowFieldSnapshot, ESPMode::ThreadSafe>;
+
+	/**
+	 * Returns the cached field for Destination, queueing a build or widening so
+	 * it covers Bounds. The field is sampled once RebuildDirtyFields has
+	 * integrated it. Returns INDEX_NONE when no field can be built.
+	 */
+	int32 FindOrBuildField(const FVector& Destination, const FBox& Bounds);
+
+	/** Fields integrated as of the last update. Any thread; hold it for one processor pass. */
+	FSnapshotRef GetSnapshot() const;
+
+	/** Samples the current snapshot. See FMassUnitFlowFieldSnapshot::SampleSteeringPoint. */
+	bool SampleSteeringPoint(int32 FieldHandle, const FVector& Location, FVector& OutSteeringPoint) const;
+
+	/**
+	 * Builds queued fields, spending at most MaxTileBuildsPerFrame tile
+	 * projections and one integration, then publishes a new snapshot. Units
+	 * keep the previous directions, or steer straight at the goal, until their
+	 * field is integrated. Called by the world subsystem each tick.
+	 */
+	void RebuildDirtyFields();
+
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Navigation")
+	int32 GetPendingFieldRebuildCount() const { return PendingFieldRebuilds.Num(); }
+
+	/** Drops every cached field and walkability tile. */
+	UFUNCTION(BlueprintCallable, Category = "Mass Unit System|Navigation")
+	void ClearCache();
+
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Navigation")
+	int32 GetCachedFieldCount() const { return Fields.Num(); }
+
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Navigation")
+	int32 GetCachedTileCount() const { return WalkTiles.Num(); }
+
+	/** Total field integrations since initialization, including widened rebuilds. */
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Navigation")
+	int32 GetFieldBuildCount() const { return FieldBuildCount; }
+
+private:
+	struct FWalkTile
+	{
+		TArray<float> Heights;
+		TArray<uint8> Walkable;
+	};
+
+	/** Keys a tile by its cell rectangle and the projection band it was built around. */
+	using FWalkTileKey = FIntVector;
+
+	struct FFlowField
+	{
+		FVector Goal = FVector::ZeroVector;
+		FIntPoint GoalCell = FIntPoint::ZeroValue;
+		FIntPoint MinTile = FIntPoint::ZeroValue;
+		FIntPoint MaxTile = FIntPoint::ZeroValue;
+		int32 HeightBand = 0;
+		/** Walkability tile of each tile in the rectangle, row-major. */
+		TArray<FWalkTileKey> TileKeys;
+		/** Last integration, shared with snapshots. Null until the first build completes. */
+		FMassUnitFlowFieldSnapshot::FFieldPtr Integrated;
+		double LastUsedTime = 0.0;
+		bool bRebuildPending = false;
+	};
+
+	UPROPERTY(Transient)
+	TObjectPtr<UWorld> World = nullptr;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UMassEntitySubsystem> EntitySubsystem = nullptr;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UMassUnitEntityManager> UnitManager = nullptr;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UMassUnitNavigationSystem> NavigationSystem = nullptr;
+
+	TMap<FWalkTileKey, FWalkTile> WalkTiles;
+	TMap<int32, FFlowField> Fields;
+	TArray<int32> PendingFieldRebuilds;
+	TMap<FIntVector, int32> FieldByGoalCell;
+	int32 NextFieldHandle = 0;
+	int32 FieldBuildCount = 0;
+	float CellSize = 100.0f;
+	float ProjectionHeight = 250.0f;
+	int32 MaxFieldTiles = 256;
+	int32 MaxCachedFields = 16;
+
+	mutable FRWLock SnapshotLock;
+	FSnapshotRef Snapshot = MakeShared<FMassUnitFlowFieldSnapshot, ESPMode::ThreadSafe>();
+
+	FDelegateHandle NavigationAreasRebuiltHandle;
+
+	void HandleNavigationAreasRebuilt(TConstArrayView<FBox> RebuiltAreas);
+
+	FIntPoint ToCell(const FVector& Location) const;
+	int32 ToHeightBand(float Z) const;
+	FWalkTileKey ToWalkTileKey(const FIntPoint& Tile, float ReferenceZ) const;
+	void BuildWalkTile(const FWalkTileKey& TileKey);
+
+	/**
+	 * Resolves the walkability tile of every tile in the field, building missing
+	 * ones until TileBudget runs out. Returns false if tiles are still missing.
+	 */
+	bool BuildFieldTiles(FFlowField& Field, int32& TileBudget);
+	void IntegrateField(FFlowField& Field);
+	void EvictLeastRecentlyUsedFields();
+	void PublishSnapshot();
+};
@@ -0,0 +1,134 @@
+// Copyright Digi Logic Labs LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/LruCache.h"
+#include "HAL/CriticalSection.h"
+#include "MassUnitHeightFieldSystem.generated.h"
+
+class UMassUnitNavigationSystem;
+
+/**
+ * Height tiles built as of one game-thread update. A published snapshot never
+ * changes, so movement processors read it from any thread without locking.
+ */
+class MASSUNITSYSTEMRUNTIME_API FMassUnitHeightFieldSnapshot
+{
+public:
+	struct FTile
+	{
+		TArray<float> Heights;
+		TArray<uint8> Valid;
+	};
+
+	using FTilePtr = TSharedPtr<const FTile, ESPMode::ThreadSafe>;
+
+	/**
+	 * Interpolates the ground height under Location from the four nearest
+	 * cells. Location.Z selects the height band, so stacked floors resolve
+	 * separately. Returns false when the field is disabled, when no ground was
+	 * found nearby, or when a tile is not built yet; tiles that are not built
+	 * are added to OutMissingTiles.
+	 */
+	bool SampleHeight(const FVector& Location, float& OutHeight, TSet<FIntVector>* OutMissingTiles = nullptr) const;
+
+	/** Tile holding the cell under Location. */
+	FIntVector ToTileKey(const FVector& Location) const;
+
+	int32 Num() const { return Tiles.Num(); }
+
+private:
+	friend class UMassUnitHeightFieldSystem;
+
+	TMap<FIntVector, FTilePtr> Tiles;
+	float CellSize = 0.0f;
+	float ProjectionHeight = 250.0f;
+
+	int32 ToHeightBand(float Z) const { return FMath::FloorToInt(Z / (ProjectionHeight * 2.0f)); }
+	bool GetCellHeight(const FIntPoint& Cell, int32 HeightBand, float& OutHeight, TSet<FIntVector>* OutMissingTiles) const;
+};
+
+/**
+ * Cached ground heights for planar crowd movement.
+ *
+ * Heights are sampled once per grid cell from the navmesh, or from static
+ * world geometry where the navmesh has no polygon, in fixed-size tiles built
+ * as units walk into them. The movement processor reads them with bilinear
+ * lookups, so conforming units follow terrain on any path, fallback, or
+ * formation destination without per-unit ground traces. Readers only see
+ * immutable snapshots and report the tiles they used or missed; the game
+ * thread builds missing tiles within a per-frame budget and publishes the
+ * next snapshot. Tiles that intersect an area the navmesh rebuilt are
+ * dropped and rebuild as units report them missing again.
+ */
+UCLASS(BlueprintType)
+class MASSUNITSYSTEMRUNTIME_API UMassUnitHeightFieldSystem : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	/** Cells along one edge of a height tile. */
+	static constexpr int32 TileCells = 16;
+
+	using FSnapshotRef = TSharedRef<const FMassUnitHeightFieldSnapshot, ESPMode::ThreadSafe>;
+
+	void Initialize(UWorld* InWorld, UMassUnitNavigationSystem* InNavigationSystem);
+	void Deinitialize();
+
+	/** Tiles built as of the last update. Any thread; hold it for one processor pass. */
+	FSnapshotRef GetSnapshot() const;
+
+	/**
+	 * Reports tiles a reader sampled and tiles it found missing. Any thread.
+	 * The next update keeps used tiles cached and builds missing ones.
+	 */
+	void ReportTileUse(const TSet<FIntVector>& UsedTiles, const TSet<FIntVector>& MissingTiles);
+
+	/** Builds reported tiles, at most a few per frame, and publishes a new snapshot. Game thread only. */
+	void BuildRequestedTiles();
+
+	/** Drops every cached height tile. */
+	UFUNCTION(BlueprintCallable, Category = "Mass Unit System|Navigation")
+	void ClearCache();
+
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Navigation")
+	int32 GetCachedTileCount() const { return Tiles.Num(); }
+
+	/** Total tile builds since initialization, including rebuilds after navmesh generation. */
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Navigation")
+	int32 GetTileBuildCount() const { return TileBuildCount; }
+
+private:
+	using FTile = FMassUnitHeightFieldSnapshot::FTile;
+	using FTilePtr = FMassUnitHeightFieldSnapshot::FTilePtr;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UWorld> World = nullptr;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UMassUnitNavigationSystem> NavigationSystem = nullptr;
+
+	static constexpr int32 MaxTileBuildsPerFrame = 4;
+
+	/** Game-thread owner of every built tile; snapshots share the tiles. */
+	TLruCache<FIntVector, FTilePtr> Tiles;
+	float CellSize = 100.0f;
+	float ProjectionHeight = 250.0f;
+	int32 TileBuildCount = 0;
+
+	mutable FRWLock SnapshotLock;
+	FSnapshotRef Snapshot = MakeShared<FMassUnitHeightFieldSnapshot, ESPMode::ThreadSafe>();
+
+	/** Reports gathered since the last update, guarded by ReportLock. */
+	FCriticalSection ReportLock;
+	TSet<FIntVector> ReportedUsedTiles;
+	TSet<FIntVector> ReportedMissingTiles;
+
+	FDelegateHandle NavigationAreasRebuiltHandle;
+
+	void HandleNavigationAreasRebuilt(TConstArrayView<FBox> RebuiltAreas);
+
+	FTilePtr BuildTile(const FIntVector& TileKey);
+	void PublishSnapshot();
+};
@@ -3,6 +3,8 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Containers/LruCache.h"
+#include "Containers/RingBuffer.h"
 #include "Entity/MassUnitEntityManager.h"
 #include "NavigationPath.h"
 #include "MassUnitNavigationSystem.generated.h"
@@ -11,6 +13,56 @@ class ANavigationData;
 class UMassEntitySubsystem;
 class UNavigationSystemV1;
 
+/** Broadcast once navmesh generation finishes, with the areas dirtied since the previous broadcast. */
+DECLARE_MULTICAST_DELEGATE_OneParam(FMassUnitNavigationAreasRebuilt, TConstArrayView<FBox> /*RebuiltAreas*/);
+
+/** Receives a shared corridor built by FindSharedPathAsync. Points are empty when no path or fallback was available. */
+using FMassUnitSharedPathCallback = TUniqueFunction<void(TArray<FVector>&& PathPoints, bool bUsesNavmesh)>;
+
+/**
+ * Service band for queued per-unit path requests. Each band is a target wait:
+ * higher bands are served first among requests queued at the same time, and a
+ * lower-band request that has waited long enough overtakes newer higher-band ones.
+ */
+UENUM(BlueprintType)
+enum class EMassUnitPathPriority : uint8
+{
+	/** Direct commands and units engaged with a player. */
+	High,
+	/** Ambient units near an observer. */
+	Normal,
+	/** Ambient units in a reduced behavior LOD. */
+	Low
+};
+
+/** Time spent in the per-unit path queue, over the most recent served requests. */
+USTRUCT(BlueprintType)
+struct MASSUNITSYSTEMRUNTIME_API FMassUnitPathQueueStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Navigation", meta = (ForceUnits = "ms"))
+	float P50LatencyMs = 0.0f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Navigation", meta = (ForceUnits = "ms"))
+	float P95LatencyMs = 0.0f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Navigation", meta = (ForceUnits = "ms"))
+	float P99LatencyMs = 0.0f;
+
+	/** Served requests the percentiles cover; at most the most recent 1024. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Navigation")
+	int32 SampleCount = 0;
+
+	/** Requests served after their Max Latency since initialization. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Navigation")
+	int32 DeadlineMisses = 0;
+
+	/** Frames that stopped serving requests because Path Request Budget Ms was spent, since initialization. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Navigation")
+	int32 BudgetExhaustedFrames = 0;
+};
+
 /** Batched asynchronous navmesh path service for Mass units. */
 UCLASS(BlueprintType)
 class MASSUNITSYSTEMRUNTIME_API UMassUnitNavigationSystem : public UObject
@@ -24,10 +76,27 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Mass Unit System|Navigation")
 	void UpdateNavigationData(UWorld* InWorld);
 
+	/** MaxLatency, in seconds, moves the request ahead of anything due later; zero leaves only the band and observer distance. */
 	UFUNCTION(BlueprintCallable, Category = "Mass Unit System|Navigation")
-	bool RequestPath(FMassUnitHandle UnitHandle, const FVector& Destination, float AcceptanceRadius = 50.0f);
+	bool RequestPath(
+		FMassUnitHandle UnitHandle,
+		const FVector& Destination,
+		float AcceptanceRadius = 50.0f,
+		EMassUnitPathPriority Priority = EMassUnitPathPriority::High,
+		float MaxLatency = 0.0f);
 
-	bool RequestPathInternal(FMassUnitEntityHandle Entity, const FVector& Destination, float AcceptanceRadius = 50.0f);
+	/**
+	 * Queues a path in the given band. Requests are served earliest target
+	 * time first: the band sets the base wait, distance from the nearest
+	 * observer lengthens it, and a positive MaxLatency caps it. A unit's newer
+	 * request supersedes its queued or in-flight one in constant time.
+	 */
+	bool RequestPathInternal(
+		FMassUnitEntityHandle Entity,
+		const FVector& Destination,
+		float AcceptanceRadius = 50.0f,
+		EMassUnitPathPriority Priority = EMassUnitPathPriority::High,
+		float MaxLatency = 0.0f);
 
 	/**
 	 * Calculates one native navmesh corridor for a group anchor. The caller can
@@ -40,6 +109,20 @@ public:
 		TArray<FVector>& OutPathPoints,
 		bool* bOutUsesNavmesh = nullptr);
 
+	/**
+	 * Builds the same shared corridor as FindSharedPath without blocking the
+	 * game thread. OnComplete runs on the game thread when the navmesh query
+	 * lands, or before this returns when no query is needed (missing nav data,
+	 * failed projection). Returns the query id, or 0 when already completed.
+	 */
+	uint32 FindSharedPathAsync(
+		const FVector& Start,
+		const FVector& Destination,
+		FMassUnitSharedPathCallback&& OnComplete);
+
+	/** Drops an in-flight shared corridor query. Its callback never runs. */
+	void CancelSharedPath(uint32 QueryId);
+
 	/** Projects one lightweight shared-crowd slot onto the active navmesh without building an individual path. */
 	bool ProjectPointToNavigation(const FVector& Point, FVector& OutProjectedLocation);
 
@@ -49,13 +132,74 @@ public:
 
 	bool CancelPathInternal(FMassUnitEntityHandle Entity);
 
+	/** Cancels queued/in-flight work for many units. Paths are left untouched. */
+	void CancelPathsInternal(TConstArrayView<FMassUnitEntityHandle> Entities);
+
+	/** Drops all queued, in-flight, route, and index state of destroyed units. */
+	void ForgetUnitsInternal(TConstArrayView<FMassUnitEntityHandle> Entities);
+
 	UFUNCTION(BlueprintCallable, Category = "Mass Unit System|Navigation")
 	void ProcessPathRequests();
 
 	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Navigation")
-	int32 GetQueuedRequestCount() const { return PathRequestQueue.Num() + PendingPathOwners.Num(); }
+	int32 GetQueuedRequestCount() const { return QueuedRequestTickets.Num() + PendingPathIds.Num(); }
+
+	/** Entries in the request heap, including superseded and cancelled ones not yet compacted away. */
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Navigation")
+	int32 GetPathRequestHeapSize() const { return PathRequestHeap.Num(); }
+
+	/** Queue latency percentiles over recently served requests, plus deadline and budget counters. */
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Navigation")
+	FMassUnitPathQueueStats GetPathQueueStats() const;
+
+	/** Drops every cached corridor. Called automatically when navmesh generation finishes. */
+	UFUNCTION(BlueprintCallable, Category = "Mass Unit System|Navigation")
+	void ClearPathCache();
+
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Navigation")
+	int32 GetCachedPathCount() const { return PathCache.Num(); }
+
+	/** Approximate heap use of the corridor cache, in bytes. */
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Navigation")
+	int64 GetPathCacheMemory() const { return PathCacheBytes; }
+
+	/** Path requests answered from the cache since initialization. */
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Navigation")
+	int32 GetPathCacheHitCount() const { return PathCacheHits; }
+
+	/** Path requests that missed the cache and issued a navmesh query since initialization. */
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Navigation")
+	int32 GetPathCacheMissCount() const { return PathCacheMisses; }
+
+	/** Path requests that joined another unit's query instead of issuing their own since initialization. */
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Navigation")
+	int32 GetCoalescedRequestCount() const { return CoalescedPathRequests; }
+
+	/** Units following a long-distance cluster route whose later clusters are not yet refined. */
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Navigation")
+	int32 GetHierarchicalRouteCount() const { return HierarchicalRoutes.Num(); }
+
+	/** Clusters of the hierarchical planner's graph built so far. Clusters near rebuilt navmesh are dropped when generation finishes. */
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Navigation")
+	int32 GetPathClusterCount() const { return PathClusters.Num(); }
+
+	/** Units whose corridors crossed rebuilt navmesh and still wait for their time-sliced repath. */
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Navigation")
+	int32 GetPendingRepathCount() const { return StalePaths.Num(); }
+
+	/** Repaths queued because a unit's corridor crossed rebuilt navmesh, since initialization. */
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Navigation")
+	int32 GetRepathCount() const { return RepathsRequested; }
+
+	/**
+	 * Lets owners of shared corridors and cached navmesh data (crowd subgroups,
+	 * engagements, flow fields) invalidate what crosses rebuilt areas. Broadcast
+	 * whenever generation finishes; an empty view means the areas are unknown.
+	 */
+	FMassUnitNavigationAreasRebuilt OnNavigationAreasRebuilt;
 
 	UNavigationSystemV1* GetNavigationSystem() const { return NavigationSystem; }
+	ANavigationData* GetNavigationData() const { return NavigationData; }
 
 private:
 	UPROPERTY(Transient)
@@ -75,16 +219,243 @@ private:
 		FMassUnitEntityHandle Entity;
 		FVector Destination = FVector::ZeroVector;
 		float AcceptanceRadius = 50.0f;
+		/** Matches the owner's entry in QueuedRequestTickets while the request is current. */
+		uint32 Ticket = 0;
+		EMassUnitPathPriority Priority = EMassUnitPathPriority::High;
+		/** Platform seconds at which the request should be served; the queue is ordered by it. */
+		double TargetTime = 0.0;
+		double EnqueueTime = 0.0;
+		/** Zero when the request has no Max Latency. */
+		double Deadline = 0.0;
+
+		bool operator<(const FPathRequest& Other) const { return TargetTime < Other.TargetTime; }
+	};
+
+	/** A unit waiting on a navmesh query, with the projected end points of its own request. */
+	struct FPathMember
+	{
+		FMassUnitEntityHandle Entity;
+		FVector Start = FVector::ZeroVector;
+		/** End of the queried corridor; the next window's goal on a hierarchical route. */
+		FVector Destination = FVector::ZeroVector;
+		/** Ordered goal the unit's fragments keep while its route is refined window by window. */
+		FVector FinalDestination = FVector::ZeroVector;
+		float AcceptanceRadius = 50.0f;
+		EMassUnitPathPriority Priority = EMassUnitPathPriority::High;
+	};
+
+	/** One in-flight query. Coalesced requests add members; the first member's end points were queried. */
+	struct FPendingPath
+	{
+		TArray<FPathMember, TInlineAllocator<1>> Members;
+		/** Start the query ran from; other members check their own way onto the corridor. */
+		FVector QueryStart = FVector::ZeroVector;
+	};
+
+	static constexpr int32 NumPathPriorities = 3;
+	/** Cache hits and coalesced members are cheap, so one frame serves up to this many requests per query slot. */
+	static constexpr int32 RequestsPerQuerySlot = 16;
+	/** Base wait per band; wider than the observer-distance term so bands only cross through waiting. */
+	static constexpr double BandWaitSeconds[NumPathPriorities] = {0.0, 1.0, 3.0};
+	/** Extra wait for a unit at or beyond ObserverWaitDistance from every observer. */
+	static constexpr double MaxObserverWaitSeconds = 0.75;
+	static constexpr float ObserverWaitDistance = 10000.0f;
+	static constexpr int32 MaxLatencySamples = 1024;
+	/** Below this size, stale heap entries are left for PopPathRequest to skip. */
+	static constexpr int32 MinHeapCompactionSize = 64;
+
+	/**
+	 * Binary min-heap on TargetTime. Superseded and cancelled requests are not
+	 * searched for; they stay in place with a stale ticket and are dropped
+	 * when popped, or all at once when they make up most of the heap.
+	 */
+	TArray<FPathRequest> PathRequestHeap;
+	TMap<FMassUnitEntityHandle, uint32> QueuedRequestTickets;
+	TMap<uint32, FPendingPath> PendingPaths;
+	TMap<FMassUnitEntityHandle, uint32> PendingPathIds;
+	uint32 NextRequestTicket = 0;
+	/** Observer locations for request scoring, gathered once per frame. */
+	TArray<FVector> ObserverLocations;
+	uint64 ObserverFrame = MAX_uint64;
+	/** Ring of recent queue latencies, in seconds. */
+	TArray<float> LatencySamples;
+	int32 NextLatencySample = 0;
+	int32 DeadlineMisses = 0;
+	int32 BudgetExhaustedFrames = 0;
+
+	/** In-flight shared corridor queries and the destination used for their direct fallback. */
+	struct FPendingSharedPath
+	{
+		FVector Destination = FVector::ZeroVector;
+		FMassUnitSharedPathCallback OnComplete;
+	};
+
+	TMap<uint32, FPendingSharedPath> PendingSharedPaths;
+
+	/** Navmesh corridor a unit is following, kept so it can be requeued when its area rebuilds. */
+	struct FIndexedPath
+	{
+		FVector Destination = FVector::ZeroVector;
+		float AcceptanceRadius = 50.0f;
+		EMassUnitPathPriority Priority = EMassUnitPathPriority::High;
+		uint32 Serial = 0;
 	};
 
-	TArray<FPathRequest> PathRequestQueue;
-	TMap<uint32, FMassUnitEntityHandle> PendingPathOwners;
+	/** Index cell or backlog entry; stale once the unit's IndexedPaths serial moves on. */
+	struct FIndexedPathRef
+	{
+		FMassUnitEntityHandle Entity;
+		uint32 Serial = 0;
+	};
+
+	static constexpr int32 MaxRepathsPerFrame = 32;
+	static constexpr int32 MaxDirtyAreas = 64;
+
+	TMap<FMassUnitEntityHandle, FIndexedPath> IndexedPaths;
+	TMap<FIntPoint, TArray<FIndexedPathRef>> PathIndex;
+	float PathIndexCellSize = 1000.0f;
+	uint32 NextIndexSerial = 0;
+	TArray<FBox> DirtyAreas;
+	TRingBuffer<FIndexedPathRef> StalePaths;
+	int32 RepathsRequested = 0;
+	FDelegateHandle NavigationDirtyHandle;
+
+	/** Requests share a corridor when they start and end on the same polygons of the same nav data (one per agent). */
+	struct FPathCacheKey
+	{
+		NavNodeRef StartPoly = INVALID_NAVNODEREF;
+		NavNodeRef GoalPoly = INVALID_NAVNODEREF;
+		uint32 NavDataId = 0;
+
+		bool operator==(const FPathCacheKey& Other) const
+		{
+			return StartPoly == Other.StartPoly && GoalPoly == Other.GoalPoly && NavDataId == Other.NavDataId;
+		}
+
+		friend uint32 GetTypeHash(const FPathCacheKey& Key)
+		{
+			return HashCombineFast(HashCombineFast(GetTypeHash(Key.StartPoly), GetTypeHash(Key.GoalPoly)), Key.NavDataId);
+		}
+	};
+
+	struct FCachedPath
+	{
+		/**
+		 * Polygons from the start polygon to the goal polygon. Each hit string-pulls
+		 * its own end points through them, so corners always fit the new start.
+		 */
+		TArray<NavNodeRef> Corridor;
+	};
+
+	TLruCache<FPathCacheKey, FCachedPath> PathCache;
+	int64 PathCacheBytes = 0;
+	int32 PathCacheHits = 0;
+	int32 PathCacheMisses = 0;
+	int32 CoalescedPathRequests = 0;
+	float PathCoalesceCellSize = 500.0f;
+
+	/** Navmesh cluster of the hierarchical planner, projected and linked lazily on first use. */
+	struct FPathCluster
+	{
+		FVector Location = FVector::ZeroVector;
+		bool bWalkable = false;
+		/** One bit per neighbor direction: whether the link was tested, and whether it is open. */
+		uint8 TestedLinks = 0;
+		uint8 OpenLinks = 0;
+	};
+
+	/** Abstract route of a long-distance request. Only the next few clusters are refined into a corridor. */
+	struct FHierarchicalRoute
+	{
+		TArray<FVector> Waypoints;
+		int32 NextWaypoint = 0;
+		FVector Destination = FVector::ZeroVector;
+		float AcceptanceRadius = 50.0f;
+		EMassUnitPathPriority Priority = EMassUnitPathPriority::High;
+	};
+
+	enum class EClusterRouteResult : uint8
+	{
+		Found,
+		NotFound,
+		/** The frame's cluster budget ran out; the request retries next frame with the clusters and links found so far. */
+		Deferred
+	};
+
+	static constexpr int32 RefinedClusterCount = 3;
+	static constexpr int32 MaxClusterExpansions = 4096;
+	static constexpr int32 MaxClusterLinkTestsPerFrame = 128;
+
+	TMap<FIntPoint, FPathCluster> PathClusters;
+	TMap<FMassUnitEntityHandle, FHierarchicalRoute> HierarchicalRoutes;
+	float HierarchicalPathDistance = 20000.0f;
+	float PathClusterSize = 5000.0f;
+	int32 ClusterLinkTestsThisFrame = 0;
+	/** Platform seconds at which this frame started serving requests; cluster work shares the request budget. */
+	double ServeStartTime = 0.0;
 
 	UPROPERTY(EditAnywhere, Category = "Navigation", meta = (ClampMin = "1"))
 	int32 MaxPathRequestsPerFrame = 100;
 
+	double PathRequestBudgetSeconds = 0.001;
+
+	void EnqueuePathRequest(
+		FMassUnitEntityHandle Entity,
+		const FVector& Destination,
+		float AcceptanceRadius,
+		EMassUnitPathPriority Priority,
+		float MaxLatency = 0.0f);
+	bool PopPathRequest(FPathRequest& OutRequest);
+	void RequeuePathRequest(const FPathRequest& Request);
+	/** Drops superseded and cancelled entries once they outnumber the live ones. */
+	void CompactPathRequestHeap();
+	/** Seconds added to a request's target time for its distance from the nearest observer. */
+	double GetObserverWait(FMassUnitEntityHandle Entity);
+	void RecordQueueLatency(const FPathRequest& Request, double Now);
+	void AbortPendingPath(FMassUnitEntityHandle Entity);
 	void HandlePathRequestComplete(uint32 PathId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path);
-	void UpdateEntityWithPath(FMassUnitEntityHandle Entity, const FNavPathSharedPtr& Path);
+	/** Projects both ends of a shared corridor onto the active navmesh. */
+	bool ProjectSharedPathEnds(
+		const FVector& Start,
+		const FVector& Destination,
+		FNavLocation& OutStart,
+		FNavLocation& OutDestination);
+	void HandleSharedPathComplete(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path);
+	/** Sends one navmesh query for the given members, or resolves them without navmesh when it cannot be issued. */
+	void DispatchPathQuery(const FVector& Start, const FVector& Destination, FPendingPath&& PendingPath);
+	/** Queries one unit's own end points; used when a shared corridor does not fit it. */
+	void DispatchMemberQuery(const FPathMember& Member);
+	/** Whether Member can walk its own start onto the corridor and off it to its own destination. */
+	bool CanFollowCorridor(const FPathMember& Member, TConstArrayView<FVector> InteriorPoints) const;
+	/** PartialEnd, when set, replaces the destination as the last point; the unit stops where the navmesh ends. */
+	void ApplyCorridor(const FPathMember& Member, TConstArrayView<FVector> InteriorPoints, const FVector* PartialEnd = nullptr);
+	void IndexPath(const FPathMember& Member, TConstArrayView<FVector> PathPoints);
+	void HandleNavigationDirty(const FBox& DirtyBounds);
+	/** Moves units whose corridors cross the rebuilt areas into the repath backlog. */
+	void CollectStalePaths();
+	void RequeueStalePaths();
+	/** Direct path toward Destination, or a failed path when the fallback is off. Either way the unit's route is dropped. */
+	void ResolveWithoutNavmesh(FMassUnitEntityHandle Entity, const FVector& Destination, float AcceptanceRadius);
+	void CachePath(const FNavPathSharedPtr& Path);
+	/** String-pulls a cached corridor between Member's end points. Returns false when the corridor no longer yields a path. */
+	bool BuildCachedCorridor(const FCachedPath& CachedPath, const FPathMember& Member, TArray<FVector>& OutInteriorPoints) const;
+	static int64 GetCachedPathBytes(const FCachedPath& CachedPath);
+	void RefineHierarchicalRoutes();
+	/** Narrows a long-distance goal to the end of the next refined window. Returns false to defer the request. */
+	bool SelectRouteSegment(const FPathRequest& Request, const FVector& Start, FNavLocation& InOutGoal);
+	EClusterRouteResult PlanClusterRoute(const FVector& Start, const FVector& Goal, TArray<FVector>& OutWaypoints);
+	/** Returns false, leaving the link untested, when this frame's cluster budget is spent. */
+	bool TryGetClusterLink(const FIntPoint& Cell, int32 Direction, float ReferenceZ, bool& bOutLinked);
+	/** Returns nullptr when the cluster is not built yet and this frame's cluster budget is spent. */
+	const FPathCluster* FindOrBuildCluster(const FIntPoint& Cell, float ReferenceZ);
+	bool HasClusterBudget() const;
+	/** Drops clusters near the rebuilt areas and the links other clusters kept to them. */
+	void InvalidatePathClusters();
+	FIntPoint ToClusterCell(const FVector& Location) const;
+	FIntPoint ToPathIndexCell(const FVector& Location) const;
+
+	UFUNCTION()
+	void HandleNavigationGenerationFinished(ANavigationData* NavData);
 	bool SetDirectPath(FMassUnitEntityHandle Entity, const FVector& Destination, float AcceptanceRadius);
 	void MarkPathFailed(FMassUnitEntityHandle Entity);
 	bool IsEntityValid(FMassUnitEntityHandle Entity) const;
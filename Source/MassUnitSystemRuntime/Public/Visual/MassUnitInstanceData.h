@@ -0,0 +1,69 @@
+// Copyright Digi Logic Labs LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Per-instance custom data layout of the instanced-mesh representation.
+ *
+ * Float 0 packs the animation index, visual LOD, team palette index, and
+ * quantized health into one integer below 2^24, which a 32-bit float holds
+ * exactly, so materials decode it with floor and fmod instead of bit casts.
+ * Float 1 is the animation start phase: the start time in world seconds
+ * divided by AnimationPhasePeriod, wrapped to [0, 1). Team colors live in the
+ * team palette texture. /Plugin/MassUnitSystem/Private/MassUnitInstanceData.ush
+ * mirrors this layout for material Custom nodes.
+ */
+namespace UE::MassUnitSystem::InstanceData
+{
+	inline constexpr int32 FloatCount = 2;
+	inline constexpr int32 AnimationBits = 8;
+	inline constexpr int32 LODBits = 4;
+	inline constexpr int32 TeamPaletteBits = 6;
+	inline constexpr int32 HealthBits = 6;
+	inline constexpr int32 TeamPaletteSize = 1 << TeamPaletteBits;
+	inline constexpr float AnimationPhasePeriod = 1024.0f;
+
+	static_assert(AnimationBits + LODBits + TeamPaletteBits + HealthBits <= 24, "Packed data must stay exact in a float");
+
+	struct FUnpacked
+	{
+		int32 AnimationIndex = 0;
+		int32 LODLevel = 0;
+		int32 TeamPaletteIndex = 0;
+		float HealthFraction = 0.0f;
+	};
+
+	/** Values outside a field's range are clamped to it. */
+	inline float Pack(int32 AnimationIndex, int32 LODLevel, int32 TeamPaletteIndex, float HealthFraction)
+	{
+		const uint32 Animation = FMath::Clamp(AnimationIndex, 0, (1 << AnimationBits) - 1);
+		const uint32 LOD = FMath::Clamp(LODLevel, 0, (1 << LODBits) - 1);
+		const uint32 Team = FMath::Clamp(TeamPaletteIndex, 0, TeamPaletteSize - 1);
+		const uint32 Health = FMath::RoundToInt(FMath::Clamp(HealthFraction, 0.0f, 1.0f) * ((1 << HealthBits) - 1));
+		return static_cast<float>(
+			Animation
+			| LOD << AnimationBits
+			| Team << (AnimationBits + LODBits)
+			| Health << (AnimationBits + LODBits + TeamPaletteBits));
+	}
+
+	inline FUnpacked Unpack(float Packed)
+	{
+		const uint32 Bits = static_cast<uint32>(Packed);
+		FUnpacked Result;
+		Result.AnimationIndex = Bits & ((1 << AnimationBits) - 1);
+		Result.LODLevel = (Bits >> AnimationBits) & ((1 << LODBits) - 1);
+		Result.TeamPaletteIndex = (Bits >> (AnimationBits + LODBits)) & (TeamPaletteSize - 1);
+		Result.HealthFraction = static_cast<float>((Bits >> (AnimationBits + LODBits + TeamPaletteBits)) & ((1 << HealthBits) - 1))
+			/ ((1 << HealthBits) - 1);
+		return Result;
+	}
+
+	/** Wraps in double so the phase keeps full float precision however long the world has run. */
+	inline float PackStartPhase(double StartTime)
+	{
+		return static_cast<float>(FMath::Frac(StartTime / AnimationPhasePeriod));
+	}
+}
@@ -0,0 +1,99 @@
+// Copyright Digi Logic Labs LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Immutable render-precision snapshot of the visual buffers.
+ *
+ * Published frames are shared with Niagara data interface instances and the
+ * render thread by reference, so readers never copy them. A frame is only
+ * refilled once every reader has released it.
+ */
+struct MASSUNITSYSTEMRUNTIME_API FMassUnitVisualFrame
+{
+	TArray<FVector3f> Positions;
+	TArray<FVector3f> Velocities;
+	TArray<FVector3f> Scales;
+	TArray<FQuat4f> Rotations;
+	TArray<FVector3f> TeamColors;
+	TArray<float> TeamIDs;
+	TArray<float> AnimationIndices;
+	TArray<float> AnimationTimes;
+	TArray<float> LODLevels;
+	TArray<float> VisibilityFlags;
+
+	/** Buffer revision this frame was last synchronized to. */
+	uint32 Revision = 0;
+
+	int32 Num() const { return Positions.Num(); }
+};
+
+/**
+ * Persistent structure-of-arrays copy of what the GPU representation draws.
+ *
+ * Each unit owns one render slot for its whole lifetime, so its data stays at
+ * the same index in every array between updates. Writes compare against the
+ * stored values and stamp a slot with the current revision only when something
+ * the renderer cares about changed; the animation clock advances every frame
+ * and is kept out of that test. Consumers remember the revision they last
+ * synchronized to. Distinct slots may be written from different threads.
+ */
+class MASSUNITSYSTEMRUNTIME_API FMassUnitVisualBuffers
+{
+public:
+	struct FSample
+	{
+		FVector Position = FVector::ZeroVector;
+		FVector Velocity = FVector::ZeroVector;
+		FVector Scale = FVector::OneVector;
+		FQuat Rotation = FQuat::Identity;
+		FVector TeamColor = FVector::OneVector;
+		float TeamID = 0.0f;
+		float AnimationIndex = 0.0f;
+		float AnimationTime = 0.0f;
+		float LODLevel = 0.0f;
+	};
+
+	/** Bytes one slot occupies across all uploaded arrays, at the renderer's float precision. */
+	static constexpr int32 BytesPerSlot = 4 * sizeof(FVector3f) + sizeof(FQuat4f) + 5 * sizeof(float);
+
+	/** Grows or shrinks to SlotCount. New slots start hidden and changed. */
+	void SetNum(int32 SlotCount);
+	void Reset();
+
+	/** Stores a visible sample and stamps the slot when anything but the animation time changed. */
+	void Write(int32 Slot, const FSample& Sample);
+
+	/** Hides a slot whose unit is gone or not drawn through these buffers. */
+	void Hide(int32 Slot);
+
+	/** Current revision. Consumers record it after synchronizing, then call AdvanceRevision. */
+	uint32 GetRevision() const { return Revision; }
+	void AdvanceRevision() { ++Revision; }
+
+	bool HasChangedSince(int32 Slot, uint32 SyncedRevision) const { return SlotRevisions[Slot] > SyncedRevision; }
+	int32 CountChangedSince(uint32 SyncedRevision) const;
+
+	/** Copies slots changed since Frame.Revision, plus every animation time, and returns the bytes written. */
+	int32 CopyToFrame(FMassUnitVisualFrame& Frame) const;
+
+	int32 Num() const { return Positions.Num(); }
+	bool IsValidIndex(int32 Slot) const { return Positions.IsValidIndex(Slot); }
+
+	TArray<FVector> Positions;
+	TArray<FVector> Velocities;
+	TArray<FVector> Scales;
+	TArray<FQuat> Rotations;
+	TArray<FVector> TeamColors;
+	TArray<float> TeamIDs;
+	TArray<float> AnimationIndices;
+	TArray<float> AnimationTimes;
+	TArray<float> LODLevels;
+	TArray<float> VisibilityFlags;
+
+private:
+	TArray<uint32> SlotRevisions;
+	uint32 Revision = 1;
+};
@@ -0,0 +1,70 @@
+// Copyright Digi Logic Labs LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NiagaraDataInterface.h"
+#include "NiagaraDataInterfaceMassUnits.generated.h"
+
+/**
+ * Niagara data interface that reads unit visuals straight from the Mass Unit
+ * System, for CPU and GPU emitters.
+ *
+ * Each system instance holds a reference to the latest immutable frame the
+ * representation published. The render thread receives the same reference and
+ * packs it into one GPU buffer only when a newer frame arrives, so no Unit*
+ * array copies are involved. Turn off Upload Niagara Unit Arrays when a system
+ * reads units through this interface.
+ */
+UCLASS(EditInlineNew, Category = "Mass Unit System", CollapseCategories, meta = (DisplayName = "Mass Units"))
+class MASSUNITSYSTEMRUNTIME_API UNiagaraDataInterfaceMassUnits : public UNiagaraDataInterface
+{
+	GENERATED_BODY()
+
+public:
+	UNiagaraDataInterfaceMassUnits();
+
+	/** float4 elements per unit in the GPU buffer, which is packed whole for every newer frame. */
+	static constexpr int32 UnitDataStride = 6;
+
+	virtual void PostInitProperties() override;
+
+	virtual bool CanExecuteOnTarget(ENiagaraSimTarget Target) const override { return true; }
+	virtual int32 PerInstanceDataSize() const override;
+	virtual bool InitPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance) override;
+	virtual void DestroyPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance) override;
+	virtual bool HasPreSimulateTick() const override { return true; }
+	virtual bool PerInstanceTick(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance, float DeltaSeconds) override;
+	virtual void ProvidePerInstanceDataForRenderThread(
+		void* DataForRenderThread,
+		void* PerInstanceData,
+		const FNiagaraSystemInstanceID& SystemInstance) override;
+	virtual void GetVMExternalFunction(
+		const FVMExternalFunctionBindingInfo& BindingInfo,
+		void* InstanceData,
+		FVMExternalFunction& OutFunc) override;
+
+#if WITH_EDITORONLY_DATA
+	virtual bool AppendCompileHash(FNiagaraCompileHashVisitor* InVisitor) const override;
+	virtual void GetParameterDefinitionHLSL(const FNiagaraDataInterfaceGPUParamInfo& ParamInfo, FString& OutHLSL) override;
+	virtual bool GetFunctionHLSL(
+		const FNiagaraDataInterfaceGPUParamInfo& ParamInfo,
+		const FNiagaraDataInterfaceGeneratedFunction& FunctionInfo,
+		int FunctionInstanceIndex,
+		FString& OutHLSL) override;
+#endif
+	virtual void BuildShaderParameters(FNiagaraShaderParametersBuilder& ShaderParametersBuilder) const override;
+	virtual void SetShaderParameters(const FNiagaraDataInterfaceSetShaderParametersContext& Context) const override;
+
+protected:
+#if WITH_EDITORONLY_DATA
+	virtual void GetFunctionsInternal(TArray<FNiagaraFunctionSignature>& OutFunctions) const override;
+#endif
+
+private:
+	void VMGetNumUnits(FVectorVMExternalFunctionContext& Context);
+	void VMGetUnitTransform(FVectorVMExternalFunctionContext& Context);
+	void VMGetUnitVelocity(FVectorVMExternalFunctionContext& Context);
+	void VMGetUnitTeam(FVectorVMExternalFunctionContext& Context);
+	void VMGetUnitAnimation(FVectorVMExternalFunctionContext& Context);
+};
@@ -4,26 +4,102 @@
 
 #include "CoreMinimal.h"
 #include "Entity/MassUnitEntityManager.h"
+#include "Visual/MassUnitInstanceData.h"
+#include "Visual/MassUnitVisualBuffers.h"
 #include "NiagaraUnitSystem.generated.h"
 
 class UInstancedStaticMeshComponent;
 class UMassEntitySubsystem;
+class UMaterialInterface;
 class UNiagaraComponent;
 class UNiagaraSystem;
 class UStaticMesh;
+class UTexture2D;
 class UVertexAnimationManager;
+struct FMassUnitRenderSlotFragment;
+struct FMassUnitStateFragment;
+struct FMassUnitTeamFragment;
+struct FMassUnitTransformFragment;
+struct FMassUnitVelocityFragment;
+struct FMassUnitVisualFragment;
 
-/** GPU representation uploader with an asset-free instanced-mesh fallback. */
+/** Cost of the most recent Niagara visual update. */
+USTRUCT(BlueprintType)
+struct MASSUNITSYSTEMRUNTIME_API FMassUnitVisualUploadStats
+{
+	GENERATED_BODY()
+
+	/** Time spent copying fragments into the slot buffers, on workers or the game thread. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Rendering", meta = (ForceUnits = "ms"))
+	float GatherMs = 0.0f;
+
+	/**
+	 * Bytes Niagara receives: every Unit* array that was set, each sent whole,
+	 * plus the buffer the Mass Units interface packs for GPU emitters from a
+	 * newly published frame.
+	 */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Rendering")
+	int32 UploadBytes = 0;
+
+	/** Slots whose data changed during the latest gather. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Rendering")
+	int32 DirtySlots = 0;
+
+	/** Render slots covered by the buffers, including free and hidden ones. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Rendering")
+	int32 SlotCount = 0;
+};
+
+/**
+ * GPU representation uploader with an asset-free instanced-mesh fallback.
+ *
+ * Niagara reads persistent per-slot arrays indexed by each unit's render slot.
+ * The visual gather processor fills them in parallel. The Mass Units data
+ * interface shares them as published frames; systems that still bind the
+ * Unit* arrays receive them whole, and only when a slot changed.
+ */
 UCLASS(BlueprintType)
 class MASSUNITSYSTEMRUNTIME_API UNiagaraUnitSystem : public UObject
 {
 	GENERATED_BODY()
 
 public:
-	void Initialize(UWorld* InWorld, UMassEntitySubsystem* InEntitySubsystem);
+	void Initialize(UWorld* InWorld, UMassEntitySubsystem* InEntitySubsystem, UMassUnitEntityManager* InUnitManager);
 	void Deinitialize();
+
+	/**
+	 * Uploads the slot buffers to Niagara, or rebuilds the instanced-mesh
+	 * fallback from Entities. When the gather processor did not run this frame,
+	 * Entities are gathered into their slots on the game thread first.
+	 */
 	void UpdateUnitVisuals(const TArray<FMassUnitEntityHandle>& Entities);
 
+	/** Sizes the slot buffers and hides freed slots. Returns false when no Niagara upload is due this frame. */
+	bool PrepareVisualGather();
+
+	/** Stores one unit in its render slot. Safe to call concurrently for distinct slots between Prepare and Finish. */
+	void WriteVisualSample(
+		int32 Slot,
+		const FMassUnitTransformFragment& Transform,
+		const FMassUnitVelocityFragment& Velocity,
+		const FMassUnitVisualFragment& Visual,
+		const FMassUnitTeamFragment& Team,
+		const FMassUnitStateFragment& State);
+
+	/** Registers animation textures seen during the gather and records its duration. */
+	void FinishVisualGather(double GatherSeconds);
+
+	/**
+	 * Latest frame published for the Mass Units Niagara data interface. Frames
+	 * are immutable once published and stay valid while referenced; null until
+	 * a reader is registered and an upload has run.
+	 */
+	TSharedPtr<const FMassUnitVisualFrame, ESPMode::ThreadSafe> GetPublishedVisualFrame() const;
+
+	/** Data interface instances register here so frames are only published while something reads them. Game thread only. */
+	void AddVisualFrameReader();
+	void RemoveVisualFrameReader();
+
 	UFUNCTION(BlueprintCallable, Category = "Mass Unit System|Rendering")
 	void UpdateUnitVisualsByHandles(const TArray<FMassUnitHandle>& UnitHandles);
 
@@ -36,7 +112,7 @@ public:
 	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Rendering")
 	bool IsUsingNiagara() const { return NiagaraComponent != nullptr; }
 
-	/** Number of dynamic ISM components currently allocated by the asset-free/static-mesh fallback. */
+	/** Number of dynamic ISM components currently allocated by the asset-free/static-mesh fallback, one per mesh and shadow setting. */
 	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Rendering|Diagnostics")
 	int32 GetInstancedMeshComponentCount() const { return InstancedMeshComponents.Num(); }
 
@@ -48,10 +124,33 @@ public:
 	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Rendering|Diagnostics")
 	int32 GetInstancedMeshTopologyRevision() const { return InstancedMeshTopologyRevision; }
 
-	/** Per-instance material data: animation index/time, LOD, team id/RGB, and health percent. */
+	/** Instances currently drawn as impostor cards through the ISM fallback. */
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Rendering|Diagnostics")
+	int32 GetImpostorInstanceCount() const;
+
+	/** Instances whose transform was re-uploaded in the latest ISM update; scales with moving units, not total units. */
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Rendering|Diagnostics")
+	int32 GetInstancedMeshTransformUpdateCount() const { return InstancedTransformUpdateCount; }
+
+	/** Instances whose custom data was re-uploaded in the latest ISM update. */
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Rendering|Diagnostics")
+	int32 GetInstancedMeshCustomDataUpdateCount() const { return InstancedCustomDataUpdateCount; }
+
+	/** Per-instance material data: packed animation index/LOD/team palette index/health, then animation start phase. */
 	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Rendering|Diagnostics")
 	int32 GetInstancedMeshCustomDataFloatCount() const { return InstancedCustomDataFloatCount; }
 
+	/**
+	 * One texel per team and team color seen by the instanced fallback, indexed by the packed team palette
+	 * index. Bound to the TeamPalette texture parameter of instanced materials that declare it.
+	 */
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Rendering")
+	UTexture2D* GetTeamPaletteTexture() const { return TeamPaletteTexture; }
+
+	/** Gather time, uploaded bytes, and dirty slots of the most recent Niagara update. */
+	UFUNCTION(BlueprintPure, Category = "Mass Unit System|Rendering|Diagnostics")
+	FMassUnitVisualUploadStats GetVisualUploadStats() const { return UploadStats; }
+
 	UVertexAnimationManager* GetVertexAnimationManager() const { return VertexAnimationManager; }
 
 private:
@@ -61,6 +160,9 @@ private:
 	UPROPERTY(Transient)
 	TObjectPtr<UMassEntitySubsystem> EntitySubsystem = nullptr;
 
+	UPROPERTY(Transient)
+	TObjectPtr<UMassUnitEntityManager> UnitManager = nullptr;
+
 	UPROPERTY(Transient)
 	TObjectPtr<UNiagaraSystem> NiagaraSystemAsset = nullptr;
 
@@ -74,23 +176,119 @@ private:
 	TObjectPtr<UStaticMesh> FallbackStaticMesh = nullptr;
 
 	UPROPERTY(Transient)
-	TMap<TObjectPtr<UStaticMesh>, TObjectPtr<UInstancedStaticMeshComponent>> InstancedMeshComponents;
+	TObjectPtr<UStaticMesh> ImpostorCardMesh = nullptr;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UTexture2D> TeamPaletteTexture = nullptr;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UInstancedStaticMeshComponent>> InstancedMeshComponents;
+
+	/**
+	 * One ISM bucket. Units only change bucket when a visual LOD change selects another mesh or shadow
+	 * setting, or moves them into the impostor tier, whose buckets carry the template's card material.
+	 */
+	struct FInstancedMeshKey
+	{
+		UStaticMesh* Mesh = nullptr;
+		UMaterialInterface* ImpostorMaterial = nullptr;
+		bool bCastShadow = true;
+
+		bool operator==(const FInstancedMeshKey& Other) const
+		{
+			return Mesh == Other.Mesh && ImpostorMaterial == Other.ImpostorMaterial && bCastShadow == Other.bCastShadow;
+		}
+		friend uint32 GetTypeHash(const FInstancedMeshKey& Key)
+		{
+			return HashCombine(HashCombine(::GetTypeHash(Key.Mesh), ::GetTypeHash(Key.ImpostorMaterial)), ::GetTypeHash(Key.bCastShadow));
+		}
+	};
+
+	/** Persistent instance list of one ISM component; instance index equals position in these arrays. */
+	struct FInstancedMeshBatch
+	{
+		UInstancedStaticMeshComponent* Component = nullptr;
+		TArray<FMassUnitEntityHandle> Owners;
+		TArray<FTransform> Transforms;
+		TArray<float> CustomData;
+		TArray<uint8> DirtyFlags;
+		TArray<int32> DirtyIndices;
+	};
+
+	struct FInstanceSlot
+	{
+		FInstancedMeshKey Bucket;
+		int32 Index = INDEX_NONE;
+		uint32 UpdateStamp = 0;
+	};
+
+	static constexpr uint8 InstanceTransformDirty = 1 << 0;
+	static constexpr uint8 InstanceCustomDataDirty = 1 << 1;
+
+	TMap<FInstancedMeshKey, FInstancedMeshBatch> InstancedMeshBatches;
+	TMap<FMassUnitEntityHandle, FInstanceSlot> InstanceSlots;
+	TArray<int32> MovedInstanceScratch;
+
+	/** Palette slot per team id and packed team color, so units of one team share a texel. */
+	TMap<uint64, int32> TeamPaletteIndices;
+	TArray<FColor> TeamPaletteColors;
+	bool bTeamPaletteDirty = false;
+	uint32 InstanceUpdateStamp = 0;
+	int32 InstancedTransformUpdateCount = 0;
+	int32 InstancedCustomDataUpdateCount = 0;
 
 	int32 CurrentLODLevel = 0;
 	int32 MaxUnits = 10000;
 	int32 InstancedMeshTopologyRevision = 0;
-	static constexpr int32 InstancedCustomDataFloatCount = 8;
+	float ImpostorCardWidth = 100.0f;
+	static constexpr int32 InstancedCustomDataFloatCount = UE::MassUnitSystem::InstanceData::FloatCount;
 	float UpdateFrequency = 0.033f;
 	float LastUpdateTime = -BIG_NUMBER;
 	bool bEnableInstancedFallback = true;
+	bool bUploadUnitArrays = true;
+	/** Whether the bound component exposes the Unit* arrays; resolved once when it is spawned. */
+	bool bUnitArraysBound = false;
+
+	FMassUnitVisualBuffers VisualBuffers;
+	FMassUnitVisualUploadStats UploadStats;
+	TMap<FGameplayTag, UTexture2D*> PendingAnimationTextures;
+	FCriticalSection PendingAnimationTexturesLock;
+	uint64 VisualGatherFrame = 0;
+	int32 ObservedSlotReleaseCount = 0;
+	int32 UploadedSlotCount = INDEX_NONE;
+	uint32 UploadedArrayRevision = 0;
+	TSharedPtr<FMassUnitVisualFrame, ESPMode::ThreadSafe> VisualFrames[2];
+	int32 PublishedFrameIndex = 0;
+	int32 VisualFrameReaderCount = 0;
+	double LastGatherSeconds = 0.0;
 
 	void CreateNiagaraSystem();
+	bool IsVisualUpdateDue() const;
+	void SyncVisualSlots();
 	void UpdateNiagaraData(const TArray<FMassUnitEntityHandle>& Entities);
+	void GatherVisualSamples(const TArray<FMassUnitEntityHandle>& Entities);
+	void UploadVisualBuffers();
+	int32 UploadUnitArrays();
+	int32 PublishVisualFrame();
+	void StoreVisualSample(
+		int32 Slot,
+		const FMassUnitTransformFragment& Transform,
+		const FMassUnitVelocityFragment& Velocity,
+		const FMassUnitVisualFragment& Visual,
+		const FMassUnitTeamFragment& Team,
+		const FMassUnitStateFragment& State,
+		int32 AnimationIndex);
 	void UpdateInstancedMeshData(const TArray<FMassUnitEntityHandle>& Entities);
-	void SynchronizeInstancedMeshComponent(
-		UInstancedStaticMeshComponent* Component,
-		const TArray<FTransform>& WorldTransforms,
-		const TArray<float>& CustomData);
-	int32 ResolveAnimationIndex(const struct FMassUnitVisualFragment& Visual, const struct FMassUnitStateFragment& State);
-	UInstancedStaticMeshComponent* GetOrCreateInstancedMeshComponent(UStaticMesh* Mesh);
+	FInstancedMeshKey ResolveInstancedMeshBucket(const FMassUnitVisualFragment& Visual) const;
+	void UpdateInstanceSlot(FMassUnitEntityHandle Entity, const FInstancedMeshKey& Bucket, const FTransform& Transform, const float* CustomData);
+	void RemoveInstanceSlot(const FInstanceSlot& Slot);
+	int32 ResolveTeamPaletteIndex(const FMassUnitTeamFragment& Team);
+	void CreateTeamPaletteTexture();
+	void UploadTeamPalette();
+	void SynchronizeInstancedMeshBatch(const FInstancedMeshKey& Bucket, FInstancedMeshBatch& Batch);
+	int32 ResolveAnimationIndex(const FMassUnitVisualFragment& Visual, const FMassUnitStateFragment& State);
+
+	/** Read-only variant for worker threads; unregistered textures are queued for FinishVisualGather. */
+	int32 ResolveAnimationIndexDeferred(const FMassUnitVisualFragment& Visual, const FMassUnitStateFragment& State);
+	UInstancedStaticMeshComponent* GetOrCreateInstancedMeshComponent(const FInstancedMeshKey& Bucket, FInstancedMeshBatch& Batch);
 };
@@ -0,0 +1,26 @@
+// Copyright Digi Logic Labs LLC. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class MassUnitSystemShaders : ModuleRules
+{
+	public MassUnitSystemShaders(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Core"
+			}
+		);
+
+		PrivateDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Projects",
+				"RenderCore"
+			}
+		);
+	}
+}
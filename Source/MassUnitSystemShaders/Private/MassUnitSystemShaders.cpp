@@ -0,0 +1,19 @@
+// Copyright Digi Logic Labs LLC. All Rights Reserved.
+
+#include "MassUnitSystemShaders.h"
+#include "Interfaces/IPluginManager.h"
+#include "Misc/Paths.h"
+#include "Modules/ModuleManager.h"
+#include "ShaderCore.h"
+
+IMPLEMENT_MODULE(FMassUnitSystemShadersModule, MassUnitSystemShaders);
+
+void FMassUnitSystemShadersModule::StartupModule()
+{
+	// Material Custom nodes include the instance data decoders from /Plugin/MassUnitSystem.
+	const TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("MassUnitSystem"));
+	if (Plugin && !AllShaderSourceDirectoryMappings().Contains(TEXT("/Plugin/MassUnitSystem")))
+	{
+		AddShaderSourceDirectoryMapping(TEXT("/Plugin/MassUnitSystem"), FPaths::Combine(Plugin->GetBaseDir(), TEXT("Shaders")));
+	}
+}
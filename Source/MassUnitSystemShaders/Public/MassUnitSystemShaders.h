@@ -0,0 +1,20 @@
+// Copyright Digi Logic Labs LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Modules/ModuleManager.h"
+
+/**
+ * Module that maps the plugin's Shaders directory to /Plugin/MassUnitSystem.
+ *
+ * Shader source directories must be registered before the shader map is
+ * built, so this module loads in the PostConfigInit phase, ahead of the
+ * runtime module.
+ */
+class FMassUnitSystemShadersModule : public IModuleInterface
+{
+public:
+	/** IModuleInterface implementation */
+	virtual void StartupModule() override;
+};